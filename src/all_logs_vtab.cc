@@ -67,16 +67,39 @@ all_logs_vtab::extract(logfile* lf,
     auto& line = values.lvv_sbr;
     auto* format = lf->get_format_ptr();
 
-    logline_value_vector sub_values;
+    auto& line_sigs = this->alv_line_sigs[lf->get_content_id()];
+    if (line_number < line_sigs.size()
+        && line_sigs[line_number] != SIG_UNKNOWN)
+    {
+        const auto& sig = this->alv_sig_pool[line_sigs[line_number]];
 
-    this->vi_attrs.clear();
-    sub_values.lvv_sbr = line;
-    format->annotate(line_number, this->vi_attrs, sub_values, false);
+        values.lvv_values.emplace_back(this->alv_msg_meta, sig.ms_format);
+        values.lvv_values.emplace_back(this->alv_schema_meta, sig.ms_schema);
+        return;
+    }
+
+    line_range body;
+    auto extent = lf->get_line_extent(line_number);
 
-    auto body = find_string_attr_range(this->vi_attrs, &SA_BODY);
-    if (body.lr_start == -1) {
-        body.lr_start = 0;
+    if (extent && extent->le_body_start > 0
+        && extent->le_body_start < line.length())
+    {
+        // The scanner recorded where the body starts, no need to re-run
+        // the format's regex just to find it.
+        body.lr_start = extent->le_body_start;
         body.lr_end = line.length();
+    } else {
+        logline_value_vector sub_values;
+
+        this->vi_attrs.clear();
+        sub_values.lvv_sbr = line;
+        format->annotate(line_number, this->vi_attrs, sub_values, false);
+
+        body = find_string_attr_range(this->vi_attrs, &SA_BODY);
+        if (body.lr_start == -1) {
+            body.lr_start = 0;
+            body.lr_end = line.length();
+        }
     }
 
     data_scanner ds(
@@ -87,9 +110,26 @@ all_logs_vtab::extract(logfile* lf,
     dp.dp_msg_format = &str;
     dp.parse();
 
+    auto schema = dp.dp_schema_id.to_string();
+    auto intern_key = fmt::format(FMT_STRING("{}\x1f{}"), schema, str);
+    auto id_iter = this->alv_sig_ids.find(intern_key);
+    uint32_t sig_id;
+
+    if (id_iter != this->alv_sig_ids.end()) {
+        sig_id = id_iter->second;
+    } else {
+        sig_id = this->alv_sig_pool.size();
+        this->alv_sig_pool.emplace_back(msg_signature{str, schema});
+        this->alv_sig_ids.emplace(std::move(intern_key), sig_id);
+    }
+    if (line_number >= line_sigs.size()) {
+        line_sigs.resize(
+            std::max((size_t) line_number + 1, lf->size()), SIG_UNKNOWN);
+    }
+    line_sigs[line_number] = sig_id;
+
     values.lvv_values.emplace_back(this->alv_msg_meta, std::move(str));
-    values.lvv_values.emplace_back(this->alv_schema_meta,
-                                   dp.dp_schema_id.to_string());
+    values.lvv_values.emplace_back(this->alv_schema_meta, std::move(schema));
 }
 
 bool
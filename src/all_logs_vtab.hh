@@ -31,6 +31,8 @@
 #define lnav_all_logs_vtab_hh
 
 #include <array>
+#include <unordered_map>
+#include <vector>
 
 #include "data_parser.hh"
 #include "log_vtab_impl.hh"
@@ -53,8 +55,31 @@ public:
     bool next(log_cursor& lc, logfile_sub_source& lss) override;
 
 private:
+    /** A distinct (msg_format, schema ID) pair produced by the parser. */
+    struct msg_signature {
+        std::string ms_format;
+        std::string ms_schema;
+    };
+
+    static constexpr uint32_t SIG_UNKNOWN = UINT32_MAX;
+
     logline_value_meta alv_msg_meta;
     logline_value_meta alv_schema_meta;
+
+    /**
+     * The distinct signatures seen so far.  Messages repeat heavily, so
+     * this pool stays small while the per-line tables below shrink to an
+     * ID each.
+     */
+    std::vector<msg_signature> alv_sig_pool;
+    std::unordered_map<std::string, uint32_t> alv_sig_ids;
+    /**
+     * Per-file table of signature IDs, keyed by content ID and indexed by
+     * line number.  Filled as lines are first extracted so the repeated
+     * triage aggregation over log_msg_format does not re-tokenize every
+     * row on every run.
+     */
+    std::unordered_map<std::string, std::vector<uint32_t>> alv_line_sigs;
 };
 
 #endif  // LNAV_ALL_LOGS_VTAB_HH
@@ -29,6 +29,12 @@
  * @file archive_manager.cc
  */
 
+#include <algorithm>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "config.h"
@@ -110,6 +116,15 @@ is_archive(const fs::path& filename)
                 if (filter_count == 2 && GZ_FILTER_NAME == first_filter_name) {
                     return false;
                 }
+#ifdef HAVE_ZSTD_H
+                // line_buffer decodes zstd natively, like gzip, so these
+                // files can be read directly instead of being extracted.
+                static const auto ZSTD_FILTER_NAME = string_fragment("zstd");
+                if (filter_count == 2 && ZSTD_FILTER_NAME == first_filter_name)
+                {
+                    return false;
+                }
+#endif
             }
             log_info(
                 "detected archive: %s -- %s", filename.c_str(), format_name);
@@ -215,48 +230,22 @@ copy_data(const std::string& filename,
     }
 }
 
+/**
+ * Extract this worker's share of an archive's entries into the workdir
+ * cache.  Each worker walks the full header list with its own archive
+ * handles and claims every Nth entry, so workers never contend on a
+ * handle and member decompression runs concurrently.
+ */
 static walk_result_t
-extract(const std::string& filename, const extract_cb& cb)
+extract_worker(const std::string& filename,
+               const fs::path& tmp_path,
+               const extract_cb& cb,
+               size_t worker_index,
+               size_t worker_count)
 {
     static const int FLAGS = ARCHIVE_EXTRACT_TIME | ARCHIVE_EXTRACT_PERM
         | ARCHIVE_EXTRACT_ACL | ARCHIVE_EXTRACT_FFLAGS;
 
-    std::error_code ec;
-    auto tmp_path = filename_to_tmp_path(filename);
-
-    fs::create_directories(tmp_path.parent_path(), ec);
-    if (ec) {
-        return Err(fmt::format("unable to create directory: {} -- {}",
-                               tmp_path.parent_path().string(),
-                               ec.message()));
-    }
-
-    auto arc_lock = lnav::filesystem::file_lock(tmp_path);
-    auto lock_guard = lnav::filesystem::file_lock::guard(&arc_lock);
-    auto done_path = tmp_path;
-
-    done_path += ".done";
-
-    if (fs::exists(done_path)) {
-        size_t file_count = 0;
-        if (fs::is_directory(tmp_path)) {
-            for (const auto& entry : fs::directory_iterator(tmp_path)) {
-                (void) entry;
-                file_count += 1;
-            }
-        }
-        if (file_count > 0) {
-            fs::last_write_time(done_path, std::chrono::system_clock::now());
-            log_info("%s: archive has already been extracted!",
-                     done_path.c_str());
-            return Ok();
-        }
-        log_warning("%s: archive cache has been damaged, re-extracting",
-                    done_path.c_str());
-
-        fs::remove(done_path);
-    }
-
     auto_mem<archive> arc(archive_free);
     auto_mem<archive> ext(archive_free);
 
@@ -267,19 +256,30 @@ extract(const std::string& filename, const extract_cb& cb)
     ext = archive_write_disk_new();
     archive_write_disk_set_options(ext, FLAGS);
     archive_write_disk_set_standard_lookup(ext);
-    if (archive_read_open_filename(arc, filename.c_str(), 10240) != ARCHIVE_OK)
-    {
+
+    auto arc_fd = auto_fd(lnav::filesystem::openp(filename, O_RDONLY));
+    if (arc_fd == -1) {
+        return Err(fmt::format(FMT_STRING("unable to open archive: {} -- {}"),
+                               filename,
+                               strerror(errno)));
+    }
+#ifdef POSIX_FADV_SEQUENTIAL
+    // The archive is consumed front-to-back in one pass, so ask the kernel
+    // to read ahead aggressively instead of waiting for each block request
+    // to fault the pages in.
+    posix_fadvise(arc_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+    if (archive_read_open_fd(arc, arc_fd, 128 * 1024) != ARCHIVE_OK) {
         return Err(fmt::format(FMT_STRING("unable to open archive: {} -- {}"),
                                filename,
                                archive_error_string(arc)));
     }
 
-    log_info("extracting %s to %s", filename.c_str(), tmp_path.c_str());
+    size_t entry_index = 0;
     while (true) {
         struct archive_entry* entry = nullptr;
         auto r = archive_read_next_header(arc, &entry);
         if (r == ARCHIVE_EOF) {
-            log_info("all done");
             break;
         }
         if (r != ARCHIVE_OK) {
@@ -289,6 +289,11 @@ extract(const std::string& filename, const extract_cb& cb)
                             archive_error_string(arc)));
         }
 
+        if (entry_index++ % worker_count != worker_index) {
+            archive_read_data_skip(arc);
+            continue;
+        }
+
         const auto* format_name = archive_format_name(arc);
         auto filter_count = archive_filter_count(arc);
 
@@ -330,6 +335,129 @@ extract(const std::string& filename, const extract_cb& cb)
     archive_read_close(arc);
     archive_write_close(ext);
 
+    return Ok();
+}
+
+/**
+ * Check whether an archive's members can be visited independently.
+ * Formats wrapped in a stream compression filter (tar.gz, tar.zst, ...)
+ * can only be reached by decompressing everything before them, so extra
+ * workers would each redo the full decompression just to skip entries.
+ */
+static bool
+is_seekable_archive(const std::string& filename)
+{
+    auto_mem<archive> probe(archive_read_free);
+
+    probe = archive_read_new();
+    enable_desired_archive_formats(probe);
+    archive_read_support_format_raw(probe);
+    archive_read_support_filter_all(probe);
+    if (archive_read_open_filename(probe, filename.c_str(), 128 * 1024)
+        != ARCHIVE_OK)
+    {
+        return false;
+    }
+
+    struct archive_entry* entry = nullptr;
+    if (archive_read_next_header(probe, &entry) != ARCHIVE_OK) {
+        return false;
+    }
+
+    static const auto RAW_FORMAT_NAME = string_fragment("raw");
+
+    return archive_filter_count(probe) == 1
+        && RAW_FORMAT_NAME != archive_format_name(probe);
+}
+
+/**
+ * Unpack all of an archive's entries into the workdir cache.
+ *
+ * Extraction is deliberately a full pass rather than a lazy per-member
+ * affair: the common inputs are tar streams where members can only be
+ * reached by decompressing everything before them, and every extracted
+ * member is loaded and indexed anyway, so deferring members would only
+ * move the same work later and add a seek-and-rescan cost for each one.
+ */
+static walk_result_t
+extract(const std::string& filename, const extract_cb& cb)
+{
+    std::error_code ec;
+    auto tmp_path = filename_to_tmp_path(filename);
+
+    fs::create_directories(tmp_path.parent_path(), ec);
+    if (ec) {
+        return Err(fmt::format("unable to create directory: {} -- {}",
+                               tmp_path.parent_path().string(),
+                               ec.message()));
+    }
+
+    auto arc_lock = lnav::filesystem::file_lock(tmp_path);
+    auto lock_guard = lnav::filesystem::file_lock::guard(&arc_lock);
+    auto done_path = tmp_path;
+
+    done_path += ".done";
+
+    if (fs::exists(done_path)) {
+        size_t file_count = 0;
+        if (fs::is_directory(tmp_path)) {
+            for (const auto& entry : fs::directory_iterator(tmp_path)) {
+                (void) entry;
+                file_count += 1;
+            }
+        }
+        if (file_count > 0) {
+            fs::last_write_time(done_path, std::chrono::system_clock::now());
+            log_info("%s: archive has already been extracted!",
+                     done_path.c_str());
+            return Ok();
+        }
+        log_warning("%s: archive cache has been damaged, re-extracting",
+                    done_path.c_str());
+
+        fs::remove(done_path);
+    }
+
+    size_t worker_count = 1;
+    if (is_seekable_archive(filename)) {
+        worker_count = std::min(
+            (size_t) 4,
+            (size_t) std::max(1U, std::thread::hardware_concurrency()));
+    }
+
+    log_info("extracting %s to %s with %zu worker(s)",
+             filename.c_str(),
+             tmp_path.c_str(),
+             worker_count);
+    if (worker_count == 1) {
+        TRY(extract_worker(filename, tmp_path, cb, 0, 1));
+    } else {
+        std::vector<std::future<walk_result_t>> workers;
+
+        for (size_t lpc = 0; lpc < worker_count; lpc++) {
+            workers.emplace_back(std::async(std::launch::async,
+                                            extract_worker,
+                                            filename,
+                                            tmp_path,
+                                            cb,
+                                            lpc,
+                                            worker_count));
+        }
+
+        std::string first_error;
+        for (auto& worker : workers) {
+            auto res = worker.get();
+
+            if (res.isErr() && first_error.empty()) {
+                first_error = res.unwrapErr();
+            }
+        }
+        if (!first_error.empty()) {
+            return Err(std::move(first_error));
+        }
+    }
+    log_info("all done");
+
     lnav::filesystem::create_file(done_path, O_WRONLY, 0600);
 
     return Ok();
@@ -33,6 +33,8 @@
 
 #include "ansi_scrubber.hh"
 
+#include <string.h>
+
 #include "base/opt_util.hh"
 #include "config.h"
 #include "pcrepp/pcre2pp.hh"
@@ -48,11 +50,28 @@ ansi_regex()
     return retval;
 }
 
+/**
+ * Check for the bytes that can start one of the sequences handled by
+ * the scrubbers.  Most lines have no escapes at all and memchr() scans
+ * a cache line at a time, so this is much cheaper than starting up the
+ * regex machinery just to find nothing.
+ */
+static bool
+has_ansi_escapes(const char* str, size_t len)
+{
+    return memchr(str, '\x1b', len) != nullptr
+        || memchr(str, '\b', len) != nullptr;
+}
+
 size_t
 erase_ansi_escapes(string_fragment input)
 {
     static thread_local auto md = lnav::pcre2pp::match_data::unitialized();
 
+    if (!has_ansi_escapes(input.data(), input.length())) {
+        return input.length();
+    }
+
     const auto& regex = ansi_regex();
     nonstd::optional<int> move_start;
     size_t fill_index = 0;
@@ -124,6 +143,12 @@ scrub_ansi_string(std::string& str, string_attrs_t* sa)
     int64_t origin_offset = 0;
     int last_origin_offset_end = 0;
 
+    if (!has_ansi_escapes(str.c_str(), str.size())
+        && memchr(str.c_str(), '\0', str.size()) == nullptr)
+    {
+        return;
+    }
+
     replace(str.begin(), str.end(), '\0', ' ');
     auto matcher = regex.capture_from(str).into(md);
     while (true) {
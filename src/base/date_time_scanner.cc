@@ -100,6 +100,23 @@ date_time_scanner::scan(const char* time_dest,
         time_fmt = PTIMEC_FORMAT_STR;
     }
 
+    if (this->dts_fmt_lock != -1
+        && this->dts_shape_matches >= SHAPE_MATCH_COUNT
+        && !(time_len > 0 && time_dest[0] == '+')
+        && !this->shape_matches(time_dest, time_len))
+    {
+        // The locked format has been matching timestamps with a stable
+        // digit/separator shape and this line does not fit it, so there
+        // is no point in running the full parser.  Only break the lock
+        // after enough consecutive misses in case the file switched
+        // formats mid-stream.
+        this->dts_scan_misses += 1;
+        if (this->dts_scan_misses < MAX_SCAN_MISSES) {
+            return nullptr;
+        }
+        this->unlock();
+    }
+
     while (next_format(time_fmt, curr_time_fmt, this->dts_fmt_lock)) {
         *tm_out = this->dts_base_tm;
         tm_out->et_flags = 0;
@@ -187,8 +204,11 @@ date_time_scanner::scan(const char* time_dest,
                 tm_out->et_tm.tm_zone = nullptr;
             }
 #endif
-            if (ptime_fmt(
-                    time_fmt[curr_time_fmt], tm_out, time_dest, off, time_len)
+            if (ptime_exec(ptime_prog_for(time_fmt[curr_time_fmt]),
+                           tm_out,
+                           time_dest,
+                           off,
+                           time_len)
                 && (time_dest[off] == '.' || time_dest[off] == ','
                     || off == (off_t) time_len))
             {
@@ -265,6 +285,32 @@ date_time_scanner::scan(const char* time_dest,
         }
     }
 
+    if (retval != nullptr) {
+        auto match_len = (size_t) (retval - time_dest);
+        auto shape = digit_shape(time_dest, match_len);
+
+        if (match_len > 64) {
+            match_len = 64;
+        }
+        this->dts_scan_misses = 0;
+        if ((int) match_len == this->dts_shape_len
+            && shape == this->dts_shape_digits)
+        {
+            if (this->dts_shape_matches < SHAPE_MATCH_COUNT) {
+                this->dts_shape_matches += 1;
+            }
+        } else {
+            this->dts_shape_digits = shape;
+            this->dts_shape_len = match_len;
+            this->dts_shape_matches = 1;
+        }
+    } else if (this->dts_fmt_lock != -1) {
+        this->dts_scan_misses += 1;
+        if (this->dts_scan_misses >= MAX_SCAN_MISSES) {
+            this->unlock();
+        }
+    }
+
     return retval;
 }
 
@@ -32,6 +32,8 @@
 #ifndef lnav_date_time_scanner_hh
 #define lnav_date_time_scanner_hh
 
+#include <cctype>
+#include <cstdint>
 #include <ctime>
 #include <string>
 
@@ -57,6 +59,10 @@ struct date_time_scanner {
         this->dts_fmt_len = -1;
         this->dts_last_tv = timeval{};
         this->dts_last_tm = exttm{};
+        this->dts_shape_digits = 0;
+        this->dts_shape_len = 0;
+        this->dts_shape_matches = 0;
+        this->dts_scan_misses = 0;
     }
 
     /**
@@ -66,6 +72,46 @@ struct date_time_scanner {
     {
         this->dts_fmt_lock = -1;
         this->dts_fmt_len = -1;
+        this->dts_shape_digits = 0;
+        this->dts_shape_len = 0;
+        this->dts_shape_matches = 0;
+        this->dts_scan_misses = 0;
+    }
+
+    /**
+     * Compute a bitmap of the digit positions in the first 64 characters
+     * of the given string.  The bitmap is used as a cheap check that a
+     * line has the same shape as previously scanned timestamps before
+     * doing a full parse.
+     */
+    static uint64_t digit_shape(const char* str, size_t len)
+    {
+        uint64_t retval = 0;
+
+        if (len > 64) {
+            len = 64;
+        }
+        for (size_t lpc = 0; lpc < len; lpc++) {
+            if (isdigit(str[lpc])) {
+                retval |= 1ULL << lpc;
+            }
+        }
+
+        return retval;
+    }
+
+    /**
+     * Check that a string has the same digit/separator shape as the
+     * timestamps previously matched by the locked format.
+     */
+    bool shape_matches(const char* str, size_t len) const
+    {
+        if (len < (size_t) this->dts_shape_len) {
+            return false;
+        }
+
+        return digit_shape(str, this->dts_shape_len)
+            == this->dts_shape_digits;
     }
 
     void set_base_time(time_t base_time, const tm& local_tm);
@@ -85,6 +131,10 @@ struct date_time_scanner {
     struct exttm dts_base_tm;
     int dts_fmt_lock{-1};
     int dts_fmt_len{-1};
+    uint64_t dts_shape_digits{0};
+    int dts_shape_len{0};
+    int dts_shape_matches{0};
+    int dts_scan_misses{0};
     struct exttm dts_last_tm {};
     struct timeval dts_last_tv {};
     time_t dts_local_offset_cache{0};
@@ -93,6 +143,18 @@ struct date_time_scanner {
 
     static const int EXPIRE_TIME = 15 * 60;
 
+    /**
+     * The number of identically-shaped matches required before the shape
+     * check can reject lines without running the full parser.
+     */
+    static const int SHAPE_MATCH_COUNT = 3;
+
+    /**
+     * The number of consecutive misses before the format lock is dropped
+     * and discovery is re-run.
+     */
+    static const int MAX_SCAN_MISSES = 10;
+
     const char* scan(const char* time_src,
                      size_t time_len,
                      const char* const time_fmt[],
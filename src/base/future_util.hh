@@ -30,6 +30,7 @@
 #ifndef lnav_future_util_hh
 #define lnav_future_util_hh
 
+#include <chrono>
 #include <deque>
 #include <future>
 
@@ -75,8 +76,8 @@ public:
 
     /**
      * Add a future to the queue.  If the size of the queue is greater than the
-     * MAX_QUEUE_SIZE, this call will block waiting for the first queued
-     * future to return a result.
+     * MAX_QUEUE_SIZE, this call will block waiting for a queued future to
+     * return a result.
      *
      * @param f The future to add to the queue.
      */
@@ -87,17 +88,33 @@ public:
     }
 
     /**
-     * Removes the next future from the queue, waits for the result, and then
-     * repeats until the queue reaches the given size.
+     * Removes a future from the queue, waits for the result, and then
+     * repeats until the queue reaches the given size.  Futures that have
+     * already finished are taken first, so one slow future at the head of
+     * the queue does not hold up the results of faster ones behind it.
      *
      * @param size The new desired size of the queue.
      */
     void pop_to(size_t size = 0)
     {
         while (this->fq_deque.size() > size) {
-            auto v = this->fq_deque.front().get();
+            auto iter = this->fq_deque.begin();
+
+            for (auto probe = this->fq_deque.begin();
+                 probe != this->fq_deque.end();
+                 ++probe)
+            {
+                if (probe->wait_for(std::chrono::seconds(0))
+                    == std::future_status::ready)
+                {
+                    iter = probe;
+                    break;
+                }
+            }
+
+            auto v = iter->get();
             this->fq_processor(v);
-            this->fq_deque.pop_front();
+            this->fq_deque.erase(iter);
         }
     }
 
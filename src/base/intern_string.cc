@@ -40,23 +40,32 @@
 #include "xxHash/xxhash.h"
 
 const static int TABLE_SIZE = 4095;
+const static int SHARD_COUNT = 16;
+const static int LOOKUP_CACHE_SIZE = 256;
 
 struct intern_string::intern_table {
+    struct shard {
+        std::mutex s_mutex;
+        intern_string* s_buckets[TABLE_SIZE] = {};
+    };
+
     ~intern_table()
     {
-        for (auto is : this->it_table) {
-            auto curr = is;
+        for (auto& sh : this->it_shards) {
+            for (auto is : sh.s_buckets) {
+                auto curr = is;
 
-            while (curr != nullptr) {
-                auto next = curr->is_next;
+                while (curr != nullptr) {
+                    auto next = curr->is_next;
 
-                delete curr;
-                curr = next;
+                    delete curr;
+                    curr = next;
+                }
             }
         }
     }
 
-    intern_string* it_table[TABLE_SIZE];
+    shard it_shards[SHARD_COUNT];
 };
 
 intern_table_lifetime
@@ -76,36 +85,60 @@ hash_str(const char* str, size_t len)
 const intern_string*
 intern_string::lookup(const char* str, ssize_t len) noexcept
 {
+    // Recently interned strings are remembered per-thread so that the
+    // hot lookups during a scan (field names, levels, opids) do not
+    // need to touch a shard mutex at all.  Interned strings live until
+    // the table itself is torn down, so the cached pointers stay valid.
+    struct lookup_cache_entry {
+        unsigned long lce_hash{0};
+        const intern_string* lce_str{nullptr};
+    };
+    static thread_local lookup_cache_entry lookup_cache[LOOKUP_CACHE_SIZE];
+
     unsigned long h;
     intern_string* curr;
 
     if (len == -1) {
         len = strlen(str);
     }
-    h = hash_str(str, len) % TABLE_SIZE;
+    h = hash_str(str, len);
 
+    auto& cached = lookup_cache[h % LOOKUP_CACHE_SIZE];
+    if (cached.lce_str != nullptr && cached.lce_hash == h
+        && static_cast<ssize_t>(cached.lce_str->is_str.size()) == len
+        && strncmp(cached.lce_str->is_str.c_str(), str, len) == 0)
     {
-        static std::mutex table_mutex;
+        return cached.lce_str;
+    }
 
-        std::lock_guard<std::mutex> lk(table_mutex);
+    {
         auto tab = get_table_lifetime();
+        auto& sh = tab->it_shards[h % SHARD_COUNT];
+        auto bucket = (h / SHARD_COUNT) % TABLE_SIZE;
 
-        curr = tab->it_table[h];
+        std::lock_guard<std::mutex> lk(sh.s_mutex);
+
+        curr = sh.s_buckets[bucket];
         while (curr != nullptr) {
             if (static_cast<ssize_t>(curr->is_str.size()) == len
                 && strncmp(curr->is_str.c_str(), str, len) == 0)
             {
-                return curr;
+                break;
             }
             curr = curr->is_next;
         }
 
-        curr = new intern_string(str, len);
-        curr->is_next = tab->it_table[h];
-        tab->it_table[h] = curr;
-
-        return curr;
+        if (curr == nullptr) {
+            curr = new intern_string(str, len);
+            curr->is_next = sh.s_buckets[bucket];
+            sh.s_buckets[bucket] = curr;
+        }
     }
+
+    cached.lce_hash = h;
+    cached.lce_str = curr;
+
+    return curr;
 }
 
 const intern_string*
@@ -27,14 +27,38 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <array>
 #include <cctype>
 #include <iostream>
+#include <thread>
 
 #include "intern_string.hh"
 
 #include "config.h"
 #include "doctest/doctest.h"
 
+TEST_CASE("intern_string::lookup")
+{
+    auto tab = intern_string::get_table_lifetime();
+    std::array<const intern_string*, 4> results{};
+    std::vector<std::thread> threads;
+
+    for (size_t lpc = 0; lpc < results.size(); lpc++) {
+        threads.emplace_back([&results, lpc]() {
+            results[lpc] = intern_string::lookup("intern-lookup-test");
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+
+    for (const auto* is : results) {
+        CHECK(is == results[0]);
+    }
+    CHECK(intern_string::lookup("intern-lookup-test") == results[0]);
+    CHECK(intern_string::lookup("intern-lookup-other") != results[0]);
+}
+
 TEST_CASE("string_fragment::startswith")
 {
     std::string empty;
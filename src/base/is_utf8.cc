@@ -25,10 +25,76 @@
  * SUCH DAMAGE.
  */
 
+#include <string.h>
+
 #include "is_utf8.hh"
 
 #include "config.h"
 
+#if defined(HAVE_X86INTRIN_H) && defined(__SSE2__)
+#    include <x86intrin.h>
+#endif
+
+/**
+ * Advance over the plain-ASCII prefix of the buffer in blocks, stopping at
+ * the first byte that needs the scalar loop's attention: a non-ASCII byte,
+ * an escape character, or the line terminator.  This lets the common case of
+ * ASCII log data move a block at a time instead of byte-at-a-time while the
+ * scalar loop retains full responsibility for correctness at the stopping
+ * point.
+ */
+static inline ssize_t
+scan_ascii_prefix(const unsigned char* str,
+                  ssize_t i,
+                  ssize_t len,
+                  unsigned char term)
+{
+#if defined(HAVE_X86INTRIN_H) && defined(__SSE2__)
+    const auto esc_block = _mm_set1_epi8('\x1b');
+    const auto term_block = _mm_set1_epi8((char) term);
+
+    while (i + 16 <= len) {
+        auto block = _mm_loadu_si128((const __m128i*) &str[i]);
+        auto special = _mm_movemask_epi8(block)
+            | _mm_movemask_epi8(_mm_cmpeq_epi8(block, esc_block))
+            | _mm_movemask_epi8(_mm_cmpeq_epi8(block, term_block));
+
+        if (special != 0) {
+            i += __builtin_ctz(special);
+            return i;
+        }
+        i += 16;
+    }
+#else
+    constexpr uint64_t ONES = 0x0101010101010101ULL;
+    constexpr uint64_t HIGHS = 0x8080808080808080ULL;
+    const uint64_t esc_mask = ONES * (uint64_t) '\x1b';
+    const uint64_t term_mask = ONES * (uint64_t) term;
+
+    while (i + 8 <= (ssize_t) len) {
+        uint64_t word;
+
+        memcpy(&word, &str[i], sizeof(word));
+
+        auto esc_hit = (word ^ esc_mask);
+        auto term_hit = (word ^ term_mask);
+        auto special = (word & HIGHS)
+            | ((esc_hit - ONES) & ~esc_hit & HIGHS)
+            | ((term_hit - ONES) & ~term_hit & HIGHS);
+
+        if (special != 0) {
+            i += __builtin_ctzll(special) / 8;
+            return i;
+        }
+        i += 8;
+    }
+#endif
+    while (i < len && str[i] != '\x1b' && str[i] != term && str[i] <= 0x7f) {
+        i += 1;
+    }
+    return i;
+}
+
 /*
   Check if the given unsigned char * is a valid utf-8 sequence.
 
@@ -68,10 +134,16 @@ is_utf8(const unsigned char* str,
 {
     bool has_ansi = false;
     ssize_t i = 0;
+    const auto term_byte = terminator.value_or('\x1b');
 
     *message = nullptr;
     *faulty_bytes = 0;
     while (i < len) {
+        i = scan_ascii_prefix(str, i, (ssize_t) len, term_byte);
+        if (i >= (ssize_t) len) {
+            break;
+        }
+
         if (str[i] == '\x1b') {
             has_ansi = true;
         }
@@ -0,0 +1,102 @@
+/**
+ * Copyright (c) 2023, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+
+#include "is_utf8.hh"
+
+#include "config.h"
+#include "doctest/doctest.h"
+
+static utf8_scan_result
+scan(const std::string& str)
+{
+    const char* msg = nullptr;
+    int faulty_bytes = 0;
+
+    return is_utf8(
+        (const unsigned char*) str.data(), str.size(), &msg, &faulty_bytes, '\n');
+}
+
+TEST_CASE("is_utf8: ascii line")
+{
+    auto str = std::string(100, 'a') + "\n" + std::string(50, 'b');
+    auto res = scan(str);
+
+    CHECK(res.usr_end == 100);
+    CHECK(!res.usr_has_ansi);
+}
+
+TEST_CASE("is_utf8: ansi escape before terminator")
+{
+    auto str
+        = std::string(20, 'x') + "\x1b[31m" + std::string(20, 'y') + "\nzz";
+    auto res = scan(str);
+
+    CHECK(res.usr_has_ansi);
+    CHECK(str[res.usr_end] == '\n');
+}
+
+TEST_CASE("is_utf8: multi-byte sequence straddling blocks")
+{
+    auto str = std::string(30, 'm') + "\xc3\xa9" + std::string(30, 'n') + "\n";
+    auto res = scan(str);
+
+    CHECK(str[res.usr_end] == '\n');
+}
+
+TEST_CASE("is_utf8: invalid sequence")
+{
+    const char* msg = nullptr;
+    int faulty_bytes = 0;
+    auto str = std::string(17, 'q') + "\xc3\x28" + "\n";
+    auto res = is_utf8((const unsigned char*) str.data(),
+                       str.size(),
+                       &msg,
+                       &faulty_bytes,
+                       '\n');
+
+    CHECK(msg != nullptr);
+    CHECK(res.usr_end == 17);
+}
+
+TEST_CASE("is_utf8: no terminator present")
+{
+    const char* msg = nullptr;
+    int faulty_bytes = 0;
+    auto str = std::string(77, 'k');
+    auto res = is_utf8((const unsigned char*) str.data(),
+                       str.size(),
+                       &msg,
+                       &faulty_bytes,
+                       nonstd::nullopt);
+
+    CHECK(res.usr_end == -1);
+    CHECK(msg == nullptr);
+}
@@ -324,22 +324,41 @@ log_msg(lnav_log_level_t level,
 
     va_start(args, fmt);
     gettimeofday(&curr_time, nullptr);
-    localtime_r(&curr_time.tv_sec, &localtm);
+
+    // Most messages only land in the crash ring, where the cost of the
+    // append is dominated by formatting the timestamp.  The date/time
+    // part of the prefix only changes once a second, so it is cached
+    // and reused until the second rolls over.  (The cache is shared
+    // state, but we are under the log mutex here.)
+    static time_t last_sec = 0;
+    static char last_time_buf[32];
+    static ssize_t last_time_len = 0;
+
+    if (curr_time.tv_sec != last_sec || last_time_len == 0) {
+        localtime_r(&curr_time.tv_sec, &localtm);
+        last_time_len = snprintf(last_time_buf,
+                                 sizeof(last_time_buf),
+                                 "%4d-%02d-%02dT%02d:%02d:%02d",
+                                 localtm.tm_year + 1900,
+                                 localtm.tm_mon + 1,
+                                 localtm.tm_mday,
+                                 localtm.tm_hour,
+                                 localtm.tm_min,
+                                 localtm.tm_sec);
+        last_sec = curr_time.tv_sec;
+    }
+
     auto line = log_alloc();
-    prefix_size = snprintf(line,
-                           MAX_LOG_LINE_SIZE,
-                           "%4d-%02d-%02dT%02d:%02d:%02d.%03d %s t%u %s:%d ",
-                           localtm.tm_year + 1900,
-                           localtm.tm_mon + 1,
-                           localtm.tm_mday,
-                           localtm.tm_hour,
-                           localtm.tm_min,
-                           localtm.tm_sec,
-                           (int) (curr_time.tv_usec / 1000),
-                           LEVEL_NAMES[lnav::enums::to_underlying(level)],
-                           current_thid.t_id,
-                           src_file,
-                           line_number);
+    memcpy(line, last_time_buf, last_time_len);
+    prefix_size = last_time_len;
+    prefix_size += snprintf(&line[prefix_size],
+                            MAX_LOG_LINE_SIZE - prefix_size,
+                            ".%03d %s t%u %s:%d ",
+                            (int) (curr_time.tv_usec / 1000),
+                            LEVEL_NAMES[lnav::enums::to_underlying(level)],
+                            current_thid.t_id,
+                            src_file,
+                            line_number);
 #if 0
     if (!thread_log_prefix.empty()) {
         prefix_size += snprintf(
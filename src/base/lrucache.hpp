@@ -1,4 +1,4 @@
-/* 
+/*
  * File:   lrucache.hpp
  * Author: Alexander Ponomarev
  *
@@ -17,6 +17,12 @@
 
 namespace cache {
 
+/**
+ * An LRU cache with a segmented eviction policy.  New entries start out
+ * in a probationary segment and are only promoted to the protected
+ * segment when they are hit again, so a burst of one-shot keys can only
+ * churn the probationary half and cannot evict the frequently-used set.
+ */
 template<typename key_t, typename value_t>
 class lru_cache {
 public:
@@ -26,54 +32,102 @@ public:
 	lru_cache(size_t max_size) :
 		_max_size(max_size) {
 	}
-	
+
 	void put(const key_t& key, const value_t& value) {
 		auto it = _cache_items_map.find(key);
-		_cache_items_list.push_front(key_value_pair_t(key, value));
 		if (it != _cache_items_map.end()) {
-			_cache_items_list.erase(it->second);
-			_cache_items_map.erase(it);
-		}
-		_cache_items_map[key] = _cache_items_list.begin();
-		
-		if (_cache_items_map.size() > _max_size) {
-			auto last = _cache_items_list.end();
-			last--;
-			_cache_items_map.erase(last->first);
-			_cache_items_list.pop_back();
+			it->second.e_iter->second = value;
+			this->touch(it->second);
+			return;
 		}
+
+		_probationary_list.push_front(key_value_pair_t(key, value));
+		_cache_items_map[key] = entry_t{false, _probationary_list.begin()};
+		this->shrink_probationary();
 	}
-	
+
 	nonstd::optional<value_t> get(const key_t& key) {
 		auto it = _cache_items_map.find(key);
 		if (it == _cache_items_map.end()) {
 			return nonstd::nullopt;
 		}
 
-		_cache_items_list.splice(_cache_items_list.begin(), _cache_items_list, it->second);
-        return it->second->second;
+		this->touch(it->second);
+		return it->second.e_iter->second;
 	}
-	
+
 	bool exists(const key_t& key) const {
 		return _cache_items_map.find(key) != _cache_items_map.end();
 	}
-	
+
 	size_t size() const {
 		return _cache_items_map.size();
 	}
 
 	void set_max_size(size_t max_size) {
 	    this->_max_size = max_size;
+	    this->shrink_probationary();
 	}
 
 	void clear() {
 	    this->_cache_items_map.clear();
-	    this->_cache_items_list.clear();
+	    this->_probationary_list.clear();
+	    this->_protected_list.clear();
 	}
-	
+
 private:
-	std::list<key_value_pair_t> _cache_items_list;
-	std::map<key_t, list_iterator_t> _cache_items_map;
+	struct entry_t {
+		bool e_protected;
+		list_iterator_t e_iter;
+	};
+
+	size_t protected_capacity() const {
+		return _max_size / 2;
+	}
+
+	void touch(entry_t& entry) {
+		if (entry.e_protected) {
+			_protected_list.splice(
+				_protected_list.begin(), _protected_list, entry.e_iter);
+			return;
+		}
+		if (this->protected_capacity() == 0) {
+			// Too small to segment, fall back to plain LRU.
+			_probationary_list.splice(
+				_probationary_list.begin(), _probationary_list, entry.e_iter);
+			return;
+		}
+
+		_protected_list.splice(
+			_protected_list.begin(), _probationary_list, entry.e_iter);
+		entry.e_protected = true;
+
+		if (_protected_list.size() > this->protected_capacity()) {
+			// Demote the coldest protected entry instead of dropping it
+			// outright so it gets another chance in probation.
+			auto last = _protected_list.end();
+			last--;
+			auto demoted = _cache_items_map.find(last->first);
+			_probationary_list.splice(
+				_probationary_list.begin(), _protected_list, last);
+			demoted->second.e_protected = false;
+			this->shrink_probationary();
+		}
+	}
+
+	void shrink_probationary() {
+		while (_cache_items_map.size() > _max_size &&
+		       !_probationary_list.empty()) {
+			auto last = _probationary_list.end();
+			last--;
+			_cache_items_map.erase(last->first);
+			_probationary_list.pop_back();
+		}
+	}
+
+	std::list<key_value_pair_t> _probationary_list;
+	std::list<key_value_pair_t> _protected_list;
+	std::map<key_t, entry_t> _cache_items_map;
 	size_t _max_size;
 };
 
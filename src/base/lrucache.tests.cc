@@ -0,0 +1,86 @@
+/**
+ * Copyright (c) 2023, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string>
+
+#include "lrucache.hpp"
+
+#include "config.h"
+#include "doctest/doctest.h"
+
+TEST_CASE("lru_cache: basic put/get")
+{
+    cache::lru_cache<int, std::string> lc{4};
+
+    lc.put(1, "one");
+    lc.put(2, "two");
+
+    CHECK(lc.size() == 2);
+    CHECK(lc.get(1).value() == "one");
+    CHECK(lc.get(2).value() == "two");
+    CHECK(!lc.get(3).has_value());
+
+    lc.put(1, "uno");
+    CHECK(lc.size() == 2);
+    CHECK(lc.get(1).value() == "uno");
+}
+
+TEST_CASE("lru_cache: one-shot keys do not evict the hot set")
+{
+    cache::lru_cache<int, std::string> lc{4};
+
+    lc.put(1, "one");
+    lc.put(2, "two");
+    // Promote both entries to the protected segment.
+    CHECK(lc.get(1).has_value());
+    CHECK(lc.get(2).has_value());
+
+    // A scan of unrepeated keys can only churn the probationary half.
+    for (int lpc = 100; lpc < 120; lpc++) {
+        lc.put(lpc, "scan");
+    }
+
+    CHECK(lc.get(1).value() == "one");
+    CHECK(lc.get(2).value() == "two");
+    CHECK(lc.size() <= 4);
+}
+
+TEST_CASE("lru_cache: eviction still happens in order")
+{
+    cache::lru_cache<int, int> lc{2};
+
+    lc.put(1, 1);
+    lc.put(2, 2);
+    lc.put(3, 3);
+
+    CHECK(lc.size() == 2);
+    CHECK(!lc.get(1).has_value());
+    CHECK(lc.get(2).has_value());
+    CHECK(lc.get(3).has_value());
+}
@@ -167,6 +167,14 @@ utf8_char_to_byte_index(const std::string& str, ssize_t ch_index)
 {
     ssize_t retval = 0;
 
+    // ASCII characters are one byte each, so runs of them can be skipped
+    // without consulting the UTF-8 machinery.
+    while (ch_index > 0 && retval < (ssize_t) str.length()
+           && !(static_cast<unsigned char>(str[retval]) & 0x80))
+    {
+        retval += 1;
+        ch_index -= 1;
+    }
     while (ch_index > 0) {
         auto ch_len
             = ww898::utf::utf8::char_size([&str, retval]() {
@@ -190,6 +198,14 @@ utf8_string_length(const char* str, ssize_t len = -1)
     }
 
     for (ssize_t byte_index = 0; byte_index < len;) {
+        // Lines are overwhelmingly ASCII, which is one byte per
+        // character, so only run the decoder for multi-byte sequences.
+        if (!(static_cast<unsigned char>(str[byte_index]) & 0x80)) {
+            byte_index += 1;
+            retval += 1;
+            continue;
+        }
+
         auto ch_size
             = TRY(ww898::utf::utf8::char_size([str, len, byte_index]() {
                   return std::make_pair(str[byte_index], len - byte_index);
@@ -87,4 +87,24 @@ TEST_CASE("strnatcmp")
 
         CHECK(strnatcmp(strlen(n1), n1, strlen(n2), n2) < 0);
     }
+    {
+        // the common prefix ends inside a digit run with a leading
+        // zero, so the full runs must be compared fractionally
+        constexpr const char* n1 = "x010";
+        constexpr const char* n2 = "x02";
+
+        CHECK(strnatcmp(strlen(n1), n1, strlen(n2), n2) < 0);
+    }
+    {
+        constexpr const char* n1 = "access.log.9";
+        constexpr const char* n2 = "access.log.10";
+
+        CHECK(strnatcmp(strlen(n1), n1, strlen(n2), n2) < 0);
+    }
+    {
+        constexpr const char* n1 = "host12.example.com";
+        constexpr const char* n2 = "host12.example.com";
+
+        CHECK(strnatcmp(strlen(n1), n1, strlen(n2), n2) == 0);
+    }
 }
@@ -132,6 +132,24 @@ static int strnatcmp0(int a_len, nat_char const *a,
 
 	assert(a && b);
 	ai = bi = 0;
+
+	/* Fast path: skip the common prefix byte-wise, then back up to
+	   the start of any digit run in progress so the runs are still
+	   compared with natural-number semantics (e.g. "x010" vs "x02"
+	   must compare the full runs, not "10" vs "2").  Equal bytes
+	   fold and skip identically, so this is safe for the
+	   case-insensitive variant as well. */
+	{
+		int max_common = a_len < b_len ? a_len : b_len;
+		int ci = 0;
+
+		while (ci < max_common && a[ci] == b[ci])
+			ci++;
+		while (ci > 0 && nat_isdigit(a[ci - 1]))
+			ci--;
+		ai = bi = ci;
+	}
+
 	while (1) {
 		if (ai >= a_len)
 			ca = 0;
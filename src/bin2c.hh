@@ -45,18 +45,28 @@ struct bin_src_file {
                  const unsigned char* data,
                  size_t compressed_size,
                  size_t size)
-        : bsf_name(name), bsf_data(new unsigned char[size + 1]), bsf_size(size)
+        : bsf_name(name), bsf_compressed_data(data),
+          bsf_compressed_size(compressed_size), bsf_size(size)
     {
-        uLongf zsize = size;
-        auto rc
-            = uncompress(this->bsf_data.get(), &zsize, data, compressed_size);
-        assert(rc == Z_OK);
-        assert(zsize == size);
-        this->bsf_data[size] = '\0';
-    };
+    }
 
     string_fragment to_string_fragment() const
     {
+        // Decompress on first use so embedded files that are never
+        // touched in a session don't cost anything at startup.
+        if (!this->bsf_data) {
+            uLongf zsize = this->bsf_size;
+
+            this->bsf_data.reset(new unsigned char[this->bsf_size + 1]);
+            auto rc = uncompress(this->bsf_data.get(),
+                                 &zsize,
+                                 this->bsf_compressed_data,
+                                 this->bsf_compressed_size);
+            assert(rc == Z_OK);
+            assert(zsize == (uLongf) this->bsf_size);
+            (void) rc;
+            this->bsf_data[this->bsf_size] = '\0';
+        }
         return string_fragment{this->bsf_data.get(), 0, (int) this->bsf_size};
     }
 
@@ -67,7 +77,9 @@ struct bin_src_file {
 
 private:
     const char* bsf_name;
-    std::unique_ptr<unsigned char[]> bsf_data;
+    const unsigned char* bsf_compressed_data;
+    size_t bsf_compressed_size;
+    mutable std::unique_ptr<unsigned char[]> bsf_data;
     ssize_t bsf_size;
 };
 
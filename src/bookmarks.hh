@@ -90,12 +90,20 @@ public:
 
         require(vl >= 0);
 
-        auto lb = std::lower_bound(this->begin(), this->end(), vl);
-        if (lb == this->end() || *lb != vl) {
-            this->insert(lb, vl);
+        // Mass-marking (search hits, mark expressions, index rebuilds)
+        // visits lines in ascending order, so check for an append before
+        // falling back to the O(n) shuffle of a mid-vector insert.
+        if (this->empty() || this->back() < vl) {
+            this->push_back(vl);
             retval = this->end();
         } else {
-            retval = lb;
+            auto lb = std::lower_bound(this->begin(), this->end(), vl);
+            if (*lb != vl) {
+                this->insert(lb, vl);
+                retval = this->end();
+            } else {
+                retval = lb;
+            }
         }
 
         return retval;
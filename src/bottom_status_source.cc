@@ -29,8 +29,12 @@
 
 #include "bottom_status_source.hh"
 
+#include <stdio.h>
+#include <string.h>
+
 #include "base/snippet_highlighters.hh"
 #include "config.h"
+#include "perf_counters.hh"
 
 bottom_status_source::bottom_status_source()
 {
@@ -174,6 +178,45 @@ bottom_status_source::update_hits(textview_curses* tc)
     this->update_marks(tc);
 }
 
+bool
+bottom_status_source::update_rates()
+{
+    static const auto SAMPLE_PERIOD = std::chrono::milliseconds(500);
+
+    auto now = std::chrono::steady_clock::now();
+    const auto& counters = lnav::perf::get_counters();
+    auto bytes
+        = counters[(size_t) lnav::perf::counter_id::LINE_BUFFER_READ_BYTES]
+              .c_count.load(std::memory_order_relaxed);
+    auto lines = counters[(size_t) lnav::perf::counter_id::FORMAT_SCANS]
+                     .c_count.load(std::memory_order_relaxed);
+
+    if (this->bss_rate_sample_time
+        == std::chrono::steady_clock::time_point{}) {
+        this->bss_rate_sample_time = now;
+        this->bss_rate_sample_bytes = bytes;
+        this->bss_rate_sample_lines = lines;
+        return false;
+    }
+
+    auto elapsed = now - this->bss_rate_sample_time;
+    if (elapsed < SAMPLE_PERIOD) {
+        return false;
+    }
+
+    auto elapsed_us
+        = std::chrono::duration_cast<std::chrono::microseconds>(elapsed)
+              .count();
+    this->bss_rate_mb_per_sec
+        = (bytes - this->bss_rate_sample_bytes) / (double) elapsed_us;
+    this->bss_rate_lines_per_sec
+        = (lines - this->bss_rate_sample_lines) * 1000000.0 / elapsed_us;
+    this->bss_rate_sample_time = now;
+    this->bss_rate_sample_bytes = bytes;
+    this->bss_rate_sample_lines = lines;
+    return true;
+}
+
 void
 bottom_status_source::update_loading(file_off_t off, file_ssize_t total)
 {
@@ -185,6 +228,10 @@ bottom_status_source::update_loading(file_off_t off, file_ssize_t total)
     if (total == 0) {
         sf.set_cylon(false);
         sf.set_role(role_t::VCR_STATUS);
+        sf.set_width(13);
+        this->bss_rate_sample_time = {};
+        this->bss_rate_mb_per_sec = 0;
+        this->bss_rate_lines_per_sec = 0;
         if (this->bss_paused) {
             sf.set_value("\xE2\x80\x96 Paused");
         } else {
@@ -207,13 +254,29 @@ bottom_status_source::update_loading(file_off_t off, file_ssize_t total)
                      DOTS[this->bss_load_percent % DOTS.size()].c_str());
     } else {
         int pct = (int) (((double) off / (double) total) * 100.0);
+        auto rates_updated = this->update_rates();
 
-        if (this->bss_load_percent != pct) {
+        if (this->bss_load_percent != pct || rates_updated) {
             this->bss_load_percent = pct;
 
             sf.set_cylon(true);
             sf.set_role(role_t::VCR_ACTIVE_STATUS2);
-            sf.set_value(" Loading %2d%% ", pct);
+            if (this->bss_rate_mb_per_sec > 0
+                || this->bss_rate_lines_per_sec > 0)
+            {
+                char buffer[64];
+
+                snprintf(buffer,
+                         sizeof(buffer),
+                         " Loading %2d%% %.1fMB/s %.0f lines/s ",
+                         pct,
+                         this->bss_rate_mb_per_sec,
+                         this->bss_rate_lines_per_sec);
+                sf.set_width(strlen(buffer));
+                sf.set_value("%s", buffer);
+            } else {
+                sf.set_value(" Loading %2d%% ", pct);
+            }
         }
     }
 }
@@ -30,6 +30,7 @@
 #ifndef lnav_bottom_status_source_hh
 #define lnav_bottom_status_source_hh
 
+#include <chrono>
 #include <string>
 
 #include "grep_proc.hh"
@@ -85,10 +86,23 @@ private:
     status_field bss_prompt{1024, role_t::VCR_STATUS};
     status_field bss_error{1024, role_t::VCR_ALERT_STATUS};
     status_field bss_line_error{1024, role_t::VCR_ALERT_STATUS};
+    /**
+     * Samples the perf counters and refreshes the ingest rate gauges, if
+     * enough time has passed since the last sample.
+     *
+     * @return True if the rates were refreshed.
+     */
+    bool update_rates();
+
     status_field bss_fields[BSF__MAX];
     int bss_hit_spinner{0};
     int bss_load_percent{0};
     bool bss_paused{false};
+    std::chrono::steady_clock::time_point bss_rate_sample_time;
+    uint64_t bss_rate_sample_bytes{0};
+    uint64_t bss_rate_sample_lines{0};
+    double bss_rate_mb_per_sec{0};
+    double bss_rate_lines_per_sec{0};
 };
 
 #endif
@@ -59,6 +59,32 @@ breadcrumb_curses::do_update()
     size_t crumb_index = 0;
     size_t sel_crumb_offset = 0;
     auto width = static_cast<size_t>(getmaxx(this->bc_window));
+    auto cacheable = !this->bc_selected_crumb
+        && this->bc_focused_crumbs.empty() && this->bc_source_token;
+
+    if (cacheable) {
+        auto token = this->bc_source_token();
+
+        if (this->bc_last_source_token
+            && this->bc_last_source_token.value() == token)
+        {
+            // Nothing the crumbs are built from has changed, so redraw
+            // the rendered line instead of rebuilding the whole chain.
+            line_range cache_lr{0, static_cast<int>(width)};
+            view_curses::mvwattrline(this->bc_window,
+                                     this->bc_y,
+                                     0,
+                                     this->bc_rendered_line,
+                                     cache_lr,
+                                     role_t::VCR_STATUS);
+            view_curses::do_update();
+            return;
+        }
+        this->bc_last_source_token = token;
+    } else {
+        this->bc_last_source_token = nonstd::nullopt;
+    }
+
     auto crumbs = this->bc_focused_crumbs.empty() ? this->bc_line_source()
                                                   : this->bc_focused_crumbs;
     if (this->bc_last_selected_crumb
@@ -96,6 +122,10 @@ breadcrumb_curses::do_update()
         crumbs_line.append("\u276d"_breadcrumb);
     }
 
+    if (cacheable) {
+        this->bc_rendered_line = crumbs_line;
+    }
+
     line_range lr{0, static_cast<int>(width)};
     view_curses::mvwattrline(
         this->bc_window, this->bc_y, 0, crumbs_line, lr, role_t::VCR_STATUS);
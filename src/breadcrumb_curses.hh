@@ -61,6 +61,18 @@ public:
         this->bc_line_source = std::move(ls);
     }
 
+    /**
+     * Set a callback that fingerprints the state the crumb chain is
+     * built from (view, position, file generation).  While the token is
+     * unchanged and the bar is not focused, do_update() redraws the
+     * cached line instead of asking the line source to rebuild the
+     * chain, which it would otherwise do on every frame.
+     */
+    void set_source_token(std::function<size_t()> st)
+    {
+        this->bc_source_token = std::move(st);
+    }
+
     void focus();
     void blur();
 
@@ -91,6 +103,9 @@ private:
 
     WINDOW* bc_window{nullptr};
     std::function<std::vector<breadcrumb::crumb>()> bc_line_source;
+    std::function<size_t()> bc_source_token;
+    nonstd::optional<size_t> bc_last_source_token;
+    attr_line_t bc_rendered_line;
     int bc_y{0};
     std::vector<breadcrumb::crumb> bc_focused_crumbs;
     nonstd::optional<size_t> bc_selected_crumb;
@@ -27,6 +27,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <future>
+#include <map>
+#include <memory>
+#include <unordered_map>
 #include <vector>
 
 #include "command_executor.hh"
@@ -45,10 +49,13 @@
 #include "lnav_config.hh"
 #include "lnav_util.hh"
 #include "log_format_loader.hh"
+#include "log_vtab_impl.hh"
 #include "readline_highlighters.hh"
 #include "service_tags.hh"
 #include "shlex.hh"
 #include "sql_util.hh"
+#include "stall_watchdog.hh"
+#include "textview_curses.hh"
 #include "vtab_module.hh"
 #include "yajlpp/json_ptr.hh"
 
@@ -81,9 +88,28 @@ sql_progress(const struct log_cursor& lc)
         return 1;
     }
 
+    if (lnav_data.ld_sigint_pending) {
+        lnav_data.ld_sigint_pending = 0;
+        return 1;
+    }
+
     static sig_atomic_t sql_counter = 0;
+    static struct timeval last_poll = {0, 0};
+
+    struct timeval now;
+
+    gettimeofday(&now, nullptr);
+
+    auto poll_diff_us = (now.tv_sec - last_poll.tv_sec) * 1000000LL
+        + (now.tv_usec - last_poll.tv_usec);
 
-    if (ui_periodic_timer::singleton().time_to_update(sql_counter)) {
+    // Refresh on the regular status-bar tick, but also poll for input at
+    // least every 100ms so a CTRL+] cancel does not have to wait out the
+    // 350ms tick while a query has the main loop blocked.
+    if (ui_periodic_timer::singleton().time_to_update(sql_counter)
+        || poll_diff_us >= 100000)
+    {
+        last_poll = now;
         lnav_data.ld_bottom_source.update_loading(off, total);
         lnav_data.ld_status_refresher();
     }
@@ -109,37 +135,66 @@ static Result<std::string, lnav::console::user_message> execute_from_file(
     int line_number,
     const std::string& cmdline);
 
+/**
+ * A command line that has been tokenized and resolved to its handler so
+ * that replaying it, from a keymap binding or a script loop, skips the
+ * per-execution parsing.
+ */
+struct prepared_command {
+    readline_context::command_t* pc_cmd;
+    std::vector<std::string> pc_args;
+};
+
 Result<std::string, lnav::console::user_message>
 execute_command(exec_context& ec, const std::string& cmdline)
 {
-    std::vector<std::string> args;
+    // The command set is fixed after startup, so prepared commands never
+    // go stale; the cache is just bounded to keep a pathological script
+    // from growing it without limit.
+    constexpr size_t MAX_PREPARED_COMMANDS = 1024;
+    static std::unordered_map<std::string, prepared_command> prepared_cmds;
 
     log_info("Executing: %s", cmdline.c_str());
 
-    split_ws(cmdline, args);
+    auto cache_iter = prepared_cmds.find(cmdline);
+    if (cache_iter == prepared_cmds.end()) {
+        prepared_command pc;
 
-    if (!args.empty()) {
-        readline_context::command_map_t::iterator iter;
+        split_ws(cmdline, pc.pc_args);
 
-        if ((iter = lnav_commands.find(args[0])) == lnav_commands.end()) {
-            return ec.make_error("unknown command - {}", args[0]);
+        if (pc.pc_args.empty()) {
+            return ec.make_error("no command to execute");
         }
 
-        ec.ec_current_help = &iter->second->c_help;
-        auto retval = iter->second->c_func(ec, cmdline, args);
-        if (retval.isErr()) {
-            auto um = retval.unwrapErr();
+        auto cmd_iter = lnav_commands.find(pc.pc_args[0]);
+        if (cmd_iter == lnav_commands.end()) {
+            return ec.make_error("unknown command - {}", pc.pc_args[0]);
+        }
+        pc.pc_cmd = cmd_iter->second;
 
-            ec.add_error_context(um);
-            ec.ec_current_help = nullptr;
-            return Err(um);
+        if (prepared_cmds.size() >= MAX_PREPARED_COMMANDS) {
+            prepared_cmds.clear();
         }
-        ec.ec_current_help = nullptr;
+        cache_iter = prepared_cmds.emplace(cmdline, std::move(pc)).first;
+    }
+
+    const auto& pc = cache_iter->second;
+    // Command handlers can modify their argument vector, so they get a
+    // copy and the prepared form stays pristine.
+    auto args = pc.pc_args;
 
-        return retval;
+    ec.ec_current_help = &pc.pc_cmd->c_help;
+    auto retval = pc.pc_cmd->c_func(ec, cmdline, args);
+    if (retval.isErr()) {
+        auto um = retval.unwrapErr();
+
+        ec.add_error_context(um);
+        ec.ec_current_help = nullptr;
+        return Err(um);
     }
+    ec.ec_current_help = nullptr;
 
-    return ec.make_error("no command to execute");
+    return retval;
 }
 
 static Result<std::map<std::string, scoped_value_t>,
@@ -260,9 +315,98 @@ execute_search(const std::string& search_cmd)
     };
 }
 
+struct sql_result_cache_entry {
+    std::string ce_retval;
+    uint32_t ce_generation{0};
+};
+
+struct sql_result_cache {
+    static const size_t MAX_ENTRIES = 64;
+
+    std::map<std::string, sql_result_cache_entry> c_entries;
+    uint32_t c_hits{0};
+    uint32_t c_misses{0};
+};
+
+static sql_result_cache&
+get_sql_result_cache()
+{
+    static sql_result_cache retval;
+
+    return retval;
+}
+
+sql_cache_stats
+get_sql_result_cache_stats()
+{
+    const auto& cache = get_sql_result_cache();
+    sql_cache_stats retval;
+
+    retval.scs_entry_count = cache.c_entries.size();
+    retval.scs_hits = cache.c_hits;
+    retval.scs_misses = cache.c_misses;
+    return retval;
+}
+
+/**
+ * Functions whose results depend on UI state, the clock, or that have
+ * side effects can produce different results for the same SQL text, so
+ * statements that mention them cannot be served from the cache.  The
+ * check is a substring scan, which errs on the side of not caching.
+ */
+static bool
+is_cacheable_sql(const std::string& stmt_str)
+{
+    static const char* UNCACHEABLE_SUBSTRS[] = {
+        "random",
+        "now",
+        "echoln",
+        "raise_error",
+        "log_top",
+        "lnav_top_file",
+        nullptr,
+    };
+
+    auto lowered = tolower(stmt_str);
+
+    for (int lpc = 0; UNCACHEABLE_SUBSTRS[lpc] != nullptr; lpc++) {
+        if (lowered.find(UNCACHEABLE_SUBSTRS[lpc]) != std::string::npos) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Log the plan for a statement before it runs, so there is a record of
+ * what a long-running query was about to do.  The row estimates that the
+ * log vtabs report from xBestIndex feed into the plan details.
+ */
+static void
+log_query_plan(const char* sql)
+{
+    auto_mem<sqlite3_stmt> stmt(sqlite3_finalize);
+    auto explain_sql = fmt::format(FMT_STRING("EXPLAIN QUERY PLAN {}"), sql);
+
+    if (sqlite3_prepare_v2(lnav_data.ld_db.in(),
+                           explain_sql.c_str(),
+                           -1,
+                           stmt.out(),
+                           nullptr)
+        != SQLITE_OK)
+    {
+        return;
+    }
+
+    while (sqlite3_step(stmt.in()) == SQLITE_ROW) {
+        log_info("  query plan: %s", sqlite3_column_text(stmt.in(), 3));
+    }
+}
+
 Result<std::string, lnav::console::user_message>
 execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
 {
+    lnav::stalls::stage_guard sql_sg(lnav::stalls::STAGE_SQL);
     db_label_source& dls = lnav_data.ld_db_row_source;
     auto_mem<sqlite3_stmt> stmt(sqlite3_finalize);
     struct timeval start_tv, end_tv;
@@ -300,15 +444,43 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
 
     ec.ec_accumulator->clear();
 
+    // Scripts and pipes re-execute the same diagnostic queries many times
+    // in a session, so their accumulated results are cached keyed on the
+    // statement text and the log index generation.  Interactive queries
+    // populate the DB view and are not cached.
+    auto cacheable
+        = ec.ec_sql_callback != sql_callback && is_cacheable_sql(stmt_str);
+    if (cacheable) {
+        auto& res_cache = get_sql_result_cache();
+        auto cache_iter = res_cache.c_entries.find(stmt_str);
+
+        if (cache_iter != res_cache.c_entries.end()) {
+            if (cache_iter->second.ce_generation
+                == lnav_data.ld_log_source.lss_index_generation)
+            {
+                res_cache.c_hits += 1;
+                return Ok(cache_iter->second.ce_retval);
+            }
+            // The files behind the query have changed, invalidate.
+            res_cache.c_entries.erase(cache_iter);
+        }
+        res_cache.c_misses += 1;
+    }
+
     const auto& source = ec.ec_source.back();
     sql_progress_guard progress_guard(sql_progress,
                                       sql_progress_finished,
                                       source.s_location,
                                       source.s_content);
+    // Clear any cancel request left over from before this query started.
+    lnav_data.ld_sigint_pending = 0;
     gettimeofday(&start_tv, nullptr);
 
     const auto* curr_stmt = stmt_str.c_str();
     auto last_is_readonly = false;
+    auto all_readonly = true;
+
+    ec.ec_last_sql_readonly = false;
     while (curr_stmt != nullptr) {
         const char* tail = nullptr;
         while (isspace(*curr_stmt)) {
@@ -357,7 +529,19 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
 #endif
         bool done = false;
 
+        if (!last_is_readonly) {
+            cacheable = false;
+            all_readonly = false;
+        } else {
+            log_query_plan(curr_stmt);
+        }
+
         auto bound_values = TRY(bind_sql_parameters(ec, stmt.in()));
+        if (!bound_values.empty()) {
+            // Bound variables can change between executions of the same
+            // statement text.
+            cacheable = false;
+        }
         if (lnav_data.ld_rl_view != nullptr) {
             if (lnav_data.ld_rl_view) {
                 lnav_data.ld_rl_view->set_attr_value(
@@ -425,6 +609,8 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
         curr_stmt = tail;
     }
 
+    ec.ec_last_sql_readonly = all_readonly;
+
     if (lnav_data.ld_rl_view != nullptr) {
         lnav_data.ld_rl_view->clear_value();
     }
@@ -444,6 +630,19 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
             | lnav::itertools::for_each(&logfile::dump_stats);
         if (ec.ec_sql_callback != sql_callback) {
             retval = ec.ec_accumulator->get_string();
+            if (cacheable) {
+                auto& res_cache = get_sql_result_cache();
+
+                if (res_cache.c_entries.size()
+                    >= sql_result_cache::MAX_ENTRIES)
+                {
+                    res_cache.c_entries.clear();
+                }
+                res_cache.c_entries[stmt_str] = {
+                    retval,
+                    lnav_data.ld_log_source.lss_index_generation,
+                };
+            }
         } else if (!dls.dls_rows.empty()) {
             if (lnav_data.ld_flags & LNF_HEADLESS) {
                 if (ec.ec_local_vars.size() == 1) {
@@ -511,35 +710,108 @@ execute_sql(exec_context& ec, const std::string& sql, std::string& alt_msg)
     return Ok(retval);
 }
 
-static Result<std::string, lnav::console::user_message>
-execute_file_contents(exec_context& ec,
-                      const ghc::filesystem::path& path,
-                      bool multiline)
+Result<std::string, lnav::console::user_message>
+execute_parallel_query(exec_context& ec,
+                       const std::string& sql,
+                       std::string& alt_msg)
 {
-    static ghc::filesystem::path stdin_path("-");
-    static ghc::filesystem::path dev_stdin_path("/dev/stdin");
+    struct warmed_file {
+        std::shared_ptr<log_vtab_impl> wf_impl;
+        std::vector<std::pair<uint64_t, logline_value_vector>> wf_lines;
+    };
 
-    std::string retval;
-    FILE* file;
+    auto& lss = lnav_data.ld_log_source;
+    std::vector<std::future<warmed_file>> futures;
 
-    if (path == stdin_path || path == dev_stdin_path) {
-        if (isatty(STDIN_FILENO)) {
-            return ec.make_error("stdin has already been consumed");
+    // The expensive part of an analytic query is re-reading and re-parsing
+    // every message in xColumn, so do that up front with one task per file
+    // and let SQLite run the aggregation over the warmed extract caches.
+    // Each task only touches its own file and that file's specialized
+    // format instance, so they can run concurrently.
+    for (auto iter = lss.begin(); iter != lss.end(); ++iter) {
+        auto* lf = (*iter)->get_file_ptr();
+
+        if (lf == nullptr || lf->size() == 0) {
+            continue;
         }
-        file = stdin;
-    } else if ((file = fopen(path.c_str(), "r")) == nullptr) {
-        return ec.make_error("unable to open file");
+
+        auto vi = lnav_data.ld_vtab_manager->lookup_impl(
+            lf->get_format()->get_name());
+        if (vi == nullptr) {
+            continue;
+        }
+
+        auto base_cl = lss.get_file_base_content_line(iter);
+        futures.emplace_back(
+            std::async(std::launch::async, [lf, vi, base_cl]() {
+                warmed_file retval{vi};
+                auto format = lf->get_format();
+                string_attrs_t sa;
+
+                for (auto ll = lf->begin(); ll != lf->end(); ++ll) {
+                    if (!ll->is_message()) {
+                        continue;
+                    }
+
+                    auto line_number = static_cast<uint64_t>(
+                        std::distance(lf->begin(), ll));
+                    logline_value_vector values;
+
+                    lf->read_full_message(ll, values.lvv_sbr);
+                    values.lvv_sbr.erase_ansi();
+                    sa.clear();
+                    format->annotate(line_number, sa, values, false);
+                    retval.wf_lines.emplace_back(base_cl + line_number,
+                                                 std::move(values));
+                }
+
+                return retval;
+            }));
     }
 
+    for (auto& fut : futures) {
+        auto wf = fut.get();
+        auto& cache = wf.wf_impl->vi_extract_cache;
+
+        if (cache.ec_generation != lss.lss_index_generation) {
+            cache.ec_lines.clear();
+            cache.ec_generation = lss.lss_index_generation;
+        }
+        for (auto& warmed_pair : wf.wf_lines) {
+            if (cache.ec_lines.size()
+                >= log_vtab_impl::extract_cache::MAX_LINES)
+            {
+                break;
+            }
+            cache.ec_lines[warmed_pair.first] = std::move(warmed_pair.second);
+        }
+    }
+
+    return execute_sql(ec, sql, alt_msg);
+}
+
+/**
+ * A script file broken down into individually-executable commands.  The
+ * breakdown only depends on the file contents, so it is cached and reused
+ * across executions until the file changes on disk.
+ */
+struct compiled_script {
+    struct stat cs_stat {};
+    bool cs_multiline{true};
+    std::vector<std::pair<int, std::string>> cs_commands;
+};
+
+static compiled_script
+compile_script_file(FILE* file, bool multiline)
+{
+    compiled_script retval;
     int line_number = 0, starting_line_number = 0;
     auto_mem<char> line;
     size_t line_max_size;
-    ssize_t line_size;
     nonstd::optional<std::string> cmdline;
 
-    ec.ec_path_stack.emplace_back(path.parent_path());
-    exec_context::output_guard og(ec);
-    while ((line_size = getline(line.out(), &line_max_size, file)) != -1) {
+    retval.cs_multiline = multiline;
+    while (getline(line.out(), &line_max_size, file) != -1) {
         line_number += 1;
 
         if (trim(line.in()).empty()) {
@@ -558,8 +830,8 @@ execute_file_contents(exec_context& ec,
             case ';':
             case '|':
                 if (cmdline) {
-                    retval = TRY(execute_from_file(
-                        ec, path, starting_line_number, trim(cmdline.value())));
+                    retval.cs_commands.emplace_back(starting_line_number,
+                                                    trim(cmdline.value()));
                 }
 
                 starting_line_number = line_number;
@@ -569,25 +841,92 @@ execute_file_contents(exec_context& ec,
                 if (multiline) {
                     cmdline = fmt::format("{}{}", cmdline.value(), line);
                 } else {
-                    retval = TRY(execute_from_file(
-                        ec, path, line_number, fmt::format(":{}", line.in())));
+                    retval.cs_commands.emplace_back(
+                        line_number, fmt::format(":{}", line.in()));
                 }
                 break;
         }
     }
 
     if (cmdline) {
-        retval = TRY(execute_from_file(
-            ec, path, starting_line_number, trim(cmdline.value())));
+        retval.cs_commands.emplace_back(starting_line_number,
+                                        trim(cmdline.value()));
     }
 
-    if (file == stdin) {
+    return retval;
+}
+
+static Result<std::string, lnav::console::user_message>
+execute_file_contents(exec_context& ec,
+                      const ghc::filesystem::path& path,
+                      bool multiline)
+{
+    static ghc::filesystem::path stdin_path("-");
+    static ghc::filesystem::path dev_stdin_path("/dev/stdin");
+    static std::map<std::string, compiled_script> script_cache;
+    constexpr size_t MAX_CACHED_SCRIPTS = 32;
+
+    std::string retval;
+    std::vector<std::pair<int, std::string>> commands;
+    FILE* file;
+
+    if (path == stdin_path || path == dev_stdin_path) {
+        if (isatty(STDIN_FILENO)) {
+            return ec.make_error("stdin has already been consumed");
+        }
+        file = stdin;
+        commands = compile_script_file(file, multiline).cs_commands;
         if (isatty(STDOUT_FILENO)) {
             log_perror(dup2(STDOUT_FILENO, STDIN_FILENO));
         }
+    } else if ((file = fopen(path.c_str(), "r")) == nullptr) {
+        return ec.make_error("unable to open file");
     } else {
+        struct stat st;
+
+        log_perror(fstat(fileno(file), &st));
+        auto cache_iter = script_cache.find(path.string());
+        if (cache_iter != script_cache.end()
+            && cache_iter->second.cs_multiline == multiline
+            && cache_iter->second.cs_stat.st_mtime == st.st_mtime
+            && cache_iter->second.cs_stat.st_size == st.st_size)
+        {
+            commands = cache_iter->second.cs_commands;
+        } else {
+            if (script_cache.size() >= MAX_CACHED_SCRIPTS) {
+                script_cache.clear();
+            }
+
+            auto script = compile_script_file(file, multiline);
+            script.cs_stat = st;
+            commands = script.cs_commands;
+            script_cache[path.string()] = std::move(script);
+        }
         fclose(file);
     }
+
+    ec.ec_path_stack.emplace_back(path.parent_path());
+    exec_context::output_guard og(ec);
+
+    /*
+     * Batch up filter-change notifications while the script runs so that
+     * a block of consecutive filter commands costs a single re-scan of
+     * the files instead of one per command.
+     */
+    auto old_batch = ec.ec_batch_filter_changes;
+    ec.ec_batch_filter_changes = true;
+    auto batch_restore = finally([&ec, old_batch] {
+        ec.ec_batch_filter_changes = old_batch;
+        if (!old_batch) {
+            ec.flush_pending_filter_changes();
+        }
+    });
+
+    for (const auto& cmd_pair : commands) {
+        retval = TRY(
+            execute_from_file(ec, path, cmd_pair.first, cmd_pair.second));
+    }
+
     ec.ec_path_stack.pop_back();
 
     return Ok(retval);
@@ -686,6 +1025,32 @@ execute_file(exec_context& ec, const std::string& path_and_args, bool multiline)
     return Ok(retval);
 }
 
+static bool
+is_filter_stack_command(const std::string& cmdline)
+{
+    static const std::set<std::string> FILTER_STACK_COMMANDS = {
+        "filter-in",
+        "filter-out",
+        "enable-filter",
+        "disable-filter",
+        "delete-filter",
+    };
+
+    if (cmdline.empty() || cmdline[0] != ':') {
+        return false;
+    }
+
+    auto start = cmdline.find_first_not_of(" \t", 1);
+    if (start == std::string::npos) {
+        return false;
+    }
+    auto end = cmdline.find_first_of(" \t", start);
+
+    return FILTER_STACK_COMMANDS.count(cmdline.substr(
+               start, end == std::string::npos ? end : end - start))
+        > 0;
+}
+
 Result<std::string, lnav::console::user_message>
 execute_from_file(exec_context& ec,
                   const ghc::filesystem::path& path,
@@ -696,6 +1061,12 @@ execute_from_file(exec_context& ec,
     auto _sg = ec.enter_source(
         intern_string::lookup(path.string()), line_number, cmdline);
 
+    if (!is_filter_stack_command(cmdline)) {
+        // The upcoming command might depend on the filtered view, deliver
+        // any batched filter changes before running it.
+        ec.flush_pending_filter_changes();
+    }
+
     switch (cmdline[0]) {
         case ':':
             retval = TRY(execute_command(ec, cmdline.substr(1)));
@@ -827,8 +1198,13 @@ execute_init_commands(
                         break;
                 }
 
-                rescan_files();
-                rebuild_indexes_repeatedly();
+                // A batch of plain queries can share a single index
+                // build, so only rescan when the command could have
+                // changed the file set or the index.
+                if (cmd.at(0) != ';' || !ec.ec_last_sql_readonly) {
+                    rescan_files();
+                    rebuild_indexes_repeatedly();
+                }
             }
             if (dls.dls_rows.size() > 1) {
                 ensure_view(LNV_DB);
@@ -1117,6 +1493,25 @@ exec_context::enter_source(intern_string_t path,
     return {this};
 }
 
+void
+exec_context::filters_changed(text_sub_source* tss)
+{
+    if (this->ec_batch_filter_changes) {
+        this->ec_pending_filter_sources.insert(tss);
+    } else {
+        tss->text_filters_changed();
+    }
+}
+
+void
+exec_context::flush_pending_filter_changes()
+{
+    for (auto* tss : this->ec_pending_filter_sources) {
+        tss->text_filters_changed();
+    }
+    this->ec_pending_filter_sources.clear();
+}
+
 exec_context::output_guard::output_guard(exec_context& context,
                                          std::string name,
                                          const nonstd::optional<output_t>& file)
@@ -31,6 +31,7 @@
 #define LNAV_COMMAND_EXECUTOR_H
 
 #include <future>
+#include <set>
 #include <stack>
 #include <string>
 
@@ -50,6 +51,7 @@ struct exec_context;
 class attr_line_t;
 class logline_value;
 struct logline_value_vector;
+class text_sub_source;
 
 using sql_callback_t = int (*)(exec_context&, sqlite3_stmt*);
 int sql_callback(exec_context& ec, sqlite3_stmt* stmt);
@@ -155,6 +157,17 @@ struct exec_context {
                               int line_number,
                               const std::string& content);
 
+    /**
+     * Notify a sub-source that its filter stack changed.  While a script
+     * is executing, the notification is deferred until a command that
+     * depends on the filter results runs, so a block of consecutive
+     * filter commands triggers one re-scan instead of one per command.
+     */
+    void filters_changed(text_sub_source* tss);
+
+    /** Deliver any deferred filter-change notifications. */
+    void flush_pending_filter_changes();
+
     struct error_cb_guard {
         error_cb_guard(exec_context* context) : sg_context(context) {}
 
@@ -217,6 +230,16 @@ struct exec_context {
     vis_line_t ec_top_line{0_vl};
     bool ec_dry_run{false};
     perm_t ec_perms{perm_t::READ_WRITE};
+    bool ec_batch_filter_changes{false};
+    std::set<text_sub_source*> ec_pending_filter_sources;
+    /**
+     * True if the most recent SQL command consisted only of read-only
+     * statements.  The batch runner uses this to skip the file rescan
+     * and index rebuild between plain queries.  Without
+     * sqlite3_stmt_readonly() support this stays false, which is just
+     * conservative.
+     */
+    bool ec_last_sql_readonly{false};
 
     std::map<std::string, std::string> ec_override;
     logline_value_vector* ec_line_values;
@@ -241,6 +264,17 @@ Result<std::string, lnav::console::user_message> execute_command(
 
 Result<std::string, lnav::console::user_message> execute_sql(
     exec_context& ec, const std::string& sql, std::string& alt_msg);
+
+/** Counters for the session-scoped cache of SQL results. */
+struct sql_cache_stats {
+    size_t scs_entry_count{0};
+    uint32_t scs_hits{0};
+    uint32_t scs_misses{0};
+};
+
+sql_cache_stats get_sql_result_cache_stats();
+Result<std::string, lnav::console::user_message> execute_parallel_query(
+    exec_context& ec, const std::string& sql, std::string& alt_msg);
 Result<std::string, lnav::console::user_message> execute_file(
     exec_context& ec, const std::string& path_and_args, bool multiline = true);
 Result<std::string, lnav::console::user_message> execute_any(
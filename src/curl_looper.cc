@@ -125,6 +125,45 @@ struct curl_request_eq {
     const std::string& cre_name;
 };
 
+static std::mutex curl_share_mutexes[CURL_LOCK_DATA_LAST];
+
+static void
+curl_share_lock_cb(CURL* handle,
+                   curl_lock_data data,
+                   curl_lock_access access,
+                   void* userp)
+{
+    curl_share_mutexes[data].lock();
+}
+
+static void
+curl_share_unlock_cb(CURL* handle, curl_lock_data data, void* userp)
+{
+    curl_share_mutexes[data].unlock();
+}
+
+CURLSH*
+curl_request::get_shared_state()
+{
+    static CURLSH* retval = nullptr;
+    static std::once_flag retval_once;
+
+    // Requests are performed from the main thread as well as the looper
+    // thread, so the share handle needs the lock callbacks.
+    std::call_once(retval_once, []() {
+        retval = curl_share_init();
+        curl_share_setopt(retval, CURLSHOPT_LOCKFUNC, curl_share_lock_cb);
+        curl_share_setopt(retval, CURLSHOPT_UNLOCKFUNC, curl_share_unlock_cb);
+        curl_share_setopt(retval, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(retval, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+#    if CURL_AT_LEAST_VERSION(7, 57, 0)
+        curl_share_setopt(retval, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+#    endif
+    });
+
+    return retval;
+}
+
 int
 curl_request::debug_cb(
     CURL* handle, curl_infotype type, char* data, size_t size, void* userp)
@@ -79,6 +79,10 @@ public:
     {
         this->cr_handle.reset(curl_easy_init());
         curl_easy_setopt(this->cr_handle, CURLOPT_NOSIGNAL, 1);
+        // Share DNS lookups, TLS sessions, and connections across all
+        // requests so repeated fetches from the same origin do not pay
+        // for connection setup every time.
+        curl_easy_setopt(this->cr_handle, CURLOPT_SHARE, get_shared_state());
         curl_easy_setopt(
             this->cr_handle, CURLOPT_ERRORBUFFER, this->cr_error_buffer);
         curl_easy_setopt(this->cr_handle, CURLOPT_DEBUGFUNCTION, debug_cb);
@@ -168,6 +172,8 @@ public:
     }
 
 protected:
+    static CURLSH* get_shared_state();
+
     static int debug_cb(
         CURL* handle, curl_infotype type, char* data, size_t size, void* userp);
 
@@ -185,6 +191,12 @@ public:
     curl_looper() : cl_curl_multi(curl_multi_cleanup)
     {
         this->cl_curl_multi.reset(curl_multi_init());
+#    if CURL_AT_LEAST_VERSION(7, 43, 0)
+        // Let transfers to the same HTTP/2 origin ride on one connection
+        // instead of opening a connection per request.
+        curl_multi_setopt(
+            this->cl_curl_multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+#    endif
     }
 
     void process_all();
@@ -27,7 +27,11 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <future>
+#include <limits>
 #include <regex>
+#include <thread>
 
 #include "db_sub_source.hh"
 
@@ -107,11 +111,20 @@ db_label_source::text_attrs_for_line(textview_curses& tc,
         const auto& hm = this->dls_headers[lpc];
 
         if (hm.hm_graphable) {
-            auto num_scan_res = scn::scan_value<double>(row_view);
+            // Typed values captured at push time save re-parsing the cell,
+            // but graphable text columns still need the scan fallback.
+            auto cell_num = this->dls_rows[row].number_at(lpc);
 
-            if (num_scan_res) {
+            if (!cell_num) {
+                auto num_scan_res = scn::scan_value<double>(row_view);
+
+                if (num_scan_res) {
+                    cell_num = num_scan_res.value();
+                }
+            }
+            if (cell_num) {
                 this->dls_chart.chart_attrs_for_value(
-                    tc, left, hm.hm_name, num_scan_res.value(), sa);
+                    tc, left, hm.hm_name, cell_num.value(), sa);
             }
         }
         if (row_view.length() > 2 && row_view.length() < MAX_JSON_WIDTH
@@ -211,7 +224,33 @@ db_label_source::push_column(const scoped_value_t& sv)
         }
     }
 
-    this->dls_rows.back().push_back(col_sf.data());
+    auto& row = this->dls_rows.back();
+    if (row.rv_cells == nullptr) {
+        row.rv_cells = reinterpret_cast<const char**>(
+            this->dls_allocator->allocate(this->dls_headers.size()
+                                          * sizeof(const char*)));
+        auto has_numeric_col = std::any_of(
+            this->dls_headers.begin(),
+            this->dls_headers.end(),
+            [](const header_meta& lhm) {
+                return lhm.hm_column_type == SQLITE_INTEGER
+                    || lhm.hm_column_type == SQLITE_FLOAT || lhm.hm_graphable;
+            });
+        if (has_numeric_col) {
+            row.rv_numbers = reinterpret_cast<double*>(
+                this->dls_allocator->allocate(this->dls_headers.size()
+                                              * sizeof(double)));
+        }
+    }
+    if (row.rv_numbers != nullptr) {
+        row.rv_numbers[row.rv_size] = sv.match(
+            [](int64_t i) { return (double) i; },
+            [](double d) { return d; },
+            [](const auto&) {
+                return std::numeric_limits<double>::quiet_NaN();
+            });
+    }
+    row.rv_cells[row.rv_size++] = col_sf.data();
     hm.hm_column_size
         = std::max(this->dls_headers[index].hm_column_size,
                    (size_t) utf8_string_length(col_sf.data(), col_sf.length())
@@ -268,6 +307,100 @@ db_label_source::column_name_to_index(const std::string& name) const
     return this->dls_headers | lnav::itertools::find(name);
 }
 
+void
+db_label_source::sort_rows_by_column(size_t col_index, bool descending)
+{
+    const auto& hm = this->dls_headers[col_index];
+    auto numeric = hm.hm_column_type == SQLITE_INTEGER
+        || hm.hm_column_type == SQLITE_FLOAT;
+    auto comp = [col_index, numeric, descending](const row_values& lhs,
+                                                 const row_values& rhs) {
+        const auto* lhs_cell = lhs[col_index];
+        const auto* rhs_cell = rhs[col_index];
+        auto lhs_null = lhs_cell == NULL_STR;
+        auto rhs_null = rhs_cell == NULL_STR;
+        int rc;
+
+        if (lhs_null || rhs_null) {
+            // NULLs sort before everything else, like sqlite's ORDER BY.
+            rc = (lhs_null ? 0 : 1) - (rhs_null ? 0 : 1);
+        } else if (numeric) {
+            auto lhs_num = lhs.number_at(col_index);
+            auto rhs_num = rhs.number_at(col_index);
+            auto lhs_value
+                = lhs_num ? lhs_num.value() : strtod(lhs_cell, nullptr);
+            auto rhs_value
+                = rhs_num ? rhs_num.value() : strtod(rhs_cell, nullptr);
+
+            rc = lhs_value < rhs_value ? -1 : (rhs_value < lhs_value ? 1 : 0);
+        } else {
+            rc = strcmp(lhs_cell, rhs_cell);
+        }
+        return descending ? rc > 0 : rc < 0;
+    };
+
+    static const size_t PARALLEL_SORT_THRESHOLD = 64 * 1024;
+
+    auto row_count = this->dls_rows.size();
+    auto worker_count
+        = std::min((size_t) 4,
+                   (size_t) std::max(1U, std::thread::hardware_concurrency()));
+    if (worker_count == 1 || row_count < PARALLEL_SORT_THRESHOLD) {
+        std::stable_sort(this->dls_rows.begin(), this->dls_rows.end(), comp);
+    } else {
+        // Sort equal-sized runs concurrently, then merge pairs of sorted
+        // runs until one remains.  The rows are small structs pointing
+        // into the arena, so the moves are cheap and the comparisons
+        // dominate.
+        std::vector<size_t> bounds;
+
+        for (size_t lpc = 0; lpc <= worker_count; lpc++) {
+            bounds.push_back(lpc * row_count / worker_count);
+        }
+
+        std::vector<std::future<void>> workers;
+        for (size_t lpc = 0; lpc < worker_count; lpc++) {
+            auto first = this->dls_rows.begin() + bounds[lpc];
+            auto last = this->dls_rows.begin() + bounds[lpc + 1];
+
+            workers.emplace_back(
+                std::async(std::launch::async, [first, last, &comp]() {
+                    std::stable_sort(first, last, comp);
+                }));
+        }
+        for (auto& worker : workers) {
+            worker.get();
+        }
+
+        for (size_t width = 1; width < worker_count; width *= 2) {
+            std::vector<std::future<void>> merges;
+
+            for (size_t lpc = 0; lpc + width < worker_count; lpc += width * 2) {
+                auto first = this->dls_rows.begin() + bounds[lpc];
+                auto middle = this->dls_rows.begin() + bounds[lpc + width];
+                auto last = this->dls_rows.begin()
+                    + bounds[std::min(lpc + width * 2, worker_count)];
+
+                merges.emplace_back(std::async(
+                    std::launch::async, [first, middle, last, &comp]() {
+                        std::inplace_merge(first, middle, last, comp);
+                    }));
+            }
+            for (auto& merge : merges) {
+                merge.get();
+            }
+        }
+    }
+
+    if (this->dls_time_column_index != -1) {
+        // The rows are no longer in query order, so the mapping from
+        // times to rows does not hold anymore.
+        this->dls_time_column_invalidated_at = 0;
+        this->dls_time_column_index = -1;
+        this->dls_time_column.clear();
+    }
+}
+
 nonstd::optional<vis_line_t>
 db_label_source::row_for_time(struct timeval time_bucket)
 {
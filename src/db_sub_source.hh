@@ -30,6 +30,7 @@
 #ifndef db_sub_source_hh
 #define db_sub_source_hh
 
+#include <cmath>
 #include <iterator>
 #include <string>
 #include <vector>
@@ -86,6 +87,8 @@ public:
     nonstd::optional<size_t> column_name_to_index(
         const std::string& name) const;
 
+    void sort_rows_by_column(size_t col_index, bool descending);
+
     nonstd::optional<vis_line_t> row_for_time(
         struct timeval time_bucket) override;
 
@@ -114,9 +117,51 @@ public:
         text_attrs hm_title_attrs;
     };
 
+    /**
+     * The cell values for a result row.  The pointer array is carved out
+     * of dls_allocator, like the cell contents it points to, so a large
+     * result set does not pay a heap allocation per row and clear() can
+     * release everything by dropping the arena.
+     */
+    struct row_values {
+        size_t size() const { return this->rv_size; }
+
+        bool empty() const { return this->rv_size == 0; }
+
+        const char* operator[](size_t index) const
+        {
+            return this->rv_cells[index];
+        }
+
+        /**
+         * The typed value for a numeric cell, captured when the row was
+         * pushed so that sorting, charting, and the spectrogram view do
+         * not have to re-parse the display string on every pass.
+         */
+        nonstd::optional<double> number_at(size_t index) const
+        {
+            if (this->rv_numbers == nullptr
+                || std::isnan(this->rv_numbers[index]))
+            {
+                return nonstd::nullopt;
+            }
+            return this->rv_numbers[index];
+        }
+
+        const char** begin() const { return this->rv_cells; }
+
+        const char** end() const { return this->rv_cells + this->rv_size; }
+
+        const char** rv_cells{nullptr};
+        /** Parallel to rv_cells, only carved out for result sets with a
+         * numeric column; non-numeric cells hold NaN. */
+        double* rv_numbers{nullptr};
+        size_t rv_size{0};
+    };
+
     stacked_bar_chart<std::string> dls_chart;
     std::vector<header_meta> dls_headers;
-    std::vector<std::vector<const char*>> dls_rows;
+    std::vector<row_values> dls_rows;
     std::vector<struct timeval> dls_time_column;
     std::vector<size_t> dls_cell_width;
     int dls_time_column_index{-1};
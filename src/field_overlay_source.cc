@@ -49,14 +49,46 @@ field_overlay_source::build_field_lines(const listview_curses& lv)
     auto& lss = this->fos_lss;
     auto& vc = view_colors::singleton();
 
+    // Repaints arrive much more often than the inputs to the overlay
+    // change, so reuse the styled lines when the selection, view top,
+    // index, metadata, and context stack are all the same.  The "time
+    // ago" text tracks the wall clock, so the cache also expires every
+    // second.
+    auto build_time = time(nullptr);
+    if (!this->fos_lines.empty() || this->fos_last_selection != -1_vl) {
+        if (lv.get_selection() == this->fos_last_selection
+            && lv.get_top() == this->fos_last_top
+            && lss.lss_index_generation == this->fos_last_index_generation
+            && lss.text_metadata_generation()
+                == this->fos_last_meta_generation
+            && this->fos_contexts.size() == this->fos_last_context_count
+            && (this->fos_contexts.empty()
+                || this->fos_contexts.top().c_show
+                    == this->fos_last_context_show)
+            && build_time == this->fos_last_build_time)
+        {
+            return;
+        }
+    }
+
     this->fos_lines.clear();
 
     if (lss.text_line_count() == 0) {
         this->fos_log_helper.clear();
+        this->fos_last_selection = -1_vl;
 
         return;
     }
 
+    this->fos_last_selection = lv.get_selection();
+    this->fos_last_top = lv.get_top();
+    this->fos_last_index_generation = lss.lss_index_generation;
+    this->fos_last_meta_generation = lss.text_metadata_generation();
+    this->fos_last_context_count = this->fos_contexts.size();
+    this->fos_last_context_show
+        = this->fos_contexts.empty() ? false : this->fos_contexts.top().c_show;
+    this->fos_last_build_time = build_time;
+
     content_line_t cl = lss.at(lv.get_selection());
     std::shared_ptr<logfile> file = lss.find(cl);
     auto ll = file->begin() + cl;
@@ -81,6 +81,16 @@ public:
     std::vector<attr_line_t> fos_lines;
     vis_line_t fos_meta_lines_row{0_vl};
     std::vector<attr_line_t> fos_meta_lines;
+
+    /** State that fos_lines was last built from, so a repaint that does
+     * not change any of it can reuse the styled lines as-is. */
+    vis_line_t fos_last_selection{-1_vl};
+    vis_line_t fos_last_top{-1_vl};
+    uint32_t fos_last_index_generation{0};
+    size_t fos_last_meta_generation{0};
+    size_t fos_last_context_count{0};
+    bool fos_last_context_show{false};
+    time_t fos_last_build_time{0};
 };
 
 #endif  // LNAV_FIELD_OVERLAY_SOURCE_H
@@ -0,0 +1,151 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <map>
+
+#include "base/injector.bind.hh"
+#include "config.h"
+#include "lnav.hh"
+#include "log_format_ext.hh"
+#include "vtab_module.hh"
+
+struct lnav_field_stats : public tvt_iterator_cursor<lnav_field_stats> {
+    struct stats_row {
+        std::string sr_format;
+        std::string sr_field;
+        int64_t sr_count;
+        int64_t sr_distinct_estimate;
+        std::string sr_top_values;
+    };
+
+    using iterator = std::vector<stats_row>::iterator;
+
+    static constexpr const char* NAME = "lnav_field_stats";
+    static constexpr const char* CREATE_STMT = R"(
+-- Statistics sketches collected while indexing fields marked 'collect-stats'.
+CREATE TABLE lnav_field_stats (
+    format            TEXT,     -- The name of the log format.
+    field             TEXT,     -- The name of the field.
+    count             INTEGER,  -- The number of values seen for the field.
+    distinct_estimate INTEGER,  -- Estimated number of distinct values.
+    top_values        TEXT      -- The most frequent values and their counts.
+);
+)";
+
+    iterator begin()
+    {
+        std::map<std::pair<std::string, std::string>, logline_value_sketch>
+            merged;
+
+        this->fs_rows.clear();
+        for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+            auto format = std::dynamic_pointer_cast<external_log_format>(
+                lf->get_format());
+
+            if (format == nullptr) {
+                continue;
+            }
+            for (const auto& sketch : format->lf_value_sketches) {
+                if (sketch.lvk_count == 0) {
+                    continue;
+                }
+
+                auto key = std::make_pair(format->get_name().to_string(),
+                                          sketch.lvk_field.to_string());
+                auto iter = merged.find(key);
+
+                if (iter == merged.end()) {
+                    merged[key] = sketch;
+                } else {
+                    iter->second.merge(sketch);
+                }
+            }
+        }
+        for (const auto& pair : merged) {
+            const auto& sketch = pair.second;
+            auto sorted_topk = sketch.lvk_topk;
+
+            std::sort(sorted_topk.begin(),
+                      sorted_topk.end(),
+                      [](const auto& lhs, const auto& rhs) {
+                          return lhs.second > rhs.second;
+                      });
+
+            std::string top_values;
+            for (const auto& entry : sorted_topk) {
+                if (!top_values.empty()) {
+                    top_values.append(", ");
+                }
+                top_values.append(
+                    fmt::format(FMT_STRING("{} ({})"), entry.first, entry.second));
+            }
+            this->fs_rows.push_back(stats_row{
+                pair.first.first,
+                pair.first.second,
+                sketch.lvk_count,
+                sketch.estimate_cardinality(),
+                std::move(top_values),
+            });
+        }
+        return this->fs_rows.begin();
+    }
+
+    iterator end() { return this->fs_rows.end(); }
+
+    int get_column(cursor& vc, sqlite3_context* ctx, int col)
+    {
+        auto& sr = *vc.iter;
+
+        switch (col) {
+            case 0:
+                to_sqlite(ctx, sr.sr_format);
+                break;
+            case 1:
+                to_sqlite(ctx, sr.sr_field);
+                break;
+            case 2:
+                to_sqlite(ctx, sr.sr_count);
+                break;
+            case 3:
+                to_sqlite(ctx, sr.sr_distinct_estimate);
+                break;
+            case 4:
+                to_sqlite(ctx, sr.sr_top_values);
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+    std::vector<stats_row> fs_rows;
+};
+
+static auto field_stats_binder
+    = injector::bind_multiple<vtab_module_base>()
+          .add<vtab_module<tvt_no_update<lnav_field_stats>>>();
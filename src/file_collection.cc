@@ -189,27 +189,6 @@ file_collection::merge(file_collection& other)
     }
 }
 
-/**
- * Functor used to compare files based on their device and inode number.
- */
-struct same_file {
-    explicit same_file(const struct stat& stat) : sf_stat(stat){};
-
-    /**
-     * Compare the given log file against the 'stat' given in the constructor.
-     * @param  lf The log file to compare.
-     * @return    True if the dev/inode values in the stat given in the
-     *   constructor matches the stat in the logfile object.
-     */
-    bool operator()(const std::shared_ptr<logfile>& lf) const
-    {
-        return !lf->is_closed() && this->sf_stat.st_dev == lf->get_stat().st_dev
-            && this->sf_stat.st_ino == lf->get_stat().st_ino;
-    }
-
-    const struct stat& sf_stat;
-};
-
 /**
  * Try to load the given file as a log file.  If the file has not already been
  * loaded, it will be loaded.  If the file has already been loaded, the file
@@ -283,21 +262,15 @@ file_collection::watch_logfile(const std::string& filename,
         return lnav::futures::make_ready_future(std::move(retval));
     }
 
-    if (this->fc_new_stats | lnav::itertools::find_if([&st](const auto& elem) {
-            return st.st_ino == elem.st_ino && st.st_dev == elem.st_dev;
-        }))
-    {
+    if (!this->fc_new_stats.insert({st.st_dev, st.st_ino}).second) {
         // this file is probably a link that we have already scanned in this
         // pass.
         return lnav::futures::make_ready_future(std::move(retval));
     }
 
-    this->fc_new_stats.emplace_back(st);
-
-    auto file_iter = std::find_if(
-        this->fc_files.begin(), this->fc_files.end(), same_file(st));
+    auto file_iter = this->fc_files_by_ino.find({st.st_dev, st.st_ino});
 
-    if (file_iter == this->fc_files.end()) {
+    if (file_iter == this->fc_files_by_ino.end()) {
         if (this->fc_other_files.find(filename) != this->fc_other_files.end()) {
             return lnav::futures::make_ready_future(std::move(retval));
         }
@@ -380,9 +353,9 @@ file_collection::watch_logfile(const std::string& filename,
                 }
 
                 case file_format_t::ARCHIVE: {
-                    nonstd::optional<
+                    std::vector<
                         std::list<archive_manager::extract_progress>::iterator>
-                        prog_iter_opt;
+                        prog_iters;
 
                     if (loo2.loo_source == logfile_name_source::ARCHIVE) {
                         // Don't try to open nested archives
@@ -391,16 +364,18 @@ file_collection::watch_logfile(const std::string& filename,
 
                     auto res = archive_manager::walk_archive_files(
                         filename,
-                        [prog, &prog_iter_opt](const auto& path,
-                                               const auto total) {
+                        [prog, &prog_iters](const auto& path,
+                                            const auto total) {
+                            // The extraction workers call in here
+                            // concurrently, so the entries they are still
+                            // filling in cannot be erased until the walk
+                            // finishes.  The progress lock serializes
+                            // access to the iterator list as well.
                             safe::WriteAccess<safe_scan_progress> sp(*prog);
 
-                            prog_iter_opt | [&sp](auto prog_iter) {
-                                sp->sp_extractions.erase(prog_iter);
-                            };
                             auto prog_iter = sp->sp_extractions.emplace(
                                 sp->sp_extractions.begin(), path, total);
-                            prog_iter_opt = prog_iter;
+                            prog_iters.push_back(prog_iter);
 
                             return &(*prog_iter);
                         },
@@ -440,10 +415,11 @@ file_collection::watch_logfile(const std::string& filename,
                         retval.fc_other_files[filename] = ff;
                     }
                     {
-                        prog_iter_opt | [&prog](auto prog_iter) {
-                            prog->writeAccess()->sp_extractions.erase(
-                                prog_iter);
-                        };
+                        safe::WriteAccess<safe_scan_progress> sp(*prog);
+
+                        for (const auto& prog_iter : prog_iters) {
+                            sp->sp_extractions.erase(prog_iter);
+                        }
                     }
                     break;
                 }
@@ -471,7 +447,7 @@ file_collection::watch_logfile(const std::string& filename,
         return std::async(std::launch::async, std::move(func));
     }
 
-    auto lf = *file_iter;
+    auto lf = file_iter->second;
 
     if (lf->is_valid_filename() && lf->get_filename() != filename) {
         /* The file is already loaded, but has been found under a different
@@ -616,6 +592,17 @@ file_collection::rescan_files(bool required)
     lnav::futures::future_queue<file_collection> fq(
         [&retval](auto& fc) { retval.merge(fc); });
 
+    this->fc_files_by_ino.clear();
+    for (const auto& lf : this->fc_files) {
+        if (lf->is_closed()) {
+            continue;
+        }
+
+        const auto& lf_stat = lf->get_stat();
+
+        this->fc_files_by_ino[{lf_stat.st_dev, lf_stat.st_ino}] = lf;
+    }
+
     for (auto& pair : this->fc_file_names) {
         if (!pair.second.loo_temp_file) {
             this->expand_filename(fq, pair.first, pair.second, required);
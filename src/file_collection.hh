@@ -39,6 +39,8 @@
 #include <string>
 #include <utility>
 
+#include <sys/types.h>
+
 #include "archive_manager.hh"
 #include "base/future_util.hh"
 #include "file_format.hh"
@@ -138,7 +140,15 @@ struct file_collection {
     std::map<std::string, other_file_descriptor> fc_other_files;
     std::set<std::string> fc_synced_files;
     std::shared_ptr<safe_scan_progress> fc_progress;
-    std::vector<struct stat> fc_new_stats;
+    /** The device/inode pairs seen during the current rescan pass. */
+    std::set<std::pair<dev_t, ino_t>> fc_new_stats;
+    /**
+     * Index of open files by device/inode, rebuilt at the start of each
+     * rescan pass so watch_logfile() does not have to scan fc_files for
+     * every glob match.
+     */
+    std::map<std::pair<dev_t, ino_t>, std::shared_ptr<logfile>>
+        fc_files_by_ino;
     std::list<child_poller> fc_child_pollers;
     size_t fc_largest_path_length{0};
 
@@ -155,6 +165,7 @@ struct file_collection {
         this->fc_closed_files.clear();
         this->fc_other_files.clear();
         this->fc_new_stats.clear();
+        this->fc_files_by_ino.clear();
     }
 
     file_collection rescan_files(bool required = false);
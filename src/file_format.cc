@@ -29,8 +29,11 @@
  * @file file_format.hh
  */
 
+#include <algorithm>
 #include <unordered_map>
 
+#include <string.h>
+
 #include "file_format.hh"
 
 #include "archive_manager.hh"
@@ -89,28 +92,73 @@ is_pcap_header(uint8_t* buffer)
     return false;
 }
 
-file_format_t
-detect_file_format(const ghc::filesystem::path& filename)
+/**
+ * Check if the header bytes could belong to a format that libarchive
+ * handles.  This is a cheap pre-filter so that plain text files, the
+ * common case when opening a log directory, do not pay for a full
+ * libarchive open per file; false positives just fall through to the
+ * real check in archive_manager::is_archive().
+ */
+static bool
+is_possible_archive(const uint8_t* buffer, ssize_t len)
 {
-    if (archive_manager::is_archive(filename)) {
-        return file_format_t::ARCHIVE;
+    static const struct archive_magic {
+        size_t am_offset;
+        const char* am_bytes;
+        size_t am_len;
+    } MAGICS[] = {
+        {0, "\x1f\x8b", 2}, /* gzip */
+        {0, "\x1f\x9d", 2}, /* compress */
+        {0, "BZh", 3}, /* bzip2 */
+        {0, "\xfd" "7zXZ", 5}, /* xz */
+        {0, "\x28\xb5\x2f\xfd", 4}, /* zstd */
+        {0, "\x04\x22\x4d\x18", 4}, /* lz4 */
+        {0, "LZIP", 4}, /* lzip */
+        {0, "PK", 2}, /* zip */
+        {0, "7z\xbc\xaf", 4}, /* 7-zip */
+        {0, "!<arch>", 7}, /* ar */
+        {0, "070707", 6}, /* cpio */
+        {0, "\xc7\x71", 2}, /* cpio (binary) */
+        {257, "ustar", 5}, /* tar */
+    };
+
+    for (const auto& magic : MAGICS) {
+        if ((size_t) len >= magic.am_offset + magic.am_len
+            && memcmp(&buffer[magic.am_offset], magic.am_bytes, magic.am_len)
+                == 0)
+        {
+            return true;
+        }
     }
+    return false;
+}
 
+file_format_t
+detect_file_format(const ghc::filesystem::path& filename)
+{
     file_format_t retval = file_format_t::UNKNOWN;
     auto_fd fd;
 
     if ((fd = lnav::filesystem::openp(filename, O_RDONLY)) != -1) {
-        uint8_t buffer[32];
+        // A single read covers all of the header checks, including the
+        // tar magic at offset 257, instead of libarchive doing its own
+        // open-and-read for every file in the directory.
+        uint8_t buffer[512];
         ssize_t rc;
 
         if ((rc = read(fd, buffer, sizeof(buffer))) > 0) {
             static auto SQLITE3_HEADER = "SQLite format 3";
-            auto header_frag = string_fragment(buffer, 0, rc);
+            auto header_frag = string_fragment(
+                buffer, 0, std::min(rc, (ssize_t) 32));
 
             if (header_frag.startswith(SQLITE3_HEADER)) {
                 retval = file_format_t::SQLITE_DB;
             } else if (rc > 24 && is_pcap_header(buffer)) {
                 retval = file_format_t::PCAP;
+            } else if (is_possible_archive(buffer, rc)
+                       && archive_manager::is_archive(filename))
+            {
+                retval = file_format_t::ARCHIVE;
             }
         }
     }
@@ -214,6 +214,7 @@ CREATE TABLE lnav_file (
 
                 init_session();
                 load_session();
+                load_time_bookmarks();
             }
         }
 
@@ -327,6 +328,110 @@ CREATE TABLE lnav_file_metadata (
     file_collection& lfm_collection;
 };
 
+struct lnav_log_summary {
+    static constexpr const char* NAME = "lnav_log_summary";
+    static constexpr const char* CREATE_STMT = R"(
+-- Access the message counts maintained while files are indexed.
+CREATE TABLE lnav_log_summary (
+    filepath text,   -- The path to the log file.
+    log_level text,  -- The message level.
+    lines integer    -- The number of messages with this level in the file.
+);
+)";
+
+    struct cursor {
+        struct summary_row {
+            summary_row(std::shared_ptr<logfile> lf,
+                        log_level_t level,
+                        int64_t lines)
+                : sr_logfile(std::move(lf)), sr_level(level), sr_lines(lines)
+            {
+            }
+            std::shared_ptr<logfile> sr_logfile;
+            log_level_t sr_level;
+            int64_t sr_lines;
+        };
+
+        sqlite3_vtab_cursor base;
+        lnav_log_summary& c_summary;
+        std::vector<summary_row>::iterator c_iter;
+        std::vector<summary_row> c_rows;
+
+        cursor(sqlite3_vtab* vt)
+            : base({vt}),
+              c_summary(((vtab_module<lnav_log_summary>::vtab*) vt)->v_impl)
+        {
+            for (auto& lf : this->c_summary.lls_collection.fc_files) {
+                if (lf->get_format() == nullptr) {
+                    continue;
+                }
+
+                const auto& stats = lf->get_level_stats();
+
+                for (int lpc = 0; lpc < LEVEL__MAX; lpc++) {
+                    if (stats[lpc] == 0) {
+                        continue;
+                    }
+
+                    this->c_rows.emplace_back(
+                        lf, static_cast<log_level_t>(lpc), stats[lpc]);
+                }
+            }
+        }
+
+        ~cursor() { this->c_iter = this->c_rows.end(); }
+
+        int next()
+        {
+            if (this->c_iter != this->c_rows.end()) {
+                ++this->c_iter;
+            }
+            return SQLITE_OK;
+        }
+
+        int eof() { return this->c_iter == this->c_rows.end(); }
+
+        int reset()
+        {
+            this->c_iter = this->c_rows.begin();
+            return SQLITE_OK;
+        }
+
+        int get_rowid(sqlite3_int64& rowid_out)
+        {
+            rowid_out = this->c_iter - this->c_rows.begin();
+
+            return SQLITE_OK;
+        }
+    };
+
+    explicit lnav_log_summary(file_collection& fc) : lls_collection(fc) {}
+
+    int get_column(const cursor& vc, sqlite3_context* ctx, int col)
+    {
+        auto& sr = *vc.c_iter;
+
+        switch (col) {
+            case 0:
+                to_sqlite(ctx, sr.sr_logfile->get_filename());
+                break;
+            case 1:
+                to_sqlite(ctx, level_names[sr.sr_level]);
+                break;
+            case 2:
+                to_sqlite(ctx, sr.sr_lines);
+                break;
+            default:
+                ensure(0);
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+    file_collection& lls_collection;
+};
+
 struct injectable_lnav_file : vtab_module<lnav_file> {
     using vtab_module<lnav_file>::vtab_module;
     using injectable = injectable_lnav_file(file_collection&);
@@ -341,5 +446,14 @@ struct injectable_lnav_file_metadata
 static auto file_binder
     = injector::bind_multiple<vtab_module_base>().add<injectable_lnav_file>();
 
+struct injectable_lnav_log_summary
+    : vtab_module<tvt_no_update<lnav_log_summary>> {
+    using vtab_module<tvt_no_update<lnav_log_summary>>::vtab_module;
+    using injectable = injectable_lnav_log_summary(file_collection&);
+};
+
 static auto file_meta_binder = injector::bind_multiple<vtab_module_base>()
                                    .add<injectable_lnav_file_metadata>();
+
+static auto log_summary_binder = injector::bind_multiple<vtab_module_base>()
+                                     .add<injectable_lnav_log_summary>();
@@ -31,6 +31,7 @@
 
 #include "config.h"
 #include "log_format.hh"
+#include "perf_counters.hh"
 
 void
 line_filter_observer::logline_new_lines(const logfile& lf,
@@ -47,10 +48,16 @@ line_filter_observer::logline_new_lines(const logfile& lf,
         return;
     }
 
-    for (; ll_begin != ll_end; ++ll_begin) {
+    size_t line_index = offset;
+
+    for (; ll_begin != ll_end; ++ll_begin, ++line_index) {
         if (lf.get_format() != nullptr) {
             lf.get_format()->get_subline(*ll_begin, sbr);
         }
+        if (line_index >= this->lfo_filter_state.tfs_sketched_lines) {
+            this->lfo_filter_state.sketch_line(
+                line_index, sbr.get_data(), sbr.length());
+        }
         for (auto& filter : this->lfo_filter_stack) {
             if (filter->lf_deleted) {
                 continue;
@@ -58,6 +65,7 @@ line_filter_observer::logline_new_lines(const logfile& lf,
             if (offset
                 >= this->lfo_filter_state.tfs_filter_count[filter->get_index()])
             {
+                lnav::perf::count(lnav::perf::counter_id::FILTER_EVALS);
                 filter->add_line(this->lfo_filter_state, ll_begin, sbr);
             }
         }
@@ -109,3 +117,16 @@ line_filter_observer::clear_deleted_filter_state()
     }
     this->lfo_filter_state.clear_deleted_filter_state(used_mask);
 }
+
+void
+line_filter_observer::restart_edited_filter_state()
+{
+    for (auto& filter : this->lfo_filter_stack) {
+        if (filter->lf_deleted
+            || filter->lf_edit_delta == text_filter::edit_delta_t::NONE)
+        {
+            continue;
+        }
+        this->lfo_filter_state.restart_filter_state(filter->get_index());
+    }
+}
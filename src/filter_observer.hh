@@ -47,6 +47,11 @@ public:
         for (auto& filter : this->lfo_filter_stack) {
             filter->revert_to_last(this->lfo_filter_state, rollback_size);
         }
+        // The rolled-back lines will be re-delivered with new content, so
+        // they need to be sketched again.  Their old trigrams linger in
+        // the chunk sketch, which only costs false positives.
+        auto& sketched = this->lfo_filter_state.tfs_sketched_lines;
+        sketched -= std::min(sketched, (size_t) rollback_size);
     }
 
     void logline_new_lines(const logfile& lf,
@@ -71,6 +76,8 @@ public:
 
     void clear_deleted_filter_state();
 
+    void restart_edited_filter_state();
+
     filter_stack& lfo_filter_stack;
     logfile_filter_state lfo_filter_state;
 };
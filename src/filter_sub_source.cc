@@ -32,6 +32,7 @@
 #include "base/enum_util.hh"
 #include "base/func_util.hh"
 #include "base/opt_util.hh"
+#include "base/string_util.hh"
 #include "config.h"
 #include "lnav.hh"
 #include "readline_highlighters.hh"
@@ -174,7 +175,7 @@ filter_sub_source::list_input_handle_key(listview_curses& lv, int ch)
             this->fss_editor->set_visible(true);
             this->fss_editor->set_y(
                 lv.get_y() + (int) (lv.get_selection() - lv.get_top()));
-            this->fss_editor->set_left(25);
+            this->fss_editor->set_left(35);
             this->fss_editor->set_width(this->tss_view->get_width() - 8 - 1);
             this->fss_editor->focus(filter_lang_t::REGEX, "", "");
             this->fss_filter_state = true;
@@ -210,7 +211,7 @@ filter_sub_source::list_input_handle_key(listview_curses& lv, int ch)
             this->fss_editor->set_visible(true);
             this->fss_editor->set_y(
                 lv.get_y() + (int) (lv.get_selection() - lv.get_top()));
-            this->fss_editor->set_left(25);
+            this->fss_editor->set_left(35);
             this->fss_editor->set_width(this->tss_view->get_width() - 8 - 1);
             this->fss_editor->focus(filter_lang_t::REGEX, "", "");
             this->fss_filter_state = true;
@@ -244,7 +245,7 @@ filter_sub_source::list_input_handle_key(listview_curses& lv, int ch)
             this->fss_editor->set_visible(true);
             this->fss_editor->set_y(
                 lv.get_y() + (int) (lv.get_selection() - lv.get_top()));
-            this->fss_editor->set_left(25);
+            this->fss_editor->set_left(35);
             this->fss_editor->set_width(this->tss_view->get_width() - 8 - 1);
             this->fss_editor->focus(tf->get_lang(), "");
             this->fss_editor->rewrite_line(0, tf->get_id().c_str());
@@ -330,12 +331,24 @@ filter_sub_source::text_value_for_line(textview_curses& tc,
     }
 
     if (this->fss_editing && line == tc.get_selection()) {
-        fmt::format_to(
-            std::back_inserter(value_out), FMT_STRING("{:>9} hits | "), "-");
+        fmt::format_to(std::back_inserter(value_out),
+                       FMT_STRING("{:>9} hits | {:>7} | "),
+                       "-",
+                       "-");
     } else {
         fmt::format_to(std::back_inserter(value_out),
                        FMT_STRING("{:>9L} hits | "),
                        tss->get_filtered_count_for(tf->get_index()));
+        if (tf->lf_eval_time_samples == 0) {
+            fmt::format_to(
+                std::back_inserter(value_out), FMT_STRING("{:>7} | "), "-");
+        } else {
+            // The sampled evaluation times give a rough per-line cost so
+            // an expensive pattern stands out in the list.
+            fmt::format_to(std::back_inserter(value_out),
+                           FMT_STRING("{:>5}us | "),
+                           tf->lf_eval_time_us / tf->lf_eval_time_samples);
+        }
     }
 
     value_out.append(tf->get_id());
@@ -379,6 +392,7 @@ filter_sub_source::text_attrs_for_line(textview_curses& tc,
     value_out.emplace_back(line_range{8, 17},
                            VC_STYLE.value(text_attrs{A_BOLD}));
     value_out.emplace_back(line_range{23, 24}, VC_GRAPHIC.value(ACS_VLINE));
+    value_out.emplace_back(line_range{33, 34}, VC_GRAPHIC.value(ACS_VLINE));
 
     attr_line_t content{tf->get_id()};
     auto& content_attrs = content.get_attrs();
@@ -394,7 +408,7 @@ filter_sub_source::text_attrs_for_line(textview_curses& tc,
             break;
     }
 
-    shift_string_attrs(content_attrs, 0, 25);
+    shift_string_attrs(content_attrs, 0, 35);
     value_out.insert(
         value_out.end(), content_attrs.begin(), content_attrs.end());
 }
@@ -494,6 +508,37 @@ filter_sub_source::rl_change(readline_curses* rc)
     }
 }
 
+/**
+ * Figure out how an edited pattern's match set relates to the pattern it
+ * replaces.  The proof is limited to plain literals (no regex
+ * metacharacters), compared caselessly since the filters are compiled
+ * with PCRE2_CASELESS: appending/prepending text to a literal can only
+ * narrow the match set and removing text can only widen it.
+ */
+static text_filter::edit_delta_t
+relation_to_replaced(const std::string& old_value, const std::string& new_value)
+{
+    static const char* REGEX_METAS = "\\^$.[]()|*+?{}";
+
+    if (old_value.empty()
+        || old_value.find_first_of(REGEX_METAS) != std::string::npos
+        || new_value.find_first_of(REGEX_METAS) != std::string::npos)
+    {
+        return text_filter::edit_delta_t::NONE;
+    }
+
+    auto old_lower = tolower(old_value);
+    auto new_lower = tolower(new_value);
+
+    if (new_lower.find(old_lower) != std::string::npos) {
+        return text_filter::edit_delta_t::NARROWED;
+    }
+    if (old_lower.find(new_lower) != std::string::npos) {
+        return text_filter::edit_delta_t::WIDENED;
+    }
+    return text_filter::edit_delta_t::NONE;
+}
+
 void
 filter_sub_source::rl_perform(readline_curses* rc)
 {
@@ -524,17 +569,27 @@ filter_sub_source::rl_perform(readline_curses* rc)
                         um);
                     this->rl_abort(rc);
                 } else {
-                    tf->lf_deleted = true;
-                    tss->text_filters_changed();
-
                     auto pf = std::make_shared<pcre_filter>(
                         tf->get_type(),
                         new_value,
                         tf->get_index(),
                         compile_res.unwrap().to_shared());
-
-                    *iter = pf;
-                    tss->text_filters_changed();
+                    auto delta = relation_to_replaced(tf->get_id(), new_value);
+
+                    if (delta != text_filter::edit_delta_t::NONE) {
+                        // Swap the filter in place so the old result bits
+                        // are carried over and used to skip evaluations
+                        // during the re-scan.
+                        pf->lf_edit_delta = delta;
+                        *iter = pf;
+                        tss->text_filters_changed();
+                    } else {
+                        tf->lf_deleted = true;
+                        tss->text_filters_changed();
+
+                        *iter = pf;
+                        tss->text_filters_changed();
+                    }
                 }
                 break;
             }
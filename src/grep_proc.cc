@@ -29,6 +29,10 @@
  * @file grep_proc.cc
  */
 
+#include <future>
+#include <memory>
+#include <vector>
+
 #include "grep_proc.hh"
 
 #include <errno.h>
@@ -40,10 +44,12 @@
 #include <unistd.h>
 
 #include "base/auto_pid.hh"
+#include "base/future_util.hh"
 #include "base/lnav_log.hh"
 #include "base/opt_util.hh"
 #include "base/string_util.hh"
 #include "config.h"
+#include "fmt/format.h"
 #include "lnav_util.hh"
 #include "vis_line.hh"
 
@@ -164,6 +170,10 @@ template<typename LineType>
 void
 grep_proc<LineType>::child_loop()
 {
+    static const size_t CHUNK_SIZE = 1024;
+
+    using line_chunk = std::vector<std::pair<LineType, std::string>>;
+
     char outbuf[BUFSIZ * 2];
     std::string line_value;
 
@@ -174,12 +184,62 @@ grep_proc<LineType>::child_loop()
     lnav_log_file
         = make_optional_from_nullable(fopen("/tmp/lnav.grep.err", "a"));
     line_value.reserve(BUFSIZ * 2);
+
+    // Run the regex over a chunk of lines, producing the same stream of
+    // text that used to be fprintf'd directly to the parent.  This runs
+    // on a worker thread, so it can only touch the compiled pattern (which
+    // is safe to share) and its own match data.
+    auto match_chunk = [this](std::shared_ptr<line_chunk> chunk) {
+        std::string retval;
+
+        for (const auto& line_pair : *chunk) {
+            this->gp_pcre->capture_from(line_pair.second)
+                .for_each([&](lnav::pcre2pp::match_data& md) {
+                    if (md.leading().sf_begin == 0) {
+                        fmt::format_to(std::back_inserter(retval),
+                                       FMT_STRING("{}\n"),
+                                       (int) line_pair.first);
+                    }
+                    fmt::format_to(std::back_inserter(retval),
+                                   FMT_STRING("[{}:{}]\n"),
+                                   md[0]->sf_begin,
+                                   md[0]->sf_end);
+                    for (int lpc = 1; lpc < md.get_count(); lpc++) {
+                        if (!md[lpc]) {
+                            continue;
+                        }
+                        fmt::format_to(std::back_inserter(retval),
+                                       FMT_STRING("({}:{})"),
+                                       md[lpc]->sf_begin,
+                                       md[lpc]->sf_end);
+                        retval.append(md[lpc]->data(), md[lpc]->length());
+                        retval.push_back('\n');
+                    }
+                    retval.append("/\n");
+                });
+        }
+
+        return retval;
+    };
+
     while (!this->gp_queue.empty()) {
         LineType start_line = this->gp_queue.front().first;
         LineType stop_line = this->gp_queue.front().second;
         bool done = false;
         LineType line;
 
+        // Reading lines from the source has to stay on this thread, but
+        // the regex matching is sharded out to a pool of workers.  The
+        // future_queue pops results in FIFO order, so matches are still
+        // delivered to the parent in line order.
+        lnav::futures::future_queue<std::string> chunk_results(
+            [this](std::string& out) {
+                fwrite(out.data(), 1, out.size(), stdout);
+                /* Flush the buffer so the parent sees progress */
+                this->child_batch();
+            });
+        auto chunk = std::make_shared<line_chunk>();
+
         this->gp_queue.pop_front();
         for (line = this->gp_source.grep_initial_line(start_line,
                                                       this->gp_highest_line);
@@ -189,37 +249,20 @@ grep_proc<LineType>::child_loop()
             line_value.clear();
             done = !this->gp_source.grep_value_for_line(line, line_value);
             if (!done) {
-                this->gp_pcre->capture_from(line_value)
-                    .for_each([&](lnav::pcre2pp::match_data& md) {
-                        if (md.leading().sf_begin == 0) {
-                            fprintf(stdout, "%d\n", (int) line);
-                        }
-                        fprintf(stdout,
-                                "[%d:%d]\n",
-                                md[0]->sf_begin,
-                                md[0]->sf_end);
-                        for (int lpc = 1; lpc < md.get_count(); lpc++) {
-                            if (!md[lpc]) {
-                                continue;
-                            }
-                            fprintf(stdout,
-                                    "(%d:%d)",
-                                    md[lpc]->sf_begin,
-                                    md[lpc]->sf_end);
-
-                            fwrite(
-                                md[lpc]->data(), 1, md[lpc]->length(), stdout);
-                            fputc('\n', stdout);
-                        }
-                        fprintf(stdout, "/\n");
-                    });
+                chunk->emplace_back(line, line_value);
+                if (chunk->size() >= CHUNK_SIZE) {
+                    chunk_results.push_back(std::async(
+                        std::launch::async, match_chunk, std::move(chunk)));
+                    chunk = std::make_shared<line_chunk>();
+                }
             }
+        }
 
-            if (((line + 1) % 10000) == 0) {
-                /* Periodically flush the buffer so the parent sees progress */
-                this->child_batch();
-            }
+        if (!chunk->empty()) {
+            chunk_results.push_back(
+                std::async(std::launch::async, match_chunk, std::move(chunk)));
         }
+        chunk_results.pop_to();
 
         if (stop_line == -1) {
             // When scanning to the end of the source, we need to return the
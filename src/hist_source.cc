@@ -36,29 +36,25 @@
 nonstd::optional<vis_line_t>
 hist_source2::row_for_time(struct timeval tv_bucket)
 {
-    std::map<int64_t, struct bucket_block>::iterator iter;
-    int retval = 0;
     time_t time_bucket = rounddown(tv_bucket.tv_sec, this->hs_time_slice);
-
-    for (iter = this->hs_blocks.begin(); iter != this->hs_blocks.end(); ++iter)
-    {
-        struct bucket_block& bb = iter->second;
-
-        if (time_bucket < bb.bb_buckets[0].b_time) {
-            break;
-        }
-        if (time_bucket > bb.bb_buckets[bb.bb_used].b_time) {
-            retval += bb.bb_used + 1;
-            continue;
-        }
-
-        for (unsigned int lpc = 0; lpc <= bb.bb_used; lpc++, retval++) {
-            if (time_bucket <= bb.bb_buckets[lpc].b_time) {
-                return vis_line_t(retval);
-            }
+    int64_t low = 0, high = this->hs_line_count;
+
+    // Bucket times increase with the row index, so the first bucket at
+    // or after the given time can be found with a binary search instead
+    // of walking every block.  Time-syncing views calls this once per
+    // cursor move, so the old linear walk was felt while scrubbing.
+    while (low < high) {
+        auto mid = low + (high - low) / 2;
+        const auto* bucket = this->bucket_for_row(mid);
+
+        if (bucket == nullptr || bucket->b_time < time_bucket) {
+            low = mid + 1;
+        } else {
+            high = mid;
         }
     }
-    return vis_line_t(retval);
+
+    return vis_line_t(low);
 }
 
 void
@@ -168,13 +164,28 @@ hist_source2::end_of_row()
 nonstd::optional<struct timeval>
 hist_source2::time_for_row(vis_line_t row)
 {
-    if (row < 0 || row > this->hs_line_count) {
+    if (row < 0 || row >= this->hs_line_count) {
         return nonstd::nullopt;
     }
 
-    bucket_t& bucket = this->find_bucket(row);
+    const auto* bucket = this->bucket_for_row(row);
+    if (bucket == nullptr) {
+        return nonstd::nullopt;
+    }
+
+    return timeval{bucket->b_time, 0};
+}
+
+const hist_source2::bucket_t*
+hist_source2::bucket_for_row(int64_t index) const
+{
+    const auto iter = this->hs_blocks.find(index / BLOCK_SIZE);
+
+    if (iter == this->hs_blocks.end()) {
+        return nullptr;
+    }
 
-    return timeval{bucket.b_time, 0};
+    return &iter->second.bb_buckets[index % BLOCK_SIZE];
 }
 
 hist_source2::bucket_t&
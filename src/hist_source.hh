@@ -397,6 +397,12 @@ private:
 
     bucket_t& find_bucket(int64_t index);
 
+    /**
+     * Look up a bucket without extending the block map, for the
+     * time/row translation queries.
+     */
+    const bucket_t* bucket_for_row(int64_t index) const;
+
     int64_t hs_time_slice{10 * 60};
     int64_t hs_line_count;
     int64_t hs_last_bucket;
@@ -148,16 +148,9 @@ key_sql_callback(exec_context& ec, sqlite3_stmt* stmt)
     return 0;
 }
 
-bool
-handle_keyseq(const char* keyseq)
+static void
+execute_key_command(const char* keyseq, const key_command& kc)
 {
-    key_map& km = lnav_config.lc_active_keymap;
-
-    const auto& iter = km.km_seq_to_cmd.find(keyseq);
-    if (iter == km.km_seq_to_cmd.end()) {
-        return false;
-    }
-
     logline_value_vector values;
     exec_context ec(&values, key_sql_callback, pipe_callback);
     auto& var_stack = ec.ec_local_vars;
@@ -168,7 +161,6 @@ handle_keyseq(const char* keyseq)
     var_stack.push(std::map<std::string, scoped_value_t>());
     auto& vars = var_stack.top();
     vars["keyseq"] = keyseq;
-    const auto& kc = iter->second;
 
     log_debug("executing key sequence %s: %s", keyseq, kc.kc_cmd.c_str());
     auto result = execute_any(ec, kc.kc_cmd);
@@ -193,6 +185,19 @@ handle_keyseq(const char* keyseq)
             lnav_data.ld_rl_view->set_alt_value(expanded_msg);
         }
     }
+}
+
+bool
+handle_keyseq(const char* keyseq)
+{
+    key_map& km = lnav_config.lc_active_keymap;
+
+    const auto& iter = km.km_seq_to_cmd.find(keyseq);
+    if (iter == km.km_seq_to_cmd.end()) {
+        return false;
+    }
+
+    execute_key_command(keyseq, iter->second);
 
     return true;
 }
@@ -210,9 +215,24 @@ handle_paging_key(int ch)
     text_sub_source* tc_tss = tc->get_sub_source();
     bookmarks<vis_line_t>::type& bm = tc->get_bookmarks();
 
-    auto keyseq = fmt::format(FMT_STRING("x{:02x}"), ch);
-    if (handle_keyseq(keyseq.c_str())) {
-        return true;
+    if (ch >= 0 && ch < 0x100) {
+        // Single-byte keys, the common case, dispatch through the dense
+        // table so an unbound key costs a null check instead of a string
+        // format plus map search.
+        const auto* kc = lnav_config.lc_active_keymap.km_single_cmd[ch];
+
+        if (kc != nullptr) {
+            auto keyseq = fmt::format(FMT_STRING("x{:02x}"), ch);
+
+            execute_key_command(keyseq.c_str(), *kc);
+            return true;
+        }
+    } else {
+        auto keyseq = fmt::format(FMT_STRING("x{:02x}"), ch);
+
+        if (handle_keyseq(keyseq.c_str())) {
+            return true;
+        }
     }
 
     if (tc->handle_key(ch)) {
@@ -0,0 +1,457 @@
+/**
+ * Copyright (c) 2023, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file index_cache.cc
+ */
+
+#include "index_cache.hh"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "base/fs_util.hh"
+#include "base/lnav_log.hh"
+#include "base/paths.hh"
+#include "config.h"
+#include "fmt/format.h"
+#include "ghc/filesystem.hpp"
+#include "lnav_util.hh"
+
+namespace lnav {
+namespace index_cache {
+
+static_assert(std::is_trivially_copyable<logline>::value,
+              "loglines are serialized by memcpy");
+static_assert(std::is_trivially_copyable<line_extent>::value
+                  && sizeof(line_extent) == 6,
+              "line extents are serialized by memcpy");
+
+struct cache_file_header {
+    static constexpr char MAGIC[8] = {
+        'l', 'n', 'a', 'v', 'i', 'd', 'x', '\0'};
+    // Version 2: logline was repacked into sixteen bytes.
+    // Version 3: the content ID was added to the header so sidecar
+    // entries produced by external tools can be verified against the
+    // file they sit next to.
+    // Version 4: per-line timestamp/body extents follow the lines.
+    static constexpr uint32_t VERSION = 4;
+
+    char cfh_magic[8];
+    uint32_t cfh_version;
+    uint32_t cfh_format_name_len;
+    char cfh_content_id[hasher::STRING_SIZE];
+    int64_t cfh_file_size;
+    int64_t cfh_file_mtime;
+    int64_t cfh_index_size;
+    uint64_t cfh_line_count;
+    uint64_t cfh_extent_count;
+};
+
+constexpr char cache_file_header::MAGIC[8];
+constexpr uint32_t cache_file_header::VERSION;
+
+static ghc::filesystem::path
+cache_path_for(const std::string& content_id)
+{
+    return lnav::paths::dotlnav() / "index-cache" / content_id;
+}
+
+static bool
+write_entry_at(const ghc::filesystem::path& cache_path,
+               mode_t mode,
+               const std::string& content_id,
+               const struct stat& st,
+               const std::string& format_name,
+               file_off_t index_size,
+               const std::vector<logline>& lines,
+               const std::vector<line_extent>& extents)
+{
+    std::error_code ec;
+    auto tmp_path = cache_path;
+    tmp_path += ".tmp";
+
+    auto open_res = lnav::filesystem::openp(
+        tmp_path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (open_res.isErr()) {
+        log_error("unable to create index-cache entry: %s -- %s",
+                  tmp_path.c_str(),
+                  open_res.unwrapErr().c_str());
+        return false;
+    }
+
+    auto fd = open_res.unwrap();
+    cache_file_header hdr{};
+
+    memcpy(hdr.cfh_magic, cache_file_header::MAGIC, sizeof(hdr.cfh_magic));
+    hdr.cfh_version = cache_file_header::VERSION;
+    hdr.cfh_format_name_len = format_name.size();
+    strncpy(hdr.cfh_content_id,
+            content_id.c_str(),
+            sizeof(hdr.cfh_content_id) - 1);
+    hdr.cfh_file_size = st.st_size;
+    hdr.cfh_file_mtime = st.st_mtime;
+    hdr.cfh_index_size = index_size;
+    hdr.cfh_line_count = lines.size();
+    // A partially-populated table is useless since it cannot be kept
+    // aligned with the lines, only write it when it is complete.
+    hdr.cfh_extent_count = extents.size() == lines.size() ? extents.size() : 0;
+
+    auto lines_length = lines.size() * sizeof(logline);
+    auto extents_length = hdr.cfh_extent_count * sizeof(line_extent);
+
+    if (write(fd, &hdr, sizeof(hdr)) != (ssize_t) sizeof(hdr)
+        || write(fd, format_name.data(), format_name.size())
+            != (ssize_t) format_name.size()
+        || write(fd, lines.data(), lines_length) != (ssize_t) lines_length
+        || write(fd, extents.data(), extents_length)
+            != (ssize_t) extents_length)
+    {
+        log_error("unable to write index-cache entry: %s", tmp_path.c_str());
+        ghc::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    ghc::filesystem::rename(tmp_path, cache_path, ec);
+    if (ec) {
+        log_error("unable to rename index-cache entry: %s -- %s",
+                  cache_path.c_str(),
+                  ec.message().c_str());
+        ghc::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    log_info("wrote index-cache entry: %s (%zu lines)",
+             cache_path.c_str(),
+             lines.size());
+    return true;
+}
+
+bool
+store(const std::string& content_id,
+      const struct stat& st,
+      const std::string& format_name,
+      file_off_t index_size,
+      const std::vector<logline>& lines,
+      const std::vector<line_extent>& extents)
+{
+    auto cache_path = cache_path_for(content_id);
+    std::error_code ec;
+
+    ghc::filesystem::create_directories(cache_path.parent_path(), ec);
+    if (ec) {
+        log_error("unable to create index-cache directory: %s -- %s",
+                  cache_path.parent_path().c_str(),
+                  ec.message().c_str());
+        return false;
+    }
+
+    return write_entry_at(cache_path,
+                          0600,
+                          content_id,
+                          st,
+                          format_name,
+                          index_size,
+                          lines,
+                          extents);
+}
+
+bool
+store_sidecar(const ghc::filesystem::path& sidecar_path,
+              const std::string& content_id,
+              const struct stat& st,
+              const std::string& format_name,
+              file_off_t index_size,
+              const std::vector<logline>& lines,
+              const std::vector<line_extent>& extents)
+{
+    // Sidecars travel with the log file, so leave them world-readable
+    // like the file they describe.
+    return write_entry_at(sidecar_path,
+                          0644,
+                          content_id,
+                          st,
+                          format_name,
+                          index_size,
+                          lines,
+                          extents);
+}
+
+static Result<cached_index, std::string>
+load_at(const ghc::filesystem::path& cache_path,
+        const std::string& content_id,
+        const struct stat& st)
+{
+    auto open_res = lnav::filesystem::openp(cache_path, O_RDONLY);
+
+    if (open_res.isErr()) {
+        return Err(open_res.unwrapErr());
+    }
+
+    auto fd = open_res.unwrap();
+    struct stat cache_st;
+
+    if (fstat(fd, &cache_st) == -1) {
+        return Err(fmt::format(FMT_STRING("unable to stat: {} -- {}"),
+                               cache_path.string(),
+                               strerror(errno)));
+    }
+
+    if ((size_t) cache_st.st_size < sizeof(cache_file_header)) {
+        return Err(fmt::format(FMT_STRING("cache entry is truncated: {}"),
+                               cache_path.string()));
+    }
+
+    auto* base
+        = mmap(nullptr, cache_st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (base == MAP_FAILED) {
+        return Err(fmt::format(FMT_STRING("unable to mmap: {} -- {}"),
+                               cache_path.string(),
+                               strerror(errno)));
+    }
+
+    auto unmapper = finally([base, &cache_st]() {
+        munmap(base, cache_st.st_size);
+    });
+    cache_file_header hdr;
+
+    memcpy(&hdr, base, sizeof(hdr));
+    if (memcmp(hdr.cfh_magic, cache_file_header::MAGIC, sizeof(hdr.cfh_magic))
+            != 0
+        || hdr.cfh_version != cache_file_header::VERSION)
+    {
+        return Err(fmt::format(FMT_STRING("cache entry is not valid: {}"),
+                               cache_path.string()));
+    }
+
+    // The entry may have come from outside of $DOT_LNAV, so check that
+    // it was actually built for this content before trusting it.
+    if (hdr.cfh_content_id[sizeof(hdr.cfh_content_id) - 1] != '\0'
+        || content_id != hdr.cfh_content_id)
+    {
+        return Err(
+            fmt::format(FMT_STRING("cache entry is for other content: {}"),
+                        cache_path.string()));
+    }
+
+    // The content ID covers the head of the file, so the entry is only
+    // usable when the index does not extend past the current EOF, as
+    // happens when a file was truncated and rewritten.
+    if (hdr.cfh_file_size > st.st_size || hdr.cfh_index_size > st.st_size) {
+        return Err(fmt::format(
+            FMT_STRING("cache entry is for a larger file: {} > {}"),
+            hdr.cfh_file_size,
+            st.st_size));
+    }
+
+    if (hdr.cfh_extent_count != 0
+        && hdr.cfh_extent_count != hdr.cfh_line_count)
+    {
+        return Err(fmt::format(FMT_STRING("cache entry is not valid: {}"),
+                               cache_path.string()));
+    }
+
+    auto expected_size = sizeof(cache_file_header) + hdr.cfh_format_name_len
+        + hdr.cfh_line_count * sizeof(logline)
+        + hdr.cfh_extent_count * sizeof(line_extent);
+    if ((size_t) cache_st.st_size != expected_size) {
+        return Err(fmt::format(FMT_STRING("cache entry is truncated: {}"),
+                               cache_path.string()));
+    }
+
+    cached_index retval;
+    const auto* name_start
+        = (const char*) base + sizeof(cache_file_header);
+
+    retval.ci_format_name.assign(name_start, hdr.cfh_format_name_len);
+    retval.ci_index_size = hdr.cfh_index_size;
+    retval.ci_lines.resize(hdr.cfh_line_count);
+    memcpy(retval.ci_lines.data(),
+           name_start + hdr.cfh_format_name_len,
+           hdr.cfh_line_count * sizeof(logline));
+    retval.ci_extents.resize(hdr.cfh_extent_count);
+    memcpy(retval.ci_extents.data(),
+           name_start + hdr.cfh_format_name_len
+               + hdr.cfh_line_count * sizeof(logline),
+           hdr.cfh_extent_count * sizeof(line_extent));
+
+    log_info("loaded index-cache entry: %s (%llu lines)",
+             cache_path.c_str(),
+             (unsigned long long) hdr.cfh_line_count);
+    return Ok(std::move(retval));
+}
+
+Result<cached_index, std::string>
+load(const std::string& content_id, const struct stat& st)
+{
+    return load_at(cache_path_for(content_id), content_id, st);
+}
+
+Result<cached_index, std::string>
+load_sidecar(const ghc::filesystem::path& sidecar_path,
+             const std::string& content_id,
+             const struct stat& st)
+{
+    return load_at(sidecar_path, content_id, st);
+}
+
+struct filter_file_header {
+    static constexpr char MAGIC[8] = {
+        'l', 'n', 'a', 'v', 'f', 'l', 't', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    char ffh_magic[8];
+    uint32_t ffh_version;
+    uint32_t ffh_word_count;
+    uint64_t ffh_line_count;
+};
+
+constexpr char filter_file_header::MAGIC[8];
+constexpr uint32_t filter_file_header::VERSION;
+
+static ghc::filesystem::path
+filter_path_for(const std::string& content_id, const std::string& filter_id)
+{
+    return lnav::paths::dotlnav() / "filter-cache"
+        / fmt::format(FMT_STRING("{}.{}"), content_id, filter_id);
+}
+
+bool
+store_filter(const std::string& content_id,
+             const std::string& filter_id,
+             uint64_t line_count,
+             const std::vector<uint32_t>& bitmap)
+{
+    auto cache_path = filter_path_for(content_id, filter_id);
+    std::error_code ec;
+
+    ghc::filesystem::create_directories(cache_path.parent_path(), ec);
+    if (ec) {
+        log_error("unable to create filter-cache directory: %s -- %s",
+                  cache_path.parent_path().c_str(),
+                  ec.message().c_str());
+        return false;
+    }
+
+    auto tmp_path = cache_path;
+    tmp_path += ".tmp";
+
+    auto open_res = lnav::filesystem::openp(
+        tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+    if (open_res.isErr()) {
+        log_error("unable to create filter-cache entry: %s -- %s",
+                  tmp_path.c_str(),
+                  open_res.unwrapErr().c_str());
+        return false;
+    }
+
+    auto fd = open_res.unwrap();
+    filter_file_header hdr{};
+
+    memcpy(hdr.ffh_magic, filter_file_header::MAGIC, sizeof(hdr.ffh_magic));
+    hdr.ffh_version = filter_file_header::VERSION;
+    hdr.ffh_word_count = bitmap.size();
+    hdr.ffh_line_count = line_count;
+
+    auto bitmap_length = bitmap.size() * sizeof(uint32_t);
+
+    if (write(fd, &hdr, sizeof(hdr)) != (ssize_t) sizeof(hdr)
+        || write(fd, bitmap.data(), bitmap_length) != (ssize_t) bitmap_length)
+    {
+        log_error("unable to write filter-cache entry: %s", tmp_path.c_str());
+        ghc::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    ghc::filesystem::rename(tmp_path, cache_path, ec);
+    if (ec) {
+        log_error("unable to rename filter-cache entry: %s -- %s",
+                  cache_path.c_str(),
+                  ec.message().c_str());
+        ghc::filesystem::remove(tmp_path, ec);
+        return false;
+    }
+
+    log_info("wrote filter-cache entry: %s (%llu lines)",
+             cache_path.c_str(),
+             (unsigned long long) line_count);
+    return true;
+}
+
+Result<cached_filter, std::string>
+load_filter(const std::string& content_id, const std::string& filter_id)
+{
+    auto cache_path = filter_path_for(content_id, filter_id);
+    auto open_res = lnav::filesystem::openp(cache_path, O_RDONLY);
+
+    if (open_res.isErr()) {
+        return Err(open_res.unwrapErr());
+    }
+
+    auto fd = open_res.unwrap();
+    filter_file_header hdr;
+
+    if (read(fd, &hdr, sizeof(hdr)) != (ssize_t) sizeof(hdr)
+        || memcmp(hdr.ffh_magic,
+                  filter_file_header::MAGIC,
+                  sizeof(hdr.ffh_magic))
+            != 0
+        || hdr.ffh_version != filter_file_header::VERSION)
+    {
+        return Err(fmt::format(FMT_STRING("cache entry is not valid: {}"),
+                               cache_path.string()));
+    }
+
+    if (hdr.ffh_word_count * 32ULL < hdr.ffh_line_count) {
+        return Err(fmt::format(FMT_STRING("cache entry is truncated: {}"),
+                               cache_path.string()));
+    }
+
+    cached_filter retval;
+
+    retval.cf_line_count = hdr.ffh_line_count;
+    retval.cf_bitmap.resize(hdr.ffh_word_count);
+
+    auto bitmap_length = retval.cf_bitmap.size() * sizeof(uint32_t);
+    if (read(fd, retval.cf_bitmap.data(), bitmap_length)
+        != (ssize_t) bitmap_length)
+    {
+        return Err(fmt::format(FMT_STRING("cache entry is truncated: {}"),
+                               cache_path.string()));
+    }
+
+    log_info("loaded filter-cache entry: %s (%llu lines)",
+             cache_path.c_str(),
+             (unsigned long long) hdr.ffh_line_count);
+    return Ok(std::move(retval));
+}
+
+}  // namespace index_cache
+}  // namespace lnav
@@ -0,0 +1,190 @@
+/**
+ * Copyright (c) 2023, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file index_cache.hh
+ */
+
+#ifndef lnav_index_cache_hh
+#define lnav_index_cache_hh
+
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+#include "base/result.h"
+#include "ghc/filesystem.hpp"
+#include "log_format_fwd.hh"
+
+namespace lnav {
+namespace index_cache {
+
+/**
+ * Extension for a pre-built index placed next to a log file, which is
+ * checked by logfile::rebuild_index() before the cache in $DOT_LNAV.
+ * Sidecars let a collection host pre-index logs so viewing them later
+ * skips the scan entirely.  The layout is the same versioned structure
+ * the index-cache uses, in the host's native byte order:
+ *
+ *   - an eight byte magic ("lnavidx\0");
+ *   - a uint32 version (currently 4);
+ *   - a uint32 length of the format name;
+ *   - the NUL-terminated hex content ID, 33 bytes, computed by
+ *     spookyhash-ing the file's first line without its line ending;
+ *   - three int64s: the file size and mtime when the index was built
+ *     and the file offset covered by the index;
+ *   - a uint64 count of index lines;
+ *   - a uint64 count of line-extent entries, zero or equal to the line
+ *     count;
+ *   - the format name, not NUL-terminated;
+ *   - the lines as packed sixteen-byte logline structures;
+ *   - the extents as packed six-byte line_extent structures.
+ *
+ * An entry is trusted only after the content ID in the header matches
+ * the one recomputed from the file being opened.
+ */
+constexpr char SIDECAR_EXTENSION[] = ".lnavidx";
+
+/**
+ * The deserialized contents of an index-cache entry.
+ */
+struct cached_index {
+    std::vector<logline> ci_lines;
+    std::vector<line_extent> ci_extents;
+    std::string ci_format_name;
+    file_off_t ci_index_size{0};
+};
+
+/**
+ * Serialize the logline index for a file to
+ * $DOT_LNAV/index-cache/<content-id> so a later open of the same content can
+ * skip the full rescan.
+ *
+ * @param content_id The content ID computed from the file's first line.
+ * @param st The stat of the file at the time the index was built.
+ * @param format_name The name of the format the file was indexed with.
+ * @param index_size The offset in the file covered by the index.
+ * @param lines The index to serialize.
+ * @param extents The per-line timestamp/body extents, which can be empty.
+ * @return True if the entry was written.
+ */
+bool store(const std::string& content_id,
+           const struct stat& st,
+           const std::string& format_name,
+           file_off_t index_size,
+           const std::vector<logline>& lines,
+           const std::vector<line_extent>& extents);
+
+/**
+ * Serialize an index as a sidecar file (see SIDECAR_EXTENSION), for
+ * placing a pre-built index next to a copy of the log file it covers.
+ *
+ * @param sidecar_path The path of the sidecar file to write.
+ * @return True if the entry was written.
+ */
+bool store_sidecar(const ghc::filesystem::path& sidecar_path,
+                   const std::string& content_id,
+                   const struct stat& st,
+                   const std::string& format_name,
+                   file_off_t index_size,
+                   const std::vector<logline>& lines,
+                   const std::vector<line_extent>& extents);
+
+/**
+ * Load a previously stored index for the given content ID.  The entry is
+ * only usable if the cached size is not past the end of the current file,
+ * the content ID check by the caller covers the actual line data.
+ *
+ * @param content_id The content ID computed from the file's first line.
+ * @param st The stat of the file being opened.
+ * @return The cached index or the reason it could not be used.
+ */
+Result<cached_index, std::string> load(const std::string& content_id,
+                                       const struct stat& st);
+
+/**
+ * Load a pre-built index from a sidecar file that sits next to the log
+ * file itself (see SIDECAR_EXTENSION).  The entry goes through the same
+ * validation as a cache entry, including the content ID check, since
+ * sidecars come from outside of $DOT_LNAV.
+ *
+ * @param sidecar_path The path of the sidecar file.
+ * @param content_id The content ID computed from the file's first line.
+ * @param st The stat of the file being opened.
+ * @return The cached index or the reason it could not be used.
+ */
+Result<cached_index, std::string> load_sidecar(
+    const ghc::filesystem::path& sidecar_path,
+    const std::string& content_id,
+    const struct stat& st);
+
+/**
+ * The deserialized filter results for a prefix of a file, one bit per line.
+ */
+struct cached_filter {
+    uint64_t cf_line_count{0};
+    std::vector<uint32_t> cf_bitmap;
+
+    bool is_line_set(size_t line) const
+    {
+        return this->cf_bitmap[line / 32] & (1UL << (line % 32));
+    }
+};
+
+/**
+ * Serialize a filter's per-line results for a file to
+ * $DOT_LNAV/filter-cache/<content-id>.<filter-id> so re-adding the same
+ * filter later does not need to re-scan the file's contents.
+ *
+ * @param content_id The content ID computed from the file's first line.
+ * @param filter_id The fingerprint of the filter's command.
+ * @param line_count The number of lines covered by the bitmap.
+ * @param bitmap The matched lines, one bit per line.
+ * @return True if the entry was written.
+ */
+bool store_filter(const std::string& content_id,
+                  const std::string& filter_id,
+                  uint64_t line_count,
+                  const std::vector<uint32_t>& bitmap);
+
+/**
+ * Load previously stored filter results for the given content ID.  The
+ * results may cover fewer lines than the file currently has, the remainder
+ * needs to be evaluated as usual.
+ *
+ * @param content_id The content ID computed from the file's first line.
+ * @param filter_id The fingerprint of the filter's command.
+ * @return The cached results or the reason they could not be used.
+ */
+Result<cached_filter, std::string> load_filter(const std::string& content_id,
+                                               const std::string& filter_id);
+
+}  // namespace index_cache
+}  // namespace lnav
+
+#endif
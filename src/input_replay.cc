@@ -0,0 +1,238 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file input_replay.cc
+ */
+
+#include "input_replay.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include <inttypes.h>
+#include <stdlib.h>
+
+#include "base/lnav_log.hh"
+#include "config.h"
+
+#if defined HAVE_NCURSESW_CURSES_H
+#    include <ncursesw/curses.h>
+#elif defined HAVE_NCURSESW_H
+#    include <ncursesw.h>
+#elif defined HAVE_NCURSES_CURSES_H
+#    include <ncurses/curses.h>
+#elif defined HAVE_NCURSES_H
+#    include <ncurses.h>
+#elif defined HAVE_CURSES_H
+#    include <curses.h>
+#else
+#    error "SysV or X/Open-compatible Curses header file required"
+#endif
+
+namespace lnav {
+namespace replay {
+
+struct trace_event {
+    int64_t te_time_us;
+    int te_ch;
+};
+
+/**
+ * Captured at static-init so the report's throughput window runs from
+ * (approximately) process start to the first post-build loop iteration.
+ */
+static const std::chrono::steady_clock::time_point process_start
+    = std::chrono::steady_clock::now();
+
+static FILE*
+trace_file()
+{
+    static FILE* retval = []() -> FILE* {
+        const auto* path = getenv("LNAV_INPUT_TRACE");
+
+        if (path == nullptr) {
+            return nullptr;
+        }
+
+        auto* fp = fopen(path, "ae");
+        if (fp == nullptr) {
+            log_error("unable to open input trace file: %s", path);
+        } else {
+            log_info("recording input trace to: %s", path);
+        }
+        return fp;
+    }();
+
+    return retval;
+}
+
+bool
+is_recording()
+{
+    return trace_file() != nullptr;
+}
+
+void
+record_input(const struct timeval& tv, int ch)
+{
+    auto* fp = trace_file();
+
+    if (fp == nullptr) {
+        return;
+    }
+
+    fprintf(fp,
+            "{\"ts_us\": %" PRId64 ", \"ch\": %d}\n",
+            (int64_t) tv.tv_sec * 1000000LL + tv.tv_usec,
+            ch);
+    fflush(fp);
+}
+
+bool
+is_replaying()
+{
+    return getenv("LNAV_INPUT_REPLAY") != nullptr;
+}
+
+static std::vector<trace_event>
+load_trace(const char* path)
+{
+    std::vector<trace_event> retval;
+    auto* fp = fopen(path, "re");
+
+    if (fp == nullptr) {
+        log_error("unable to open input trace file: %s", path);
+        return retval;
+    }
+
+    trace_event te;
+    while (fscanf(fp,
+                  " {\"ts_us\": %" SCNd64 ", \"ch\": %d}",
+                  &te.te_time_us,
+                  &te.te_ch)
+           == 2)
+    {
+        retval.push_back(te);
+    }
+    fclose(fp);
+
+    return retval;
+}
+
+static uint64_t
+percentile(const std::vector<uint64_t>& sorted, int pct)
+{
+    if (sorted.empty()) {
+        return 0;
+    }
+
+    auto index = (sorted.size() - 1) * pct / 100;
+
+    return sorted[index];
+}
+
+void
+run(size_t indexed_lines,
+    const std::function<bool(const struct timeval&, int)>& deliver)
+{
+    const auto* trace_path = getenv("LNAV_INPUT_REPLAY");
+    const auto index_elapsed_us
+        = std::chrono::duration_cast<std::chrono::microseconds>(
+              std::chrono::steady_clock::now() - process_start)
+              .count();
+    auto events = load_trace(trace_path);
+    std::vector<uint64_t> latencies;
+    uint64_t total_us = 0;
+
+    log_info("replaying %zu input events from: %s", events.size(), trace_path);
+    latencies.reserve(events.size());
+    for (const auto& te : events) {
+        if (te.te_ch == KEY_MOUSE) {
+            // The mouse body bytes were consumed out-of-band by the
+            // mouse handler, so this event cannot be replayed.
+            continue;
+        }
+
+        struct timeval tv = {
+            (time_t) (te.te_time_us / 1000000LL),
+            (suseconds_t) (te.te_time_us % 1000000LL),
+        };
+        auto start = std::chrono::steady_clock::now();
+        auto keep_going = deliver(tv, te.te_ch);
+        auto elapsed_us
+            = std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - start)
+                  .count();
+
+        latencies.push_back(elapsed_us);
+        total_us += elapsed_us;
+        if (!keep_going) {
+            break;
+        }
+    }
+    std::sort(latencies.begin(), latencies.end());
+
+    const auto* report_path = getenv("LNAV_INPUT_REPLAY_REPORT");
+    auto* report_file = stderr;
+
+    if (report_path != nullptr) {
+        report_file = fopen(report_path, "we");
+        if (report_file == nullptr) {
+            log_error("unable to open replay report file: %s", report_path);
+            report_file = stderr;
+        }
+    }
+    fprintf(report_file,
+            "{\"trace\": \"%s\", "
+            "\"events\": %zu, "
+            "\"latency_us\": {"
+            "\"mean\": %" PRIu64 ", "
+            "\"p50\": %" PRIu64 ", "
+            "\"p90\": %" PRIu64 ", "
+            "\"p99\": %" PRIu64 ", "
+            "\"max\": %" PRIu64 "}, "
+            "\"index\": {"
+            "\"lines\": %zu, "
+            "\"elapsed_us\": %" PRId64 "}}\n",
+            trace_path,
+            latencies.size(),
+            latencies.empty() ? 0 : total_us / latencies.size(),
+            percentile(latencies, 50),
+            percentile(latencies, 90),
+            percentile(latencies, 99),
+            latencies.empty() ? 0 : latencies.back(),
+            indexed_lines,
+            index_elapsed_us);
+    if (report_file != stderr) {
+        fclose(report_file);
+    }
+}
+
+}  // namespace replay
+}  // namespace lnav
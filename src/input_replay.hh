@@ -0,0 +1,100 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file input_replay.hh
+ */
+
+#ifndef lnav_input_replay_hh
+#define lnav_input_replay_hh
+
+#include <functional>
+
+#include <stdio.h>
+#include <sys/time.h>
+
+namespace lnav {
+namespace replay {
+
+/**
+ * A macro-benchmark harness for recording a real interactive session and
+ * replaying it later while measuring per-event latency and index
+ * throughput.  The microbenchmarks in test/ cover isolated routines;
+ * this measures the whole stack the user actually feels -- dispatcher,
+ * handlers, and redraw.
+ *
+ * Recording: when LNAV_INPUT_TRACE is set to a path, every input
+ * character delivered to the dispatcher is appended to that file as one
+ * JSON line -- {"ts_us": <gettimeofday in us>, "ch": <curses keycode>}.
+ *
+ * Replay: when LNAV_INPUT_REPLAY is set to a trace path, lnav runs
+ * normally until the initial index build finishes, then feeds the trace
+ * through the input dispatcher instead of polling stdin and exits.  The
+ * recorded timestamps drive the dispatcher's escape-timeout logic, so
+ * traces must be replayed as recorded.  A JSON report with the latency
+ * distribution (mean/p50/p90/p99/max, in microseconds) and the indexed
+ * line count over the time from process start to the first post-build
+ * iteration is written to LNAV_INPUT_REPLAY_REPORT, or stderr when that
+ * is not set, for comparison across builds in CI.
+ *
+ * The trace stores only input; the invoking command line must supply the
+ * same files.  KEY_MOUSE events are skipped on replay since the mouse
+ * body bytes are read out-of-band by the mouse handler and are not in
+ * the trace.
+ */
+
+/** @return True if LNAV_INPUT_TRACE is set and the trace file is open. */
+bool is_recording();
+
+/**
+ * Append an input event to the trace, if recording is enabled.
+ *
+ * @param tv The wall-clock time the event was processed.
+ * @param ch The character/keycode returned by getch().
+ */
+void record_input(const struct timeval& tv, int ch);
+
+/** @return True if LNAV_INPUT_REPLAY is set. */
+bool is_replaying();
+
+/**
+ * Replay the whole recorded trace and write the report.  The deliver
+ * callback feeds one event into the dispatcher and redraws; it returns
+ * false to cut the replay short (e.g. the trace quit out of the last
+ * view).
+ *
+ * @param indexed_lines The number of lines indexed by the initial build,
+ *   reported as the throughput numerator.
+ * @param deliver Called once per replayable event.
+ */
+void run(size_t indexed_lines,
+         const std::function<bool(const struct timeval&, int)>& deliver);
+
+}  // namespace replay
+}  // namespace lnav
+
+#endif
@@ -55,6 +55,7 @@ public:
     std::string sjo_str;
     int64_t sjo_int{0};
     double sjo_float{0.0};
+    bool sjo_matched{false};
 };
 
 static void
@@ -188,9 +189,12 @@ gen_handle_null(void* ctx)
 
     if (sjo->jo_ptr.jp_state == json_ptr::match_state_t::DONE) {
         sjo->sjo_type = SQLITE_NULL;
-    } else {
-        sjo->jo_ptr_error_code = yajl_gen_null(gen);
+        // The pointed-at value has been captured, cancel the parse so
+        // the rest of the document is not scanned for nothing.
+        sjo->sjo_matched = true;
+        return 0;
     }
+    sjo->jo_ptr_error_code = yajl_gen_null(gen);
 
     return sjo->jo_ptr_error_code == yajl_gen_status_ok;
 }
@@ -204,9 +208,10 @@ gen_handle_boolean(void* ctx, int boolVal)
     if (sjo->jo_ptr.jp_state == json_ptr::match_state_t::DONE) {
         sjo->sjo_type = SQLITE_INTEGER;
         sjo->sjo_int = boolVal;
-    } else {
-        sjo->jo_ptr_error_code = yajl_gen_bool(gen, boolVal);
+        sjo->sjo_matched = true;
+        return 0;
     }
+    sjo->jo_ptr_error_code = yajl_gen_bool(gen, boolVal);
 
     return sjo->jo_ptr_error_code == yajl_gen_status_ok;
 }
@@ -220,9 +225,10 @@ gen_handle_string(void* ctx, const unsigned char* stringVal, size_t len)
     if (sjo->jo_ptr.jp_state == json_ptr::match_state_t::DONE) {
         sjo->sjo_type = SQLITE3_TEXT;
         sjo->sjo_str = std::string((char*) stringVal, len);
-    } else {
-        sjo->jo_ptr_error_code = yajl_gen_string(gen, stringVal, len);
+        sjo->sjo_matched = true;
+        return 0;
     }
+    sjo->jo_ptr_error_code = yajl_gen_string(gen, stringVal, len);
 
     return sjo->jo_ptr_error_code == yajl_gen_status_ok;
 }
@@ -246,9 +252,10 @@ gen_handle_number(void* ctx, const char* numval, size_t numlen)
             sjo->sjo_float = scan_float_res.value();
             sjo->sjo_type = SQLITE_FLOAT;
         }
-    } else {
-        sjo->jo_ptr_error_code = yajl_gen_number(gen, numval, numlen);
+        sjo->sjo_matched = true;
+        return 0;
     }
+    sjo->jo_ptr_error_code = yajl_gen_number(gen, numval, numlen);
 
     return sjo->jo_ptr_error_code == yajl_gen_status_ok;
 }
@@ -308,36 +315,46 @@ sql_jget(sqlite3_context* context, int argc, sqlite3_value** argv)
             {
                 sqlite3_result_error(
                     context, jo.jo_ptr.error_msg().c_str(), -1);
-            } else {
+                return;
+            }
+            if (!jo.sjo_matched) {
                 null_or_default(context, argc, argv);
+                return;
             }
-            return;
+            // The scalar handlers cancel the parse once the pointed-at
+            // value has been captured, so the result is already in hand.
+            break;
         default:
             break;
     }
 
-    switch (yajl_complete_parse(handle.in())) {
-        case yajl_status_error: {
-            err = yajl_get_error(handle.in(),
-                                 1,
-                                 (const unsigned char*) json_in,
-                                 strlen(json_in));
-            sqlite3_result_error(context, (const char*) err, -1);
-            yajl_free_error(handle.in(), err);
-            return;
-        }
-        case yajl_status_client_canceled:
-            if (jo.jo_ptr.jp_state
-                == json_ptr::match_state_t::ERR_INVALID_ESCAPE)
-            {
-                sqlite3_result_error(
-                    context, jo.jo_ptr.error_msg().c_str(), -1);
-            } else {
-                null_or_default(context, argc, argv);
+    if (!jo.sjo_matched) {
+        switch (yajl_complete_parse(handle.in())) {
+            case yajl_status_error: {
+                err = yajl_get_error(handle.in(),
+                                     1,
+                                     (const unsigned char*) json_in,
+                                     strlen(json_in));
+                sqlite3_result_error(context, (const char*) err, -1);
+                yajl_free_error(handle.in(), err);
+                return;
             }
-            return;
-        default:
-            break;
+            case yajl_status_client_canceled:
+                if (jo.jo_ptr.jp_state
+                    == json_ptr::match_state_t::ERR_INVALID_ESCAPE)
+                {
+                    sqlite3_result_error(
+                        context, jo.jo_ptr.error_msg().c_str(), -1);
+                    return;
+                }
+                if (!jo.sjo_matched) {
+                    null_or_default(context, argc, argv);
+                    return;
+                }
+                break;
+            default:
+                break;
+        }
     }
 
     switch (jo.sjo_type) {
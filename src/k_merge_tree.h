@@ -95,7 +95,63 @@ public:
             return false;
         }
 	}
-	
+
+	// return the run of entries from the winning bucket that sort before
+	// the best entry of every other bucket and advance past the whole run
+	// with a single re-processing of the tree.  When one bucket has a long
+	// burst of consecutive entries, this touches the comparison tree once
+	// per run instead of once per entry.
+	// if false is returned, the merge is complete
+	bool			next_run(owner_t *&owner, iterator_t& begin, iterator_t& end)
+	{
+        if (!top_node_ptr_mbr->has_iterator ||
+            top_node_ptr_mbr->current_iterator == top_node_ptr_mbr->end_iterator) {
+            return false;
+        }
+
+        // walk down to the winning leaf, remembering the best entry among
+        // the buckets the winner beat along the way
+        node_rec*   node_ptr = top_node_ptr_mbr;
+        node_rec*   runner_up_ptr = NULL;
+        while ( node_ptr->source_node_ptr )
+        {
+            node_rec*   child_ptr = node_ptr->source_node_ptr;
+            node_rec*   sibling_ptr = child_ptr->next_ptr ?
+                child_ptr->next_ptr : child_ptr->previous_ptr;
+
+            if ( sibling_ptr && sibling_ptr->has_iterator &&
+                 sibling_ptr->current_iterator != sibling_ptr->end_iterator )
+            {
+                if ( !runner_up_ptr ||
+                     comparitor_mbr(*sibling_ptr->current_iterator,
+                                    *runner_up_ptr->current_iterator) )
+                {
+                    runner_up_ptr = sibling_ptr;
+                }
+            }
+            node_ptr = child_ptr;
+        }
+
+        owner = node_ptr->owner_ptr;
+        begin = node_ptr->current_iterator;
+        do
+        {
+            ++node_ptr->current_iterator;
+        } while ( node_ptr->current_iterator != node_ptr->end_iterator &&
+                  (!runner_up_ptr ||
+                   comparitor_mbr(*node_ptr->current_iterator,
+                                  *runner_up_ptr->current_iterator)) );
+        end = node_ptr->current_iterator;
+
+        while ( node_ptr->parent_ptr )
+        {
+            compare_nodes(node_ptr);
+            node_ptr = node_ptr->parent_ptr;
+        }
+
+        return true;
+	}
+
 private:
 	class node_rec
 	{
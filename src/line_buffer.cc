@@ -33,6 +33,8 @@
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 #include "config.h"
@@ -41,8 +43,18 @@
 #    include <bzlib.h>
 #endif
 
+#ifdef HAVE_ZSTD_H
+#    include <zstd.h>
+#endif
+
 #include <algorithm>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <set>
+#include <vector>
 
 #ifdef HAVE_X86INTRIN_H
 #    include "simdutf8check.h"
@@ -58,10 +70,194 @@
 #include "base/paths.hh"
 #include "fmtlib/fmt/format.h"
 #include "line_buffer.hh"
+#include "logfile.cfg.hh"
 #include "lnav_util.hh"
+#include "perf_counters.hh"
 
 using namespace std::chrono_literals;
 
+/**
+ * A process-wide LRU of decompressed blocks shared by all line_buffer
+ * instances.  Random access into a compressed file re-inflates from the
+ * nearest sync point, so scrolling around several compressed files keeps
+ * hitting the same windows; caching the decompressed blocks under a global
+ * byte budget amortizes that cost across files.
+ *
+ * When zstd is available the cache is split into two tiers: recently
+ * used blocks stay raw, and blocks evicted from the raw tier are
+ * recompressed into a cold tier that holds them at roughly 4:1 for log
+ * data.  A cold hit decompresses and promotes the block, which is far
+ * cheaper than re-inflating from the file's sync point, so the same
+ * byte budget covers about twice the span of the file.
+ */
+class decompressed_block_cache {
+public:
+    static constexpr size_t BLOCK_SIZE = 4 * GZ_WINSIZE;
+
+    using block = std::shared_ptr<std::vector<unsigned char>>;
+
+    static decompressed_block_cache& singleton()
+    {
+        static decompressed_block_cache retval;
+
+        return retval;
+    }
+
+    static uint64_t next_reader_id()
+    {
+        static std::atomic<uint64_t> next_id{1};
+
+        return next_id.fetch_add(1);
+    }
+
+    block find(uint64_t reader_id, file_off_t block_off, size_t budget)
+    {
+        std::lock_guard<std::mutex> guard(this->dbc_mutex);
+        auto key = std::make_pair(reader_id, block_off);
+        auto iter = this->dbc_blocks.find(key);
+
+        if (iter != this->dbc_blocks.end()) {
+            this->dbc_lru.splice(
+                this->dbc_lru.begin(), this->dbc_lru, iter->second.e_lru_iter);
+            return iter->second.e_block;
+        }
+#ifdef HAVE_ZSTD_H
+        auto cold_iter = this->dbc_cold_blocks.find(key);
+        if (cold_iter != this->dbc_cold_blocks.end()) {
+            auto& ce = cold_iter->second;
+            auto blk = std::make_shared<std::vector<unsigned char>>(
+                ce.ce_decompressed_size);
+            auto rc = ZSTD_decompress(blk->data(),
+                                      blk->size(),
+                                      ce.ce_data.data(),
+                                      ce.ce_data.size());
+
+            this->dbc_cold_byte_count -= ce.ce_data.size();
+            this->dbc_cold_lru.erase(ce.ce_lru_iter);
+            this->dbc_cold_blocks.erase(cold_iter);
+            if (ZSTD_isError(rc) || rc != blk->size()) {
+                return nullptr;
+            }
+            // Promote back into the raw tier so repeated hits do not
+            // pay for decompression every time.
+            this->insert_hot(key, blk, budget);
+            return blk;
+        }
+#endif
+        return nullptr;
+    }
+
+    void put(uint64_t reader_id,
+             file_off_t block_off,
+             block b,
+             size_t budget)
+    {
+        std::lock_guard<std::mutex> guard(this->dbc_mutex);
+        auto key = std::make_pair(reader_id, block_off);
+
+        if (this->dbc_blocks.count(key) > 0) {
+            return;
+        }
+        this->insert_hot(key, std::move(b), budget);
+    }
+
+private:
+    using key_type = std::pair<uint64_t, file_off_t>;
+
+    struct entry {
+        block e_block;
+        std::list<key_type>::iterator e_lru_iter;
+    };
+
+#ifdef HAVE_ZSTD_H
+    struct cold_entry {
+        std::vector<unsigned char> ce_data;
+        size_t ce_decompressed_size;
+        std::list<key_type>::iterator ce_lru_iter;
+    };
+#endif
+
+    void insert_hot(const key_type& key, block b, size_t budget)
+    {
+#ifdef HAVE_ZSTD_H
+        // The raw tier gets half of the byte budget and the compressed
+        // cold tier gets the other half.
+        auto hot_budget = budget / 2;
+        auto cold_budget = budget - hot_budget;
+#else
+        auto hot_budget = budget;
+#endif
+        this->dbc_lru.push_front(key);
+        this->dbc_byte_count += b->size();
+        this->dbc_blocks.emplace(key,
+                                 entry{std::move(b), this->dbc_lru.begin()});
+
+        while (this->dbc_byte_count > hot_budget && !this->dbc_lru.empty()) {
+            auto victim_key = this->dbc_lru.back();
+            auto victim_iter = this->dbc_blocks.find(victim_key);
+
+            this->dbc_byte_count -= victim_iter->second.e_block->size();
+#ifdef HAVE_ZSTD_H
+            this->demote(victim_key,
+                         *victim_iter->second.e_block,
+                         cold_budget);
+#endif
+            this->dbc_blocks.erase(victim_iter);
+            this->dbc_lru.pop_back();
+        }
+    }
+
+#ifdef HAVE_ZSTD_H
+    void demote(const key_type& key,
+                const std::vector<unsigned char>& data,
+                size_t cold_budget)
+    {
+        if (this->dbc_cold_blocks.count(key) > 0) {
+            return;
+        }
+
+        std::vector<unsigned char> comp(ZSTD_compressBound(data.size()));
+        auto rc = ZSTD_compress(
+            comp.data(), comp.size(), data.data(), data.size(), 1);
+        if (ZSTD_isError(rc)) {
+            return;
+        }
+        comp.resize(rc);
+        comp.shrink_to_fit();
+
+        this->dbc_cold_lru.push_front(key);
+        this->dbc_cold_byte_count += comp.size();
+        this->dbc_cold_blocks.emplace(
+            key,
+            cold_entry{
+                std::move(comp), data.size(), this->dbc_cold_lru.begin()});
+
+        while (this->dbc_cold_byte_count > cold_budget
+               && !this->dbc_cold_lru.empty())
+        {
+            auto victim_key = this->dbc_cold_lru.back();
+            auto victim_iter = this->dbc_cold_blocks.find(victim_key);
+
+            this->dbc_cold_byte_count -= victim_iter->second.ce_data.size();
+            this->dbc_cold_blocks.erase(victim_iter);
+            this->dbc_cold_lru.pop_back();
+        }
+    }
+#endif
+
+    std::mutex dbc_mutex;
+    std::map<key_type, entry> dbc_blocks;
+    std::list<key_type> dbc_lru;
+    size_t dbc_byte_count{0};
+#ifdef HAVE_ZSTD_H
+    std::map<key_type, cold_entry> dbc_cold_blocks;
+    std::list<key_type> dbc_cold_lru;
+    size_t dbc_cold_byte_count{0};
+#endif
+};
+
+constexpr size_t decompressed_block_cache::BLOCK_SIZE;
+
 static const ssize_t INITIAL_REQUEST_SIZE = 16 * 1024;
 static const ssize_t DEFAULT_INCREMENT = 128 * 1024;
 static const ssize_t INITIAL_COMPRESSED_BUFFER_SIZE = 5 * 1024 * 1024;
@@ -272,6 +468,17 @@ line_buffer::gz_indexed::stream_data(void* buf, size_t size)
             }
             this->strm.next_in = this->inbuf;
             this->strm.avail_in = rc;
+#if defined(POSIX_FADV_WILLNEED)
+            if (rc == Z_BUFSIZE) {
+                // Ask the kernel to fetch the next compressed chunk while
+                // inflate() chews on this one so the read and the
+                // decompression overlap.
+                posix_fadvise(this->gz_fd,
+                              this->strm.total_in + rc,
+                              Z_BUFSIZE,
+                              POSIX_FADV_WILLNEED);
+            }
+#endif
         }
         if (this->strm.avail_in) {
             int flush = last > this->strm.total_in ? Z_SYNC_FLUSH : Z_BLOCK;
@@ -313,14 +520,16 @@ line_buffer::gz_indexed::seek(off_t offset)
     }
 
     indexDict* dict = nullptr;
-    // Find highest syncpoint not past offset
-    // FIXME: Make this a binary-tree search
-    for (auto& d : this->syncpoints) {
-        if (d.out <= offset) {
-            dict = &d;
-        } else {
-            break;
-        }
+    // Find highest syncpoint not past offset.  The syncpoints are built in
+    // stream order, so they are already sorted by output offset.
+    auto sp_iter = std::upper_bound(this->syncpoints.begin(),
+                                    this->syncpoints.end(),
+                                    offset,
+                                    [](off_t lhs, const indexDict& rhs) {
+                                        return lhs < rhs.out;
+                                    });
+    if (sp_iter != this->syncpoints.begin()) {
+        dict = &(*std::prev(sp_iter));
     }
 
     // Choose highest available syncpoint, or keep current offset if it's ok
@@ -376,11 +585,181 @@ line_buffer::~line_buffer()
     this->set_fd(empty_fd);
 }
 
+ssize_t
+line_buffer::cached_gz_read(gz_indexed& gi,
+                            void* buf,
+                            file_off_t off,
+                            size_t size)
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    auto& cache = decompressed_block_cache::singleton();
+    auto budget = cfg.lc_decompress_block_cache_size;
+    size_t total = 0;
+
+    while (total < size) {
+        auto cur = off + (file_off_t) total;
+        auto block_off
+            = cur - (cur % decompressed_block_cache::BLOCK_SIZE);
+        auto blk = cache.find(this->lb_gz_reader_id, block_off, budget);
+
+        if (blk == nullptr) {
+            blk = std::make_shared<std::vector<unsigned char>>(
+                decompressed_block_cache::BLOCK_SIZE);
+
+            auto rc = gi.read(
+                blk->data(), block_off, decompressed_block_cache::BLOCK_SIZE);
+            if (rc == -1) {
+                return -1;
+            }
+            blk->resize(rc);
+            if (blk->size() == decompressed_block_cache::BLOCK_SIZE) {
+                // Short blocks are at EOF and the file might still be
+                // growing, so only full blocks are worth remembering.
+                cache.put(this->lb_gz_reader_id, block_off, blk, budget);
+            }
+        }
+
+        auto in_blk = (size_t) (cur - block_off);
+
+        if (in_blk >= blk->size()) {
+            break;
+        }
+
+        auto copy_len = std::min(size - total, blk->size() - in_blk);
+
+        memcpy((char*) buf + total, blk->data() + in_blk, copy_len);
+        total += copy_len;
+        if (blk->size() < decompressed_block_cache::BLOCK_SIZE) {
+            break;
+        }
+    }
+
+    return total;
+}
+
+#ifdef HAVE_ZSTD_H
+ssize_t
+line_buffer::zstd_read(file_off_t seek_to, char* dst, size_t avail)
+{
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> dctx(
+        ZSTD_createDCtx(), ZSTD_freeDCtx);
+    char inbuf[32 * 1024];
+    char scratch[32 * 1024];
+    ZSTD_inBuffer zin{inbuf, 0, 0};
+    file_off_t in_off = 0;
+    size_t out_size = 0;
+
+    if (dctx == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    while (out_size < avail) {
+        if (zin.pos == zin.size) {
+            auto prc = pread(this->lb_fd, inbuf, sizeof(inbuf), in_off);
+
+            if (prc < 0) {
+                throw error(errno);
+            }
+            if (prc == 0) {
+                break;
+            }
+            in_off += prc;
+            zin.size = prc;
+            zin.pos = 0;
+        }
+
+        ZSTD_outBuffer zout;
+
+        if (seek_to > 0) {
+            zout.dst = scratch;
+            zout.size = std::min((size_t) seek_to, sizeof(scratch));
+            zout.pos = 0;
+        } else {
+            zout.dst = dst;
+            zout.size = avail;
+            zout.pos = out_size;
+        }
+
+        auto zrc = ZSTD_decompressStream(dctx.get(), &zout, &zin);
+
+        if (ZSTD_isError(zrc)) {
+            log_error("unable to decompress zstd stream: fd=%d -- %s",
+                      this->lb_fd.get(),
+                      ZSTD_getErrorName(zrc));
+            errno = EINVAL;
+            return -1;
+        }
+        if (seek_to > 0) {
+            seek_to -= zout.pos;
+        } else {
+            out_size = zout.pos;
+        }
+        this->lb_compressed_offset
+            = in_off - (file_off_t) (zin.size - zin.pos);
+    }
+
+    return out_size;
+}
+#endif
+
+bool
+line_buffer::map_file(file_off_t upto)
+{
+    if (this->lb_mmap_failed || !this->lb_seekable || this->lb_compressed) {
+        return false;
+    }
+
+    if (this->lb_mmap_base != nullptr && upto <= this->lb_mmap_size) {
+        return true;
+    }
+
+    struct stat st;
+
+    if (fstat(this->lb_fd, &st) == -1 || st.st_size == 0
+        || upto > st.st_size)
+    {
+        return false;
+    }
+
+    this->unmap_file();
+
+    auto* base
+        = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, this->lb_fd, 0);
+    if (base == MAP_FAILED) {
+        log_info("unable to mmap file, falling back to pread -- %s",
+                 strerror(errno));
+        this->lb_mmap_failed = true;
+        return false;
+    }
+
+    this->lb_mmap_base = static_cast<char*>(base);
+    this->lb_mmap_size = st.st_size;
+    return true;
+}
+
+void
+line_buffer::unmap_file()
+{
+    if (this->lb_mmap_base == nullptr) {
+        return;
+    }
+
+    // Any outstanding refs need to copy their data before the pages go away.
+    this->lb_mmap_share_manager.invalidate_refs();
+    munmap(this->lb_mmap_base, this->lb_mmap_size);
+    this->lb_mmap_base = nullptr;
+    this->lb_mmap_size = 0;
+}
+
 void
 line_buffer::set_fd(auto_fd& fd)
 {
     file_off_t newoff = 0;
 
+    this->unmap_file();
+    this->lb_mmap_failed = false;
+
     {
         safe::WriteAccess<safe_gz_indexed> gi(this->lb_gz_file);
 
@@ -392,6 +771,9 @@ line_buffer::set_fd(auto_fd& fd)
     if (this->lb_bz_file) {
         this->lb_bz_file = false;
     }
+    if (this->lb_zstd_file) {
+        this->lb_zstd_file = false;
+    }
 
     if (fd != -1) {
         /* Sync the fd's offset with the object. */
@@ -418,6 +800,8 @@ line_buffer::set_fd(auto_fd& fd)
                     }
                     this->lb_gz_file.writeAccess()->open(gzfd, this->lb_header);
                     this->lb_compressed = true;
+                    this->lb_gz_reader_id
+                        = decompressed_block_cache::next_reader_id();
                     this->lb_file_time = this->lb_header.hd_mtime.tv_sec;
                     if (this->lb_file_time < 0) {
                         this->lb_file_time = 0;
@@ -444,8 +828,31 @@ line_buffer::set_fd(auto_fd& fd)
                     this->lb_compressed_offset = 0;
                 }
 #endif
+#ifdef HAVE_ZSTD_H
+                else if (gz_id[0] == '\x28' && gz_id[1] == '\xb5'
+                         && gz_id[2] == '\x2f' && gz_id[3] == '\xfd')
+                {
+                    this->lb_zstd_file = true;
+                    this->lb_compressed = true;
+
+                    /*
+                     * Like bzip2, the stream cannot be seeked, so keep as
+                     * much decompressed data in memory as possible.
+                     */
+                    this->resize_buffer(INITIAL_COMPRESSED_BUFFER_SIZE);
+
+                    this->lb_compressed_offset = 0;
+                }
+#endif
             }
             this->lb_seekable = true;
+#if defined(POSIX_FADV_SEQUENTIAL)
+            // Files are mostly read front-to-back while indexing, so let
+            // the kernel know it should read ahead aggressively.  This
+            // covers the compressed case as well since those streams are
+            // consumed sequentially, too.
+            posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
         }
     }
     this->lb_file_offset = newoff;
@@ -455,6 +862,51 @@ line_buffer::set_fd(auto_fd& fd)
     ensure(this->invariant());
 }
 
+void
+line_buffer::record_line_length(ssize_t length)
+{
+    size_t bucket = 0;
+
+    while ((length >> bucket) > 1 && bucket < LENGTH_HIST_BUCKETS - 1) {
+        bucket += 1;
+    }
+    if (this->lb_length_hist[bucket] < UINT32_MAX) {
+        this->lb_length_hist[bucket] += 1;
+    }
+    this->lb_longest_line_seen = std::max(this->lb_longest_line_seen, length);
+}
+
+ssize_t
+line_buffer::get_estimated_line_length() const
+{
+    uint64_t count = 0;
+    uint64_t total = 0;
+
+    for (size_t bucket = 0; bucket < LENGTH_HIST_BUCKETS; bucket++) {
+        count += this->lb_length_hist[bucket];
+        // Use the midpoint of the bucket's [2^n, 2^n+1) range.
+        total += (uint64_t) this->lb_length_hist[bucket] << bucket;
+    }
+    if (count < 32) {
+        // Not enough lines to trust the histogram yet.
+        return 128;
+    }
+    return (ssize_t) (total * 3 / (2 * count));
+}
+
+size_t
+line_buffer::tuned_capacity(ssize_t needed) const
+{
+    auto target = roundup_size(needed, DEFAULT_INCREMENT);
+    auto predicted
+        = roundup_size(this->lb_longest_line_seen * 2, DEFAULT_INCREMENT);
+
+    if (predicted > target) {
+        target = predicted;
+    }
+    return std::min(target, (size_t) MAX_LINE_BUFFER_SIZE);
+}
+
 void
 line_buffer::resize_buffer(size_t new_max)
 {
@@ -539,7 +991,7 @@ line_buffer::ensure_available(file_off_t start, ssize_t max_length)
 
         available = this->lb_buffer.capacity() - (start - this->lb_file_offset);
         if (max_length > available) {
-            this->resize_buffer(roundup_size(max_length, DEFAULT_INCREMENT));
+            this->resize_buffer(this->tuned_capacity(max_length));
         }
     }
     this->lb_line_starts.clear();
@@ -642,6 +1094,30 @@ line_buffer::load_next_buffer()
         }
     }
 #endif
+#ifdef HAVE_ZSTD_H
+    else if (!this->lb_cached_fd && this->lb_zstd_file)
+    {
+        if (this->lb_file_size != (ssize_t) -1
+            && (((ssize_t) start >= this->lb_file_size)
+                || (this->in_range(start)
+                    && this->in_range(this->lb_file_size - 1))))
+        {
+            rc = 0;
+        } else {
+            rc = this->zstd_read(start + this->lb_alt_buffer.value().size(),
+                                 this->lb_alt_buffer->end(),
+                                 this->lb_alt_buffer->available());
+
+            if (rc != -1 && (rc < (this->lb_alt_buffer.value().available()))
+                && (start + this->lb_alt_buffer.value().size() + rc
+                    > this->lb_file_size))
+            {
+                this->lb_file_size
+                    = (start + this->lb_alt_buffer.value().size() + rc);
+            }
+        }
+    }
+#endif
     else
     {
         rc = pread(this->lb_cached_fd ? this->lb_cached_fd.value().get()
@@ -686,6 +1162,9 @@ line_buffer::load_next_buffer()
         default:
             this->lb_alt_buffer.value().resize_by(rc);
             retval = true;
+            lnav::perf::count(lnav::perf::counter_id::LINE_BUFFER_READS);
+            lnav::perf::count(lnav::perf::counter_id::LINE_BUFFER_READ_BYTES,
+                              rc);
             break;
     }
     // log_debug("END preload read");
@@ -811,6 +1290,19 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
                 log_debug("load offset %d",
                           this->lb_loader_file_offset.value());
                 log_debug("launch loader");
+#endif
+#if defined(POSIX_FADV_WILLNEED)
+                if (!this->lb_compressed) {
+                    // Ask the kernel to start paging in the range the
+                    // loader is about to read so the background load is
+                    // less likely to stall on cold storage.
+                    posix_fadvise(this->lb_fd,
+                                  this->lb_loader_file_offset.value()
+                                      + this->lb_alt_buffer->size(),
+                                  this->lb_alt_buffer->capacity()
+                                      - this->lb_alt_buffer->size(),
+                                  POSIX_FADV_WILLNEED);
+                }
 #endif
                 auto prom = std::make_shared<std::promise<bool>>();
                 this->lb_loader_future = prom->get_future();
@@ -843,9 +1335,11 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
                                           / this->lb_last_line_offset]
                         += 1;
                 }
-                rc = gi->read(this->lb_buffer.end(),
-                              this->lb_file_offset + this->lb_buffer.size(),
-                              this->lb_buffer.available());
+                rc = this->cached_gz_read(*gi,
+                                          this->lb_buffer.end(),
+                                          this->lb_file_offset
+                                              + this->lb_buffer.size(),
+                                          this->lb_buffer.available());
                 this->lb_compressed_offset = gi->get_source_offset();
                 if (rc != -1 && (rc < this->lb_buffer.available())) {
                     this->lb_file_size
@@ -916,6 +1410,28 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
             }
         }
 #endif
+#ifdef HAVE_ZSTD_H
+        else if (!this->lb_cached_fd && this->lb_zstd_file)
+        {
+            if (this->lb_file_size != (ssize_t) -1
+                && (((ssize_t) start >= this->lb_file_size)
+                    || (this->in_range(start)
+                        && this->in_range(this->lb_file_size - 1))))
+            {
+                rc = 0;
+            } else {
+                rc = this->zstd_read(
+                    this->lb_file_offset + this->lb_buffer.size(),
+                    this->lb_buffer.end(),
+                    this->lb_buffer.available());
+
+                if (rc != -1 && (rc < (this->lb_buffer.available()))) {
+                    this->lb_file_size
+                        = (this->lb_file_offset + this->lb_buffer.size() + rc);
+                }
+            }
+        }
+#endif
         else if (this->lb_seekable)
         {
             this->lb_stats.s_preads += 1;
@@ -989,6 +1505,9 @@ line_buffer::fill_range(file_off_t start, ssize_t max_length)
             default:
                 this->lb_buffer.resize_by(rc);
                 retval = true;
+                lnav::perf::count(lnav::perf::counter_id::LINE_BUFFER_READS);
+                lnav::perf::count(
+                    lnav::perf::counter_id::LINE_BUFFER_READ_BYTES, rc);
                 break;
         }
 
@@ -1097,21 +1616,56 @@ line_buffer::load_next_line(file_range prev_line)
         if (!found_in_cache) {
             const char* msg;
             int faulty_bytes;
+            const char* scan_start = line_start;
+            ssize_t scan_len = retval.li_file_range.fr_size;
+            bool prefix_has_ansi = false;
+
+            if (this->lb_utf_frontier_line == offset
+                && this->lb_utf_frontier_offset > offset
+                && this->lb_utf_frontier_offset <= offset + scan_len)
+            {
+                // This line's prefix was validated on a previous pass, only
+                // the appended bytes need to be examined.
+                auto skip = this->lb_utf_frontier_offset - offset;
 
-            auto scan_res = is_utf8((unsigned char*) line_start,
-                                    retval.li_file_range.fr_size,
-                                    &msg,
-                                    &faulty_bytes,
-                                    '\n');
+                scan_start += skip;
+                scan_len -= skip;
+                prefix_has_ansi = this->lb_utf_frontier_has_ansi;
+            }
+
+            auto scan_res = is_utf8(
+                (unsigned char*) scan_start, scan_len, &msg, &faulty_bytes, '\n');
             if (msg != nullptr) {
-                lf = (char*) memchr(
-                    line_start, '\n', retval.li_file_range.fr_size);
+                lf = (char*) memchr(scan_start, '\n', scan_len);
                 utf8_end = lf - line_start;
                 retval.li_valid_utf = false;
+            } else if (scan_res.usr_end >= 0) {
+                utf8_end = (scan_start - line_start) + scan_res.usr_end;
             } else {
-                utf8_end = scan_res.usr_end;
+                utf8_end = -1;
+
+                // The scan was clean but no terminator was found, so
+                // checkpoint at the last sequence boundary for the next
+                // append.
+                auto frontier = retval.li_file_range.fr_size;
+                const auto* data = (const unsigned char*) line_start;
+
+                for (int back = 0;
+                     back < 3 && frontier > 0
+                     && (data[frontier - 1] & 0xC0) == 0x80;
+                     back++)
+                {
+                    frontier -= 1;
+                }
+                if (frontier > 0 && data[frontier - 1] >= 0xC2) {
+                    frontier -= 1;
+                }
+                this->lb_utf_frontier_line = offset;
+                this->lb_utf_frontier_offset = offset + frontier;
+                this->lb_utf_frontier_has_ansi
+                    = prefix_has_ansi || scan_res.usr_has_ansi;
             }
-            retval.li_has_ansi = scan_res.usr_has_ansi;
+            retval.li_has_ansi = prefix_has_ansi || scan_res.usr_has_ansi;
         }
 
         if (utf8_end >= 0) {
@@ -1179,6 +1733,10 @@ line_buffer::load_next_line(file_range prev_line)
 
             offset += retval.li_file_range.fr_size;
 
+            if (!retval.li_partial) {
+                this->record_line_length(retval.li_file_range.fr_size);
+            }
+
             done = true;
         } else {
             if (!this->is_pipe() || !this->is_pipe_closed()) {
@@ -1212,6 +1770,15 @@ Result<shared_buffer_ref, std::string>
 line_buffer::read_range(const file_range fr)
 {
     shared_buffer_ref retval;
+
+    TRY(this->read_range(fr, retval));
+
+    return Ok(std::move(retval));
+}
+
+Result<void, std::string>
+line_buffer::read_range(const file_range fr, shared_buffer_ref& sbr_out)
+{
     const char* line_start;
     file_ssize_t avail;
 
@@ -1229,6 +1796,19 @@ line_buffer::read_range(const file_range fr)
                         this->lb_last_line_offset));
     }
 
+    if (this->map_file(fr.next_offset())) {
+        /*
+         * Zero-copy mode: hand out a ref that points directly into the
+         * mapping so re-reads during rendering do not thrash lb_buffer.
+         */
+        sbr_out.share(this->lb_mmap_share_manager,
+                      this->lb_mmap_base + fr.fr_offset,
+                      fr.fr_size);
+        sbr_out.get_metadata() = fr.fr_metadata;
+
+        return Ok();
+    }
+
     if (!(this->in_range(fr.fr_offset)
           && this->in_range(fr.fr_offset + fr.fr_size - 1)))
     {
@@ -1242,10 +1822,10 @@ line_buffer::read_range(const file_range fr)
         return Err(fmt::format(
             FMT_STRING("short-read (need: {}; avail: {})"), fr.fr_size, avail));
     }
-    retval.share(this->lb_share_manager, line_start, fr.fr_size);
-    retval.get_metadata() = fr.fr_metadata;
+    sbr_out.share(this->lb_share_manager, line_start, fr.fr_size);
+    sbr_out.get_metadata() = fr.fr_metadata;
 
-    return Ok(std::move(retval));
+    return Ok();
 }
 
 file_range
@@ -1309,6 +1889,35 @@ line_buffer::is_likely_to_flush(file_range prev_line)
     return remaining < INITIAL_REQUEST_SIZE;
 }
 
+void
+line_buffer::hibernate()
+{
+    if (this->lb_loader_future.valid()) {
+        this->lb_loader_future.wait();
+        this->lb_loader_future = std::future<bool>();
+    }
+    // Any outstanding refs need to own their data before the buffer goes.
+    this->lb_share_manager.invalidate_refs();
+    this->reset();
+    {
+        safe::WriteAccess<safe_gz_indexed> gi(this->lb_gz_file);
+
+        if (*gi) {
+            gi->close();
+        }
+    }
+    this->lb_buffer = auto_buffer::alloc(0);
+    this->lb_alt_buffer = nonstd::nullopt;
+    this->lb_alt_line_starts.clear();
+    this->lb_alt_line_starts.shrink_to_fit();
+    this->lb_alt_line_is_utf.clear();
+    this->lb_alt_line_has_ansi.clear();
+    this->lb_line_starts.clear();
+    this->lb_line_starts.shrink_to_fit();
+    this->lb_line_is_utf.clear();
+    this->lb_line_has_ansi.clear();
+}
+
 void
 line_buffer::quiesce()
 {
@@ -202,6 +202,15 @@ public:
 
     Result<shared_buffer_ref, std::string> read_range(file_range fr);
 
+    /**
+     * Read a range into a caller-provided reference.  Scan loops reuse
+     * one reference for a whole batch of lines so that each line does
+     * not pay to register, move, and unregister a fresh ref with the
+     * share manager.
+     */
+    Result<void, std::string> read_range(file_range fr,
+                                         shared_buffer_ref& sbr_out);
+
     file_range get_available();
 
     bool is_likely_to_flush(file_range prev_line);
@@ -213,17 +222,20 @@ public:
         } else {
             this->lb_buffer.clear();
         }
+        this->lb_utf_frontier_line = -1;
     }
 
     /** Release any resources held by this object. */
     void reset()
     {
+        this->unmap_file();
         this->lb_fd.reset();
 
         this->lb_file_offset = 0;
         this->lb_file_size = (ssize_t) -1;
         this->lb_buffer.resize(0);
         this->lb_last_line_offset = -1;
+        this->lb_utf_frontier_line = -1;
     }
 
     /** Check the invariants for this object. */
@@ -234,6 +246,13 @@ public:
         return true;
     }
 
+    /**
+     * Release the file descriptor, heap buffers, and any file mapping for a
+     * file that is going dormant.  A later set_fd() brings the object back
+     * to a usable state, the buffer regrows on the first read.
+     */
+    void hibernate();
+
     void quiesce();
 
     struct stats {
@@ -253,6 +272,17 @@ public:
 
     struct stats consume_stats() { return std::exchange(this->lb_stats, {}); }
 
+    /** Number of power-of-two buckets in the line-length histogram. */
+    static constexpr size_t LENGTH_HIST_BUCKETS = 16;
+
+    /**
+     * @return The mean line length observed in this file so far, estimated
+     * from the length histogram, or a conservative default until enough
+     * lines have been seen.  Callers use it to convert byte budgets into
+     * line counts when sizing scan batches.
+     */
+    ssize_t get_estimated_line_length() const;
+
     size_t get_buffer_size() const { return this->lb_buffer.size(); }
 
     const header_data& get_header_data() const { return this->lb_header; }
@@ -275,6 +305,18 @@ private:
 
     void resize_buffer(size_t new_max);
 
+    /** Add a completed line's length to the histogram. */
+    void record_line_length(ssize_t length);
+
+    /**
+     * @return The buffer capacity to grow to for a line of the given
+     * length, based on the lengths seen so far.  When a file has already
+     * produced lines this large, more are likely coming, so the buffer
+     * grows past the immediate need instead of creeping up one line at a
+     * time and paying for a reallocation and ref invalidation each step.
+     */
+    size_t tuned_capacity(ssize_t needed) const;
+
     /**
      * Ensure there is enough room in the buffer to cache a range of data from
      * the file.  First, this method will check to see if there is enough room
@@ -324,15 +366,70 @@ private:
 
     bool load_next_buffer();
 
+    /**
+     * Read decompressed data through the process-wide block cache so
+     * revisiting the same window of a compressed file does not re-inflate
+     * it from the nearest sync point every time.
+     *
+     * @param gi The reader for the compressed file.
+     * @param buf The buffer to fill.
+     * @param off The offset in the decompressed stream.
+     * @param size The number of bytes to read.
+     * @return The number of bytes read or -1 on error.
+     */
+    ssize_t cached_gz_read(gz_indexed& gi,
+                           void* buf,
+                           file_off_t off,
+                           size_t size);
+
+    /**
+     * Decompress the zstd stream into the given buffer after skipping
+     * seek_to bytes of decompressed output.  Like bzip2, there is no
+     * seeking within the stream, so it is decoded from the start of the
+     * file on every call.
+     *
+     * @param seek_to The decompressed offset to start filling from.
+     * @param dst The buffer to fill.
+     * @param avail The number of bytes to read.
+     * @return The number of bytes read or -1 on error.
+     */
+    ssize_t zstd_read(file_off_t seek_to, char* dst, size_t avail);
+
+    /**
+     * Map the whole file read-only so read_range() can hand out
+     * shared_buffer_refs that point directly into the page cache instead of
+     * copying through lb_buffer.  The mapping is grown when a request lands
+     * beyond the current size.  Only used for uncompressed, seekable files.
+     *
+     * @param upto The file offset that needs to be covered by the mapping.
+     * @return True if the mapping covers the requested offset.
+     */
+    bool map_file(file_off_t upto);
+
+    void unmap_file();
+
     using safe_gz_indexed = safe::Safe<gz_indexed>;
 
     shared_buffer lb_share_manager;
+    shared_buffer lb_mmap_share_manager; /*<
+                                          * Refs into the mmapped file, only
+                                          * invalidated on remap, not on
+                                          * buffer churn.
+                                          */
+    char* lb_mmap_base{nullptr}; /*< Read-only mapping of the file. */
+    file_ssize_t lb_mmap_size{0}; /*< The size of the current mapping. */
+    bool lb_mmap_failed{false}; /*< Set when mmap is not usable. */
 
     auto_fd lb_fd; /*< The file to read data from. */
     safe_gz_indexed lb_gz_file; /*< File reader for gzipped files. */
+    uint64_t lb_gz_reader_id{0}; /*< Identity in the global block cache. */
     bool lb_bz_file{false}; /*< Flag set for bzip2 compressed files. */
+    bool lb_zstd_file{false}; /*< Flag set for zstd compressed files. */
 
     auto_buffer lb_buffer{auto_buffer::alloc(DEFAULT_LINE_BUFFER_SIZE)};
+    /** Log2-bucketed lengths of the lines seen so far in this file. */
+    std::array<uint32_t, LENGTH_HIST_BUCKETS> lb_length_hist{};
+    ssize_t lb_longest_line_seen{0};
     nonstd::optional<auto_buffer> lb_alt_buffer;
     std::vector<uint32_t> lb_alt_line_starts;
     std::vector<bool> lb_alt_line_is_utf;
@@ -357,6 +454,18 @@ private:
     bool lb_compressed{false};
     file_off_t lb_last_line_offset{-1}; /*< */
 
+    /**
+     * UTF-8 validation checkpoint for the partial line at the end of the
+     * file.  When a tail append only adds bytes, re-validation restarts
+     * from this file offset (always a sequence boundary) instead of the
+     * start of the line.  lb_utf_frontier_line identifies the line the
+     * checkpoint belongs to and lb_utf_frontier_has_ansi carries the
+     * escape-sequence flag for the already-validated prefix.
+     */
+    file_off_t lb_utf_frontier_line{-1};
+    file_off_t lb_utf_frontier_offset{-1};
+    bool lb_utf_frontier_has_ansi{false};
+
     std::vector<uint32_t> lb_line_starts;
     std::vector<bool> lb_line_is_utf;
     std::vector<bool> lb_line_has_ansi;
@@ -38,6 +38,7 @@
 
 #include "base/lnav_log.hh"
 #include "config.h"
+#include "perf_counters.hh"
 
 list_gutter_source listview_curses::DEFAULT_GUTTER_SOURCE;
 
@@ -190,6 +191,8 @@ listview_curses::do_update()
         return;
     }
 
+    lnav::perf::timer repaint_timer(lnav::perf::counter_id::VIEW_REPAINTS);
+
     vis_line_t height;
     unsigned long width;
 
@@ -234,8 +237,21 @@ listview_curses::do_update()
         size_t blank_rows = 0;
         row = this->lv_top;
         bottom = y + height;
-        std::vector<attr_line_t> rows(
-            std::min((size_t) height, row_count - (int) this->lv_top));
+        auto& rows = this->lv_row_buffer;
+
+        size_t fetch_rows = (size_t) height;
+        if (this->lv_word_wrap) {
+            // With word wrap enabled, a wide line occupies several display
+            // rows, so a full screen's worth of lines may not be needed.
+            // Ask rows_available() how many lines will actually be shown
+            // (plus one for a partially-visible last line) instead of
+            // formatting lines that would fall below the bottom.
+            fetch_rows = std::min(
+                fetch_rows,
+                (size_t) this->rows_available(this->lv_top, RD_DOWN) + 1);
+        }
+        rows.resize(
+            std::min(fetch_rows, row_count - (int) this->lv_top));
         this->lv_source->listview_value_for_rows(*this, row, rows);
         while (y < bottom) {
             lr.lr_start = this->lv_left;
@@ -251,7 +267,9 @@ listview_curses::do_update()
                 mvwattrline(this->lv_window, y, this->lv_x, overlay_line, lr);
                 overlay_line.clear();
                 ++y;
-            } else if (row < (int) row_count) {
+            } else if (row < (int) row_count
+                       && (size_t) (row - this->lv_top) < rows.size())
+            {
                 auto& al = rows[row - this->lv_top];
 
                 size_t remaining = 0;
@@ -417,7 +435,7 @@ listview_curses::handle_mouse(mouse_event& me)
 
     switch (me.me_button) {
         case mouse_button_t::BUTTON_SCROLL_UP:
-        case mouse_button_t::BUTTON_SCROLL_DOWN:
+        case mouse_button_t::BUTTON_SCROLL_DOWN: {
             if (diff.tv_sec > 0 || diff.tv_usec > 80000) {
                 this->lv_scroll_accel = 1;
                 this->lv_scroll_velo = 0;
@@ -426,10 +444,20 @@ listview_curses::handle_mouse(mouse_event& me)
             }
             this->lv_scroll_velo += this->lv_scroll_accel;
 
-            this->shift_top(vis_line_t(scroll_polarity(me.me_button)
-                                       * this->lv_scroll_velo),
-                            true);
+            // A coalesced run of wheel events gets the acceleration
+            // bookkeeping for each click, but the view only moves once
+            // for the whole batch.
+            auto amount = this->lv_scroll_velo;
+            for (auto lpc = 1; lpc < me.me_count; lpc++) {
+                this->lv_scroll_accel += 2;
+                this->lv_scroll_velo += this->lv_scroll_accel;
+                amount += this->lv_scroll_velo;
+            }
+
+            this->shift_top(
+                vis_line_t(scroll_polarity(me.me_button) * amount), true);
             break;
+        }
         default:
             break;
     }
@@ -563,6 +563,13 @@ protected:
     int lv_mouse_y{-1};
     lv_mode_t lv_mouse_mode{lv_mode_t::NONE};
     vis_line_t lv_tail_space{1};
+
+    /**
+     * The lines rendered by do_update().  Kept as a member so that the
+     * string and attribute storage from the previous frame is recycled
+     * instead of being reallocated on every repaint.
+     */
+    std::vector<attr_line_t> lv_row_buffer;
 };
 
 #endif
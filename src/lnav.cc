@@ -99,6 +99,7 @@
 #include "grep_proc.hh"
 #include "hist_source.hh"
 #include "init-sql.h"
+#include "input_replay.hh"
 #include "listview_curses.hh"
 #include "lnav.events.hh"
 #include "lnav.hh"
@@ -114,6 +115,7 @@
 #include "log_vtab_impl.hh"
 #include "logfile.hh"
 #include "logfile_sub_source.hh"
+#include "perf_counters.hh"
 #include "piper_proc.hh"
 #include "readline_curses.hh"
 #include "readline_highlighters.hh"
@@ -126,6 +128,7 @@
 #include "sql_util.hh"
 #include "sqlite-extension-func.hh"
 #include "sqlitepp.client.hh"
+#include "stall_watchdog.hh"
 #include "static_file_vtab.hh"
 #include "tailer/tailer.looper.hh"
 #include "term_extra.hh"
@@ -453,6 +456,18 @@ append_default_files()
 
 static void
 sigint(int sig)
+{
+    if (lnav_data.ld_mode == ln_mode_t::BUSY) {
+        // An interrupt while a query has the main loop blocked should
+        // cancel the query, not tear down the whole session.
+        lnav_data.ld_sigint_pending = 1;
+    } else {
+        lnav_data.ld_looping = false;
+    }
+}
+
+static void
+sigterm(int sig)
 {
     lnav_data.ld_looping = false;
 }
@@ -755,7 +770,7 @@ update_view_position(listview_curses* lv)
 
 class lnav_behavior : public mouse_behavior {
 public:
-    void mouse_event(int button, bool release, int x, int y) override
+    void mouse_event(int button, bool release, int count, int x, int y) override
     {
         textview_curses* tc = *(lnav_data.ld_view_stack.top());
         struct mouse_event me;
@@ -789,6 +804,7 @@ public:
         gettimeofday(&me.me_time, nullptr);
         me.me_x = x - 1;
         me.me_y = y - tc->get_y() - 1;
+        me.me_count = count;
 
         tc->handle_mouse(me);
     }
@@ -1012,6 +1028,117 @@ wait_for_pipers()
     }
 }
 
+/**
+ * Single-line scroll keys that are safe to fold together when key
+ * auto-repeat floods the input queue.
+ */
+static bool
+is_repeatable_scroll_key(int ch)
+{
+    switch (ch) {
+        case 'j':
+        case 'k':
+        case KEY_DOWN:
+        case KEY_UP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Deliver all pending input to the dispatcher.  A run of auto-repeated
+ * scroll keys is collapsed into the first press plus one larger movement
+ * so the per-scroll bookkeeping runs once for the whole run instead of
+ * once per key.  The collapse only happens when the first press moved
+ * the top view by a single line, so custom key bindings and modal
+ * handlers still see every press.
+ */
+static void
+process_pending_input(const struct timeval& current_time)
+{
+    int ch;
+
+    while ((ch = getch()) != ERR) {
+        lnav_data.ld_user_message_source.clear();
+
+        alerter::singleton().new_input(ch);
+
+        lnav::replay::record_input(current_time, ch);
+
+        int repeats = 0;
+
+        if (lnav_data.ld_mode == ln_mode_t::PAGING
+            && is_repeatable_scroll_key(ch))
+        {
+            int next_ch;
+
+            while (repeats < 1000 && (next_ch = getch()) != ERR) {
+                if (next_ch != ch) {
+                    ungetch(next_ch);
+                    break;
+                }
+                lnav::replay::record_input(current_time, next_ch);
+                repeats += 1;
+            }
+        }
+
+        auto* before_tc = lnav_data.ld_view_stack.top().value_or(nullptr);
+        auto before_pos = 0_vl;
+
+        if (before_tc != nullptr) {
+            before_pos = before_tc->is_selectable()
+                ? before_tc->get_selection()
+                : before_tc->get_top();
+        }
+
+        lnav_data.ld_input_dispatcher.new_input(current_time, ch);
+
+        if (repeats > 0 && lnav_data.ld_looping) {
+            auto delta = (ch == 'j' || ch == KEY_DOWN) ? 1 : -1;
+            auto* after_tc
+                = lnav_data.ld_view_stack.top().value_or(nullptr);
+            auto after_pos = 0_vl;
+
+            if (after_tc != nullptr) {
+                after_pos = after_tc->is_selectable()
+                    ? after_tc->get_selection()
+                    : after_tc->get_top();
+            }
+            if (after_tc != nullptr && after_tc == before_tc
+                && lnav_data.ld_mode == ln_mode_t::PAGING
+                && after_pos == before_pos + vis_line_t(delta))
+            {
+                if (after_tc->is_selectable()) {
+                    after_tc->shift_selection(repeats * delta);
+                } else {
+                    after_tc->shift_top(vis_line_t(repeats * delta), true);
+                }
+            } else {
+                // The first press did not act like a plain one-line
+                // scroll (e.g. a custom binding consumed it), so replay
+                // the rest of the run normally.
+                for (int lpc = 0; lpc < repeats && lnav_data.ld_looping;
+                     lpc++)
+                {
+                    lnav_data.ld_input_dispatcher.new_input(current_time, ch);
+                }
+            }
+        }
+
+        lnav_data.ld_view_stack.top() | [ch](auto tc) {
+            lnav_data.ld_key_repeat_history.update(ch, tc->get_top());
+        };
+
+        if (!lnav_data.ld_looping) {
+            // No reason to keep processing input after the
+            // user has quit.  The view stack will also be
+            // empty, which will cause issues.
+            break;
+        }
+    }
+}
+
 struct refresh_status_bars {
     refresh_status_bars(std::shared_ptr<top_status_source> top_source)
         : rsb_top_source(std::move(top_source))
@@ -1024,27 +1151,9 @@ struct refresh_status_bars {
     void doit() const
     {
         struct timeval current_time {};
-        int ch;
 
         gettimeofday(&current_time, nullptr);
-        while ((ch = getch()) != ERR) {
-            lnav_data.ld_user_message_source.clear();
-
-            alerter::singleton().new_input(ch);
-
-            lnav_data.ld_input_dispatcher.new_input(current_time, ch);
-
-            lnav_data.ld_view_stack.top() | [ch](auto tc) {
-                lnav_data.ld_key_repeat_history.update(ch, tc->get_top());
-            };
-
-            if (!lnav_data.ld_looping) {
-                // No reason to keep processing input after the
-                // user has quit.  The view stack will also be
-                // empty, which will cause issues.
-                break;
-            }
-        }
+        process_pending_input(current_time);
 
         this->rsb_top_source->update_time(current_time);
         for (auto& sc : lnav_data.ld_status) {
@@ -1067,6 +1176,25 @@ looper()
     static auto* ps = injector::get<pollable_supervisor*>();
     static auto* filter_source = injector::get<filter_sub_source*>();
 
+    lnav::perf::register_gauge(
+        "arena.logfile_opids.bytes",
+        "Bytes held by the per-file arenas for opid strings",
+        []() {
+            uint64_t retval = 0;
+
+            for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+                retval += lf->get_allocator_bytes();
+            }
+            return retval;
+        });
+    lnav::perf::register_gauge(
+        "arena.db_query.bytes",
+        "Bytes held by the arena for the last query's result cells",
+        []() {
+            return (uint64_t) lnav_data.ld_db_row_source.dls_allocator
+                ->getNumBytesAllocated();
+        });
+
     try {
         auto* sql_cmd_map = injector::get<readline_context::command_map_t*,
                                           sql_cmd_map_tag>();
@@ -1197,7 +1325,7 @@ looper()
         auto echo_views_stmt = echo_views_stmt_res.unwrap();
 
         (void) signal(SIGINT, sigint);
-        (void) signal(SIGTERM, sigint);
+        (void) signal(SIGTERM, sigterm);
         (void) signal(SIGWINCH, sigwinch);
         (void) signal(SIGCHLD, sigchld);
 
@@ -1332,6 +1460,21 @@ looper()
         breadcrumb_view.set_y(1);
         breadcrumb_view.set_window(lnav_data.ld_window);
         breadcrumb_view.set_line_source(lnav_crumb_source);
+        breadcrumb_view.set_source_token([]() {
+            size_t retval = 0;
+
+            lnav_data.ld_view_stack.top() | [&retval](auto* tc) {
+                retval = reinterpret_cast<size_t>(tc);
+                retval = retval * 31 + (size_t) (int) tc->get_top();
+                auto* tss = tc->get_sub_source();
+                if (tss != nullptr) {
+                    retval = retval * 31 + tss->text_line_count();
+                }
+                retval = retval * 31
+                    + lnav_data.ld_active_files.fc_files_generation;
+            };
+            return retval;
+        });
         auto event_handler = [](auto&& tc) {
             auto top_view = lnav_data.ld_view_stack.top();
 
@@ -1503,8 +1646,12 @@ looper()
         auto next_rebuild_time = ui_clock::now();
         auto next_status_update_time = next_rebuild_time;
         auto next_rescan_time = next_rebuild_time;
+        auto next_frame_time = next_rebuild_time;
+        auto next_session_checkpoint_time = next_rebuild_time + 1min;
 
         while (lnav_data.ld_looping) {
+            lnav::stalls::begin_iteration();
+
             auto loop_deadline
                 = ui_clock::now() + (session_stage == 0 ? 3s : 50ms);
 
@@ -1598,6 +1745,12 @@ looper()
                     if (!changes && ui_clock::now() < loop_deadline) {
                         next_rebuild_time = ui_clock::now() + 333ms;
                     }
+                    if (changes && session_stage >= 2) {
+                        // Files that finished indexing after the session
+                        // was restored fault their bookmarks in here.  This
+                        // is a no-op when every file has been restored.
+                        load_time_bookmarks();
+                    }
                     if (changes && text_file_count
                         && lnav_data.ld_text_source.empty()
                         && lnav_data.ld_view_stack.top().value_or(nullptr)
@@ -1618,47 +1771,92 @@ looper()
             {
                 lnav_data.ld_view_stack.set_needs_update();
             }
-            lnav_data.ld_view_stack.do_update();
-            lnav_data.ld_doc_view.do_update();
-            lnav_data.ld_example_view.do_update();
-            lnav_data.ld_match_view.do_update();
-            lnav_data.ld_preview_view.do_update();
-            lnav_data.ld_spectro_details_view.do_update();
-            lnav_data.ld_user_message_view.do_update();
-            if (ui_clock::now() >= next_status_update_time) {
-                echo_views_stmt.execute();
-                top_source->update_user_msg();
-                for (auto& sc : lnav_data.ld_status) {
-                    sc.do_update();
+            // While indexing is churning out changes, the loop spins with a
+            // zero poll timeout, so repainting on every pass floods the
+            // terminal with updates that are immediately overwritten.  Stick
+            // to a fixed frame budget while that is going on so tailing a
+            // busy file stays smooth even over a slow link.  The last
+            // iteration of a rebuild comes through with no changes, so the
+            // final state is always painted.
+            if (!changes || ui_clock::now() >= next_frame_time) {
+                lnav::stalls::stage_guard render_sg(
+                    lnav::stalls::STAGE_RENDER);
+                auto frame_start_time = ui_clock::now();
+                lnav_data.ld_view_stack.do_update();
+                lnav_data.ld_doc_view.do_update();
+                lnav_data.ld_example_view.do_update();
+                lnav_data.ld_match_view.do_update();
+                lnav_data.ld_preview_view.do_update();
+                lnav_data.ld_spectro_details_view.do_update();
+                lnav_data.ld_user_message_view.do_update();
+                if (ui_clock::now() >= next_status_update_time) {
+                    echo_views_stmt.execute();
+                    top_source->update_user_msg();
+                    for (auto& sc : lnav_data.ld_status) {
+                        sc.do_update();
+                    }
+                    next_status_update_time = ui_clock::now() + 100ms;
                 }
-                next_status_update_time = ui_clock::now() + 100ms;
-            }
-            if (filter_source->fss_editing) {
-                filter_source->fss_match_view.set_needs_update();
-            }
-            breadcrumb_view.do_update();
-            // These updates need to be done last so their readline views can
-            // put the cursor in the right place.
-            switch (lnav_data.ld_mode) {
-                case ln_mode_t::FILTER:
-                case ln_mode_t::SEARCH_FILTERS:
-                    lnav_data.ld_filter_view.set_needs_update();
-                    lnav_data.ld_filter_view.do_update();
-                    break;
-                case ln_mode_t::SEARCH_FILES:
-                case ln_mode_t::FILES:
-                    lnav_data.ld_files_view.set_needs_update();
-                    lnav_data.ld_files_view.do_update();
-                    break;
-                default:
-                    break;
+                if (filter_source->fss_editing) {
+                    filter_source->fss_match_view.set_needs_update();
+                }
+                breadcrumb_view.do_update();
+                // These updates need to be done last so their readline views
+                // can put the cursor in the right place.
+                switch (lnav_data.ld_mode) {
+                    case ln_mode_t::FILTER:
+                    case ln_mode_t::SEARCH_FILTERS:
+                        lnav_data.ld_filter_view.set_needs_update();
+                        lnav_data.ld_filter_view.do_update();
+                        break;
+                    case ln_mode_t::SEARCH_FILES:
+                    case ln_mode_t::FILES:
+                        lnav_data.ld_files_view.set_needs_update();
+                        lnav_data.ld_files_view.do_update();
+                        break;
+                    default:
+                        break;
+                }
+                if (lnav_data.ld_mode != ln_mode_t::FILTER
+                    && lnav_data.ld_mode != ln_mode_t::FILES)
+                {
+                    rlc->do_update();
+                }
+                refresh();
+
+                // Scale the frame budget with the cost of the repaint so a
+                // large window over a slow link yields more of the loop to
+                // indexing, while a cheap repaint stays at ~30fps.
+                auto frame_elapsed
+                    = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        ui_clock::now() - frame_start_time);
+                next_frame_time = ui_clock::now()
+                    + std::min(std::max<std::chrono::milliseconds>(
+                                   30ms, frame_elapsed * 3),
+                               std::chrono::milliseconds(250ms));
+            } else {
+                lnav::perf::count(lnav::perf::counter_id::VIEW_FRAMES_SKIPPED);
             }
-            if (lnav_data.ld_mode != ln_mode_t::FILTER
-                && lnav_data.ld_mode != ln_mode_t::FILES)
-            {
-                rlc->do_update();
+
+            if (!changes && initial_rescan_completed) {
+                // The screen is up to date and indexing is quiet, so use
+                // the lull to warm the pages adjacent to the viewport.
+                lnav_data.ld_view_stack.top() | [](auto* tc) {
+                    auto* tss = tc->get_sub_source();
+
+                    if (tss != nullptr) {
+                        vis_line_t height;
+                        unsigned long width;
+
+                        tc->get_dimensions(height, width);
+                        tss->text_prefetch_for(tc->get_top() - height,
+                                               tc->get_top());
+                        tss->text_prefetch_for(tc->get_bottom() + 1_vl,
+                                               tc->get_bottom() + height
+                                                   + 1_vl);
+                    }
+                };
             }
-            refresh();
 
             if (lnav_data.ld_session_loaded) {
                 // Only take input from the user after everything has loaded.
@@ -1686,6 +1884,27 @@ looper()
                 }
             }
 
+            if (lnav_data.ld_initial_build && lnav::replay::is_replaying()) {
+                // The initial index build is done, so feed the recorded
+                // trace through the dispatcher instead of waiting on
+                // stdin, write the report, and exit.
+                lnav::stalls::stage_guard input_sg(lnav::stalls::STAGE_INPUT);
+
+                lnav::replay::run(
+                    lnav_data.ld_log_source.text_line_count()
+                        + lnav_data.ld_text_source.text_line_count(),
+                    [&current_time](const struct timeval& tv, int ch) {
+                        current_time = tv;
+                        lnav_data.ld_input_dispatcher.new_input(tv, ch);
+                        lnav_data.ld_view_stack.do_update();
+                        refresh();
+                        return lnav_data.ld_looping
+                            && !lnav_data.ld_view_stack.empty();
+                    });
+                lnav_data.ld_looping = false;
+                continue;
+            }
+
             ps->update_poll_set(pollfds);
             ui_now = ui_clock::now();
             auto poll_to
@@ -1700,7 +1919,11 @@ looper()
                 poll_to = 15ms;
             }
             // log_debug("poll %d %d", changes, poll_to.count());
-            rc = poll(&pollfds[0], pollfds.size(), poll_to.count());
+            {
+                lnav::stalls::stage_guard poll_sg(lnav::stalls::STAGE_POLL);
+
+                rc = poll(&pollfds[0], pollfds.size(), poll_to.count());
+            }
 
             gettimeofday(&current_time, nullptr);
             lnav_data.ld_input_dispatcher.poll(current_time);
@@ -1723,29 +1946,14 @@ looper()
                     log_info("stdin has been closed, exiting...");
                     lnav_data.ld_looping = false;
                 } else if (in_revents & POLLIN) {
-                    int ch;
-
                     auto old_gen
                         = lnav_data.ld_active_files.fc_files_generation;
-                    while ((ch = getch()) != ERR) {
-                        lnav_data.ld_user_message_source.clear();
-
-                        alerter::singleton().new_input(ch);
 
-                        lnav_data.ld_input_dispatcher.new_input(current_time,
-                                                                ch);
-
-                        lnav_data.ld_view_stack.top() | [ch](auto tc) {
-                            lnav_data.ld_key_repeat_history.update(
-                                ch, tc->get_top());
-                        };
+                    {
+                        lnav::stalls::stage_guard input_sg(
+                            lnav::stalls::STAGE_INPUT);
 
-                        if (!lnav_data.ld_looping) {
-                            // No reason to keep processing input after the
-                            // user has quit.  The view stack will also be
-                            // empty, which will cause issues.
-                            break;
-                        }
+                        process_pending_input(current_time);
                     }
 
                     next_status_update_time = ui_clock::now();
@@ -1784,7 +1992,11 @@ looper()
                 auto old_file_names_size
                     = lnav_data.ld_active_files.fc_file_names.size();
 
-                ps->check_poll_set(pollfds);
+                {
+                    lnav::stalls::stage_guard io_sg(lnav::stalls::STAGE_IO);
+
+                    ps->check_poll_set(pollfds);
+                }
                 lnav_data.ld_view_stack.top() |
                     [](auto tc) { lnav_data.ld_bottom_source.update_hits(tc); };
 
@@ -1944,6 +2156,16 @@ looper()
                 }
             }
 
+            if (session_stage >= 2
+                && ui_clock::now() >= next_session_checkpoint_time)
+            {
+                // Checkpoint the session so a crash loses at most a
+                // minute of state and the save on exit is usually a
+                // no-op.
+                save_session();
+                next_session_checkpoint_time = ui_clock::now() + 1min;
+            }
+
             handle_winch();
 
             if (lnav_data.ld_child_terminated) {
@@ -1975,6 +2197,8 @@ looper()
             {
                 lnav_data.ld_looping = false;
             }
+
+            lnav::stalls::end_iteration();
         }
     } catch (readline_curses::error& e) {
         log_error("error: %s", strerror(e.e_err));
@@ -2303,6 +2527,12 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
         auto* recurse_flag = app.add_flag(
             "-r", lnav_data.ld_active_files.fc_recursive, "recurse");
         app.add_flag("-W", mode_flags.mf_print_warnings);
+        app.add_option("--memory-limit",
+                       lnav_data.ld_memory_limit,
+                       "Trim caches to try to keep the estimated memory "
+                       "usage under the given size.")
+            ->transform(CLI::AsSizeValue(false))
+            ->type_name("SIZE");
         auto* headless_flag = app.add_flag(
             "-n",
             [](size_t count) { lnav_data.ld_flags |= LNF_HEADLESS; },
@@ -3261,6 +3491,10 @@ SELECT tbl_name FROM sqlite_master WHERE sql LIKE 'CREATE VIRTUAL TABLE%'
                         }
                     }
                 }
+
+                if (getenv("LNAV_PERF_SUMMARY") != nullptr) {
+                    lnav::perf::write_summary(stderr);
+                }
             } else {
                 init_session();
 
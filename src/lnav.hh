@@ -177,6 +177,8 @@ struct lnav_data_t {
     sig_atomic_t ld_looping;
     sig_atomic_t ld_winched;
     sig_atomic_t ld_child_terminated;
+    /** Set by SIGINT to cancel the operation blocking the main loop. */
+    sig_atomic_t ld_sigint_pending;
     unsigned long ld_flags;
     WINDOW* ld_window;
     ln_mode_t ld_mode;
@@ -256,6 +258,7 @@ struct lnav_data_t {
 
     bool ld_initial_build{false};
     bool ld_show_help_view{false};
+    size_t ld_memory_limit{0};
 
     lnav::func::scoped_cb ld_status_refresher;
 
@@ -27,15 +27,30 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include "lnav.indexing.hh"
 
 #include "lnav.events.hh"
 #include "lnav.hh"
+#include "log.watch.hh"
+#include "logfile.cfg.hh"
 #include "service_tags.hh"
 #include "session_data.hh"
+#include "stall_watchdog.hh"
+#include "view_helpers.hist.hh"
 
 using namespace std::chrono_literals;
 
+/** The most lines of a file that watch expressions are evaluated against
+ * in one rebuild cycle, to keep a backfill from stalling the UI. */
+static constexpr size_t WATCH_LINES_PER_CYCLE = 10000;
+
 /**
  * Observer for loading progress that updates the bottom status bar.
  */
@@ -79,6 +94,153 @@ public:
     off_t lo_last_offset;
 };
 
+/**
+ * Observer that aggregates indexing progress from the worker threads doing
+ * a parallel prescan so the main thread can report a single figure.
+ */
+class aggregate_loading_observer : public logfile_observer {
+public:
+    indexing_result logfile_indexing(const std::shared_ptr<logfile>& lf,
+                                     file_off_t off,
+                                     file_size_t total) override
+    {
+        if (off > (file_off_t) total) {
+            off = total;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(this->alo_mutex);
+
+            this->alo_progress[lf.get()] = std::make_pair(off, total);
+        }
+
+        if (!lnav_data.ld_looping) {
+            return indexing_result::BREAK;
+        }
+        return indexing_result::CONTINUE;
+    }
+
+    std::pair<file_off_t, file_size_t> get_totals() const
+    {
+        std::lock_guard<std::mutex> guard(this->alo_mutex);
+        std::pair<file_off_t, file_size_t> retval{0, 0};
+
+        for (const auto& pair : this->alo_progress) {
+            retval.first += pair.second.first;
+            retval.second += pair.second.second;
+        }
+        return retval;
+    }
+
+private:
+    mutable std::mutex alo_mutex;
+    std::map<logfile*, std::pair<file_off_t, file_size_t>> alo_progress;
+};
+
+/**
+ * Rank a file for indexing cycles.  Files visible in the log view come
+ * first, then files that have been written to recently, with cold files
+ * like rotated archives trailing.
+ */
+static int
+index_priority(const std::shared_ptr<logfile>& lf, time_t now)
+{
+    static const time_t RECENT_WRITE_PERIOD = 60;
+
+    int retval = 0;
+
+    lnav_data.ld_log_source.find_data(lf) | [&retval](auto ld) {
+        if (ld->is_visible()) {
+            retval += 2;
+        }
+    };
+    if ((now - lf->get_stat().st_mtime) <= RECENT_WRITE_PERIOD) {
+        retval += 1;
+    }
+
+    return retval;
+}
+
+/**
+ * Index files with locked-in formats on worker threads so a directory full
+ * of rotated logs does not serialize on a single core.  Files that are still
+ * in format detection are left for the serial pass in
+ * logfile_sub_source::rebuild_index() since detection probes the shared root
+ * formats.  The workers pull files off a shared queue so a couple of large
+ * files do not leave the rest of the pool idle.
+ */
+static void
+prescan_logfiles_in_parallel(nonstd::optional<ui_clock::time_point> deadline)
+{
+    std::vector<std::shared_ptr<logfile>> to_scan;
+
+    for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+        if (lf->is_prescannable()) {
+            to_scan.emplace_back(lf);
+        }
+    }
+    if (to_scan.size() < 2) {
+        return;
+    }
+
+    // The workers pull files off the queue in order, so hand out the
+    // files the user is watching first and leave the cold archives for
+    // whatever time remains before the deadline.
+    auto now = time(nullptr);
+    std::stable_sort(to_scan.begin(),
+                     to_scan.end(),
+                     [now](const auto& left, const auto& right) {
+                         return index_priority(left, now)
+                             > index_priority(right, now);
+                     });
+
+    aggregate_loading_observer agg_obs;
+    std::vector<logfile_observer*> saved_observers;
+
+    saved_observers.reserve(to_scan.size());
+    for (const auto& lf : to_scan) {
+        saved_observers.push_back(lf->get_logfile_observer());
+        lf->set_logfile_observer(&agg_obs);
+    }
+
+    auto worker_count = std::min(
+        to_scan.size(),
+        (size_t) std::max(2U, std::thread::hardware_concurrency()));
+    std::atomic<size_t> next_file{0};
+    std::vector<std::future<void>> workers;
+
+    workers.reserve(worker_count);
+    for (size_t lpc = 0; lpc < worker_count; lpc++) {
+        workers.emplace_back(
+            std::async(std::launch::async, [&to_scan, &next_file, deadline]() {
+                while (lnav_data.ld_looping) {
+                    auto file_index = next_file.fetch_add(1);
+
+                    if (file_index >= to_scan.size()) {
+                        break;
+                    }
+                    to_scan[file_index]->prescan_index(deadline);
+                }
+            }));
+    }
+
+    for (auto& worker : workers) {
+        while (worker.wait_for(100ms) != std::future_status::ready) {
+            auto totals = agg_obs.get_totals();
+
+            if (lnav_data.ld_window != nullptr && totals.second > 0) {
+                lnav_data.ld_bottom_source.update_loading(totals.first,
+                                                          totals.second);
+                do_observer_update(nullptr);
+            }
+        }
+    }
+
+    for (size_t lpc = 0; lpc < to_scan.size(); lpc++) {
+        to_scan[lpc]->set_logfile_observer(saved_observers[lpc]);
+    }
+}
+
 void
 do_observer_update(const std::shared_ptr<logfile>& lf)
 {
@@ -110,10 +272,42 @@ do_observer_update(const std::shared_ptr<logfile>& lf)
 void
 rebuild_hist()
 {
+    static int last_zoom = -1;
+    static size_t last_line_count = 0;
+    static size_t last_mark_fingerprint = 0;
+
     logfile_sub_source& lss = lnav_data.ld_log_source;
     hist_source2& hs = lnav_data.ld_hist_source2;
     int zoom = lnav_data.ld_zoom_level;
 
+    // Switching to the histogram view triggers a rebuild every time, so
+    // checkpoint the inputs and keep the warm state when neither the index
+    // nor the marks have changed since the last one.
+    auto& log_view = lnav_data.ld_views[LNV_LOG];
+    auto& bm = log_view.get_bookmarks();
+    size_t mark_fingerprint = 0;
+    for (const auto* bm_type : {&textview_curses::BM_USER,
+                                &textview_curses::BM_USER_EXPR,
+                                &textview_curses::BM_META})
+    {
+        for (const auto& vl : bm[bm_type]) {
+            mark_fingerprint = mark_fingerprint * 31 + (int) vl + 1;
+        }
+    }
+    if (zoom == last_zoom && lss.text_line_count() == last_line_count
+        && mark_fingerprint == last_mark_fingerprint)
+    {
+        return;
+    }
+    last_zoom = zoom;
+    last_line_count = lss.text_line_count();
+    last_mark_fingerprint = mark_fingerprint;
+
+    auto* hid = dynamic_cast<hist_index_delegate*>(lss.get_index_delegate());
+    if (hid != nullptr && hid->repopulate_from_shards(ZOOM_LEVELS[zoom])) {
+        return;
+    }
+
     hs.set_time_slice(ZOOM_LEVELS[zoom]);
     lss.reload_index_delegate();
 }
@@ -182,9 +376,227 @@ public:
     bool did_promotion{false};
 };
 
+/**
+ * Hibernates fully-indexed files that are hidden from the log view and have
+ * not had their contents read for the configured idle time, dropping their
+ * index to the disk cache and closing their descriptors.  Files with user
+ * marks are left alone since marks are resolved through the line index.
+ */
+static void
+hibernate_idle_files()
+{
+    static const auto& cfg = injector::get<const lnav::logfile::config&>();
+
+    if (cfg.lc_hibernate_idle_time == 0) {
+        return;
+    }
+
+    const auto idle_cutoff = std::chrono::steady_clock::now()
+        - std::chrono::seconds(cfg.lc_hibernate_idle_time);
+    auto& lss = lnav_data.ld_log_source;
+
+    for (auto& ld : lss) {
+        auto* lf = ld->get_file_ptr();
+
+        if (lf == nullptr || ld->is_visible() || lf->is_hibernated()
+            || lf->get_last_read_time() > idle_cutoff)
+        {
+            continue;
+        }
+
+        const auto mark_range_start = content_line_t(
+            ld->ld_file_index * logfile_sub_source::MAX_LINES_PER_FILE);
+        const auto mark_range_end = content_line_t(
+            (ld->ld_file_index + 1) * logfile_sub_source::MAX_LINES_PER_FILE);
+        auto has_marks = false;
+
+        for (const auto& bm_pair : lss.get_user_bookmarks()) {
+            const auto& bv = bm_pair.second;
+            auto low = std::lower_bound(bv.begin(), bv.end(), mark_range_start);
+
+            if (low != bv.end() && *low < mark_range_end) {
+                has_marks = true;
+                break;
+            }
+        }
+        if (has_marks) {
+            continue;
+        }
+
+        lf->hibernate();
+    }
+}
+
+/**
+ * Checks the estimated memory usage of the loaded files against the
+ * --memory-limit option and trims the index capacity of files that are at
+ * rest when over budget.  The line index itself cannot be evicted since
+ * nearly every consumer expects random access to it, so the limit is a
+ * best-effort bound rather than a hard one.
+ */
+static void
+check_memory_budget()
+{
+    if (lnav_data.ld_memory_limit == 0) {
+        return;
+    }
+
+    size_t total_usage = 0;
+    for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+        total_usage += lf->estimated_memory_usage();
+    }
+    if (total_usage <= lnav_data.ld_memory_limit) {
+        return;
+    }
+
+    log_info("memory usage estimate (%zu) is over the limit (%zu), "
+             "trimming file indexes",
+             total_usage,
+             lnav_data.ld_memory_limit);
+    total_usage = 0;
+    for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+        if (lf->get_index_size() >= lf->get_stat().st_size) {
+            lf->reduce_memory_usage();
+        }
+        total_usage += lf->estimated_memory_usage();
+    }
+    if (total_usage > lnav_data.ld_memory_limit) {
+        static bool warned_once = false;
+
+        if (!warned_once) {
+            warned_once = true;
+            log_warning("memory usage estimate (%zu) still exceeds the "
+                        "limit (%zu) after trimming",
+                        total_usage,
+                        lnav_data.ld_memory_limit);
+        }
+    }
+}
+
+/**
+ * Look for the overlap left behind by a copytruncate race, where the tail
+ * of a rotated file reappears at the head of its successor, and mask the
+ * repeated lines out of the newer file so they only show up once in the
+ * merged view.  A pair of files is only examined again when one of them
+ * grows, and candidate regions are verified line-by-line against the file
+ * contents before anything is hidden.
+ *
+ * @return True if any lines were masked, in which case the caller needs to
+ * force a full rebuild of the merged index.
+ */
+static bool
+detect_copytruncate_overlaps()
+{
+    static const size_t MAX_OVERLAP_LINES = 10000;
+    static std::map<std::pair<std::string, std::string>,
+                    std::pair<size_t, size_t>>
+        checked_pairs;
+
+    bool retval = false;
+    const auto& files = lnav_data.ld_active_files.fc_files;
+
+    for (const auto& first_lf : files) {
+        if (first_lf->get_format() == nullptr || first_lf->size() == 0) {
+            continue;
+        }
+        for (const auto& second_lf : files) {
+            if (second_lf == first_lf || second_lf->get_format() == nullptr
+                || second_lf->size() == 0)
+            {
+                continue;
+            }
+            if (first_lf->get_format()->get_name()
+                != second_lf->get_format()->get_name())
+            {
+                continue;
+            }
+
+            // Orient the pair so that "older" is the file that starts
+            // first, since the overlap is its tail.
+            auto older = first_lf;
+            auto newer = second_lf;
+            if (newer->front().get_time_in_millis()
+                < older->front().get_time_in_millis())
+            {
+                std::swap(older, newer);
+            }
+
+            auto pair_key = std::make_pair(older->get_unique_path(),
+                                           newer->get_unique_path());
+            auto pair_sizes = std::make_pair(older->size(), newer->size());
+            auto checked_iter = checked_pairs.find(pair_key);
+            if (checked_iter != checked_pairs.end()
+                && checked_iter->second == pair_sizes)
+            {
+                continue;
+            }
+            checked_pairs[pair_key] = pair_sizes;
+
+            auto head_tv = newer->front().get_timeval();
+            if (older->back().get_timeval() < head_tv) {
+                continue;
+            }
+
+            // Find where the newer file's first line would land in the
+            // older file and check if the older file's suffix from there
+            // matches the newer file's prefix.
+            auto start_iter
+                = std::lower_bound(older->begin(), older->end(), head_tv);
+            auto suffix_len
+                = (size_t) std::distance(start_iter, older->end());
+            if (suffix_len == 0 || suffix_len > MAX_OVERLAP_LINES
+                || suffix_len > newer->size())
+            {
+                continue;
+            }
+
+            bool matched = true;
+            auto older_iter = start_iter;
+            auto newer_iter = newer->begin();
+            for (; older_iter != older->end(); ++older_iter, ++newer_iter) {
+                auto older_read = older->read_line(older_iter);
+                auto newer_read = newer->read_line(newer_iter);
+
+                if (older_read.isErr() || newer_read.isErr()) {
+                    matched = false;
+                    break;
+                }
+
+                auto older_sbr = older_read.unwrap();
+                auto newer_sbr = newer_read.unwrap();
+                if (older_sbr.length() != newer_sbr.length()
+                    || memcmp(older_sbr.get_data(),
+                              newer_sbr.get_data(),
+                              older_sbr.length())
+                        != 0)
+                {
+                    matched = false;
+                    break;
+                }
+            }
+            if (!matched) {
+                continue;
+            }
+
+            log_info("masking %zu overlapping lines in %s that duplicate "
+                     "the tail of %s",
+                     suffix_len,
+                     newer->get_filename().c_str(),
+                     older->get_filename().c_str());
+            for (size_t lpc = 0; lpc < suffix_len; lpc++) {
+                (*newer)[lpc].set_ignore(true);
+            }
+            retval = true;
+        }
+    }
+
+    return retval;
+}
+
 size_t
 rebuild_indexes(nonstd::optional<ui_clock::time_point> deadline)
 {
+    lnav::stalls::stage_guard indexing_sg(lnav::stalls::STAGE_INDEXING);
     logfile_sub_source& lss = lnav_data.ld_log_source;
     textview_curses& log_view = lnav_data.ld_views[LNV_LOG];
     textview_curses& text_view = lnav_data.ld_views[LNV_TEXT];
@@ -267,6 +679,8 @@ rebuild_indexes(nonstd::optional<ui_clock::time_point> deadline)
         lnav_data.ld_active_files.close_files(closed_files);
     }
 
+    prescan_logfiles_in_parallel(deadline);
+
     auto result = lss.rebuild_index(deadline);
     if (result != logfile_sub_source::rebuild_result::rr_no_change) {
         size_t new_count = lss.text_line_count();
@@ -319,6 +733,12 @@ rebuild_indexes(nonstd::optional<ui_clock::time_point> deadline)
             }
         }
 
+        if (detect_copytruncate_overlaps()) {
+            // The masked lines are already in the merged index, so it
+            // has to be rebuilt from scratch to drop them.
+            lss.set_force_rebuild();
+        }
+
         retval += 1;
     }
 
@@ -337,6 +757,19 @@ rebuild_indexes(nonstd::optional<ui_clock::time_point> deadline)
         lnav_data.ld_scroll_broadcaster(tc);
     };
 
+    if (lnav::log::watch::have_watch_exprs()) {
+        // Watch expressions run after indexing, a bounded batch per file
+        // per cycle, so the scan itself can use the parallel path and a
+        // watch added mid-session drains over the corpus progressively
+        // instead of freezing the UI.
+        for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+            lnav::log::watch::catch_up(*lf, WATCH_LINES_PER_CYCLE);
+        }
+    }
+
+    hibernate_idle_files();
+    check_memory_budget();
+
     return retval;
 }
 
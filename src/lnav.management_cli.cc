@@ -27,10 +27,12 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <future>
 #include <queue>
 
 #include "lnav.management_cli.hh"
 
+#include "base/future_util.hh"
 #include "base/itertools.hh"
 #include "base/result.h"
 #include "base/string_util.hh"
@@ -38,6 +40,7 @@
 #include "itertools.similar.hh"
 #include "log_format.hh"
 #include "log_format_ext.hh"
+#include "logfile.hh"
 #include "mapbox/variant.hpp"
 #include "regex101.import.hh"
 #include "session_data.hh"
@@ -71,6 +74,12 @@ struct subcmd_format_t {
     using action_t = std::function<perform_result_t(const subcmd_format_t&)>;
 
     CLI::App* sf_format_app{nullptr};
+    /**
+     * All of the format names given on the command-line.  The action is run
+     * once per name, with sf_name set to the one being operated on, so that
+     * CI loops can batch N formats into a single invocation.
+     */
+    std::vector<std::string> sf_names;
     std::string sf_name;
     CLI::App* sf_regex_app{nullptr};
     std::string sf_regex_name;
@@ -711,8 +720,94 @@ struct subcmd_regex101_t {
     }
 };
 
-using operations_v
-    = mapbox::util::variant<no_subcmd_t, subcmd_format_t, subcmd_regex101_t>;
+struct subcmd_cache_t {
+    using action_t = std::function<perform_result_t(const subcmd_cache_t&)>;
+
+    CLI::App* sc_app{nullptr};
+    action_t sc_action;
+    std::vector<std::string> sc_paths;
+
+    subcmd_cache_t& set_action(action_t act)
+    {
+        if (!this->sc_action) {
+            this->sc_action = std::move(act);
+        }
+        return *this;
+    }
+
+    static perform_result_t default_action(const subcmd_cache_t& sc)
+    {
+        auto um = console::user_message::error(
+            "expecting an operation to perform on the index cache");
+        um.with_help(
+            sc.sc_app->get_subcommands({})
+            | lnav::itertools::fold(
+                subcmd_reducer, attr_line_t{"the available operations are:"}));
+
+        return {um};
+    }
+
+    static perform_result_t warm_one(const std::string& path)
+    {
+        perform_result_t retval;
+        logfile_open_options loo;
+        auto open_res = logfile::open(path, loo);
+
+        if (open_res.isErr()) {
+            retval.emplace_back(
+                console::user_message::error(
+                    attr_line_t("unable to open file: ")
+                        .append(lnav::roles::file(path)))
+                    .with_reason(open_res.unwrapErr()));
+            return retval;
+        }
+
+        auto lf = open_res.unwrap();
+
+        lf->rebuild_index();
+        if (lf->get_format() == nullptr) {
+            retval.emplace_back(
+                console::user_message::warning(
+                    attr_line_t("no format matched: ")
+                        .append(lnav::roles::file(path)))
+                    .with_note("only files that match a log format have "
+                               "their index cached"));
+        } else {
+            retval.emplace_back(console::user_message::ok(
+                attr_line_t("indexed ")
+                    .append(lnav::roles::number(fmt::to_string(lf->size())))
+                    .append(" lines in ")
+                    .append(lnav::roles::file(path))));
+        }
+
+        return retval;
+    }
+
+    static perform_result_t warm_action(const subcmd_cache_t& sc)
+    {
+        perform_result_t retval;
+
+        // Indexing is dominated by scanning/decompressing each file, so
+        // farm the files out to parallel tasks and collect the messages
+        // as they finish.
+        lnav::futures::future_queue<perform_result_t> fq(
+            [&retval](auto& one_res) {
+                retval.insert(
+                    retval.end(), one_res.begin(), one_res.end());
+            });
+
+        for (const auto& path : sc.sc_paths) {
+            fq.push_back(
+                std::async(std::launch::async, warm_one, path));
+        }
+        fq.pop_to();
+
+        return retval;
+    }
+};
+
+using operations_v = mapbox::util::
+    variant<no_subcmd_t, subcmd_format_t, subcmd_regex101_t, subcmd_cache_t>;
 
 class operations {
 public:
@@ -732,6 +827,7 @@ describe_cli(CLI::App& app, int argc, char* argv[])
 
     subcmd_format_t format_args;
     subcmd_regex101_t regex101_args;
+    subcmd_cache_t cache_args;
 
     {
         auto* subcmd_format
@@ -742,10 +838,9 @@ describe_cli(CLI::App& app, int argc, char* argv[])
                       retval->o_ops = format_args;
                   });
         format_args.sf_format_app = subcmd_format;
-        subcmd_format
-            ->add_option(
-                "format_name", format_args.sf_name, "the name of the format")
-            ->expected(1);
+        subcmd_format->add_option("format_name",
+                                  format_args.sf_names,
+                                  "the name(s) of the formats to operate on");
 
         {
             subcmd_format
@@ -883,6 +978,32 @@ describe_cli(CLI::App& app, int argc, char* argv[])
         }
     }
 
+    {
+        auto* subcmd_cache
+            = app.add_subcommand("cache",
+                                 "perform operations on the index cache")
+                  ->callback([&]() {
+                      cache_args.set_action(subcmd_cache_t::default_action);
+                      retval->o_ops = cache_args;
+                  });
+        cache_args.sc_app = subcmd_cache;
+
+        {
+            auto* subcmd_cache_warm
+                = subcmd_cache
+                      ->add_subcommand(
+                          "warm",
+                          "index the given files so that opening them "
+                          "in the viewer can restore the index instead "
+                          "of rebuilding it")
+                      ->callback([&]() {
+                          cache_args.set_action(subcmd_cache_t::warm_action);
+                      });
+            subcmd_cache_warm->add_option(
+                "path", cache_args.sc_paths, "the files to index");
+        }
+    }
+
     app.parse(argc, argv);
 
     return retval;
@@ -902,8 +1023,25 @@ perform(std::shared_ptr<operations> opts)
 
             return {um};
         },
-        [](const subcmd_format_t& sf) { return sf.sf_action(sf); },
-        [](const subcmd_regex101_t& sr) { return sr.sr_action(sr); });
+        [](const subcmd_format_t& sf) -> perform_result_t {
+            if (sf.sf_names.empty()) {
+                return sf.sf_action(sf);
+            }
+
+            perform_result_t retval;
+
+            for (const auto& name : sf.sf_names) {
+                auto one_sf = sf;
+
+                one_sf.sf_name = name;
+                auto one_res = sf.sf_action(one_sf);
+                retval.insert(
+                    retval.end(), one_res.begin(), one_res.end());
+            }
+            return retval;
+        },
+        [](const subcmd_regex101_t& sr) { return sr.sr_action(sr); },
+        [](const subcmd_cache_t& sc) { return sc.sc_action(sc); });
 }
 
 }  // namespace management
@@ -69,6 +69,7 @@
 #include "readline_curses.hh"
 #include "readline_highlighters.hh"
 #include "readline_possibilities.hh"
+#include "profiler.hh"
 #include "relative_time.hh"
 #include "scn/scn.h"
 #include "service_tags.hh"
@@ -331,6 +332,20 @@ com_current_time(exec_context& ec,
     return Ok(retval);
 }
 
+static Result<std::string, lnav::console::user_message>
+com_cache_stats(exec_context& ec,
+                std::string cmdline,
+                std::vector<std::string>& args)
+{
+    auto stats = get_sql_result_cache_stats();
+
+    return Ok(
+        fmt::format(FMT_STRING("cached results: {}; hits: {}; misses: {}"),
+                    stats.scs_entry_count,
+                    stats.scs_hits,
+                    stats.scs_misses));
+}
+
 static Result<std::string, lnav::console::user_message>
 com_goto(exec_context& ec, std::string cmdline, std::vector<std::string>& args)
 {
@@ -842,28 +857,20 @@ csv_needs_quoting(const std::string& str)
     return (str.find_first_of(",\"\r\n") != std::string::npos);
 }
 
-static std::string
-csv_quote_string(const std::string& str)
-{
-    static const std::regex csv_column_quoter("\"");
-
-    std::string retval = std::regex_replace(str, csv_column_quoter, "\"\"");
-
-    retval.insert(0, 1, '\"');
-    retval.append(1, '\"');
-
-    return retval;
-}
-
 static void
-csv_write_string(FILE* outfile, const std::string& str)
+csv_append_string(std::string& buffer, const std::string& str)
 {
     if (csv_needs_quoting(str)) {
-        std::string quoted_str = csv_quote_string(str);
-
-        fmt::fprintf(outfile, "%s", quoted_str);
+        buffer.push_back('"');
+        for (const auto ch : str) {
+            if (ch == '"') {
+                buffer.push_back('"');
+            }
+            buffer.push_back(ch);
+        }
+        buffer.push_back('"');
     } else {
-        fmt::fprintf(outfile, "%s", str);
+        buffer.append(str);
     }
 }
 
@@ -875,6 +882,156 @@ yajl_writer(void* context, const char* str, size_t len)
     fwrite(str, len, 1, file);
 }
 
+/**
+ * Append a JSON-escaped version of the given string to the buffer.  The
+ * string is scanned for characters that need escaping and the clean
+ * spans in between are appended in bulk, so a cell with nothing to
+ * escape is reduced to one scan and one append.
+ */
+static void
+json_append_escaped(std::string& buffer, const char* str, size_t len)
+{
+    static const char HEX[] = "0123456789abcdef";
+    size_t start = 0;
+
+    buffer.push_back('"');
+    for (size_t lpc = 0; lpc < len; lpc++) {
+        const auto ch = (unsigned char) str[lpc];
+
+        if (ch >= 0x20 && ch != '"' && ch != '\\') {
+            continue;
+        }
+
+        buffer.append(str + start, lpc - start);
+        switch (ch) {
+            case '"':
+                buffer.append("\\\"");
+                break;
+            case '\\':
+                buffer.append("\\\\");
+                break;
+            case '\b':
+                buffer.append("\\b");
+                break;
+            case '\f':
+                buffer.append("\\f");
+                break;
+            case '\n':
+                buffer.append("\\n");
+                break;
+            case '\r':
+                buffer.append("\\r");
+                break;
+            case '\t':
+                buffer.append("\\t");
+                break;
+            default:
+                buffer.append("\\u00");
+                buffer.push_back(HEX[ch >> 4]);
+                buffer.push_back(HEX[ch & 0x0f]);
+                break;
+        }
+        start = lpc + 1;
+    }
+    buffer.append(str + start, len - start);
+    buffer.push_back('"');
+}
+
+/**
+ * Write the DB view rows as JSON-lines without going through a yajl
+ * generator.  The object keys are escaped once up front and each cell
+ * only needs its value formatted, which makes a big difference for the
+ * headless extraction jobs that funnel millions of rows through
+ * :write-jsonlines-to.
+ *
+ * @return The number of rows written, or nothing if a column requires
+ *   the generic writer (embedded JSON cells are re-parsed by it so they
+ *   are emitted as JSON values rather than strings).
+ */
+static nonstd::optional<size_t>
+write_jsonlines_rows(FILE* outfile, bool dry_run)
+{
+    static constexpr size_t FLUSH_SIZE = 64 * 1024;
+
+    struct column_plan {
+        std::string cp_prefix;
+        int cp_type;
+    };
+
+    auto& dls = lnav_data.ld_db_row_source;
+    std::vector<column_plan> plan;
+
+    if (dls.dls_headers.empty()) {
+        return nonstd::nullopt;
+    }
+
+    plan.reserve(dls.dls_headers.size());
+    for (size_t col = 0; col < dls.dls_headers.size(); col++) {
+        const auto& hm = dls.dls_headers[col];
+
+        if (hm.hm_sub_type == 74) {
+            return nonstd::nullopt;
+        }
+
+        column_plan cp;
+
+        cp.cp_prefix.push_back(col == 0 ? '{' : ',');
+        json_append_escaped(
+            cp.cp_prefix, hm.hm_name.c_str(), hm.hm_name.size());
+        cp.cp_prefix.push_back(':');
+        cp.cp_type = hm.hm_column_type;
+        plan.emplace_back(std::move(cp));
+    }
+
+    std::string buffer;
+    size_t retval = 0;
+
+    buffer.reserve(FLUSH_SIZE + 4 * 1024);
+    for (size_t row = 0; row < dls.dls_rows.size(); row++) {
+        if (dry_run && row > 10) {
+            break;
+        }
+
+        for (size_t col = 0; col < plan.size(); col++) {
+            const auto* cell = dls.dls_rows[row][col];
+
+            buffer.append(plan[col].cp_prefix);
+            if (cell == db_label_source::NULL_STR) {
+                buffer.append("null");
+                continue;
+            }
+
+            auto cell_len = strlen(cell);
+
+            switch (plan[col].cp_type) {
+                case SQLITE_FLOAT:
+                case SQLITE_INTEGER:
+                    if (cell_len == 0) {
+                        buffer.append("null");
+                    } else {
+                        buffer.append(cell, cell_len);
+                    }
+                    break;
+                default:
+                    json_append_escaped(buffer, cell, cell_len);
+                    break;
+            }
+        }
+        buffer.append("}\n");
+        retval += 1;
+
+        if (buffer.size() >= FLUSH_SIZE) {
+            fwrite(buffer.c_str(), buffer.size(), 1, outfile);
+            buffer.clear();
+        }
+    }
+    if (!buffer.empty()) {
+        fwrite(buffer.c_str(), buffer.size(), 1, outfile);
+    }
+
+    return retval;
+}
+
 static void
 json_write_row(yajl_gen handle,
                int row,
@@ -1098,29 +1255,38 @@ com_save_to(exec_context& ec,
         return ec.make_error("unable to open file -- {}", split_args[0]);
     } else {
         toclose = outfile;
+        /* The writers that have not been converted to batch into their
+         * own buffer still benefit from fewer trips into the kernel. */
+        setvbuf(outfile, nullptr, _IOFBF, 256 * 1024);
     }
 
     int line_count = 0;
 
     if (args[0] == "write-csv-to") {
-        std::vector<std::vector<const char*>>::iterator row_iter;
-        std::vector<const char*>::iterator iter;
+        /* Rows are formatted into a buffer that is flushed in large
+         * batches, a write call per cell makes big exports many times
+         * slower. */
+        static const size_t FLUSH_SIZE = 256 * 1024;
+
         std::vector<db_label_source::header_meta>::iterator hdr_iter;
+        std::string buffer;
         bool first = true;
 
+        buffer.reserve(FLUSH_SIZE + 1024);
         for (hdr_iter = dls.dls_headers.begin();
              hdr_iter != dls.dls_headers.end();
              ++hdr_iter)
         {
             if (!first) {
-                fprintf(outfile, ",");
+                buffer.push_back(',');
             }
-            csv_write_string(outfile, hdr_iter->hm_name);
+            csv_append_string(buffer, hdr_iter->hm_name);
             first = false;
         }
-        fprintf(outfile, "\n");
+        buffer.push_back('\n');
 
-        for (row_iter = dls.dls_rows.begin(); row_iter != dls.dls_rows.end();
+        for (auto row_iter = dls.dls_rows.begin();
+             row_iter != dls.dls_rows.end();
              ++row_iter)
         {
             if (ec.ec_dry_run && distance(dls.dls_rows.begin(), row_iter) > 10)
@@ -1129,20 +1295,28 @@ com_save_to(exec_context& ec,
             }
 
             first = true;
-            for (iter = row_iter->begin(); iter != row_iter->end(); ++iter) {
+            for (auto iter = row_iter->begin(); iter != row_iter->end(); ++iter)
+            {
                 if (!first) {
-                    fprintf(outfile, ",");
+                    buffer.push_back(',');
                 }
-                csv_write_string(
-                    outfile,
+                csv_append_string(
+                    buffer,
                     anonymize ? ta.next(string_fragment::from_c_str(*iter))
                               : *iter);
                 first = false;
             }
-            fprintf(outfile, "\n");
+            buffer.push_back('\n');
+            if (buffer.size() >= FLUSH_SIZE) {
+                fwrite(buffer.data(), 1, buffer.size(), outfile);
+                buffer.clear();
+            }
 
             line_count += 1;
         }
+        if (!buffer.empty()) {
+            fwrite(buffer.data(), 1, buffer.size(), outfile);
+        }
     } else if (args[0] == "write-cols-to" || args[0] == "write-table-to") {
         bool first = true;
 
@@ -1242,19 +1416,28 @@ com_save_to(exec_context& ec,
             }
         }
     } else if (args[0] == "write-jsonlines-to") {
-        yajlpp_gen gen;
+        nonstd::optional<size_t> fast_count;
 
-        yajl_gen_config(gen, yajl_gen_beautify, 0);
-        yajl_gen_config(gen, yajl_gen_print_callback, yajl_writer, outfile);
+        if (!anonymize) {
+            fast_count = write_jsonlines_rows(outfile, ec.ec_dry_run);
+        }
+        if (fast_count) {
+            line_count = fast_count.value();
+        } else {
+            yajlpp_gen gen;
 
-        for (size_t row = 0; row < dls.dls_rows.size(); row++) {
-            if (ec.ec_dry_run && row > 10) {
-                break;
-            }
+            yajl_gen_config(gen, yajl_gen_beautify, 0);
+            yajl_gen_config(gen, yajl_gen_print_callback, yajl_writer, outfile);
 
-            json_write_row(gen, row, ta, anonymize);
-            yajl_gen_reset(gen, "\n");
-            line_count += 1;
+            for (size_t row = 0; row < dls.dls_rows.size(); row++) {
+                if (ec.ec_dry_run && row > 10) {
+                    break;
+                }
+
+                json_write_row(gen, row, ta, anonymize);
+                yajl_gen_reset(gen, "\n");
+                line_count += 1;
+            }
         }
     } else if (args[0] == "write-screen-to") {
         bool wrapped = tc->get_word_wrap();
@@ -1907,7 +2090,7 @@ com_filter(exec_context& ec,
                       pf->get_index(),
                       args[1].c_str());
             fs.add_filter(pf);
-            tss->text_filters_changed();
+            ec.filters_changed(tss);
 
             retval = "info: filter now active";
         }
@@ -1937,7 +2120,7 @@ com_delete_filter(exec_context& ec,
             retval = "";
         } else if (fs.delete_filter(args[1])) {
             retval = "info: deleted filter";
-            tss->text_filters_changed();
+            ec.filters_changed(tss);
         } else {
             return ec.make_error("unknown filter -- {}", args[1]);
         }
@@ -1973,7 +2156,7 @@ com_enable_filter(exec_context& ec,
             retval = "";
         } else {
             fs.set_filter_enabled(lf, true);
-            tss->text_filters_changed();
+            ec.filters_changed(tss);
             retval = "info: filter enabled";
         }
     } else {
@@ -2008,7 +2191,7 @@ com_disable_filter(exec_context& ec,
             retval = "";
         } else {
             fs.set_filter_enabled(lf, false);
-            tss->text_filters_changed();
+            ec.filters_changed(tss);
             retval = "info: filter disabled";
         }
     } else {
@@ -3709,6 +3892,7 @@ com_load_session(exec_context& ec,
     if (args.empty()) {
     } else if (!ec.ec_dry_run) {
         load_session();
+        load_time_bookmarks();
         lnav_data.ld_views[LNV_LOG].reload_data();
     }
 
@@ -3775,6 +3959,15 @@ com_export_session_to(exec_context& ec,
             outfile = open_res.unwrap();
         } else if (lnav_data.ld_flags & LNF_SECURE_MODE) {
             return ec.make_error("{} -- unavailable in secure mode", args[0]);
+        } else if (endswith(fn, "/") || ghc::filesystem::is_directory(fn)) {
+            auto bundle_res = lnav::session::export_bundle_to(fn);
+
+            if (bundle_res.isErr()) {
+                return Err(bundle_res.unwrapErr());
+            }
+
+            return Ok(fmt::format(
+                FMT_STRING("info: wrote session bundle to -- {}"), fn));
         } else {
             if ((outfile = fopen(fn.c_str(), "we")) == nullptr) {
                 return ec.make_error("unable to open file -- {}", fn);
@@ -4070,6 +4263,39 @@ com_show_unmarked(exec_context& ec,
     return Ok(retval);
 }
 
+static Result<std::string, lnav::console::user_message>
+com_hide_duplicates(exec_context& ec,
+                    std::string cmdline,
+                    std::vector<std::string>& args)
+{
+    std::string retval = "info: hid duplicate messages";
+
+    if (args.empty()) {
+    } else if (ec.ec_dry_run) {
+        retval = "";
+    } else {
+        lnav_data.ld_log_source.set_duplicates_hidden(true);
+    }
+
+    return Ok(retval);
+}
+
+static Result<std::string, lnav::console::user_message>
+com_show_duplicates(exec_context& ec,
+                    std::string cmdline,
+                    std::vector<std::string>& args)
+{
+    std::string retval = "info: showing duplicate messages";
+
+    if (ec.ec_dry_run) {
+        retval = "";
+    } else {
+        lnav_data.ld_log_source.set_duplicates_hidden(false);
+    }
+
+    return Ok(retval);
+}
+
 static Result<std::string, lnav::console::user_message>
 com_rebuild(exec_context& ec,
             std::string cmdline,
@@ -4084,6 +4310,55 @@ com_rebuild(exec_context& ec,
     return Ok(std::string());
 }
 
+static Result<std::string, lnav::console::user_message>
+com_start_profile(exec_context& ec,
+                  std::string cmdline,
+                  std::vector<std::string>& args)
+{
+    std::string retval;
+
+    if (args.empty()) {
+    } else if (!ec.ec_dry_run) {
+        auto start_res = lnav::profiler::start();
+
+        if (start_res.isErr()) {
+            return ec.make_error("{}", start_res.unwrapErr());
+        }
+        retval = "info: profiler started, use :stop-profile to save the "
+                 "collapsed stacks";
+    }
+
+    return Ok(retval);
+}
+
+static Result<std::string, lnav::console::user_message>
+com_stop_profile(exec_context& ec,
+                 std::string cmdline,
+                 std::vector<std::string>& args)
+{
+    std::string retval;
+
+    if (args.empty()) {
+        args.emplace_back("filename");
+    } else if (!ec.ec_dry_run) {
+        auto out_path = args.size() > 1
+            ? ghc::filesystem::path(trim(remaining_args(cmdline, args)))
+            : lnav::paths::workdir()
+                / fmt::format(FMT_STRING("profile-{}.folded"), getpid());
+        auto stop_res = lnav::profiler::stop(out_path);
+
+        if (stop_res.isErr()) {
+            return ec.make_error("{}", stop_res.unwrapErr());
+        }
+        retval = fmt::format(
+            FMT_STRING("info: wrote {} samples to {}"),
+            stop_res.unwrap(),
+            out_path.string());
+    }
+
+    return Ok(retval);
+}
+
 static Result<std::string, lnav::console::user_message>
 com_shexec(exec_context& ec,
            std::string cmdline,
@@ -4279,6 +4554,37 @@ com_eval(exec_context& ec, std::string cmdline, std::vector<std::string>& args)
     return Ok(retval);
 }
 
+static Result<std::string, lnav::console::user_message>
+com_parallel_query(exec_context& ec,
+                   std::string cmdline,
+                   std::vector<std::string>& args)
+{
+    std::string retval;
+
+    if (args.empty()) {
+    } else if (args.size() > 1) {
+        auto query = remaining_args(cmdline, args);
+
+        if (ec.ec_dry_run) {
+            attr_line_t al(query);
+
+            lnav_data.ld_preview_status_source.get_description().set_value(
+                "The query to be executed:");
+
+            lnav_data.ld_preview_source.replace_with(al);
+
+            return Ok(std::string());
+        }
+
+        std::string alt_msg;
+        return execute_parallel_query(ec, query, alt_msg);
+    } else {
+        return ec.make_error("expecting a query to execute");
+    }
+
+    return Ok(retval);
+}
+
 static Result<std::string, lnav::console::user_message>
 com_config(exec_context& ec,
            std::string cmdline,
@@ -4548,6 +4854,47 @@ com_spectrogram(exec_context& ec,
     return Ok(retval);
 }
 
+static Result<std::string, lnav::console::user_message>
+com_sort_db_view(exec_context& ec,
+                 std::string cmdline,
+                 std::vector<std::string>& args)
+{
+    std::string retval;
+
+    if (args.empty()) {
+        return Ok(retval);
+    }
+    if (args.size() < 2) {
+        return ec.make_error("expecting a column name to sort by");
+    }
+
+    auto& dls = lnav_data.ld_db_row_source;
+    auto col_index_opt = dls.column_name_to_index(args[1]);
+
+    if (!col_index_opt) {
+        return ec.make_error("unknown column -- {}", args[1]);
+    }
+
+    bool descending = false;
+    if (args.size() > 2) {
+        if (args[2] == "desc") {
+            descending = true;
+        } else if (args[2] != "asc") {
+            return ec.make_error("expecting 'asc' or 'desc', not: {}", args[2]);
+        }
+    }
+
+    if (!ec.ec_dry_run) {
+        dls.sort_rows_by_column(col_index_opt.value(), descending);
+        lnav_data.ld_views[LNV_DB].reload_data();
+        retval = fmt::format(FMT_STRING("info: sorted {} rows by -- {}"),
+                             dls.dls_rows.size(),
+                             args[1]);
+    }
+
+    return Ok(retval);
+}
+
 static Result<std::string, lnav::console::user_message>
 com_quit(exec_context& ec, std::string cmdline, std::vector<std::string>& args)
 {
@@ -4933,6 +5280,12 @@ readline_context::command_t STD_COMMANDS[] = {
      help_text(":current-time")
          .with_summary("Print the current time in human-readable form and "
                        "seconds since the epoch")},
+    {"cache-stats",
+     com_cache_stats,
+
+     help_text(":cache-stats")
+         .with_summary("Print statistics for the session's SQL result "
+                       "cache")},
     {"goto",
      com_goto,
 
@@ -5108,6 +5461,22 @@ readline_context::command_t STD_COMMANDS[] = {
          .with_summary("Show lines that have not been bookmarked")
          .with_opposites({"show-unmarked-lines"})
          .with_tags({"filtering", "bookmarks"})},
+    {"hide-duplicate-messages",
+     com_hide_duplicates,
+
+     help_text(":hide-duplicate-messages")
+         .with_summary("Hide messages that repeat an earlier message, "
+                       "ignoring numbers, so only the first occurrence "
+                       "is shown")
+         .with_tags({"filtering"})},
+    {"show-duplicate-messages",
+     com_show_duplicates,
+
+     help_text(":show-duplicate-messages")
+         .with_summary("Show messages that were hidden by the "
+                       "'hide-duplicate-messages' command")
+         .with_opposites({"hide-duplicate-messages"})
+         .with_tags({"filtering"})},
     {"highlight",
      com_highlight,
 
@@ -5626,14 +5995,35 @@ readline_context::command_t STD_COMMANDS[] = {
      help_text(":export-session-to")
          .with_summary("Export the current lnav state to an executable lnav "
                        "script file that contains the commands needed to "
-                       "restore the current session")
-         .with_parameter(help_text("path", "The path to the file to write"))
+                       "restore the current session.  If the path is a "
+                       "directory, a self-contained bundle with copies of "
+                       "the log files and their indexes is written instead")
+         .with_parameter(
+             help_text("path", "The path to the file or directory to write"))
          .with_tags({"io", "scripting"})},
     {"rebuild",
      com_rebuild,
      help_text(":rebuild")
          .with_summary("Forcefully rebuild file indexes")
          .with_tags({"scripting"})},
+    {"start-profile",
+     com_start_profile,
+     help_text(":start-profile")
+         .with_summary("Start capturing stack samples of lnav itself so "
+                       "slowness can be diagnosed from the field")
+         .with_example({"To start capturing samples", "start-profile"})},
+    {"stop-profile",
+     com_stop_profile,
+     help_text(":stop-profile")
+         .with_parameter(
+             help_text("path", "The path to write the collapsed stacks to")
+                 .optional())
+         .with_summary("Stop capturing stack samples and write the stacks "
+                       "in the collapsed format used by flamegraph tooling, "
+                       "to the work directory if no path is given")
+         .with_example(
+             {"To save the profile to 'lnav.folded'",
+              "stop-profile lnav.folded"})},
     {"set-min-log-level",
      com_set_min_log_level,
 
@@ -5690,6 +6080,19 @@ readline_context::command_t STD_COMMANDS[] = {
          .with_tags({"scripting"})
          .with_examples({{"To substitute the table name from a variable",
                           ";SELECT * FROM ${table}"}})},
+    {"parallel-query",
+     com_parallel_query,
+
+     help_text(":parallel-query")
+         .with_summary(
+             "Execute a SQL query after warming the log tables' value "
+             "caches in parallel, one task per file.  Useful for analytic "
+             "queries that aggregate over most of the log lines")
+         .with_parameter(help_text("query", "The SQL query to execute"))
+         .with_tags({"scripting"})
+         .with_example({"To count the lines for each log level",
+                        "SELECT log_level, count(*) FROM all_logs GROUP BY "
+                        "log_level"})},
     {"config",
      com_config,
 
@@ -5727,6 +6130,19 @@ readline_context::command_t STD_COMMANDS[] = {
          .with_example(
              {"To visualize the sc_bytes field in the access_log format",
               "sc_bytes"})},
+    {"sort-db-view",
+     com_sort_db_view,
+
+     help_text(":sort-db-view")
+         .with_summary("Sort the DB view rows by the given column without "
+                       "re-running the query")
+         .with_parameter(
+             help_text("column", "The name of the column to sort by"))
+         .with_parameter(
+             help_text("direction", "The sort direction, 'asc' or 'desc'")
+                 .optional())
+         .with_example({"To sort by the total column in descending order",
+                        "total desc"})},
     {"quit",
      com_quit,
 
@@ -36,6 +36,7 @@
 
 #include "lnav_config.hh"
 
+#include <ctype.h>
 #include <fcntl.h>
 #include <fmt/format.h>
 #include <glob.h>
@@ -1075,6 +1076,22 @@ static const struct json_path_container logfile_handlers = {
         .with_min_value(1)
         .for_field(&_lnav_config::lc_logfile,
                    &lnav::logfile::config::lc_max_unrecognized_lines),
+    yajlpp::property_handler("decompress-block-cache-size")
+        .with_synopsis("<bytes>")
+        .with_description("The size of the cache of decompressed blocks "
+                          "shared by all compressed files")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_decompress_block_cache_size),
+    yajlpp::property_handler("hibernate-idle-time")
+        .with_synopsis("<seconds>")
+        .with_description("The number of seconds a hidden file can go "
+                          "unread before its index is moved to the disk "
+                          "cache and its descriptor is closed, or zero to "
+                          "disable hibernation")
+        .with_min_value(0)
+        .for_field(&_lnav_config::lc_logfile,
+                   &lnav::logfile::config::lc_hibernate_idle_time),
 };
 
 static const struct json_path_container ssh_config_handlers = {
@@ -1324,6 +1341,28 @@ const json_path_container lnav_config_handlers = json_path_container {
 }
     .with_schema_id(*SUPPORTED_CONFIG_SCHEMAS.cbegin());
 
+void
+key_map::compile()
+{
+    this->km_single_cmd.fill(nullptr);
+    for (const auto& pair : this->km_seq_to_cmd) {
+        const auto& seq = pair.first;
+
+        // Only sequences in the exact form the input path generates
+        // ("x" followed by two lowercase hex digits) go in the dense
+        // table, anything else still goes through the map.
+        if (seq.size() != 3 || seq[0] != 'x' || !isxdigit(seq[1])
+            || !isxdigit(seq[2]) || isupper(seq[1]) || isupper(seq[2]))
+        {
+            continue;
+        }
+
+        auto index = strtoul(&seq.c_str()[1], nullptr, 16);
+
+        this->km_single_cmd[index] = &pair.second;
+    }
+}
+
 class active_key_map_listener : public lnav_config_listener {
 public:
     void reload_config(error_reporter& reporter) override
@@ -1335,6 +1374,7 @@ public:
             lnav_config.lc_active_keymap.km_seq_to_cmd[pair.first]
                 = pair.second;
         }
+        lnav_config.lc_active_keymap.compile();
     }
 };
 
@@ -1485,6 +1525,11 @@ load_config(const std::vector<ghc::filesystem::path>& extra_paths,
         auto sample_path = lnav::paths::dotlnav() / "configs" / "default"
             / fmt::format(FMT_STRING("{}.sample"), bsf.get_name());
 
+        auto read_res = lnav::filesystem::read_file(sample_path);
+        if (read_res.isOk() && read_res.unwrap() == bsf.to_string_fragment()) {
+            // The sample is already up-to-date, don't dirty the file.
+            continue;
+        }
         auto write_res = lnav::filesystem::write_file(sample_path,
                                                       bsf.to_string_fragment());
         if (write_res.isErr()) {
@@ -1499,7 +1544,10 @@ load_config(const std::vector<ghc::filesystem::path>& extra_paths,
         log_info("loading builtin configuration into default");
         load_default_configs(lnav_default_config, "*", errors);
         log_info("loading builtin configuration into base");
-        load_default_configs(lnav_config, "*", errors);
+        // The builtin files were just parsed into the default config, so
+        // the base config can start from a copy instead of a second parse
+        // of the same JSON.
+        lnav_config = lnav_default_config;
 
         log_info("loading user configuration files");
         for (const auto& extra_path : extra_paths) {
@@ -33,6 +33,7 @@
 #define lnav_config_hh
 
 #include <functional>
+#include <array>
 #include <map>
 #include <set>
 #include <string>
@@ -83,6 +84,15 @@ struct key_command {
 
 struct key_map {
     std::map<std::string, key_command> km_seq_to_cmd;
+    /**
+     * Dispatch table for single-byte key sequences ("xNN", lowercase hex),
+     * pointing into km_seq_to_cmd, so the per-keystroke path is an array
+     * index instead of building a string and searching the map.  Rebuilt
+     * by compile() whenever the map changes.
+     */
+    std::array<const key_command*, 256> km_single_cmd{};
+
+    void compile();
 };
 
 enum class config_movement_mode : unsigned int {
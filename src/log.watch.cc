@@ -27,6 +27,10 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include "log.watch.hh"
 
 #include <sqlite3.h>
@@ -44,11 +48,76 @@ namespace lnav {
 namespace log {
 namespace watch {
 
+enum class bound_param : unsigned char {
+    env,
+    level,
+    time,
+    time_msecs,
+    format,
+    format_regex,
+    path,
+    unique_path,
+    text,
+    body,
+    opid,
+    raw_text,
+    tags,
+    value,
+};
+
+/**
+ * The bind plan for a single statement parameter, computed once at
+ * prepare time so evaluating an expression per-line does not have to
+ * re-classify parameter names with a chain of strcmp()s.
+ */
+struct watch_param {
+    int wp_index;
+    bound_param wp_kind;
+    /** Points into the prepared statement's storage. */
+    const char* wp_name;
+};
+
 struct compiled_watch_expr {
     auto_mem<sqlite3_stmt> cwe_stmt{sqlite3_finalize};
     bool cwe_enabled{true};
+    std::vector<watch_param> cwe_params;
+    /** The expression text, for telling a changed expression from a
+     * reloaded one. */
+    std::string cwe_expr;
+    /** The expression-set generation this expression first appeared in,
+     * so a backfill can evaluate just the newly added expressions. */
+    size_t cwe_generation{0};
 };
 
+static bound_param
+classify_bound_param(const char* name)
+{
+    static const std::map<std::string, bound_param> NAME_TO_KIND = {
+        {":log_level", bound_param::level},
+        {":log_time", bound_param::time},
+        {":log_time_msecs", bound_param::time_msecs},
+        {":log_format", bound_param::format},
+        {":log_format_regex", bound_param::format_regex},
+        {":log_path", bound_param::path},
+        {":log_unique_path", bound_param::unique_path},
+        {":log_text", bound_param::text},
+        {":log_body", bound_param::body},
+        {":log_opid", bound_param::opid},
+        {":log_raw_text", bound_param::raw_text},
+        {":log_tags", bound_param::tags},
+    };
+
+    if (name[0] == '$') {
+        return bound_param::env;
+    }
+
+    auto iter = NAME_TO_KIND.find(name);
+    if (iter != NAME_TO_KIND.end()) {
+        return iter->second;
+    }
+    return bound_param::value;
+}
+
 struct expressions : public lnav_config_listener {
     void reload_config(error_reporter& reporter) override
     {
@@ -61,6 +130,10 @@ struct expressions : public lnav_config_listener {
 
         const auto& cfg = injector::get<const logfile_sub_source_ns::config&>();
 
+        auto prev_exprs = std::move(this->e_watch_exprs);
+        auto next_generation = this->e_generation + 1;
+        auto generation_used = false;
+
         this->e_watch_exprs.clear();
         for (const auto& pair : cfg.c_watch_exprs) {
             auto stmt_str = fmt::format(FMT_STRING("SELECT 1 WHERE {}"),
@@ -94,8 +167,33 @@ struct expressions : public lnav_config_listener {
                 continue;
             }
 
+            auto param_count = sqlite3_bind_parameter_count(cwe.cwe_stmt.in());
+            for (int lpc = 0; lpc < param_count; lpc++) {
+                const auto* name
+                    = sqlite3_bind_parameter_name(cwe.cwe_stmt.in(), lpc + 1);
+
+                cwe.cwe_params.push_back(
+                    {lpc + 1, classify_bound_param(name), name});
+            }
+
+            // Carry over the generation of an unchanged expression so a
+            // config reload does not trigger a backfill over every file.
+            cwe.cwe_expr = pair.second.we_expr;
+            auto prev_iter = prev_exprs.find(pair.first);
+            if (prev_iter != prev_exprs.end()
+                && prev_iter->second.cwe_expr == cwe.cwe_expr)
+            {
+                cwe.cwe_generation = prev_iter->second.cwe_generation;
+            } else {
+                cwe.cwe_generation = next_generation;
+                generation_used = true;
+            }
+
             this->e_watch_exprs.emplace(pair.first, std::move(cwe));
         }
+        if (generation_used) {
+            this->e_generation = next_generation;
+        }
     }
 
     void unload_config() override {
@@ -103,16 +201,33 @@ struct expressions : public lnav_config_listener {
     }
 
     std::map<std::string, compiled_watch_expr> e_watch_exprs;
+    size_t e_generation{0};
 };
 
 static expressions exprs;
 
-void
-eval_with(logfile& lf, logfile::iterator ll)
+bool
+have_watch_exprs()
+{
+    return std::any_of(
+        exprs.e_watch_exprs.begin(),
+        exprs.e_watch_exprs.end(),
+        [](const auto& elem) { return elem.second.cwe_enabled; });
+}
+
+/**
+ * Evaluate the watch expressions with a generation newer than
+ * min_generation against the message starting at the given line.
+ */
+static void
+eval_line(logfile& lf, logfile::iterator ll, size_t min_generation)
 {
     if (std::none_of(exprs.e_watch_exprs.begin(),
                      exprs.e_watch_exprs.end(),
-                     [](const auto& elem) { return elem.second.cwe_enabled; }))
+                     [min_generation](const auto& elem) {
+                         return elem.second.cwe_enabled
+                             && elem.second.cwe_generation > min_generation;
+                     }))
     {
         return;
     }
@@ -130,193 +245,212 @@ eval_with(logfile& lf, logfile::iterator ll)
     format->annotate(line_number, sa, values);
 
     for (auto& watch_pair : exprs.e_watch_exprs) {
-        if (!watch_pair.second.cwe_enabled) {
+        if (!watch_pair.second.cwe_enabled
+            || watch_pair.second.cwe_generation <= min_generation)
+        {
             continue;
         }
 
         auto* stmt = watch_pair.second.cwe_stmt.in();
         sqlite3_reset(stmt);
 
-        auto count = sqlite3_bind_parameter_count(stmt);
         auto missing_column = false;
-        for (int lpc = 0; lpc < count; lpc++) {
-            const auto* name = sqlite3_bind_parameter_name(stmt, lpc + 1);
+        for (const auto& wp : watch_pair.second.cwe_params) {
+            const auto* name = wp.wp_name;
 
-            if (name[0] == '$') {
-                const char* env_value;
+            switch (wp.wp_kind) {
+                case bound_param::env: {
+                    const char* env_value;
 
-                if ((env_value = getenv(&name[1])) != nullptr) {
-                    sqlite3_bind_text(
-                        stmt, lpc + 1, env_value, -1, SQLITE_STATIC);
+                    if ((env_value = getenv(&name[1])) != nullptr) {
+                        sqlite3_bind_text(
+                            stmt, wp.wp_index, env_value, -1, SQLITE_STATIC);
+                    }
+                    break;
                 }
-                continue;
-            }
-            if (strcmp(name, ":log_level") == 0) {
-                sqlite3_bind_text(
-                    stmt, lpc + 1, ll->get_level_name(), -1, SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_time") == 0) {
-                auto len = sql_strftime(timestamp_buffer,
-                                        sizeof(timestamp_buffer),
-                                        ll->get_timeval(),
-                                        'T');
-                sqlite3_bind_text(
-                    stmt, lpc + 1, timestamp_buffer, len, SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_time_msecs") == 0) {
-                sqlite3_bind_int64(stmt, lpc + 1, ll->get_time_in_millis());
-                continue;
-            }
-            if (strcmp(name, ":log_format") == 0) {
-                const auto format_name = format->get_name();
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  format_name.get(),
-                                  format_name.size(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_format_regex") == 0) {
-                const auto pat_name = format->get_pattern_name(line_number);
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  pat_name.get(),
-                                  pat_name.size(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_path") == 0) {
-                const auto& filename = lf.get_filename();
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  filename.c_str(),
-                                  filename.length(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_unique_path") == 0) {
-                const auto& filename = lf.get_unique_path();
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  filename.c_str(),
-                                  filename.length(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_text") == 0) {
-                sqlite3_bind_text(stmt,
-                                  lpc + 1,
-                                  values.lvv_sbr.get_data(),
-                                  values.lvv_sbr.length(),
-                                  SQLITE_STATIC);
-                continue;
-            }
-            if (strcmp(name, ":log_body") == 0) {
-                auto body_attr_opt = get_string_attr(sa, SA_BODY);
-                if (body_attr_opt) {
-                    const auto& sar
-                        = body_attr_opt.value().saw_string_attr->sa_range;
-
+                case bound_param::level:
+                    sqlite3_bind_text(stmt,
+                                      wp.wp_index,
+                                      ll->get_level_name(),
+                                      -1,
+                                      SQLITE_STATIC);
+                    break;
+                case bound_param::time: {
+                    auto len = sql_strftime(timestamp_buffer,
+                                            sizeof(timestamp_buffer),
+                                            ll->get_timeval(),
+                                            'T');
                     sqlite3_bind_text(stmt,
-                                      lpc + 1,
-                                      values.lvv_sbr.get_data_at(sar.lr_start),
-                                      sar.length(),
+                                      wp.wp_index,
+                                      timestamp_buffer,
+                                      len,
                                       SQLITE_STATIC);
-                } else {
-                    sqlite3_bind_null(stmt, lpc + 1);
+                    break;
                 }
-                continue;
-            }
-            if (strcmp(name, ":log_opid") == 0) {
-                auto opid_attr_opt = get_string_attr(sa, logline::L_OPID);
-                if (opid_attr_opt) {
-                    const auto& sar
-                        = opid_attr_opt.value().saw_string_attr->sa_range;
-
+                case bound_param::time_msecs:
+                    sqlite3_bind_int64(
+                        stmt, wp.wp_index, ll->get_time_in_millis());
+                    break;
+                case bound_param::format: {
+                    const auto format_name = format->get_name();
                     sqlite3_bind_text(stmt,
-                                      lpc + 1,
-                                      values.lvv_sbr.get_data_at(sar.lr_start),
-                                      sar.length(),
+                                      wp.wp_index,
+                                      format_name.get(),
+                                      format_name.size(),
                                       SQLITE_STATIC);
-                } else {
-                    sqlite3_bind_null(stmt, lpc + 1);
+                    break;
                 }
-                continue;
-            }
-            if (strcmp(name, ":log_raw_text") == 0) {
-                auto res = lf.read_raw_message(ll);
-
-                if (res.isOk()) {
-                    raw_sbr = res.unwrap();
+                case bound_param::format_regex: {
+                    const auto pat_name = format->get_pattern_name(line_number);
                     sqlite3_bind_text(stmt,
-                                      lpc + 1,
-                                      raw_sbr.get_data(),
-                                      raw_sbr.length(),
+                                      wp.wp_index,
+                                      pat_name.get(),
+                                      pat_name.size(),
                                       SQLITE_STATIC);
+                    break;
                 }
-                continue;
-            }
-            if (strcmp(name, ":log_tags") == 0) {
-                const auto& bm = lf.get_bookmark_metadata();
-                auto bm_iter = bm.find(line_number);
-                if (bm_iter != bm.end() && !bm_iter->second.bm_tags.empty()) {
-                    const auto& meta = bm_iter->second;
-                    yajlpp_gen gen;
-
-                    yajl_gen_config(gen, yajl_gen_beautify, false);
+                case bound_param::path: {
+                    const auto& filename = lf.get_filename();
+                    sqlite3_bind_text(stmt,
+                                      wp.wp_index,
+                                      filename.c_str(),
+                                      filename.length(),
+                                      SQLITE_STATIC);
+                    break;
+                }
+                case bound_param::unique_path: {
+                    const auto& filename = lf.get_unique_path();
+                    sqlite3_bind_text(stmt,
+                                      wp.wp_index,
+                                      filename.c_str(),
+                                      filename.length(),
+                                      SQLITE_STATIC);
+                    break;
+                }
+                case bound_param::text:
+                    sqlite3_bind_text(stmt,
+                                      wp.wp_index,
+                                      values.lvv_sbr.get_data(),
+                                      values.lvv_sbr.length(),
+                                      SQLITE_STATIC);
+                    break;
+                case bound_param::body: {
+                    auto body_attr_opt = get_string_attr(sa, SA_BODY);
+                    if (body_attr_opt) {
+                        const auto& sar
+                            = body_attr_opt.value().saw_string_attr->sa_range;
+
+                        sqlite3_bind_text(
+                            stmt,
+                            wp.wp_index,
+                            values.lvv_sbr.get_data_at(sar.lr_start),
+                            sar.length(),
+                            SQLITE_STATIC);
+                    } else {
+                        sqlite3_bind_null(stmt, wp.wp_index);
+                    }
+                    break;
+                }
+                case bound_param::opid: {
+                    auto opid_attr_opt = get_string_attr(sa, logline::L_OPID);
+                    if (opid_attr_opt) {
+                        const auto& sar
+                            = opid_attr_opt.value().saw_string_attr->sa_range;
+
+                        sqlite3_bind_text(
+                            stmt,
+                            wp.wp_index,
+                            values.lvv_sbr.get_data_at(sar.lr_start),
+                            sar.length(),
+                            SQLITE_STATIC);
+                    } else {
+                        sqlite3_bind_null(stmt, wp.wp_index);
+                    }
+                    break;
+                }
+                case bound_param::raw_text: {
+                    auto res = lf.read_raw_message(ll);
 
+                    if (res.isOk()) {
+                        raw_sbr = res.unwrap();
+                        sqlite3_bind_text(stmt,
+                                          wp.wp_index,
+                                          raw_sbr.get_data(),
+                                          raw_sbr.length(),
+                                          SQLITE_STATIC);
+                    }
+                    break;
+                }
+                case bound_param::tags: {
+                    const auto& bm = lf.get_bookmark_metadata();
+                    auto bm_iter = bm.find(line_number);
+                    if (bm_iter != bm.end()
+                        && !bm_iter->second.bm_tags.empty())
                     {
-                        yajlpp_array arr(gen);
+                        const auto& meta = bm_iter->second;
+                        yajlpp_gen gen;
 
-                        for (const auto& str : meta.bm_tags) {
-                            arr.gen(str);
-                        }
-                    }
+                        yajl_gen_config(gen, yajl_gen_beautify, false);
 
-                    string_fragment sf = gen.to_string_fragment();
+                        {
+                            yajlpp_array arr(gen);
 
-                    sqlite3_bind_text(stmt,
-                                      lpc + 1,
-                                      sf.data(),
-                                      sf.length(),
-                                      SQLITE_TRANSIENT);
-                }
-                continue;
-            }
-            auto found = false;
-            for (const auto& lv : values.lvv_values) {
-                if (lv.lv_meta.lvm_name != &name[1]) {
-                    continue;
-                }
+                            for (const auto& str : meta.bm_tags) {
+                                arr.gen(str);
+                            }
+                        }
+
+                        string_fragment sf = gen.to_string_fragment();
 
-                found = true;
-                switch (lv.lv_meta.lvm_kind) {
-                    case value_kind_t::VALUE_BOOLEAN:
-                        sqlite3_bind_int64(stmt, lpc + 1, lv.lv_value.i);
-                        break;
-                    case value_kind_t::VALUE_FLOAT:
-                        sqlite3_bind_double(stmt, lpc + 1, lv.lv_value.d);
-                        break;
-                    case value_kind_t::VALUE_INTEGER:
-                        sqlite3_bind_int64(stmt, lpc + 1, lv.lv_value.i);
-                        break;
-                    case value_kind_t::VALUE_NULL:
-                        sqlite3_bind_null(stmt, lpc + 1);
-                        break;
-                    default:
                         sqlite3_bind_text(stmt,
-                                          lpc + 1,
-                                          lv.text_value(),
-                                          lv.text_length(),
+                                          wp.wp_index,
+                                          sf.data(),
+                                          sf.length(),
                                           SQLITE_TRANSIENT);
+                    }
+                    break;
+                }
+                case bound_param::value: {
+                    auto found = false;
+                    for (const auto& lv : values.lvv_values) {
+                        if (lv.lv_meta.lvm_name != &name[1]) {
+                            continue;
+                        }
+
+                        found = true;
+                        switch (lv.lv_meta.lvm_kind) {
+                            case value_kind_t::VALUE_BOOLEAN:
+                                sqlite3_bind_int64(
+                                    stmt, wp.wp_index, lv.lv_value.i);
+                                break;
+                            case value_kind_t::VALUE_FLOAT:
+                                sqlite3_bind_double(
+                                    stmt, wp.wp_index, lv.lv_value.d);
+                                break;
+                            case value_kind_t::VALUE_INTEGER:
+                                sqlite3_bind_int64(
+                                    stmt, wp.wp_index, lv.lv_value.i);
+                                break;
+                            case value_kind_t::VALUE_NULL:
+                                sqlite3_bind_null(stmt, wp.wp_index);
+                                break;
+                            default:
+                                sqlite3_bind_text(stmt,
+                                                  wp.wp_index,
+                                                  lv.text_value(),
+                                                  lv.text_length(),
+                                                  SQLITE_TRANSIENT);
+                                break;
+                        }
                         break;
+                    }
+                    if (!found) {
+                        missing_column = true;
+                    }
+                    break;
                 }
-                break;
             }
-            if (!found) {
-                missing_column = true;
+            if (missing_column) {
                 break;
             }
         }
@@ -383,6 +517,90 @@ eval_with(logfile& lf, logfile::iterator ll)
     }
 }
 
+void
+catch_up(logfile& lf, size_t max_lines)
+{
+    if (lf.get_format_ptr() == nullptr || lf.is_hibernated()) {
+        return;
+    }
+
+    auto& wc = lf.get_watch_cursor();
+
+    if (!have_watch_exprs()) {
+        // Nothing to evaluate, fast-forward so enabling a watch later
+        // does not sweep lines that arrived while none were active.
+        wc.wc_frontier = lf.size();
+        wc.wc_generation = exprs.e_generation;
+        wc.wc_backfill_line = wc.wc_backfill_end = 0;
+        return;
+    }
+
+    if (wc.wc_generation != exprs.e_generation) {
+        if (wc.wc_frontier > 0) {
+            // Expressions were added mid-session.  Sweep the lines the
+            // frontier already passed with just the new expressions, a
+            // batch per rebuild cycle, instead of re-evaluating the
+            // whole corpus synchronously.  If a sweep was already in
+            // progress, restart it from the top with the older floor;
+            // a short stretch of lines may see an expression twice.
+            if (wc.wc_backfill_end == 0) {
+                wc.wc_backfill_floor = wc.wc_generation;
+            }
+            wc.wc_backfill_line = 0;
+            wc.wc_backfill_end = wc.wc_frontier;
+        }
+        wc.wc_generation = exprs.e_generation;
+    }
+
+    if (wc.wc_frontier >= lf.size() && wc.wc_backfill_end == 0) {
+        return;
+    }
+
+    // Publish all of this batch's events in one transaction so each
+    // match does not pay for its own commit.
+    static auto& lnav_db = injector::get<auto_sqlite3&>();
+    auto txn_started = false;
+
+    if (sqlite3_get_autocommit(lnav_db.in())) {
+        txn_started = sqlite3_exec(
+                          lnav_db.in(), "BEGIN", nullptr, nullptr, nullptr)
+            == SQLITE_OK;
+    }
+
+    auto budget = max_lines;
+
+    // Newly indexed lines first so the steady state stays current while
+    // a backfill is draining.
+    while (wc.wc_frontier < lf.size() && budget > 0) {
+        auto iter = lf.begin() + wc.wc_frontier;
+
+        if (!iter->is_continued()) {
+            eval_line(lf, iter, 0);
+        }
+        wc.wc_frontier += 1;
+        budget -= 1;
+    }
+
+    while (wc.wc_backfill_end > 0 && wc.wc_backfill_line < wc.wc_backfill_end
+           && budget > 0)
+    {
+        auto iter = lf.begin() + wc.wc_backfill_line;
+
+        if (!iter->is_continued()) {
+            eval_line(lf, iter, wc.wc_backfill_floor);
+        }
+        wc.wc_backfill_line += 1;
+        budget -= 1;
+    }
+    if (wc.wc_backfill_end > 0 && wc.wc_backfill_line >= wc.wc_backfill_end) {
+        wc.wc_backfill_line = wc.wc_backfill_end = 0;
+    }
+
+    if (txn_started) {
+        sqlite3_exec(lnav_db.in(), "COMMIT", nullptr, nullptr, nullptr);
+    }
+}
+
 }  // namespace watch
 }  // namespace log
 }  // namespace lnav
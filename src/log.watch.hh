@@ -36,7 +36,18 @@ namespace lnav {
 namespace log {
 namespace watch {
 
-void eval_with(logfile& lf, logfile::iterator ll);
+bool have_watch_exprs();
+
+/**
+ * Evaluate watch expressions against lines of the given file that they
+ * have not seen yet, up to the given number of lines, publishing a
+ * msg-detected event for each match.  Newly indexed lines are evaluated
+ * with every expression; when an expression is added mid-session, the
+ * already-indexed lines are swept again in the background with just the
+ * new expressions so the addition does not stall the rebuild loop.  All
+ * of a call's events are published in a single transaction.
+ */
+void catch_up(logfile& lf, size_t max_lines);
 
 }
 }  // namespace log
@@ -29,6 +29,8 @@
  * @file log_data_helper.cc
  */
 
+#include <algorithm>
+
 #include "log_data_helper.hh"
 
 #include "config.h"
@@ -44,15 +46,117 @@ log_data_helper::clear()
     this->ldh_json_pairs.clear();
     this->ldh_xml_pairs.clear();
     this->ldh_line_attrs.clear();
+    this->ldh_parse_cache.clear();
+}
+
+void
+log_data_helper::stash_current()
+{
+    if (this->ldh_file == nullptr || this->ldh_parser == nullptr) {
+        return;
+    }
+
+    cached_parse cp;
+
+    cp.cp_source_line = this->ldh_source_line;
+    cp.cp_allow_middle = this->ldh_allow_middle;
+    cp.cp_file = std::move(this->ldh_file);
+    cp.cp_y_offset = this->ldh_y_offset;
+    cp.cp_line = this->ldh_line;
+    cp.cp_line_index = this->ldh_line_index;
+    cp.cp_scanner = std::move(this->ldh_scanner);
+    cp.cp_parser = std::move(this->ldh_parser);
+    cp.cp_line_attrs = std::move(this->ldh_line_attrs);
+    cp.cp_line_values = std::move(this->ldh_line_values);
+    cp.cp_json_pairs = std::move(this->ldh_json_pairs);
+    cp.cp_xml_pairs = std::move(this->ldh_xml_pairs);
+    cp.cp_msg_format = std::move(this->ldh_msg_format);
+    this->ldh_parse_cache.emplace_front(std::move(cp));
+    while (this->ldh_parse_cache.size() > PARSE_CACHE_SIZE) {
+        this->ldh_parse_cache.pop_back();
+    }
+
+    this->ldh_file = nullptr;
+    this->ldh_line_attrs.clear();
+    this->ldh_line_values.clear();
+    this->ldh_json_pairs.clear();
+    this->ldh_xml_pairs.clear();
+    this->ldh_msg_format.clear();
+}
+
+void
+log_data_helper::restore_cached(cached_parse& cp)
+{
+    this->ldh_source_line = cp.cp_source_line;
+    this->ldh_allow_middle = cp.cp_allow_middle;
+    this->ldh_file = std::move(cp.cp_file);
+    this->ldh_y_offset = cp.cp_y_offset;
+    this->ldh_line = cp.cp_line;
+    this->ldh_line_index = cp.cp_line_index;
+    this->ldh_scanner = std::move(cp.cp_scanner);
+    this->ldh_parser = std::move(cp.cp_parser);
+    this->ldh_line_attrs = std::move(cp.cp_line_attrs);
+    this->ldh_line_values = std::move(cp.cp_line_values);
+    this->ldh_json_pairs = std::move(cp.cp_json_pairs);
+    this->ldh_xml_pairs = std::move(cp.cp_xml_pairs);
+    this->ldh_msg_format = std::move(cp.cp_msg_format);
+    this->ldh_parser->dp_msg_format = &this->ldh_msg_format;
+    this->reset_namer();
+}
+
+void
+log_data_helper::reset_namer()
+{
+    this->ldh_namer
+        = std::make_unique<column_namer>(column_namer::language::SQL);
+    for (const auto& lv : this->ldh_line_values.lvv_values) {
+        this->ldh_namer->cn_builtin_names.emplace_back(
+            lv.lv_meta.lvm_name.get());
+    }
 }
 
 bool
 log_data_helper::parse_line(content_line_t line, bool allow_middle)
 {
+    if (this->ldh_cache_generation
+        != this->ldh_log_source.lss_index_generation)
+    {
+        // A rebuild renumbers content lines, so everything cached is stale,
+        // including the current parse, which must not be stashed below.
+        this->ldh_parse_cache.clear();
+        this->ldh_parser.reset();
+        this->ldh_cache_generation = this->ldh_log_source.lss_index_generation;
+    } else if (this->ldh_file != nullptr && this->ldh_parser != nullptr
+               && this->ldh_source_line == line
+               && this->ldh_allow_middle == allow_middle)
+    {
+        this->reset_namer();
+        return true;
+    } else {
+        auto cache_iter
+            = std::find_if(this->ldh_parse_cache.begin(),
+                           this->ldh_parse_cache.end(),
+                           [line, allow_middle](const auto& cp) {
+                               return cp.cp_source_line == line
+                                   && cp.cp_allow_middle == allow_middle;
+                           });
+
+        if (cache_iter != this->ldh_parse_cache.end()) {
+            auto cp = std::move(*cache_iter);
+
+            this->ldh_parse_cache.erase(cache_iter);
+            this->stash_current();
+            this->restore_cached(cp);
+            return true;
+        }
+    }
+    this->stash_current();
+
     logfile::iterator ll;
     bool retval = false;
 
     this->ldh_source_line = this->ldh_line_index = line;
+    this->ldh_allow_middle = allow_middle;
 
     this->ldh_file = this->ldh_log_source.find(this->ldh_line_index);
     ll = this->ldh_file->begin() + this->ldh_line_index;
@@ -93,16 +197,10 @@ log_data_helper::parse_line(content_line_t line, bool allow_middle)
         this->ldh_msg_format.clear();
         this->ldh_parser->dp_msg_format = &this->ldh_msg_format;
         this->ldh_parser->parse();
-        this->ldh_namer
-            = std::make_unique<column_namer>(column_namer::language::SQL);
+        this->reset_namer();
         this->ldh_json_pairs.clear();
         this->ldh_xml_pairs.clear();
 
-        for (const auto& lv : this->ldh_line_values.lvv_values) {
-            this->ldh_namer->cn_builtin_names.emplace_back(
-                lv.lv_meta.lvm_name.get());
-        }
-
         for (auto& ldh_line_value : this->ldh_line_values.lvv_values) {
             switch (ldh_line_value.lv_meta.lvm_kind) {
                 case value_kind_t::VALUE_JSON: {
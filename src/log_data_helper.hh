@@ -32,6 +32,7 @@
 #ifndef log_data_helper_hh
 #define log_data_helper_hh
 
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -59,6 +60,42 @@ public:
 
     bool parse_line(content_line_t line, bool allow_middle = false);
 
+    /**
+     * The state produced by parse_line() for a single line.  Recently
+     * parsed lines are stashed here so that scrolling back over them does
+     * not rerun the data_scanner/data_parser pass.
+     */
+    struct cached_parse {
+        content_line_t cp_source_line;
+        bool cp_allow_middle{false};
+        std::shared_ptr<logfile> cp_file;
+        int cp_y_offset{0};
+        logfile::iterator cp_line;
+        content_line_t cp_line_index;
+        std::unique_ptr<data_scanner> cp_scanner;
+        std::unique_ptr<data_parser> cp_parser;
+        string_attrs_t cp_line_attrs;
+        logline_value_vector cp_line_values;
+        std::map<const intern_string_t, json_ptr_walk::walk_list_t>
+            cp_json_pairs;
+        std::map<std::pair<const intern_string_t, std::string>, std::string>
+            cp_xml_pairs;
+        std::string cp_msg_format;
+    };
+
+    /** Move the current parsed line, if any, into the cache. */
+    void stash_current();
+
+    /** Move a cached parse back into the members callers read. */
+    void restore_cached(cached_parse& cp);
+
+    /**
+     * Hand out a fresh column namer for the current line values.  Callers
+     * mutate the namer as they assign column names, so a cached parse
+     * cannot share one across uses.
+     */
+    void reset_namer();
+
     int get_line_bounds(size_t& line_index_out,
                         size_t& line_end_index_out) const;
 
@@ -72,8 +109,11 @@ public:
 
     std::string format_json_getter(const intern_string_t field, int index);
 
+    static const size_t PARSE_CACHE_SIZE = 8;
+
     logfile_sub_source& ldh_log_source;
     content_line_t ldh_source_line;
+    bool ldh_allow_middle{false};
     std::shared_ptr<logfile> ldh_file;
     int ldh_y_offset{0};
     logfile::iterator ldh_line;
@@ -87,6 +127,8 @@ public:
     std::map<std::pair<const intern_string_t, std::string>, std::string>
         ldh_xml_pairs;
     std::string ldh_msg_format;
+    std::deque<cached_parse> ldh_parse_cache;
+    uint32_t ldh_cache_generation{0};
 };
 
 #endif
@@ -110,33 +110,17 @@ log_data_table::get_columns_int()
 }
 
 bool
-log_data_table::next(log_cursor& lc, logfile_sub_source& lss)
+log_data_table::read_and_parse(logfile& lf, uint64_t line_number)
 {
-    if (lc.is_eof()) {
-        return true;
-    }
-
-    content_line_t cl;
-
-    cl = lss.at(lc.lc_curr_line);
-    std::shared_ptr<logfile> lf = lss.find(cl);
-    auto lf_iter = lf->begin() + cl;
-
-    if (!lf_iter->is_message()) {
-        return false;
-    }
-
-    if (lf_iter->has_schema() && !lf_iter->match_schema(this->ldt_schema_id)) {
-        return false;
-    }
-
     string_attrs_t sa;
     struct line_range body;
     logline_value_vector line_values;
 
-    lf->read_full_message(lf_iter, line_values.lvv_sbr);
+    this->ldt_pairs.clear();
+    this->ldt_pairs_loaded = false;
+    lf.read_full_message(lf.begin() + line_number, line_values.lvv_sbr);
     line_values.lvv_sbr.erase_ansi();
-    lf->get_format()->annotate(cl, sa, line_values, false);
+    lf.get_format()->annotate(line_number, sa, line_values, false);
     body = find_string_attr_range(sa, &SA_BODY);
     if (body.lr_end == -1) {
         return false;
@@ -146,20 +130,57 @@ log_data_table::next(log_cursor& lc, logfile_sub_source& lss)
     data_parser dp(&ds);
     dp.parse();
 
-    lf_iter->set_schema(dp.dp_schema_id);
-
-    /* The cached schema ID in the log line is not complete, so we still */
-    /* need to check for a full match. */
     if (dp.dp_schema_id != this->ldt_schema_id) {
         return false;
     }
 
-    this->ldt_pairs.clear();
     this->ldt_pairs.swap(dp.dp_pairs, __FILE__, __LINE__);
+    this->ldt_pairs_loaded = true;
 
     return true;
 }
 
+bool
+log_data_table::next(log_cursor& lc, logfile_sub_source& lss)
+{
+    if (lc.is_eof()) {
+        return true;
+    }
+
+    content_line_t cl;
+
+    cl = lss.at(lc.lc_curr_line);
+    auto full_cl = cl;
+    std::shared_ptr<logfile> lf = lss.find(cl);
+    auto lf_iter = lf->begin() + cl;
+
+    if (!lf_iter->is_message()) {
+        return false;
+    }
+
+    auto memo_iter = this->ldt_schema_memo.find(full_cl);
+    if (memo_iter != this->ldt_schema_memo.end()) {
+        if (!memo_iter->second) {
+            return false;
+        }
+
+        /*
+         * The schema matched on a previous query.  Parsing is deferred
+         * to extract(), which only runs when the extract cache misses,
+         * so a re-query with a warm cache does not re-tokenize at all.
+         */
+        this->ldt_pairs.clear();
+        this->ldt_pairs_loaded = false;
+        return true;
+    }
+
+    auto matched = this->read_and_parse(*lf, cl);
+
+    this->ldt_schema_memo[full_cl] = matched;
+
+    return matched;
+}
+
 void
 log_data_table::extract(logfile* lf,
                         uint64_t line_number,
@@ -168,6 +189,9 @@ log_data_table::extract(logfile* lf,
     auto& line = values.lvv_sbr;
     auto meta_iter = this->ldt_value_metas.begin();
 
+    if (!this->ldt_pairs_loaded) {
+        this->read_and_parse(*lf, line_number);
+    }
     this->ldt_format_impl->extract(lf, line_number, values);
     for (const auto& ldt_pair : this->ldt_pairs) {
         const auto& pvalue = ldt_pair.get_pair_value();
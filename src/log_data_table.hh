@@ -33,6 +33,7 @@
 #define lnav_log_data_table_hh
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "column_namer.hh"
@@ -67,6 +68,16 @@ public:
                  logline_value_vector& values) override;
 
 private:
+    /**
+     * Run the data parser over a line and capture the pairs into
+     * ldt_pairs when the line's schema matches this table's.
+     *
+     * @param lf The file that contains the line.
+     * @param line_number The line to parse.
+     * @return True if the line's schema matches this table.
+     */
+    bool read_and_parse(logfile& lf, uint64_t line_number);
+
     logfile_sub_source& ldt_log_source;
     const content_line_t ldt_template_line;
     data_parser::schema_id_t ldt_schema_id;
@@ -74,6 +85,18 @@ private:
     std::shared_ptr<log_vtab_impl> ldt_format_impl;
     std::vector<vtab_column> ldt_cols;
     std::vector<logline_value_meta> ldt_value_metas;
+    /**
+     * Memo of whether a line's schema matched this table's, keyed by the
+     * line's content number, so later queries can skip re-parsing lines
+     * entirely: mismatches are rejected outright and matches defer
+     * parsing to extract(), which only runs when the extract cache
+     * misses.  This used to be stored in the logline itself, but it is
+     * only needed while one of these tables is being queried, so it was
+     * moved here to keep the index small.
+     */
+    std::unordered_map<int64_t, bool> ldt_schema_memo;
+    /** True when ldt_pairs holds the pairs for the cursor's current line. */
+    bool ldt_pairs_loaded{false};
 };
 
 #endif
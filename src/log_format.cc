@@ -31,6 +31,7 @@
 
 #include <fnmatch.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 
 #include "base/snippet_highlighters.hh"
@@ -45,6 +46,7 @@
 #include "ptimec.hh"
 #include "scn/scn.h"
 #include "sql_util.hh"
+#include "xxHash/xxhash.h"
 #include "yajlpp/yajlpp.hh"
 #include "yajlpp/yajlpp_def.hh"
 
@@ -434,6 +436,12 @@ static int read_json_field(yajlpp_parse_context* ypc,
                            const unsigned char* str,
                            size_t len);
 
+static void scan_json_string_field(json_log_userdata* jlu,
+                                   intern_string_t field_name,
+                                   bool top_level,
+                                   const unsigned char* str,
+                                   size_t len);
+
 static int
 read_json_null(yajlpp_parse_context* ypc)
 {
@@ -458,12 +466,12 @@ read_json_bool(yajlpp_parse_context* ypc, int val)
     return 1;
 }
 
-static int
-read_json_int(yajlpp_parse_context* ypc, long long val)
+static void
+scan_json_int_field(json_log_userdata* jlu,
+                    const intern_string_t field_name,
+                    bool top_level,
+                    long long val)
 {
-    json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
-    const intern_string_t field_name = ypc->get_path();
-
     if (jlu->jlu_format->lf_timestamp_field == field_name) {
         long long divisor = jlu->jlu_format->elf_timestamp_divisor;
         struct timeval tv;
@@ -508,32 +516,42 @@ read_json_int(yajlpp_parse_context* ypc, long long val)
                 string_fragment::from_c_str(level_buf),
                 jlu->jlu_batch_context));
         } else {
-            std::vector<std::pair<int64_t, log_level_t>>::iterator iter;
+            // The pairs are sorted by value after loading, so the level
+            // can be found with a binary search instead of a scan.
+            const auto& pairs = jlu->jlu_format->elf_level_pairs;
+            auto iter = std::lower_bound(
+                pairs.begin(),
+                pairs.end(),
+                val,
+                [](const std::pair<int64_t, log_level_t>& elem,
+                   int64_t value) { return elem.first < value; });
 
-            for (iter = jlu->jlu_format->elf_level_pairs.begin();
-                 iter != jlu->jlu_format->elf_level_pairs.end();
-                 ++iter)
-            {
-                if (iter->first == val) {
-                    jlu->jlu_base_line->set_level(iter->second);
-                    break;
-                }
+            if (iter != pairs.end() && iter->first == val) {
+                jlu->jlu_base_line->set_level(iter->second);
             }
         }
     }
 
     jlu->jlu_sub_line_count
-        += jlu->jlu_format->value_line_count(field_name, ypc->is_level(1));
-
-    return 1;
+        += jlu->jlu_format->value_line_count(field_name, top_level);
 }
 
 static int
-read_json_double(yajlpp_parse_context* ypc, double val)
+read_json_int(yajlpp_parse_context* ypc, long long val)
 {
     json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
-    const intern_string_t field_name = ypc->get_path();
 
+    scan_json_int_field(jlu, ypc->get_path(), ypc->is_level(1), val);
+
+    return 1;
+}
+
+static void
+scan_json_double_field(json_log_userdata* jlu,
+                       const intern_string_t field_name,
+                       bool top_level,
+                       double val)
+{
     if (jlu->jlu_format->lf_timestamp_field == field_name) {
         double divisor = jlu->jlu_format->elf_timestamp_divisor;
         struct timeval tv;
@@ -553,7 +571,15 @@ read_json_double(yajlpp_parse_context* ypc, double val)
     }
 
     jlu->jlu_sub_line_count
-        += jlu->jlu_format->value_line_count(field_name, ypc->is_level(1));
+        += jlu->jlu_format->value_line_count(field_name, top_level);
+}
+
+static int
+read_json_double(yajlpp_parse_context* ypc, double val)
+{
+    json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
+
+    scan_json_double_field(jlu, ypc->get_path(), ypc->is_level(1), val);
 
     return 1;
 }
@@ -604,6 +630,183 @@ static const struct json_path_container json_log_handlers = {
         .add_cb(read_json_field),
 };
 
+/**
+ * Scan a flat JSON log line by hand, feeding each member to the same
+ * per-field logic used by the yajl callbacks but without the callback
+ * dispatch and per-field allocations.  Anything surprising -- nested
+ * containers, escape sequences, oddball keys, malformed values -- makes
+ * this back off so scan() can run the full parser, which is the only
+ * thing that gets the sub-line accounting right for those cases.
+ *
+ * @return True if the line was fully handled.
+ */
+static bool
+scan_json_line_fast(json_log_userdata& jlu,
+                    const unsigned char* data,
+                    size_t len)
+{
+    size_t pos = 1;  // skip the opening curly brace
+
+    auto skip_ws = [data, len, &pos]() {
+        while (pos < len
+               && (data[pos] == ' ' || data[pos] == '\t' || data[pos] == '\r'
+                   || data[pos] == '\n'))
+        {
+            pos += 1;
+        }
+    };
+
+    skip_ws();
+    if (pos < len && data[pos] == '}') {
+        pos += 1;
+        skip_ws();
+        return pos == len;
+    }
+
+    while (true) {
+        skip_ws();
+        if (pos >= len || data[pos] != '"') {
+            return false;
+        }
+        pos += 1;
+
+        size_t key_start = pos;
+        while (pos < len && data[pos] != '"') {
+            if (!isalnum(data[pos]) && data[pos] != '_') {
+                return false;
+            }
+            pos += 1;
+        }
+        if (pos >= len || pos == key_start) {
+            return false;
+        }
+
+        const auto field_name = intern_string::lookup(
+            (const char*) &data[key_start], pos - key_start);
+
+        pos += 1;
+        skip_ws();
+        if (pos >= len || data[pos] != ':') {
+            return false;
+        }
+        pos += 1;
+        skip_ws();
+        if (pos >= len) {
+            return false;
+        }
+
+        switch (data[pos]) {
+            case '"': {
+                pos += 1;
+                size_t val_start = pos;
+                while (pos < len && data[pos] != '"') {
+                    if (data[pos] == '\\') {
+                        return false;
+                    }
+                    pos += 1;
+                }
+                if (pos >= len) {
+                    return false;
+                }
+                scan_json_string_field(&jlu,
+                                       field_name,
+                                       true,
+                                       &data[val_start],
+                                       pos - val_start);
+                pos += 1;
+                break;
+            }
+            case '{':
+            case '[':
+                return false;
+            case 't':
+                if (len - pos < 4 || memcmp(&data[pos], "true", 4) != 0) {
+                    return false;
+                }
+                pos += 4;
+                jlu.jlu_sub_line_count
+                    += jlu.jlu_format->value_line_count(field_name, true);
+                break;
+            case 'f':
+                if (len - pos < 5 || memcmp(&data[pos], "false", 5) != 0) {
+                    return false;
+                }
+                pos += 5;
+                jlu.jlu_sub_line_count
+                    += jlu.jlu_format->value_line_count(field_name, true);
+                break;
+            case 'n':
+                if (len - pos < 4 || memcmp(&data[pos], "null", 4) != 0) {
+                    return false;
+                }
+                pos += 4;
+                jlu.jlu_sub_line_count
+                    += jlu.jlu_format->value_line_count(field_name, true);
+                break;
+            default: {
+                size_t val_start = pos;
+                bool is_double = false;
+
+                while (pos < len
+                       && (isdigit(data[pos]) || data[pos] == '-'
+                           || data[pos] == '+' || data[pos] == '.'
+                           || data[pos] == 'e' || data[pos] == 'E'))
+                {
+                    if (data[pos] == '.' || data[pos] == 'e'
+                        || data[pos] == 'E')
+                    {
+                        is_double = true;
+                    }
+                    pos += 1;
+                }
+
+                char num_buf[64];
+                auto num_len = pos - val_start;
+                char* num_end;
+
+                if (num_len == 0 || num_len >= sizeof(num_buf)) {
+                    return false;
+                }
+                memcpy(num_buf, &data[val_start], num_len);
+                num_buf[num_len] = '\0';
+                if (is_double) {
+                    auto val = strtod(num_buf, &num_end);
+
+                    if (num_end != &num_buf[num_len]) {
+                        return false;
+                    }
+                    scan_json_double_field(&jlu, field_name, true, val);
+                } else {
+                    auto val = strtoll(num_buf, &num_end, 10);
+
+                    if (num_end != &num_buf[num_len]) {
+                        return false;
+                    }
+                    scan_json_int_field(&jlu, field_name, true, val);
+                }
+                break;
+            }
+        }
+
+        skip_ws();
+        if (pos >= len) {
+            return false;
+        }
+        if (data[pos] == ',') {
+            pos += 1;
+            continue;
+        }
+        if (data[pos] == '}') {
+            pos += 1;
+            break;
+        }
+        return false;
+    }
+
+    skip_ws();
+    return pos == len;
+}
+
 static int rewrite_json_field(yajlpp_parse_context* ypc,
                               const unsigned char* str,
                               size_t len);
@@ -772,9 +975,17 @@ external_log_format::scan(logfile& lf,
         jlu.jlu_line_value = sbr.get_data();
         jlu.jlu_line_size = sbr.length();
         jlu.jlu_handle = handle;
-        if (yajl_parse(handle, line_data, sbr.length()) == yajl_status_ok
-            && yajl_complete_parse(handle) == yajl_status_ok)
-        {
+        bool line_parsed = scan_json_line_fast(jlu, line_data, sbr.length());
+        if (!line_parsed) {
+            // The fast path may have partially updated the line before
+            // backing off, so start over for the full parse.
+            ll = logline(li.li_file_range.fr_offset, 0, 0, LEVEL_INFO);
+            jlu.jlu_sub_line_count = 1;
+            line_parsed = yajl_parse(handle, line_data, sbr.length())
+                    == yajl_status_ok
+                && yajl_complete_parse(handle) == yajl_status_ok;
+        }
+        if (line_parsed) {
             if (ll.get_time() == 0) {
                 if (this->lf_specialized) {
                     ll.set_ignore(true);
@@ -832,6 +1043,25 @@ external_log_format::scan(logfile& lf,
     int pat_index = orig_lock;
     auto line_sf = sbr.to_string_fragment();
 
+    if (this->lf_specialized && !dst.empty()
+        && this->elf_first_byte_filter && this->elf_first_byte_anchored
+        && !line_sf.empty()
+        && !this->elf_first_byte_set[(unsigned char) line_sf.data()[0]])
+    {
+        // No pattern can match at the start of this line, so it has to be
+        // a continuation (e.g. a wrapped stack trace), which saves running
+        // the regexes over it.
+        if (!this->lf_multiline) {
+            auto& last_line = dst.back();
+
+            dst.emplace_back(li.li_file_range.fr_offset,
+                             last_line.get_timeval(),
+                             log_level_t::LEVEL_INVALID);
+            return log_format::SCAN_MATCH;
+        }
+        return log_format::SCAN_NO_MATCH;
+    }
+
     while (::next_format(this->elf_pattern_order, curr_fmt, pat_index)) {
         static thread_local auto md = lnav::pcre2pp::match_data::unitialized();
 
@@ -842,6 +1072,19 @@ external_log_format::scan(logfile& lf,
             continue;
         }
 
+        if (fpat->p_first_byte_filter && !line_sf.empty()
+            && !fpat->p_first_byte_set[(unsigned char) line_sf.data()[0]])
+        {
+            // This pattern cannot match at the start of the line, skip
+            // the regex.  For the pattern lock, this counts the same as
+            // a failed match.
+            if (!this->lf_pattern_locks.empty() && pat_index != -1) {
+                curr_fmt = -1;
+                pat_index = -1;
+            }
+            continue;
+        }
+
         auto match_res = pat->capture_from(line_sf)
                              .into(md)
                              .matches(PCRE2_NO_UTF_CHECK)
@@ -1001,9 +1244,42 @@ external_log_format::scan(logfile& lf,
             }
         }
 
+        for (auto value_index : fpat->p_sketch_value_indexes) {
+            const indexed_value_def& ivd = fpat->p_value_by_index[value_index];
+            auto sketch_cap = md[ivd.ivd_index];
+
+            if (sketch_cap && sketch_cap->is_valid()) {
+                this->lf_value_sketches[ivd.ivd_value_def->vd_sketch_index]
+                    .add_value(sketch_cap.value());
+            }
+        }
+
         dst.emplace_back(
             li.li_file_range.fr_offset, log_tv, level, mod_index, opid);
 
+        {
+            // Remember where the timestamp and body sit in the line so
+            // renderers do not have to re-run this pattern just to find
+            // them.  The captures in md are still the original ones, the
+            // combined date/time buffer above only replaced the local.
+            line_extent extent;
+            const auto orig_ts = md[fpat->p_timestamp_field_index];
+            const auto orig_body = md[fpat->p_body_field_index];
+
+            if (orig_ts && orig_ts->sf_begin >= 0
+                && orig_ts->sf_end <= UINT16_MAX)
+            {
+                extent.le_ts_start = orig_ts->sf_begin;
+                extent.le_ts_end = orig_ts->sf_end;
+            }
+            if (orig_body && orig_body->sf_begin >= 0
+                && orig_body->sf_begin <= UINT16_MAX)
+            {
+                extent.le_body_start = orig_body->sf_begin;
+            }
+            sbc.sbc_extents.push_back(extent);
+        }
+
         if (orig_lock != curr_fmt) {
             uint32_t lock_line;
 
@@ -1291,11 +1567,13 @@ external_log_format::rewrite(exec_context& ec,
     }
 }
 
-static int
-read_json_field(yajlpp_parse_context* ypc, const unsigned char* str, size_t len)
+static void
+scan_json_string_field(json_log_userdata* jlu,
+                       const intern_string_t field_name,
+                       bool top_level,
+                       const unsigned char* str,
+                       size_t len)
 {
-    json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
-    const intern_string_t field_name = ypc->get_path();
     struct exttm tm_out;
     struct timeval tv_out;
 
@@ -1330,7 +1608,15 @@ read_json_field(yajlpp_parse_context* ypc, const unsigned char* str, size_t len)
     }
 
     jlu->jlu_sub_line_count += jlu->jlu_format->value_line_count(
-        field_name, ypc->is_level(1), str, len);
+        field_name, top_level, str, len);
+}
+
+static int
+read_json_field(yajlpp_parse_context* ypc, const unsigned char* str, size_t len)
+{
+    json_log_userdata* jlu = (json_log_userdata*) ypc->ypc_userdata;
+
+    scan_json_string_field(jlu, ypc->get_path(), ypc->is_level(1), str, len);
 
     return 1;
 }
@@ -1890,6 +2176,9 @@ external_log_format::build(std::vector<lnav::console::user_message>& errors)
                         break;
                 }
             }
+            if (vd->vd_collect_stats) {
+                pat.p_sketch_value_indexes.push_back(lpc);
+            }
         }
 
         if (!this->elf_level_field.empty() && pat.p_level_field_index == -1) {
@@ -1913,6 +2202,46 @@ external_log_format::build(std::vector<lnav::console::user_message>& errors)
         this->elf_pattern_order.push_back(iter->second);
     }
 
+    this->elf_first_byte_set.reset();
+    this->elf_first_byte_filter = !this->elf_pattern_order.empty();
+    this->elf_first_byte_anchored = !this->elf_pattern_order.empty();
+    for (const auto& pat : this->elf_pattern_order) {
+        if (pat->p_module_format) {
+            continue;
+        }
+
+        pat->p_first_byte_set.reset();
+        pat->p_first_byte_filter = false;
+        if (pat->p_pcre.pp_value == nullptr
+            || !pat->p_pcre.pp_value->add_first_code_units(
+                pat->p_first_byte_set))
+        {
+            this->elf_first_byte_filter = false;
+            this->elf_first_byte_anchored = false;
+            continue;
+        }
+        this->elf_first_byte_set |= pat->p_first_byte_set;
+        /*
+         * The starting-byte set only describes where a match can begin.
+         * Treating a line as a continuation just because its first byte is
+         * not in the set is only sound when every pattern is anchored to
+         * the start of the line.
+         */
+        if (pat->p_pcre.pp_value->get_pattern().empty()
+            || pat->p_pcre.pp_value->get_pattern()[0] != '^')
+        {
+            this->elf_first_byte_anchored = false;
+        } else {
+            /*
+             * An anchored pattern with a known starting-byte set can be
+             * skipped outright for lines that begin with some other byte,
+             * so formats with many alternative patterns only pay for the
+             * one or two regexes that could actually match.
+             */
+            pat->p_first_byte_filter = true;
+        }
+    }
+
     if (this->elf_type != elf_type_t::ELF_TYPE_TEXT) {
         if (!this->elf_patterns.empty()) {
             errors.emplace_back(
@@ -2454,6 +2783,19 @@ external_log_format::build(std::vector<lnav::console::user_message>& errors)
 
     this->lf_value_stats.resize(this->elf_numeric_value_defs.size());
 
+    for (const auto& elf_value_def : this->elf_value_def_order) {
+        if (!elf_value_def->vd_collect_stats) {
+            continue;
+        }
+        elf_value_def->vd_sketch_index = this->elf_sketch_value_defs.size();
+        this->elf_sketch_value_defs.push_back(elf_value_def);
+    }
+    this->lf_value_sketches.resize(this->elf_sketch_value_defs.size());
+    for (size_t lpc = 0; lpc < this->elf_sketch_value_defs.size(); lpc++) {
+        this->lf_value_sketches[lpc].lvk_field
+            = this->elf_sketch_value_defs[lpc]->vd_meta.lvm_name;
+    }
+
     int format_index = 0;
     for (auto iter = this->jlf_line_format.begin();
          iter != this->jlf_line_format.end();
@@ -2797,6 +3139,9 @@ external_log_format::specialized(int fmt_lock)
 
     this->lf_value_stats.clear();
     this->lf_value_stats.resize(this->elf_numeric_value_defs.size());
+    for (auto& sketch : this->lf_value_sketches) {
+        sketch.clear();
+    }
 
     return retval;
 }
@@ -2900,7 +3245,8 @@ external_log_format::convert_level(string_fragment sf,
         if (sbc != nullptr && sf.length() < 10) {
             size_t cache_index;
 
-            if (sbc->sbc_cached_level_count == 4) {
+            if (sbc->sbc_cached_level_count
+                == scan_batch_context::LEVEL_CACHE_SIZE) {
                 cache_index = sbc->sbc_cached_level_count - 1;
             } else {
                 cache_index = sbc->sbc_cached_level_count;
@@ -3054,6 +3400,108 @@ logline_value_stats::add_value(double value)
     this->lvs_total += value;
 }
 
+void
+logline_value_sketch::clear()
+{
+    this->lvk_count = 0;
+    this->lvk_hll.fill(0);
+    this->lvk_topk.clear();
+}
+
+void
+logline_value_sketch::add_value(const string_fragment& sf)
+{
+    auto hash = XXH3_64bits(sf.data(), sf.length());
+    auto bucket = hash >> 56;
+    auto rest = hash << 8;
+    uint8_t rank = rest == 0 ? 57 : (__builtin_clzll(rest) + 1);
+
+    this->lvk_count += 1;
+    if (rank > this->lvk_hll[bucket]) {
+        this->lvk_hll[bucket] = rank;
+    }
+
+    for (auto& entry : this->lvk_topk) {
+        if (entry.first.size() == (size_t) sf.length()
+            && memcmp(entry.first.data(), sf.data(), entry.first.size()) == 0)
+        {
+            entry.second += 1;
+            return;
+        }
+    }
+    if (this->lvk_topk.size() < TOPK_SIZE) {
+        this->lvk_topk.emplace_back(sf.to_string(), 1);
+        return;
+    }
+
+    // Space-saving: evict the entry with the smallest count and give the
+    // newcomer its count plus one, which bounds the overestimate.
+    auto min_iter = std::min_element(
+        this->lvk_topk.begin(),
+        this->lvk_topk.end(),
+        [](const auto& lhs, const auto& rhs) {
+            return lhs.second < rhs.second;
+        });
+    min_iter->first = sf.to_string();
+    min_iter->second += 1;
+}
+
+void
+logline_value_sketch::merge(const logline_value_sketch& other)
+{
+    this->lvk_count += other.lvk_count;
+    for (size_t lpc = 0; lpc < HLL_REGISTER_COUNT; lpc++) {
+        if (other.lvk_hll[lpc] > this->lvk_hll[lpc]) {
+            this->lvk_hll[lpc] = other.lvk_hll[lpc];
+        }
+    }
+    for (const auto& entry : other.lvk_topk) {
+        auto iter = std::find_if(this->lvk_topk.begin(),
+                                 this->lvk_topk.end(),
+                                 [&entry](const auto& elem) {
+                                     return elem.first == entry.first;
+                                 });
+        if (iter == this->lvk_topk.end()) {
+            this->lvk_topk.emplace_back(entry);
+        } else {
+            iter->second += entry.second;
+        }
+    }
+    if (this->lvk_topk.size() > TOPK_SIZE) {
+        std::sort(this->lvk_topk.begin(),
+                  this->lvk_topk.end(),
+                  [](const auto& lhs, const auto& rhs) {
+                      return lhs.second > rhs.second;
+                  });
+        this->lvk_topk.resize(TOPK_SIZE);
+    }
+}
+
+int64_t
+logline_value_sketch::estimate_cardinality() const
+{
+    // Bias-correction constant for 256 registers.
+    constexpr double ALPHA = 0.7182725932495458;
+    constexpr double M = HLL_REGISTER_COUNT;
+    double sum = 0;
+    int zero_registers = 0;
+
+    for (auto reg : this->lvk_hll) {
+        sum += ldexp(1.0, -reg);
+        if (reg == 0) {
+            zero_registers += 1;
+        }
+    }
+
+    auto estimate = ALPHA * M * M / sum;
+    if (estimate <= 2.5 * M && zero_registers > 0) {
+        // Small-range correction: fall back to linear counting.
+        estimate = M * log(M / (double) zero_registers);
+    }
+
+    return (int64_t) estimate;
+}
+
 std::vector<logline_value_meta>
 external_log_format::get_value_metadata() const
 {
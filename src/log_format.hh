@@ -36,6 +36,7 @@
 #include <sys/time.h>
 #include <time.h>
 #define __STDC_FORMAT_MACROS
+#include <array>
 #include <limits>
 #include <list>
 #include <memory>
@@ -253,6 +254,31 @@ struct logline_value_vector {
     std::vector<logline_value> lvv_values;
 };
 
+/**
+ * Online sketch of the values seen for a log field while indexing: a
+ * HyperLogLog for estimating cardinality plus a space-saving top-K of
+ * the most frequent values.  Collection is opt-in per field via the
+ * 'collect-stats' value property, so the per-line cost is only paid
+ * where it was asked for.
+ */
+struct logline_value_sketch {
+    static constexpr size_t HLL_REGISTER_COUNT = 256;
+    static constexpr size_t TOPK_SIZE = 16;
+
+    void clear();
+
+    void add_value(const string_fragment& sf);
+
+    void merge(const logline_value_sketch& other);
+
+    int64_t estimate_cardinality() const;
+
+    intern_string_t lvk_field;
+    int64_t lvk_count{0};
+    std::array<uint8_t, HLL_REGISTER_COUNT> lvk_hll{};
+    std::vector<std::pair<std::string, uint64_t>> lvk_topk;
+};
+
 struct logline_value_stats {
     logline_value_stats() { this->clear(); }
 
@@ -351,6 +377,13 @@ public:
         return false;
     }
 
+    /**
+     * Quick check of whether any of this format's patterns could match a
+     * line that starts with the given byte.  Used to skip a full scan()
+     * during format detection.
+     */
+    virtual bool match_first_byte(unsigned char ch) const { return true; }
+
     enum scan_result_t {
         SCAN_MATCH,
         SCAN_NO_MATCH,
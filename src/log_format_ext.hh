@@ -32,6 +32,7 @@
 #ifndef lnav_log_format_ext_hh
 #define lnav_log_format_ext_hh
 
+#include <bitset>
 #include <unordered_map>
 
 #include "log_format.hh"
@@ -69,9 +70,11 @@ public:
         logline_value_meta vd_meta;
         std::string vd_collate;
         bool vd_foreign_key{false};
+        bool vd_collect_stats{false};
         intern_string_t vd_unit_field;
         std::map<const intern_string_t, scaling_factor> vd_unit_scaling;
         ssize_t vd_values_index{-1};
+        ssize_t vd_sketch_index{-1};
         bool vd_internal{false};
         std::vector<std::string> vd_action_list;
         std::string vd_rewriter;
@@ -106,6 +109,7 @@ public:
             p_pcre;
         std::vector<indexed_value_def> p_value_by_index;
         std::vector<int> p_numeric_value_indexes;
+        std::vector<int> p_sketch_value_indexes;
         int p_timestamp_field_index{-1};
         int p_time_field_index{-1};
         int p_level_field_index{-1};
@@ -115,6 +119,8 @@ public:
         int p_timestamp_end{-1};
         bool p_module_format{false};
         std::set<size_t> p_matched_samples;
+        std::bitset<256> p_first_byte_set;
+        bool p_first_byte_filter{false};
     };
 
     struct level_pattern {
@@ -144,6 +150,11 @@ public:
 
     bool match_mime_type(const file_format_t ff) const;
 
+    bool match_first_byte(unsigned char ch) const
+    {
+        return !this->elf_first_byte_filter || this->elf_first_byte_set[ch];
+    }
+
     scan_result_t scan(logfile& lf,
                        std::vector<logline>& dst,
                        const line_info& offset,
@@ -338,6 +349,11 @@ public:
         elf_value_defs;
     std::vector<std::shared_ptr<value_def>> elf_value_def_order;
     std::vector<std::shared_ptr<value_def>> elf_numeric_value_defs;
+    std::vector<std::shared_ptr<value_def>> elf_sketch_value_defs;
+    std::vector<logline_value_sketch> lf_value_sketches;
+    std::bitset<256> elf_first_byte_set;
+    bool elf_first_byte_filter{false};
+    bool elf_first_byte_anchored{false};
     int elf_column_count{0};
     double elf_timestamp_divisor{1.0};
     intern_string_t elf_level_field;
@@ -58,11 +58,39 @@ using log_opid_map = robin_hood::unordered_map<string_fragment,
                                                frag_hasher,
                                                std::equal_to<string_fragment>>;
 
+/**
+ * The timestamp byte range and message-body start offset within a line,
+ * captured while the scanning regex is already matched so later consumers
+ * do not have to re-run it.  A zeroed entry means the extents are not
+ * known for that line.  Offsets are clamped to sixteen bits, which covers
+ * any reasonable log prefix.
+ */
+struct line_extent {
+    uint16_t le_ts_start{0};
+    uint16_t le_ts_end{0};
+    uint16_t le_body_start{0};
+};
+
 struct scan_batch_context {
+    /**
+     * Size of the level-string cache.  Status-code-style level fields
+     * (e.g. elb_log/s3_log map HTTP status codes to levels) commonly see
+     * more than a handful of distinct values per batch, so the cache
+     * needs enough room to keep the level regexes from rerunning on
+     * every line.
+     */
+    static constexpr size_t LEVEL_CACHE_SIZE = 8;
+
     ArenaAlloc::Alloc<char>& sbc_allocator;
     log_opid_map sbc_opids;
-    std::string sbc_cached_level_strings[4];
-    log_level_t sbc_cached_level_values[4];
+    /**
+     * One entry for each logline appended by the current scan() call, in
+     * order.  Scanners that do not know the extents leave this empty and
+     * the caller pads with zeroed entries to stay aligned with the index.
+     */
+    std::vector<line_extent> sbc_extents;
+    std::string sbc_cached_level_strings[LEVEL_CACHE_SIZE];
+    log_level_t sbc_cached_level_values[LEVEL_CACHE_SIZE];
     size_t sbc_cached_level_count{0};
 };
 
@@ -93,11 +121,12 @@ public:
             log_level_t lev,
             uint8_t mod = 0,
             uint8_t opid = 0)
-        : ll_offset(off), ll_has_ansi(false), ll_time(t), ll_millis(millis),
-          ll_opid(opid), ll_sub_offset(0), ll_valid_utf(1), ll_level(lev),
-          ll_module_id(mod), ll_expr_mark(0)
+        : ll_offset(off), ll_sub_offset(0), ll_has_ansi(false),
+          ll_expr_mark(0), ll_time_millis(0), ll_opid(opid), ll_valid_utf(1),
+          ll_level(lev), ll_module_id(mod)
     {
-        memset(this->ll_schema, 0, sizeof(this->ll_schema));
+        this->set_time(t);
+        this->set_millis(millis);
     }
 
     logline(file_off_t off,
@@ -105,11 +134,11 @@ public:
             log_level_t lev,
             uint8_t mod = 0,
             uint8_t opid = 0)
-        : ll_offset(off), ll_has_ansi(false), ll_opid(opid), ll_sub_offset(0),
-          ll_valid_utf(1), ll_level(lev), ll_module_id(mod), ll_expr_mark(0)
+        : ll_offset(off), ll_sub_offset(0), ll_has_ansi(false),
+          ll_expr_mark(0), ll_time_millis(0), ll_opid(opid), ll_valid_utf(1),
+          ll_level(lev), ll_module_id(mod)
     {
         this->set_time(tv);
-        memset(this->ll_schema, 0, sizeof(this->ll_schema));
     }
 
     /** @return The offset of the line in the file. */
@@ -120,37 +149,59 @@ public:
     void set_sub_offset(uint16_t suboff) { this->ll_sub_offset = suboff; }
 
     /** @return The timestamp for the line. */
-    time_t get_time() const { return this->ll_time; }
+    time_t get_time() const
+    {
+        return (time_t) (this->ll_time_millis / 1000ULL);
+    }
 
     void to_exttm(struct exttm& tm_out) const
     {
-        tm_out.et_tm = *gmtime(&this->ll_time);
-        tm_out.et_nsec = this->ll_millis * 1000 * 1000;
+        time_t secs = this->get_time();
+
+        tm_out.et_tm = *gmtime(&secs);
+        tm_out.et_nsec = this->get_millis() * 1000 * 1000;
     }
 
-    void set_time(time_t t) { this->ll_time = t; }
+    void set_time(time_t t)
+    {
+        this->ll_time_millis = clamp_millis(t * 1000LL + this->get_millis());
+    }
 
     /** @return The millisecond timestamp for the line. */
-    uint16_t get_millis() const { return this->ll_millis; }
+    uint16_t get_millis() const
+    {
+        return (uint16_t) (this->ll_time_millis % 1000ULL);
+    }
+
+    void set_millis(uint16_t m)
+    {
+        this->ll_time_millis = this->ll_time_millis - this->get_millis() + m;
+    }
 
-    void set_millis(uint16_t m) { this->ll_millis = m; }
+    uint64_t get_time_in_millis() const { return this->ll_time_millis; }
 
-    uint64_t get_time_in_millis() const
+    /**
+     * Shift this line's timestamp by the given amount.
+     *
+     * @param millis The millisecond delta to apply, which can be negative.
+     */
+    void adjust_time(int64_t millis)
     {
-        return (this->ll_time * 1000ULL + (uint64_t) this->ll_millis);
+        this->ll_time_millis
+            = clamp_millis((int64_t) this->ll_time_millis + millis);
     }
 
     struct timeval get_timeval() const
     {
-        struct timeval retval = {this->ll_time, this->ll_millis * 1000};
+        struct timeval retval = {this->get_time(), this->get_millis() * 1000};
 
         return retval;
     }
 
     void set_time(const struct timeval& tv)
     {
-        this->ll_time = tv.tv_sec;
-        this->ll_millis = tv.tv_usec / 1000;
+        this->ll_time_millis
+            = clamp_millis(tv.tv_sec * 1000LL + tv.tv_usec / 1000);
     }
 
     void set_ignore(bool val)
@@ -230,86 +281,64 @@ public:
 
     uint8_t get_opid() const { return this->ll_opid; }
 
-    /**
-     * @return  True if there is a schema value set for this log line.
-     */
-    bool has_schema() const
-    {
-        return (this->ll_schema[0] != 0 || this->ll_schema[1] != 0);
-    }
-
-    /**
-     * Set the "schema" for this log line.  The schema ID is used to match log
-     * lines that have a similar format when generating the logline table.  The
-     * schema is set lazily so that startup is faster.
-     *
-     * @param ba The SHA-1 hash of the constant parts of this log line.
-     */
-    void set_schema(const byte_array<2, uint64_t>& ba)
-    {
-        memcpy(this->ll_schema, ba.in(), sizeof(this->ll_schema));
-    }
-
-    char get_schema() const { return this->ll_schema[0]; }
-
-    /**
-     * Perform a partial match of the given schema against this log line.
-     * Storing the full schema is not practical, so we just keep the first four
-     * bytes.
-     *
-     * @param  ba The SHA-1 hash of the constant parts of a log line.
-     * @return    True if the first four bytes of the given schema match the
-     *   schema stored in this log line.
-     */
-    bool match_schema(const byte_array<2, uint64_t>& ba) const
-    {
-        return memcmp(this->ll_schema, ba.in(), sizeof(this->ll_schema)) == 0;
-    }
-
     /**
      * Compare loglines based on their timestamp.
      */
     bool operator<(const logline& rhs) const
     {
-        return (this->ll_time < rhs.ll_time)
-            || (this->ll_time == rhs.ll_time && this->ll_millis < rhs.ll_millis)
-            || (this->ll_time == rhs.ll_time && this->ll_millis == rhs.ll_millis
+        return (this->ll_time_millis < rhs.ll_time_millis)
+            || (this->ll_time_millis == rhs.ll_time_millis
                 && this->ll_offset < rhs.ll_offset)
-            || (this->ll_time == rhs.ll_time && this->ll_millis == rhs.ll_millis
+            || (this->ll_time_millis == rhs.ll_time_millis
                 && this->ll_offset == rhs.ll_offset
                 && this->ll_sub_offset < rhs.ll_sub_offset);
     }
 
-    bool operator<(const time_t& rhs) const { return this->ll_time < rhs; }
+    bool operator<(const time_t& rhs) const { return this->get_time() < rhs; }
 
     bool operator<(const struct timeval& rhs) const
     {
-        return ((this->ll_time < rhs.tv_sec)
-                || ((this->ll_time == rhs.tv_sec)
-                    && (this->ll_millis < (rhs.tv_usec / 1000))));
+        return (int64_t) this->ll_time_millis
+            < rhs.tv_sec * 1000LL + rhs.tv_usec / 1000;
     }
 
     bool operator<=(const struct timeval& rhs) const
     {
-        return ((this->ll_time < rhs.tv_sec)
-                || ((this->ll_time == rhs.tv_sec)
-                    && (this->ll_millis <= (rhs.tv_usec / 1000))));
+        return (int64_t) this->ll_time_millis
+            <= rhs.tv_sec * 1000LL + rhs.tv_usec / 1000;
     }
 
 private:
-    file_off_t ll_offset : 63;
-    uint8_t ll_has_ansi : 1;
-    time_t ll_time;
-    unsigned int ll_millis : 10;
-    unsigned int ll_opid : 6;
-    unsigned int ll_sub_offset : 15;
-    unsigned int ll_valid_utf : 1;
-    uint8_t ll_level;
-    uint8_t ll_module_id : 7;
-    uint8_t ll_expr_mark : 1;
-    char ll_schema[2];
+    /**
+     * Timestamps are kept as milliseconds-since-the-epoch packed into 42
+     * bits, which covers dates up to the year 2109.  Times before the epoch
+     * are clamped to zero.
+     */
+    static uint64_t clamp_millis(int64_t millis)
+    {
+        if (millis < 0) {
+            return 0;
+        }
+        if (millis >= (1LL << 42)) {
+            return (1ULL << 42) - 1;
+        }
+        return (uint64_t) millis;
+    }
+
+    uint64_t ll_offset : 47;
+    uint64_t ll_sub_offset : 15;
+    uint64_t ll_has_ansi : 1;
+    uint64_t ll_expr_mark : 1;
+    uint64_t ll_time_millis : 42;
+    uint64_t ll_opid : 6;
+    uint64_t ll_valid_utf : 1;
+    uint64_t ll_level : 8;
+    uint64_t ll_module_id : 7;
 };
 
+static_assert(sizeof(logline) == 16,
+              "the index can have millions of loglines, keep this small");
+
 struct format_tag_def {
     explicit format_tag_def(std::string name) : ftd_name(std::move(name)) {}
 
@@ -142,7 +142,7 @@ class generic_log_format : public log_format {
         int pat_index = this->pattern_index_for_line(line_number);
         auto& fmt = get_pcre_log_formats()[pat_index];
         int prefix_len = 0;
-        auto md = fmt.pcre->create_match_data();
+        static thread_local auto md = lnav::pcre2pp::match_data::unitialized();
         auto match_res = fmt.pcre->capture_from(line.to_string_fragment())
                              .into(md)
                              .matches(PCRE2_NO_UTF_CHECK)
@@ -53,6 +53,7 @@
 #include "fmt/format.h"
 #include "lnav_config.hh"
 #include "log_format_ext.hh"
+#include "pcrepp/pcre2pp.hh"
 #include "sql_util.hh"
 #include "yajlpp/yajlpp.hh"
 #include "yajlpp/yajlpp_def.hh"
@@ -585,6 +586,13 @@ static const struct json_path_container value_def_handlers = {
                           "treated as a foreign key for row in another table")
         .for_field(&external_log_format::value_def::vd_foreign_key),
 
+    yajlpp::property_handler("collect-stats")
+        .with_synopsis("<bool>")
+        .with_description("Indicates whether online statistics (cardinality "
+                          "estimate, top values) should be collected for "
+                          "this field during indexing")
+        .for_field(&external_log_format::value_def::vd_collect_stats),
+
     yajlpp::property_handler("hidden")
         .with_synopsis("<bool>")
         .with_description(
@@ -1197,6 +1205,9 @@ load_formats(const std::vector<ghc::filesystem::path>& extra_paths,
 
     write_sample_file();
 
+    auto pattern_cache_path = lnav::paths::dotlnav() / "formats.cache";
+    lnav::pcre2pp::compile_cache::load(pattern_cache_path.string());
+
     log_debug("Loading default formats");
     for (const auto& bsf : lnav_format_json) {
         yajlpp_parse_context ypc_builtin(intern_string::lookup(bsf.get_name()),
@@ -1318,6 +1329,8 @@ load_formats(const std::vector<ghc::filesystem::path>& extra_paths,
     });
     roots.insert(
         iter, graph_ordered_formats.begin(), graph_ordered_formats.end());
+
+    lnav::pcre2pp::compile_cache::save(pattern_cache_path.string());
 }
 
 static void
@@ -30,11 +30,90 @@
 #ifndef lnav_log_gutter_source_hh
 #define lnav_log_gutter_source_hh
 
+#include <algorithm>
+#include <array>
+
+#include <stdint.h>
+
 #include "command_executor.hh"
 #include "logfile_sub_source.hh"
 
 class log_gutter_source : public list_gutter_source {
 public:
+    /**
+     * Resolution of the downsampled mark-density arrays.  A gutter row
+     * summarizes row_count/height lines, so sub-bucket precision is not
+     * visible in the overview strip and the arrays can stay this small
+     * no matter how many marks there are.
+     */
+    static constexpr size_t DENSITY_BUCKETS = 4096;
+
+    /**
+     * A downsampled view of one bookmark vector.  Range queries against
+     * the vector itself are cheap individually, but a repaint does a
+     * handful of them per gutter row and a scrollbar drag repaints
+     * continuously, which adds up with hundreds of thousands of search
+     * hits.  The bucket counts are rebuilt only when the vector changes
+     * shape, so dragging renders from this array instead.
+     */
+    struct mark_density {
+        bool contains(int start, int end) const
+        {
+            if (this->md_row_count == 0 || this->md_size == 0) {
+                return false;
+            }
+            if (start < 0) {
+                start = 0;
+            }
+
+            auto lo = std::min(
+                ((size_t) start * DENSITY_BUCKETS) / this->md_row_count,
+                DENSITY_BUCKETS - 1);
+            auto hi = std::min(
+                ((size_t) end * DENSITY_BUCKETS) / this->md_row_count,
+                DENSITY_BUCKETS - 1);
+
+            for (auto bucket = lo; bucket <= hi; bucket++) {
+                if (this->md_counts[bucket] > 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void update(const bookmark_vector<vis_line_t>& bv, size_t row_count)
+        {
+            auto back = bv.empty() ? -1 : (int) bv.back();
+
+            if (this->md_size == bv.size() && this->md_back == back
+                && this->md_row_count == row_count)
+            {
+                return;
+            }
+
+            this->md_counts.fill(0);
+            if (row_count > 0) {
+                for (auto vl : bv) {
+                    auto bucket = std::min(
+                        ((size_t) vl * DENSITY_BUCKETS) / row_count,
+                        DENSITY_BUCKETS - 1);
+
+                    if (this->md_counts[bucket] < UINT8_MAX) {
+                        this->md_counts[bucket] += 1;
+                    }
+                }
+            }
+            this->md_size = bv.size();
+            this->md_back = back;
+            this->md_row_count = row_count;
+        }
+
+        size_t md_size{0};
+        int md_back{-1};
+        size_t md_row_count{0};
+        std::array<uint8_t, DENSITY_BUCKETS> md_counts{};
+    };
+
     void listview_gutter_value_for_range(const listview_curses& lv,
                                          int start,
                                          int end,
@@ -44,34 +123,46 @@ public:
     {
         textview_curses* tc = (textview_curses*) &lv;
         vis_bookmarks& bm = tc->get_bookmarks();
+        size_t row_count = tc->get_inner_height();
         bool search_hit = false;
 
         start -= 1;
 
-        auto next = bm[&textview_curses::BM_SEARCH].next(vis_line_t(start));
-        search_hit = (next && next.value() <= end);
+        this->lgs_search_density.update(bm[&textview_curses::BM_SEARCH],
+                                        row_count);
+        this->lgs_user_density.update(bm[&textview_curses::BM_USER],
+                                      row_count);
+        this->lgs_meta_density.update(bm[&textview_curses::BM_META],
+                                      row_count);
+        this->lgs_error_density.update(bm[&logfile_sub_source::BM_ERRORS],
+                                       row_count);
+        this->lgs_warning_density.update(bm[&logfile_sub_source::BM_WARNINGS],
+                                         row_count);
 
-        next = bm[&textview_curses::BM_USER].next(vis_line_t(start));
-        if (!next) {
-            next = bm[&textview_curses::BM_META].next(vis_line_t(start));
-        }
-        if (next && next.value() <= end) {
+        search_hit = this->lgs_search_density.contains(start, end);
+
+        if (this->lgs_user_density.contains(start, end)
+            || this->lgs_meta_density.contains(start, end))
+        {
             ch = search_hit ? ACS_PLUS : ACS_LTEE;
         } else {
             ch = search_hit ? ACS_RTEE : ACS_VLINE;
         }
-        next = bm[&logfile_sub_source::BM_ERRORS].next(vis_line_t(start));
-        if (next && next.value() <= end) {
+        if (this->lgs_error_density.contains(start, end)) {
             role_out = role_t::VCR_ERROR;
             bar_role_out = role_t::VCR_SCROLLBAR_ERROR;
-        } else {
-            next = bm[&logfile_sub_source::BM_WARNINGS].next(vis_line_t(start));
-            if (next && next.value() <= end) {
-                role_out = role_t::VCR_WARNING;
-                bar_role_out = role_t::VCR_SCROLLBAR_WARNING;
-            }
+        } else if (this->lgs_warning_density.contains(start, end)) {
+            role_out = role_t::VCR_WARNING;
+            bar_role_out = role_t::VCR_SCROLLBAR_WARNING;
         }
     }
+
+private:
+    mark_density lgs_search_density;
+    mark_density lgs_user_density;
+    mark_density lgs_meta_density;
+    mark_density lgs_error_density;
+    mark_density lgs_warning_density;
 };
 
 #endif
@@ -305,10 +305,30 @@ struct vtab_cursor {
         this->log_msg_line = this->log_cursor.lc_curr_line;
     }
 
+    /**
+     * Resolve the current line to its file and line number once per row
+     * instead of repeating the find_data() binary search for every column.
+     */
+    void cache_location(log_vtab* vt)
+    {
+        if (this->log_loc_line == this->log_cursor.lc_curr_line) {
+            return;
+        }
+        this->log_loc_content
+            = content_line_t(vt->lss->at(this->log_cursor.lc_curr_line));
+        this->log_loc_data
+            = vt->lss->find_data(this->log_loc_content, this->log_loc_number);
+        this->log_loc_line = this->log_cursor.lc_curr_line;
+    }
+
     sqlite3_vtab_cursor base;
     struct log_cursor log_cursor;
     vis_line_t log_msg_line{-1_vl};
     logline_value_vector line_values;
+    vis_line_t log_loc_line{-1_vl};
+    content_line_t log_loc_content;
+    logfile_sub_source::iterator log_loc_data;
+    uint64_t log_loc_number{0};
 };
 
 static int vt_destructor(sqlite3_vtab* p_svt);
@@ -447,15 +467,13 @@ populate_indexed_columns(vtab_cursor* vc, log_vtab* vt)
         }
 
         if (lf == nullptr) {
-            content_line_t cl(vt->lss->at(vc->log_cursor.lc_curr_line));
-            uint64_t line_number;
-            auto ld = vt->lss->find_data(cl, line_number);
-            lf = (*ld)->get_file_ptr();
-            auto ll = lf->begin() + line_number;
+            vc->cache_location(vt);
+            lf = (*vc->log_loc_data)->get_file_ptr();
+            auto ll = lf->begin() + vc->log_loc_number;
 
             vc->cache_msg(lf, ll);
             require(vc->line_values.lvv_sbr.get_data() != nullptr);
-            vt->vi->extract(lf, line_number, vc->line_values);
+            vt->vi->extract(lf, vc->log_loc_number, vc->line_values);
         }
 
         int sub_col = ic.cc_column - VT_COL_MAX;
@@ -607,9 +625,10 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
               col);
 #endif
 
-    content_line_t cl(vt->lss->at(vc->log_cursor.lc_curr_line));
-    uint64_t line_number;
-    auto ld = vt->lss->find_data(cl, line_number);
+    vc->cache_location(vt);
+    const auto cl = vc->log_loc_content;
+    const auto line_number = vc->log_loc_number;
+    auto ld = vc->log_loc_data;
     auto* lf = (*ld)->get_file_ptr();
     auto ll = lf->begin() + line_number;
 
@@ -952,18 +971,36 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                     }
                 }
             } else {
-                if (vc->line_values.lvv_values.empty()) {
-                    vc->cache_msg(lf, ll);
-                    require(vc->line_values.lvv_sbr.get_data() != nullptr);
-                    vt->vi->extract(lf, line_number, vc->line_values);
+                auto& ec = vt->vi->vi_extract_cache;
+                const logline_value_vector* lvv = nullptr;
+
+                if (ec.ec_generation != vt->lss->lss_index_generation) {
+                    ec.ec_lines.clear();
+                    ec.ec_generation = vt->lss->lss_index_generation;
+                }
+                auto ec_iter = ec.ec_lines.find(cl);
+                if (ec_iter != ec.ec_lines.end()) {
+                    lvv = &ec_iter->second;
+                } else {
+                    if (vc->line_values.lvv_values.empty()) {
+                        vc->cache_msg(lf, ll);
+                        require(vc->line_values.lvv_sbr.get_data() != nullptr);
+                        vt->vi->extract(lf, line_number, vc->line_values);
+                    }
+                    if (ec.ec_lines.size()
+                        >= log_vtab_impl::extract_cache::MAX_LINES)
+                    {
+                        ec.ec_lines.clear();
+                    }
+                    lvv = &(ec.ec_lines[cl] = vc->line_values);
                 }
 
                 int sub_col = col - VT_COL_MAX;
-                auto lv_iter = find_if(vc->line_values.lvv_values.begin(),
-                                       vc->line_values.lvv_values.end(),
+                auto lv_iter = find_if(lvv->lvv_values.begin(),
+                                       lvv->lvv_values.end(),
                                        logline_value_cmp(nullptr, sub_col));
 
-                if (lv_iter != vc->line_values.lvv_values.end()) {
+                if (lv_iter != lvv->lvv_values.end()) {
                     if (!lv_iter->lv_meta.lvm_struct_name.empty()) {
                         yajlpp_gen gen;
                         yajl_gen_config(gen, yajl_gen_beautify, false);
@@ -971,9 +1008,7 @@ vt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
                         {
                             yajlpp_map root(gen);
 
-                            for (const auto& lv_struct :
-                                 vc->line_values.lvv_values)
-                            {
+                            for (const auto& lv_struct : lvv->lvv_values) {
                                 if (lv_struct.lv_meta.lvm_column != sub_col) {
                                     continue;
                                 }
@@ -1309,6 +1344,8 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
     p_cur->log_cursor.lc_last_unique_path_mismatch = nullptr;
     p_cur->log_cursor.lc_curr_line = 0_vl;
     p_cur->log_cursor.lc_end_line = vis_line_t(vt->lss->text_line_count());
+    p_cur->log_msg_line = -1_vl;
+    p_cur->log_loc_line = -1_vl;
 
     nonstd::optional<time_range> log_time_range;
     nonstd::optional<log_cursor::opid_hash> opid_val;
@@ -1457,19 +1494,13 @@ vt_filter(sqlite3_vtab_cursor* p_vtc,
                             if (!log_time_range) {
                                 log_time_range = time_range{};
                             }
-                            for (const auto& file_data : *vt->lss) {
-                                if (file_data->get_file_ptr() == nullptr) {
-                                    continue;
-                                }
-                                safe::ReadAccess<logfile::safe_opid_map>
-                                    r_opid_map(
-                                        file_data->get_file_ptr()->get_opids());
-                                const auto& iter = r_opid_map->find(opid);
-                                if (iter == r_opid_map->end()) {
-                                    continue;
-                                }
-                                log_time_range->add(iter->second.otr_begin);
-                                log_time_range->add(iter->second.otr_end);
+                            const auto& opid_map = vt->lss->get_opid_map();
+                            const auto opid_iter
+                                = opid_map.find(opid.to_string());
+                            if (opid_iter != opid_map.end()) {
+                                log_time_range->add(
+                                    opid_iter->second.otr_begin);
+                                log_time_range->add(opid_iter->second.otr_end);
                             }
 
                             opid_val = log_cursor::opid_hash{
@@ -1712,6 +1743,8 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
     std::vector<std::string> index_desc;
     int argvInUse = 0;
     auto* vt = (log_vtab*) tab;
+    auto has_line_constraint = false;
+    auto has_time_constraint = false;
 
     log_info("vt_best_index(%s, nConstraint=%d)",
              vt->vi->get_name().get(),
@@ -1741,6 +1774,7 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
         switch (col) {
             case VT_COL_LINE_NUMBER: {
                 argvInUse += 1;
+                has_line_constraint = true;
                 indexes.push_back(constraint);
                 p_info->aConstraintUsage[lpc].argvIndex = argvInUse;
                 index_desc.emplace_back(fmt::format(
@@ -1749,6 +1783,7 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
             }
             case VT_COL_LOG_TIME: {
                 argvInUse += 1;
+                has_time_constraint = true;
                 indexes.push_back(p_info->aConstraint[lpc]);
                 p_info->aConstraintUsage[lpc].argvIndex = argvInUse;
                 index_desc.emplace_back(fmt::format(
@@ -1774,6 +1809,7 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
                     switch (footer_column) {
                         case log_footer_columns::time_msecs: {
                             argvInUse += 1;
+                            has_time_constraint = true;
                             indexes.push_back(p_info->aConstraint[lpc]);
                             p_info->aConstraintUsage[lpc].argvIndex = argvInUse;
                             index_desc.emplace_back(
@@ -1880,6 +1916,22 @@ vt_best_index(sqlite3_vtab* tab, sqlite3_index_info* p_info)
         p_info->idxStr = static_cast<char*>(storage);
         p_info->needToFreeIdxStr = 1;
         p_info->estimatedCost = 10.0;
+
+        // Tell the planner how much these constraints narrow the scan.  A
+        // line number or time constraint seeks directly to a row range with
+        // a binary search, the others walk the range checking each row.
+        auto total_rows
+            = static_cast<sqlite3_int64>(vt->lss->text_line_count());
+        if (has_line_constraint) {
+            p_info->estimatedCost = 1.0;
+            p_info->estimatedRows = 1;
+        } else if (has_time_constraint) {
+            p_info->estimatedRows = std::max<sqlite3_int64>(
+                1, total_rows / 100);
+        } else {
+            p_info->estimatedRows
+                = std::max<sqlite3_int64>(1, total_rows / 10);
+        }
     } else {
         static char fullscan_str[] = "fullscan";
 
@@ -243,6 +243,22 @@ public:
 
     std::map<int32_t, column_index> vi_column_indexes;
 
+    /**
+     * Cache of the values extracted from recently visited lines so that
+     * back-to-back queries against the same table do not re-read and
+     * re-parse every message.  Entries are dropped when the index
+     * generation changes and the whole cache is reset once it grows past
+     * MAX_LINES.
+     */
+    struct extract_cache {
+        static const size_t MAX_LINES = 64 * 1024;
+
+        robin_hood::unordered_map<uint64_t, logline_value_vector> ec_lines;
+        int32_t ec_generation{0};
+    };
+
+    extract_cache vi_extract_cache;
+
     bool vi_supports_indexes{true};
     int vi_column_count{0};
     string_attrs_t vi_attrs;
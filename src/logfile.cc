@@ -29,6 +29,10 @@
  * @file logfile.cc
  */
 
+#include <atomic>
+#include <deque>
+#include <future>
+#include <thread>
 #include <utility>
 
 #include "logfile.hh"
@@ -47,16 +51,23 @@
 #include "base/injector.hh"
 #include "base/string_util.hh"
 #include "config.h"
+#include "index_cache.hh"
 #include "lnav_util.hh"
-#include "log.watch.hh"
 #include "log_format.hh"
 #include "logfile.cfg.hh"
+#include "perf_counters.hh"
 #include "yajlpp/yajlpp_def.hh"
 
 static auto intern_lifetime = intern_string::get_table_lifetime();
 
 static const size_t INDEX_RESERVE_INCREMENT = 1024;
 
+/** The smallest byte range worth handing to an indexing worker thread. */
+static const file_ssize_t CHUNKED_INDEX_MIN_CHUNK = 32 * 1024 * 1024;
+
+/** The smallest index worth persisting to the on-disk cache. */
+static const size_t INDEX_CACHE_MIN_LINES = 10000;
+
 static const typed_json_path_container<line_buffer::header_data>
     file_header_handlers = {
         yajlpp::property_handler("name").for_field(
@@ -148,7 +159,21 @@ logfile::logfile(std::string filename, logfile_open_options& loo)
     this->lf_opids.writeAccess()->reserve(64);
 }
 
-logfile::~logfile() {}
+logfile::~logfile()
+{
+    if (this->lf_format != nullptr && !this->lf_content_id.empty()
+        && this->lf_applicable_taggers.empty()
+        && this->lf_index.size() >= INDEX_CACHE_MIN_LINES
+        && !this->lf_line_buffer.is_compressed())
+    {
+        lnav::index_cache::store(this->lf_content_id,
+                                 this->lf_stat,
+                                 this->lf_format->get_name().to_string(),
+                                 this->lf_index_size,
+                                 this->lf_index,
+                                 this->lf_line_extents);
+    }
+}
 
 bool
 logfile::exists() const
@@ -161,6 +186,16 @@ logfile::exists() const
         return true;
     }
 
+    // This is called for every active file on every pass of the main
+    // loop, which adds up to a stat() storm when tailing many files.
+    // Deleted/rotated files don't need to be noticed instantly, so
+    // limit the checks to one a second.
+    auto now = std::chrono::steady_clock::now();
+    if (now < this->lf_next_exists_check_time) {
+        return true;
+    }
+    this->lf_next_exists_check_time = now + std::chrono::seconds(1);
+
     auto stat_res = lnav::filesystem::stat_file(this->lf_actual_path.value());
     if (stat_res.isErr()) {
         log_error("%s: stat failed -- %s",
@@ -182,6 +217,121 @@ logfile::reset_state()
     this->lf_indexing = this->lf_options.loo_is_visible;
 }
 
+bool
+logfile::write_index_sidecar(const ghc::filesystem::path& dest_path) const
+{
+    if (this->lf_format == nullptr || this->lf_content_id.empty()
+        || !this->lf_applicable_taggers.empty() || this->lf_index.empty()
+        || this->lf_line_buffer.is_compressed())
+    {
+        return false;
+    }
+
+    return lnav::index_cache::store_sidecar(
+        dest_path,
+        this->lf_content_id,
+        this->lf_stat,
+        this->lf_format->get_name().to_string(),
+        this->lf_index_size,
+        this->lf_index,
+        this->lf_line_extents);
+}
+
+bool
+logfile::hibernate()
+{
+    if (this->lf_hibernated || this->lf_format == nullptr
+        || this->lf_content_id.empty() || !this->lf_applicable_taggers.empty()
+        || this->lf_index.empty() || !this->lf_actual_path
+        || this->lf_line_buffer.is_compressed()
+        || this->lf_line_buffer.is_pipe()
+        || this->lf_index_size < this->lf_stat.st_size)
+    {
+        return false;
+    }
+
+    if (!lnav::index_cache::store(this->lf_content_id,
+                                  this->lf_stat,
+                                  this->lf_format->get_name().to_string(),
+                                  this->lf_index_size,
+                                  this->lf_index,
+                                  this->lf_line_extents))
+    {
+        return false;
+    }
+
+    log_info("%s: hibernating with %zu lines",
+             this->lf_filename.c_str(),
+             this->lf_index.size());
+    this->lf_hibernated_line_count = this->lf_index.size();
+    this->lf_hibernated_front_time = this->lf_index.front().get_timeval();
+    std::vector<logline>().swap(this->lf_index);
+    std::vector<line_extent>().swap(this->lf_line_extents);
+    this->lf_next_line_cache = nonstd::nullopt;
+    this->lf_line_buffer.hibernate();
+    this->lf_hibernated = true;
+
+    return true;
+}
+
+bool
+logfile::resume()
+{
+    if (!this->lf_hibernated) {
+        return true;
+    }
+
+    this->lf_hibernated = false;
+    this->lf_hibernated_line_count = 0;
+
+    auto rescan = [this]() {
+        this->lf_index.clear();
+        this->lf_index_size = 0;
+        this->lf_level_stats = {};
+        this->lf_stats_line = 0;
+        this->lf_sort_needed = true;
+        return false;
+    };
+
+    auto open_res = lnav::filesystem::open_file(this->lf_actual_path.value(),
+                                                O_RDONLY | O_CLOEXEC);
+    if (open_res.isErr()) {
+        log_error("%s: unable to reopen hibernated file -- %s",
+                  this->lf_filename.c_str(),
+                  open_res.unwrapErr().c_str());
+        this->close();
+        return rescan();
+    }
+
+    auto fd = open_res.unwrap();
+    struct stat st;
+
+    if (fstat(fd, &st) == -1) {
+        this->close();
+        return rescan();
+    }
+    this->lf_line_buffer.set_fd(fd);
+
+    auto cache_res = lnav::index_cache::load(this->lf_content_id, st);
+    if (cache_res.isErr()) {
+        log_warning("%s: cached index unusable on resume (%s), rescanning",
+                    this->lf_filename.c_str(),
+                    cache_res.unwrapErr().c_str());
+        return rescan();
+    }
+
+    auto ci = cache_res.unwrap();
+
+    log_info("%s: resumed %zu lines from the index-cache",
+             this->lf_filename.c_str(),
+             ci.ci_lines.size());
+    this->lf_index = std::move(ci.ci_lines);
+    this->lf_line_extents = std::move(ci.ci_extents);
+    this->lf_index_size = ci.ci_index_size;
+
+    return true;
+}
+
 void
 logfile::set_format_base_time(log_format* lf)
 {
@@ -203,6 +353,110 @@ logfile::set_format_base_time(log_format* lf)
                                    this->lf_cached_base_tm.value());
 }
 
+/**
+ * Fold the result of a log_format scan into the destination index.  This is
+ * shared by the serial scan in process_prefix() and the chunked parallel
+ * scan in rebuild_index_chunked() so both apply the same continuation
+ * handling and out-of-time-order fixups.
+ *
+ * @return True if the lines need to be resorted.
+ */
+static bool
+apply_scan_result(log_format* format,
+                  std::vector<logline>& dst,
+                  log_format::scan_result_t found,
+                  const line_info& li,
+                  size_t prescan_size,
+                  time_t prescan_time,
+                  time_t fallback_time,
+                  uint32_t& out_of_order_count)
+{
+    bool retval = false;
+
+    switch (found) {
+        case log_format::SCAN_MATCH: {
+            if (!dst.empty()) {
+                dst.back().set_valid_utf(li.li_valid_utf);
+                dst.back().set_has_ansi(li.li_has_ansi);
+            }
+            if (prescan_size > 0 && dst.size() >= prescan_size
+                && prescan_time != dst[prescan_size - 1].get_time())
+            {
+                retval = true;
+            }
+            if (prescan_size > 0 && prescan_size < dst.size()) {
+                auto& second_to_last = dst[prescan_size - 1];
+                auto& latest = dst[prescan_size];
+
+                if (!second_to_last.is_ignored() && latest < second_to_last) {
+                    if (format->lf_time_ordered) {
+                        out_of_order_count += 1;
+                        for (size_t lpc = prescan_size; lpc < dst.size();
+                             lpc++)
+                        {
+                            auto& line_to_update = dst[lpc];
+
+                            line_to_update.set_time_skew(true);
+                            line_to_update.set_time(second_to_last.get_time());
+                            line_to_update.set_millis(
+                                second_to_last.get_millis());
+                        }
+                    } else {
+                        retval = true;
+                    }
+                }
+            }
+            break;
+        }
+        case log_format::SCAN_NO_MATCH: {
+            log_level_t last_level = LEVEL_UNKNOWN;
+            time_t last_time = fallback_time;
+            short last_millis = 0;
+            uint8_t last_mod = 0, last_opid = 0;
+
+            if (!dst.empty()) {
+                logline& ll = dst.back();
+
+                /*
+                 * Assume this line is part of the previous one(s) and copy the
+                 * metadata over.
+                 */
+                last_time = ll.get_time();
+                last_millis = ll.get_millis();
+                if (format != nullptr) {
+                    last_level = (log_level_t) (ll.get_level_and_flags()
+                                                | LEVEL_CONTINUED);
+                }
+                last_mod = ll.get_module_id();
+                last_opid = ll.get_opid();
+            }
+            dst.emplace_back(li.li_file_range.fr_offset,
+                             last_time,
+                             last_millis,
+                             last_level,
+                             last_mod,
+                             last_opid);
+            dst.back().set_valid_utf(li.li_valid_utf);
+            dst.back().set_has_ansi(li.li_has_ansi);
+            break;
+        }
+        case log_format::SCAN_INCOMPLETE:
+            break;
+    }
+
+    return retval;
+}
+
+void
+logfile::align_line_extents(size_t prescan_size, const scan_batch_context& sbc)
+{
+    this->lf_line_extents.resize(prescan_size);
+    this->lf_line_extents.insert(this->lf_line_extents.end(),
+                                 sbc.sbc_extents.begin(),
+                                 sbc.sbc_extents.end());
+    this->lf_line_extents.resize(this->lf_index.size());
+}
+
 bool
 logfile::process_prefix(shared_buffer_ref& sbr,
                         const line_info& li,
@@ -217,6 +471,9 @@ logfile::process_prefix(shared_buffer_ref& sbr,
     time_t prescan_time = 0;
     bool retval = false;
 
+    lnav::perf::count(lnav::perf::counter_id::FORMAT_SCANS);
+
+    sbc.sbc_extents.clear();
     if (this->lf_format.get() != nullptr) {
         if (!this->lf_index.empty()) {
             prescan_time = this->lf_index[prescan_size - 1].get_time();
@@ -254,6 +511,11 @@ logfile::process_prefix(shared_buffer_ref& sbr,
                 this->lf_mismatched_formats.insert((*iter)->get_name());
                 continue;
             }
+            if (sbr.length() > 0
+                && !(*iter)->match_first_byte(sbr.get_data()[0]))
+            {
+                continue;
+            }
             if (!(*iter)->match_mime_type(this->lf_options.loo_file_format)) {
                 if (li.li_file_range.fr_offset == 0) {
                     log_debug("(%s) does not match file format: %s",
@@ -266,6 +528,7 @@ logfile::process_prefix(shared_buffer_ref& sbr,
 
             (*iter)->clear();
             this->set_format_base_time(iter->get());
+            sbc.sbc_extents.clear();
             found = (*iter)->scan(*this, this->lf_index, li, sbr, sbc);
             if (found == log_format::SCAN_MATCH) {
 #if 0
@@ -323,84 +586,339 @@ logfile::process_prefix(shared_buffer_ref& sbr,
         }
     }
 
-    switch (found) {
-        case log_format::SCAN_MATCH: {
-            if (!this->lf_index.empty()) {
-                this->lf_index.back().set_valid_utf(li.li_valid_utf);
-                this->lf_index.back().set_has_ansi(li.li_has_ansi);
-            }
-            if (prescan_size > 0 && this->lf_index.size() >= prescan_size
-                && prescan_time != this->lf_index[prescan_size - 1].get_time())
-            {
-                retval = true;
-            }
-            if (prescan_size > 0 && prescan_size < this->lf_index.size()) {
-                auto& second_to_last = this->lf_index[prescan_size - 1];
-                auto& latest = this->lf_index[prescan_size];
+    retval = apply_scan_result(this->lf_format.get(),
+                               this->lf_index,
+                               found,
+                               li,
+                               prescan_size,
+                               prescan_time,
+                               this->lf_index_time,
+                               this->lf_out_of_time_order_count);
+    this->align_line_extents(prescan_size, sbc);
 
-                if (!second_to_last.is_ignored() && latest < second_to_last) {
-                    if (this->lf_format->lf_time_ordered) {
-                        this->lf_out_of_time_order_count += 1;
-                        for (size_t lpc = prescan_size;
-                             lpc < this->lf_index.size();
-                             lpc++)
-                        {
-                            auto& line_to_update = this->lf_index[lpc];
+    return retval;
+}
 
-                            line_to_update.set_time_skew(true);
-                            line_to_update.set_time(second_to_last.get_time());
-                            line_to_update.set_millis(
-                                second_to_last.get_millis());
-                        }
-                    } else {
-                        retval = true;
+file_off_t
+logfile::rebuild_index_chunked(const struct stat& st,
+                               file_off_t begin_off,
+                               scan_batch_context& sbc,
+                               bool& sort_needed)
+{
+    struct chunk_result {
+        chunk_result(file_off_t begin, file_off_t end)
+            : cr_begin(begin), cr_end(end), cr_first_offset(begin),
+              cr_resume_offset(begin)
+        {
+        }
+
+        file_off_t cr_begin;
+        file_off_t cr_end;
+        std::unique_ptr<ArenaAlloc::Alloc<char>> cr_allocator{
+            std::make_unique<ArenaAlloc::Alloc<char>>(64 * 1024)};
+        std::vector<logline> cr_lines;
+        std::vector<line_extent> cr_extents;
+        log_opid_map cr_opids;
+        size_t cr_longest_line{0};
+        uint32_t cr_out_of_order{0};
+        file_off_t cr_first_offset;
+        file_off_t cr_resume_offset;
+        std::atomic<file_off_t> cr_progress{0};
+        bool cr_sort_needed{false};
+        bool cr_valid{false};
+    };
+
+    auto range_size = (file_ssize_t) (st.st_size - begin_off);
+    auto worker_count = std::min(
+        (file_ssize_t) std::max(2U, std::thread::hardware_concurrency()),
+        range_size / CHUNKED_INDEX_MIN_CHUNK);
+
+    if (worker_count < 2) {
+        return 0;
+    }
+
+    log_info("%s: chunked scan of %" PRId64 " bytes with %" PRId64 " workers",
+             this->lf_filename.c_str(),
+             (int64_t) range_size,
+             (int64_t) worker_count);
+
+    auto chunk_size = range_size / worker_count;
+    std::deque<chunk_result> chunks;
+    std::atomic<bool> stop_requested{false};
+
+    for (file_ssize_t lpc = 0; lpc < worker_count; lpc++) {
+        chunks.emplace_back(begin_off + lpc * chunk_size,
+                            lpc == worker_count - 1
+                                ? (file_off_t) st.st_size
+                                : begin_off + (lpc + 1) * chunk_size);
+    }
+
+    std::vector<std::future<void>> workers;
+    workers.reserve(worker_count);
+    for (auto& chunk : chunks) {
+        workers.emplace_back(std::async(
+            std::launch::async, [this, &chunk, begin_off, &stop_requested]() {
+                auto_fd chunk_fd(::dup(this->lf_line_buffer.get_fd()));
+
+                if (chunk_fd == -1) {
+                    return;
+                }
+
+                line_buffer lb;
+
+                try {
+                    lb.set_fd(chunk_fd);
+                } catch (const std::exception& e) {
+                    return;
+                }
+
+                auto fmt = this->lf_format->specialized(-1);
+                scan_batch_context chunk_sbc{*chunk.cr_allocator};
+                chunk_sbc.sbc_opids.reserve(32);
+                auto prev_range = file_range{chunk.cr_begin};
+                bool first_line = true;
+
+                if (chunk.cr_begin > begin_off) {
+                    /*
+                     * The line containing the byte before this chunk belongs
+                     * to the previous worker, so skip ahead to the next line
+                     * start.
+                     */
+                    auto skip_res
+                        = lb.load_next_line(file_range{chunk.cr_begin - 1});
+                    if (skip_res.isErr()) {
+                        return;
                     }
+                    prev_range = skip_res.unwrap().li_file_range;
+                }
+
+                shared_buffer_ref sbr;
+                while (!stop_requested.load()) {
+                    sbr.disown();
+
+                    auto load_result = lb.load_next_line(prev_range);
+
+                    if (load_result.isErr()) {
+                        return;
+                    }
+
+                    auto li = load_result.unwrap();
+
+                    if (li.li_file_range.empty()
+                        || li.li_file_range.fr_offset >= chunk.cr_end)
+                    {
+                        break;
+                    }
+                    if (li.li_partial) {
+                        // Leave the partial line at EOF for the serial scan
+                        // to pick up.
+                        break;
+                    }
+                    prev_range = li.li_file_range;
+                    if (first_line) {
+                        chunk.cr_first_offset = li.li_file_range.fr_offset;
+                        first_line = false;
+                    }
+
+                    auto read_result = lb.read_range(li.li_file_range, sbr);
+                    if (read_result.isErr()) {
+                        return;
+                    }
+
+                    sbr.rtrim(is_line_ending);
+
+                    if (li.li_valid_utf && li.li_has_ansi) {
+                        auto tmp_line = sbr.to_string_fragment().to_string();
+
+                        scrub_ansi_string(tmp_line, nullptr);
+                        memcpy(sbr.get_writable_data(),
+                               tmp_line.c_str(),
+                               tmp_line.length());
+                        sbr.narrow(0, tmp_line.length());
+                    }
+
+                    chunk.cr_longest_line
+                        = std::max(chunk.cr_longest_line, sbr.length());
+
+                    size_t prescan_size = chunk.cr_lines.size();
+                    time_t prescan_time = 0;
+
+                    if (prescan_size > 0) {
+                        prescan_time
+                            = chunk.cr_lines[prescan_size - 1].get_time();
+                    }
+
+                    chunk_sbc.sbc_extents.clear();
+                    auto found
+                        = fmt->scan(*this, chunk.cr_lines, li, sbr, chunk_sbc);
+
+                    chunk.cr_sort_needed
+                        = apply_scan_result(fmt.get(),
+                                            chunk.cr_lines,
+                                            found,
+                                            li,
+                                            prescan_size,
+                                            prescan_time,
+                                            this->lf_index_time,
+                                            chunk.cr_out_of_order)
+                        || chunk.cr_sort_needed;
+                    chunk.cr_extents.resize(prescan_size);
+                    chunk.cr_extents.insert(chunk.cr_extents.end(),
+                                            chunk_sbc.sbc_extents.begin(),
+                                            chunk_sbc.sbc_extents.end());
+                    chunk.cr_extents.resize(chunk.cr_lines.size());
+                    chunk.cr_progress.store(prev_range.next_offset()
+                                            - chunk.cr_begin);
+                }
+
+                chunk.cr_resume_offset = prev_range.next_offset();
+                chunk.cr_opids = std::move(chunk_sbc.sbc_opids);
+                chunk.cr_valid = !stop_requested.load();
+            }));
+    }
+
+    for (auto& worker : workers) {
+        while (worker.wait_for(std::chrono::milliseconds(100))
+               != std::future_status::ready)
+        {
+            if (this->lf_logfile_observer != nullptr) {
+                file_off_t progress = 0;
+
+                for (const auto& chunk : chunks) {
+                    progress += chunk.cr_progress.load();
+                }
+                auto indexing_res
+                    = this->lf_logfile_observer->logfile_indexing(
+                        this->shared_from_this(),
+                        begin_off + progress,
+                        st.st_size);
+                if (indexing_res
+                    == logfile_observer::indexing_result::BREAK)
+                {
+                    stop_requested.store(true);
                 }
             }
-            break;
         }
-        case log_format::SCAN_NO_MATCH: {
-            log_level_t last_level = LEVEL_UNKNOWN;
-            time_t last_time = this->lf_index_time;
-            short last_millis = 0;
-            uint8_t last_mod = 0, last_opid = 0;
+    }
 
-            if (!this->lf_index.empty()) {
-                logline& ll = this->lf_index.back();
+    if (stop_requested.load()) {
+        return 0;
+    }
 
-                /*
-                 * Assume this line is part of the previous one(s) and copy the
-                 * metadata over.
-                 */
-                last_time = ll.get_time();
-                last_millis = ll.get_millis();
-                if (this->lf_format.get() != nullptr) {
-                    last_level = (log_level_t) (ll.get_level_and_flags()
-                                                | LEVEL_CONTINUED);
+    auto expected_offset = begin_off;
+    for (const auto& chunk : chunks) {
+        if (!chunk.cr_valid || chunk.cr_first_offset != expected_offset) {
+            log_warning(
+                "%s: chunked scan did not line up at %" PRId64 ", falling "
+                "back to serial scan",
+                this->lf_filename.c_str(),
+                (int64_t) expected_offset);
+            return 0;
+        }
+        expected_offset = chunk.cr_resume_offset;
+    }
+
+    size_t chunk_line_count = 0;
+    for (const auto& chunk : chunks) {
+        chunk_line_count += chunk.cr_lines.size();
+    }
+    this->lf_index.reserve(this->lf_index.size() + chunk_line_count);
+
+    for (auto& chunk : chunks) {
+        if (!this->lf_index.empty() && !chunk.cr_lines.empty()) {
+            /*
+             * Apply the same time-skew fixup as the serial scan for lines at
+             * the head of a chunk that are older than the tail of the
+             * previous one.
+             */
+            const auto& prev_line = this->lf_index.back();
+            auto prev_time = prev_line.get_time();
+            auto prev_millis = prev_line.get_millis();
+            bool skewed = false;
+
+            for (auto& ll : chunk.cr_lines) {
+                if (!(ll.get_time() < prev_time
+                      || (ll.get_time() == prev_time
+                          && ll.get_millis() < prev_millis)))
+                {
+                    break;
+                }
+                ll.set_time_skew(true);
+                ll.set_time(prev_time);
+                ll.set_millis(prev_millis);
+                skewed = true;
+            }
+            if (skewed) {
+                this->lf_out_of_time_order_count += 1;
+            }
+        }
+
+        this->lf_line_extents.resize(this->lf_index.size());
+        this->lf_index.insert(
+            this->lf_index.end(),
+            std::make_move_iterator(chunk.cr_lines.begin()),
+            std::make_move_iterator(chunk.cr_lines.end()));
+        this->lf_line_extents.insert(this->lf_line_extents.end(),
+                                     chunk.cr_extents.begin(),
+                                     chunk.cr_extents.end());
+        this->lf_longest_line
+            = std::max(this->lf_longest_line, chunk.cr_longest_line);
+        this->lf_out_of_time_order_count += chunk.cr_out_of_order;
+        sort_needed = sort_needed || chunk.cr_sort_needed;
+
+        for (const auto& opid_pair : chunk.cr_opids) {
+            auto opid_iter = sbc.sbc_opids.find(opid_pair.first);
+
+            if (opid_iter == sbc.sbc_opids.end()) {
+                auto opid_copy = opid_pair.first.to_owned(sbc.sbc_allocator);
+
+                sbc.sbc_opids.emplace(opid_copy, opid_pair.second);
+            } else {
+                if (opid_pair.second.otr_begin < opid_iter->second.otr_begin) {
+                    opid_iter->second.otr_begin = opid_pair.second.otr_begin;
+                }
+                if (opid_iter->second.otr_end < opid_pair.second.otr_end) {
+                    opid_iter->second.otr_end = opid_pair.second.otr_end;
                 }
-                last_mod = ll.get_module_id();
-                last_opid = ll.get_opid();
             }
-            this->lf_index.emplace_back(li.li_file_range.fr_offset,
-                                        last_time,
-                                        last_millis,
-                                        last_level,
-                                        last_mod,
-                                        last_opid);
-            this->lf_index.back().set_valid_utf(li.li_valid_utf);
-            this->lf_index.back().set_has_ansi(li.li_has_ansi);
-            break;
         }
-        case log_format::SCAN_INCOMPLETE:
-            break;
     }
 
-    return retval;
+    return chunks.back().cr_resume_offset;
+}
+
+void
+logfile::reserve_index_for(file_ssize_t remaining_bytes)
+{
+    if (remaining_bytes <= 0 || this->lf_index.empty()
+        || this->lf_index_size <= 0)
+    {
+        return;
+    }
+
+    auto avg_line_length = std::max(
+        (file_ssize_t) 16,
+        (file_ssize_t) (this->lf_index_size / this->lf_index.size()));
+    auto expected
+        = this->lf_index.size() + (remaining_bytes / avg_line_length) + 1;
+
+    if (expected > this->lf_index.capacity()) {
+        // Leave some slack so lines shorter than the average do not
+        // immediately force a doubling anyway.
+        this->lf_index.reserve(expected + expected / 8);
+    }
 }
 
 logfile::rebuild_result_t
 logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
 {
+    if (this->lf_prescan_result) {
+        auto retval = this->lf_prescan_result.value();
+
+        this->lf_prescan_result = nonstd::nullopt;
+        return retval;
+    }
+
     if (!this->lf_indexing) {
         if (this->lf_sort_needed) {
             this->lf_sort_needed = false;
@@ -409,6 +927,12 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
         return rebuild_result_t::NO_NEW_LINES;
     }
 
+    if (this->lf_hibernated) {
+        // The descriptor is closed, any new data is picked up after the
+        // file is resumed.
+        return rebuild_result_t::NO_NEW_LINES;
+    }
+
     auto retval = rebuild_result_t::NO_NEW_LINES;
     struct stat st;
 
@@ -471,9 +995,11 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
              * read.
              */
             while (this->lf_index.back().get_sub_offset() != 0) {
+                this->rollback_level_stats();
                 this->lf_index.pop_back();
                 rollback_size += 1;
             }
+            this->rollback_level_stats();
             this->lf_index.pop_back();
             rollback_size += 1;
 
@@ -509,6 +1035,74 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
             this->lf_logline_observer->logline_restart(*this, rollback_size);
         }
 
+        if (begin_size == 0 && !has_format && off == 0
+            && this->lf_options.loo_detect_format
+            && this->lf_logline_observer == nullptr
+            && !this->lf_line_buffer.is_compressed())
+        {
+            /*
+             * Compute the content ID the same way format detection would for
+             * the first line and see if a cached index is available for it.
+             */
+            auto first_line_res
+                = this->lf_line_buffer.load_next_line(file_range{0});
+
+            if (first_line_res.isOk()) {
+                auto first_li = first_line_res.unwrap();
+                auto first_read_res
+                    = this->lf_line_buffer.read_range(first_li.li_file_range);
+
+                if (first_read_res.isOk() && !first_li.li_partial) {
+                    auto first_sbr = first_read_res.unwrap();
+
+                    first_sbr.rtrim(is_line_ending);
+
+                    auto cache_id = hasher()
+                                        .update(first_sbr.get_data(),
+                                                first_sbr.length())
+                                        .to_string();
+                    auto cache_res = [this, &cache_id, &st]() {
+                        auto sidecar_path
+                            = ghc::filesystem::path(this->lf_filename);
+
+                        sidecar_path
+                            += lnav::index_cache::SIDECAR_EXTENSION;
+                        auto sidecar_res = lnav::index_cache::load_sidecar(
+                            sidecar_path, cache_id, st);
+                        if (sidecar_res.isOk()) {
+                            return sidecar_res;
+                        }
+                        return lnav::index_cache::load(cache_id, st);
+                    }();
+
+                    if (cache_res.isOk()) {
+                        auto ci = cache_res.unwrap();
+                        auto root_fmt = log_format::find_root_format(
+                            ci.ci_format_name.c_str());
+
+                        if (root_fmt != nullptr
+                            && root_fmt->lf_tag_defs.empty())
+                        {
+                            log_info("%s: restoring %zu lines from the "
+                                     "index-cache",
+                                     this->lf_filename.c_str(),
+                                     ci.ci_lines.size());
+                            this->lf_index = std::move(ci.ci_lines);
+                            this->lf_line_extents
+                                = std::move(ci.ci_extents);
+                            this->lf_format = root_fmt->specialized();
+                            this->set_format_base_time(this->lf_format.get());
+                            this->lf_text_format = text_format_t::TF_LOG;
+                            this->lf_content_id = cache_id;
+                            this->lf_index_size = ci.ci_index_size;
+                            off = ci.ci_index_size;
+                            has_format = true;
+                        }
+                    }
+                }
+            }
+        }
+
         bool sort_needed = this->lf_sort_needed;
         this->lf_sort_needed = false;
         size_t limit = SIZE_MAX;
@@ -525,7 +1119,15 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
             } else if (!has_format) {
                 limit = 1000;
             } else {
-                limit = 1000 * 1000;
+                // Size the batch by a byte budget instead of a fixed line
+                // count: a million 64-byte syslog lines and a few hundred
+                // 200KB JSON blobs cost about the same to scan.
+                static constexpr size_t BATCH_TARGET_BYTES = 64 * 1024 * 1024;
+
+                limit = std::max<size_t>(
+                    1000,
+                    BATCH_TARGET_BYTES
+                        / this->lf_line_buffer.get_estimated_line_length());
             }
         }
         if (!has_format) {
@@ -534,8 +1136,64 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
         }
         scan_batch_context sbc{this->lf_allocator};
         sbc.sbc_opids.reserve(32);
+
+        if (has_format && this->lf_applicable_taggers.empty()
+            && !this->lf_line_buffer.is_compressed()
+            && !this->lf_line_buffer.is_pipe())
+        {
+            auto pre_chunk_size = this->lf_index.size();
+            auto resume_off
+                = this->rebuild_index_chunked(st, off, sbc, sort_needed);
+
+            if (resume_off > 0) {
+                off = resume_off;
+                // Record the indexed size now so line_length() is correct
+                // for the last merged line during the replay below.
+                this->lf_index_size = resume_off;
+
+                if (this->lf_logline_observer != nullptr) {
+                    /*
+                     * The chunk workers do not notify the observer since
+                     * they scan out of order, so replay the merged lines
+                     * here to give it the same ordered progress a serial
+                     * scan would have produced.
+                     */
+                    for (auto iter = this->begin() + pre_chunk_size;
+                         iter != this->end();
+                         ++iter)
+                    {
+                        if (iter->get_sub_offset() > 0) {
+                            continue;
+                        }
+
+                        this->read_line(iter).then([this, iter](auto sbr) {
+                            auto iter_end = iter + 1;
+
+                            while (iter_end != this->end()
+                                   && iter_end->get_sub_offset() != 0)
+                            {
+                                ++iter_end;
+                            }
+                            this->lf_logline_observer->logline_new_lines(
+                                *this, iter, iter_end, sbr);
+                        });
+                    }
+                }
+            }
+        }
+
+        if (has_format) {
+            this->reserve_index_for(st.st_size - off);
+        }
+
         auto prev_range = file_range{off};
+        shared_buffer_ref sbr;
         while (limit > 0) {
+            // Drop the previous line's ref before loading the next one so
+            // that a buffer refill does not copy-on-invalidate bytes that
+            // are no longer needed.
+            sbr.disown();
+
             auto load_result = this->lf_line_buffer.load_next_line(prev_range);
 
             if (load_result.isErr()) {
@@ -594,7 +1252,7 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
             }
 
             auto read_result
-                = this->lf_line_buffer.read_range(li.li_file_range);
+                = this->lf_line_buffer.read_range(li.li_file_range, sbr);
             if (read_result.isErr()) {
                 log_error("%s:read failure -- %s",
                           this->lf_filename.c_str(),
@@ -603,7 +1261,6 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
                 return rebuild_result_t::INVALID;
             }
 
-            auto sbr = read_result.unwrap();
             sbr.rtrim(is_line_ending);
 
             if (li.li_valid_utf && li.li_has_ansi) {
@@ -692,9 +1349,6 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
                     }
                 }
 
-                if (!this->back().is_continued()) {
-                    lnav::log::watch::eval_with(*this, this->end() - 1);
-                }
             }
 
             if (li.li_partial) {
@@ -774,6 +1428,9 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
                     }
                 }
             }
+            if (!sbc.sbc_opids.empty()) {
+                this->lf_opid_generation += 1;
+            }
         }
 
         if (sort_needed) {
@@ -798,12 +1455,21 @@ logfile::rebuild_index(nonstd::optional<ui_clock::time_point> deadline)
         this->lf_out_of_time_order_count = 0;
     }
 
+    this->update_level_stats();
+
     return retval;
 }
 
+void
+logfile::prescan_index(nonstd::optional<ui_clock::time_point> deadline)
+{
+    this->lf_prescan_result = this->rebuild_index(deadline);
+}
+
 Result<shared_buffer_ref, std::string>
 logfile::read_line(logfile::iterator ll)
 {
+    this->lf_last_read_time = std::chrono::steady_clock::now();
     try {
         auto get_range_res = this->get_file_range(ll, false);
         return this->lf_line_buffer.read_range(get_range_res)
@@ -850,6 +1516,7 @@ logfile::read_full_message(logfile::const_iterator ll,
         "%s: reading msg at %d", this->lf_filename.c_str(), ll->get_offset());
 #endif
 
+    this->lf_last_read_time = std::chrono::steady_clock::now();
     msg_out.disown();
     auto range_for_line = this->get_file_range(ll);
     try {
@@ -969,6 +1636,7 @@ logfile::read_raw_message(logfile::const_iterator ll)
 {
     require(ll->get_sub_offset() == 0);
 
+    this->lf_last_read_time = std::chrono::steady_clock::now();
     return this->lf_line_buffer.read_range(this->get_file_range(ll));
 }
 
@@ -1015,15 +1683,20 @@ logfile::adjust_content_time(int line, const timeval& tv, bool abs_offset)
     } else {
         timeradd(&old_time, &tv, &this->lf_time_offset);
     }
-    for (auto& iter : *this) {
-        struct timeval curr, diff, new_time;
-
-        curr = iter.get_timeval();
-        timersub(&curr, &old_time, &diff);
-        timeradd(&diff, &this->lf_time_offset, &new_time);
-        iter.set_time(new_time);
+    // The same delta applies to every line, so compute it once and do a
+    // single 64-bit add per line instead of converting each timestamp
+    // through a timeval.  Reversing an adjustment is just another pass with
+    // the delta negated.
+    struct timeval delta_tv;
+    timersub(&this->lf_time_offset, &old_time, &delta_tv);
+
+    auto delta_ms = delta_tv.tv_sec * 1000LL + delta_tv.tv_usec / 1000LL;
+    if (delta_ms != 0) {
+        for (auto& iter : *this) {
+            iter.adjust_time(delta_ms);
+        }
+        this->lf_sort_needed = true;
     }
-    this->lf_sort_needed = true;
 }
 
 void
@@ -37,6 +37,8 @@ namespace logfile {
 
 struct config {
     uint64_t lc_max_unrecognized_lines{1000};
+    uint64_t lc_decompress_block_cache_size{64 * 1024 * 1024};
+    uint64_t lc_hibernate_idle_time{300};
 };
 
 }  // namespace logfile
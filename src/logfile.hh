@@ -33,6 +33,8 @@
 #ifndef logfile_hh
 #define logfile_hh
 
+#include <array>
+#include <chrono>
 #include <set>
 #include <string>
 #include <utility>
@@ -144,12 +146,46 @@ public:
 
     size_t get_longest_line_length() const { return this->lf_longest_line; }
 
+    /** @return The bytes held by this file's arena for opid strings. */
+    size_t get_allocator_bytes()
+    {
+        return this->lf_allocator.getNumBytesAllocated();
+    }
+
+    using level_stats_array = std::array<uint32_t, LEVEL__MAX>;
+
+    /**
+     * @return The number of messages indexed so far for each log level,
+     * maintained incrementally by rebuild_index().
+     */
+    const level_stats_array& get_level_stats() const
+    {
+        return this->lf_level_stats;
+    }
+
     bool is_compressed() const { return this->lf_line_buffer.is_compressed(); }
 
     bool is_valid_filename() const { return this->lf_valid_filename; }
 
     file_off_t get_index_size() const { return this->lf_index_size; }
 
+    /**
+     * @return An estimate of the amount of heap memory held for this file,
+     * covering the line index and the line buffer.
+     */
+    size_t estimated_memory_usage() const
+    {
+        return this->lf_index.capacity() * sizeof(logline)
+            + this->lf_line_buffer.get_buffer_size();
+    }
+
+    /**
+     * Releases the excess capacity in the line index.  Only worthwhile for
+     * files that are fully indexed, shrinking a growing index just forces a
+     * reallocation on the next append.
+     */
+    void reduce_memory_usage() { this->lf_index.shrink_to_fit(); }
+
     nonstd::optional<const_iterator> line_for_offset(file_off_t off) const;
 
     /**
@@ -197,6 +233,45 @@ public:
 
     void reset_state();
 
+    /**
+     * Move this fully-indexed file into a dormant state: the line index is
+     * saved to the index-cache and dropped along with the line buffer and
+     * file descriptor, leaving only a stub (content ID, time range, line
+     * count) behind.  Only safe for files whose lines are not reachable
+     * from any view, the caller is responsible for checking that.
+     *
+     * @return True if the file was hibernated.
+     */
+    bool hibernate();
+
+    /**
+     * Bring a hibernated file back by reopening the descriptor and
+     * restoring the index from the index-cache.
+     *
+     * @return True if the index was restored as-is.  On failure the index
+     * is left empty with a pending sort so the next rebuild_index() pass
+     * rescans the file and the merged views are rebuilt from scratch.
+     */
+    bool resume();
+
+    bool is_hibernated() const { return this->lf_hibernated; }
+
+    /**
+     * Write the current line index as a sidecar file (see
+     * lnav::index_cache::SIDECAR_EXTENSION) so a copy of this file can
+     * be opened elsewhere without a rescan.
+     *
+     * @param dest_path The path of the sidecar file to write.
+     * @return True if the sidecar was written.
+     */
+    bool write_index_sidecar(const ghc::filesystem::path& dest_path) const;
+
+    /** @return The time of the last content read, for idleness checks. */
+    std::chrono::steady_clock::time_point get_last_read_time() const
+    {
+        return this->lf_last_read_time;
+    }
+
     bool is_time_adjusted() const
     {
         return (this->lf_time_offset.tv_sec != 0
@@ -306,6 +381,25 @@ public:
     rebuild_result_t rebuild_index(
         nonstd::optional<ui_clock::time_point> deadline = nonstd::nullopt);
 
+    /**
+     * @return True if this file can be indexed off of the main thread.  Only
+     * files with a locked-in format qualify since format detection probes the
+     * shared root format objects.
+     */
+    bool is_prescannable() const
+    {
+        return this->lf_format.get() != nullptr && this->lf_indexing
+            && !this->lf_is_closed;
+    }
+
+    /**
+     * Run rebuild_index() on behalf of a worker thread and stash the result
+     * so the next call to rebuild_index() from the main thread will return
+     * it without rescanning the file.
+     */
+    void prescan_index(
+        nonstd::optional<ui_clock::time_point> deadline = nonstd::nullopt);
+
     void reobserve_from(iterator iter);
 
     void set_logfile_observer(logfile_observer* lo)
@@ -313,6 +407,11 @@ public:
         this->lf_logfile_observer = lo;
     }
 
+    logfile_observer* get_logfile_observer() const
+    {
+        return this->lf_logfile_observer;
+    }
+
     void set_logline_observer(logline_observer* llo);
 
     logline_observer* get_logline_observer() const
@@ -320,19 +419,36 @@ public:
         return this->lf_logline_observer;
     }
 
+    /**
+     * @param tm_out Set to the time of the first line, taken from the
+     * stub when the file is hibernated.
+     * @return True if the file has any lines.
+     */
+    bool front_line_time(time_t& tm_out) const
+    {
+        if (this->lf_hibernated) {
+            tm_out = this->lf_hibernated_front_time.tv_sec;
+            return this->lf_hibernated_line_count > 0;
+        }
+        if (this->lf_index.empty()) {
+            return false;
+        }
+        tm_out = this->lf_index[0].get_time();
+        return true;
+    }
+
     bool operator<(const logfile& rhs) const
     {
-        bool retval;
+        time_t lhs_time, rhs_time;
 
-        if (this->lf_index.empty()) {
-            retval = true;
-        } else if (rhs.lf_index.empty()) {
-            retval = false;
-        } else {
-            retval = this->lf_index[0].get_time() < rhs.lf_index[0].get_time();
+        if (!this->front_line_time(lhs_time)) {
+            return true;
+        }
+        if (!rhs.front_line_time(rhs_time)) {
+            return false;
         }
 
-        return retval;
+        return lhs_time < rhs_time;
     }
 
     bool is_indexing() const { return this->lf_indexing; }
@@ -362,6 +478,46 @@ public:
 
     safe_opid_map& get_opids() { return this->lf_opids; }
 
+    /**
+     * @return A counter that is incremented whenever new opids are found
+     * in this file, so that aggregated views of the per-file opid maps
+     * can tell when they need to be rebuilt.
+     */
+    size_t get_opid_generation() const { return this->lf_opid_generation; }
+
+    /**
+     * Progress of watch-expression evaluation over this file, maintained
+     * by lnav::log::watch::catch_up().  Lines before wc_frontier have been
+     * evaluated with the full expression set of wc_generation; the backfill
+     * fields track a sweep of older lines for expressions that were added
+     * mid-session.
+     */
+    struct watch_cursor {
+        size_t wc_frontier{0};
+        size_t wc_generation{0};
+        size_t wc_backfill_line{0};
+        size_t wc_backfill_end{0};
+        size_t wc_backfill_floor{0};
+    };
+
+    watch_cursor& get_watch_cursor() { return this->lf_watch_cursor; }
+
+    /**
+     * @return The timestamp/body extents captured when the given line was
+     * scanned, or nothing if the scanner did not report them.
+     */
+    nonstd::optional<line_extent> get_line_extent(size_t line) const
+    {
+        if (line < this->lf_line_extents.size()) {
+            const auto& le = this->lf_line_extents[line];
+
+            if (le.le_ts_end > le.le_ts_start) {
+                return le;
+            }
+        }
+        return nonstd::nullopt;
+    }
+
     void quiesce() { this->lf_line_buffer.quiesce(); }
 
     void enable_cache() { this->lf_line_buffer.enable_cache(); }
@@ -396,22 +552,113 @@ protected:
                         const line_info& li,
                         scan_batch_context& sbc);
 
+    /**
+     * Scan a large file with a locked-in format by splitting the remaining
+     * byte range into chunks that are indexed by worker threads, each with
+     * their own line_buffer over the same descriptor, and then splicing the
+     * per-chunk logline vectors into lf_index in order.
+     *
+     * @return The offset where the serial scan should resume or zero if the
+     * chunked scan could not be performed.
+     */
+    file_off_t rebuild_index_chunked(const struct stat& st,
+                                     file_off_t begin_off,
+                                     scan_batch_context& sbc,
+                                     bool& sort_needed);
+
     void set_format_base_time(log_format* lf);
 
+    /**
+     * Splice the extents captured by the last scan() call into
+     * lf_line_extents, padding with zeroed entries and trimming so the
+     * table stays exactly parallel to lf_index no matter which scanner
+     * ran or how many lines a rollback popped.
+     */
+    void align_line_extents(size_t prescan_size,
+                            const scan_batch_context& sbc);
+
 private:
     logfile(std::string filename, logfile_open_options& loo);
 
+    /**
+     * Reserve space in lf_index for the lines expected in the rest of the
+     * file, estimated from the average line length seen so far.  Growing a
+     * multi-gigabyte index by doubling copies the whole thing on every
+     * reallocation, so a single up-front reservation avoids the memory
+     * spikes when indexing very large files.
+     */
+    void reserve_index_for(file_ssize_t remaining_bytes);
+
+    /**
+     * Count the messages added to the index since the last call.  If the
+     * index shrank, for example when a format is detected mid-file and the
+     * lines are reparsed, the counts are rebuilt from scratch.
+     */
+    void update_level_stats()
+    {
+        if (this->lf_index.size() < this->lf_stats_line) {
+            this->lf_level_stats = {};
+            this->lf_stats_line = 0;
+        }
+        for (; this->lf_stats_line < this->lf_index.size();
+             this->lf_stats_line++)
+        {
+            const auto& ll = this->lf_index[this->lf_stats_line];
+
+            if (ll.is_continued()) {
+                continue;
+            }
+            this->lf_level_stats[ll.get_msg_level()] += 1;
+        }
+    }
+
+    /**
+     * Discount the last line of the index before it is popped during the
+     * partial-line rollback in rebuild_index().
+     */
+    void rollback_level_stats()
+    {
+        auto line_index = this->lf_index.size() - 1;
+
+        if (this->lf_stats_line <= line_index) {
+            return;
+        }
+
+        const auto& ll = this->lf_index[line_index];
+
+        if (!ll.is_continued()
+            && this->lf_level_stats[ll.get_msg_level()] > 0)
+        {
+            this->lf_level_stats[ll.get_msg_level()] -= 1;
+        }
+        this->lf_stats_line = line_index;
+    }
+
     std::string lf_filename;
     logfile_open_options lf_options;
     logfile_activity lf_activity;
     bool lf_named_file{true};
     bool lf_valid_filename{true};
     nonstd::optional<ghc::filesystem::path> lf_actual_path;
+    mutable std::chrono::steady_clock::time_point lf_next_exists_check_time{};
     std::string lf_basename;
     std::string lf_content_id;
     struct stat lf_stat {};
     std::shared_ptr<log_format> lf_format;
+    /**
+     * The index of lines in this file.  The index is effectively
+     * append-only: rebuild_index() only ever adds lines to the end, except
+     * for the single-line rollback of a partial last line.  Consumers that
+     * want a stable view across an indexing burst (e.g. the incremental
+     * rebuild in logfile_sub_source) snapshot the size and work against
+     * that prefix rather than re-reading the whole vector.  Indexing and
+     * rendering both run on the main loop, so no locking is needed; the
+     * only other thread touching this file is the line_buffer loader,
+     * which is synchronized through its own future.
+     */
     std::vector<logline> lf_index;
+    level_stats_array lf_level_stats{};
+    size_t lf_stats_line{0};
     time_t lf_index_time{0};
     file_off_t lf_index_size{0};
     bool lf_sort_needed{false};
@@ -422,6 +669,15 @@ private:
     };
     bool lf_is_closed{false};
     bool lf_indexing{true};
+    bool lf_hibernated{false};
+    /** Stub retained while hibernated, see hibernate(). */
+    size_t lf_hibernated_line_count{0};
+    struct timeval lf_hibernated_front_time {
+        0, 0
+    };
+    std::chrono::steady_clock::time_point lf_last_read_time{
+        std::chrono::steady_clock::now()};
+    nonstd::optional<rebuild_result_t> lf_prescan_result;
     bool lf_partial_line{false};
     logline_observer* lf_logline_observer{nullptr};
     logfile_observer* lf_logfile_observer{nullptr};
@@ -430,7 +686,10 @@ private:
     uint32_t lf_out_of_time_order_count{0};
     safe_notes lf_notes;
     safe_opid_map lf_opids;
-    size_t lf_watch_count{0};
+    size_t lf_opid_generation{0};
+    watch_cursor lf_watch_cursor;
+    /** Parallel to lf_index, see get_line_extent(). */
+    std::vector<line_extent> lf_line_extents;
     ArenaAlloc::Alloc<char> lf_allocator{64 * 1024};
     nonstd::optional<time_t> lf_cached_base_time;
     nonstd::optional<tm> lf_cached_base_tm;
@@ -42,15 +42,19 @@
 #include "bound_tags.hh"
 #include "command_executor.hh"
 #include "config.h"
+#include "index_cache.hh"
 #include "k_merge_tree.h"
 #include "lnav.events.hh"
+#include "lnav_util.hh"
 #include "log_accel.hh"
 #include "logfile_sub_source.cfg.hh"
 #include "md2attr_line.hh"
+#include "perf_counters.hh"
 #include "readline_highlighters.hh"
 #include "relative_time.hh"
 #include "sql_util.hh"
 #include "vtab_module.hh"
+#include "xxHash/xxhash.h"
 #include "yajlpp/yajlpp.hh"
 
 const bookmark_type_t logfile_sub_source::BM_ERRORS("error");
@@ -191,16 +195,28 @@ logfile_sub_source::text_value_for_line(textview_curses& tc,
         shared_buffer_ref sbr;
 
         this->lss_token_file->read_full_message(this->lss_token_line, sbr);
-        this->lss_token_value = to_string(sbr);
+        // Assigning into the token member reuses its capacity instead of
+        // allocating a fresh string for every rendered line.
+        this->lss_token_value.assign(sbr.get_data(), sbr.length());
+        lnav::perf::count(lnav::perf::counter_id::RENDER_COPY_BYTES,
+                          sbr.length());
         if (sbr.get_metadata().m_has_ansi) {
             scrub_ansi_string(this->lss_token_value, &this->lss_token_attrs);
             sbr.get_metadata().m_has_ansi = false;
         }
     } else {
-        this->lss_token_value
-            = this->lss_token_file->read_line(this->lss_token_line)
-                  .map([](auto sbr) { return to_string(sbr); })
-                  .unwrapOr({});
+        auto read_res = this->lss_token_file->read_line(this->lss_token_line);
+
+        if (read_res.isOk()) {
+            auto line_sbr = read_res.unwrap();
+
+            this->lss_token_value.assign(line_sbr.get_data(),
+                                         line_sbr.length());
+            lnav::perf::count(lnav::perf::counter_id::RENDER_COPY_BYTES,
+                              line_sbr.length());
+        } else {
+            this->lss_token_value.clear();
+        }
         if (this->lss_token_line->has_ansi()) {
             scrub_ansi_string(this->lss_token_value, &this->lss_token_attrs);
         }
@@ -255,25 +271,43 @@ logfile_sub_source::text_value_for_line(textview_curses& tc,
             const char* fmt;
             ssize_t len;
 
+            adjusted_time = this->lss_token_line->get_timeval();
+            if (adjusted_time.tv_sec != this->lss_time_memo_sec) {
+                gmtime_r(&adjusted_time.tv_sec, &this->lss_time_memo_tm);
+                this->lss_time_memo_sec = adjusted_time.tv_sec;
+                this->lss_time_memo_len = 0;
+            }
+            adjusted_tm.et_tm = this->lss_time_memo_tm;
+            adjusted_tm.et_nsec
+                = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      std::chrono::microseconds{adjusted_time.tv_usec})
+                      .count();
+
             if (format->lf_timestamp_flags & ETF_MACHINE_ORIENTED
                 || !(format->lf_timestamp_flags & ETF_DAY_SET)
                 || !(format->lf_timestamp_flags & ETF_MONTH_SET))
             {
-                adjusted_time = this->lss_token_line->get_timeval();
-                fmt = "%Y-%m-%d %H:%M:%S.%f";
-                gmtime_r(&adjusted_time.tv_sec, &adjusted_tm.et_tm);
-                adjusted_tm.et_nsec
-                    = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                          std::chrono::microseconds{adjusted_time.tv_usec})
-                          .count();
-                len = ftime_fmt(buffer, sizeof(buffer), fmt, adjusted_tm);
+                if (this->lss_time_memo_len == 0) {
+                    // The prefix up to the seconds only depends on tv_sec
+                    // and the format string is fixed, so it can be reused
+                    // for every line in this second.
+                    fmt = "%Y-%m-%d %H:%M:%S";
+                    this->lss_time_memo_len
+                        = ftime_fmt(this->lss_time_memo_buf,
+                                    sizeof(this->lss_time_memo_buf),
+                                    fmt,
+                                    adjusted_tm);
+                }
+                memcpy(buffer,
+                       this->lss_time_memo_buf,
+                       this->lss_time_memo_len);
+
+                off_t frac_off = this->lss_time_memo_len;
+                buffer[frac_off++] = '.';
+                ftime_f(buffer, frac_off, sizeof(buffer), adjusted_tm);
+                buffer[frac_off] = '\0';
+                len = frac_off;
             } else {
-                adjusted_time = this->lss_token_line->get_timeval();
-                gmtime_r(&adjusted_time.tv_sec, &adjusted_tm.et_tm);
-                adjusted_tm.et_nsec
-                    = std::chrono::duration_cast<std::chrono::nanoseconds>(
-                          std::chrono::microseconds{adjusted_time.tv_usec})
-                          .count();
                 len = format->lf_date_time.ftime(
                     buffer,
                     sizeof(buffer),
@@ -534,15 +568,16 @@ logfile_sub_source::text_attrs_for_line(textview_curses& lv,
                 value_out.emplace_back(
                     lr, logline::L_PARTITION.value(line_meta_opt.value()));
             }
-        }
 
-        auto line_meta_opt = this->find_bookmark_metadata(vis_line_t(row));
-
-        if (line_meta_opt) {
-            lr.lr_start = 0;
-            lr.lr_end = -1;
-            value_out.emplace_back(
-                lr, logline::L_META.value(line_meta_opt.value()));
+            // Lines only have metadata if they are in the BM_META
+            // bookmark vector, so the lower_bound above already answers
+            // whether this row has any without another lookup per row.
+            if (*bv_iter == vis_line_t(row) && line_meta_opt) {
+                lr.lr_start = 0;
+                lr.lr_end = -1;
+                value_out.emplace_back(
+                    lr, logline::L_META.value(line_meta_opt.value()));
+            }
         }
     }
 
@@ -622,6 +657,8 @@ logfile_sub_source::rebuild_index(
         return rebuild_result::rr_no_change;
     }
 
+    lnav::perf::timer rebuild_timer(lnav::perf::counter_id::INDEX_REBUILDS);
+
     iterator iter;
     size_t total_lines = 0;
     bool full_sort = false;
@@ -660,6 +697,39 @@ logfile_sub_source::rebuild_index(
                                  < right_ld->get_file_ptr()->back();
                          });
     }
+    if (deadline) {
+        // The deadline can cut indexing short, so give the cycles to the
+        // files the user is actually looking at or tailing and let cold
+        // files soak up whatever time is left.  The sort is stable so
+        // files of equal priority keep the oldest-tail-first order from
+        // above, which minimizes the partial rebuilds caused by indexing
+        // newer lines before older ones.
+        static const time_t RECENT_WRITE_PERIOD = 60;
+
+        auto now = time(nullptr);
+        auto prio_for = [this, now](size_t index) {
+            const auto& ld = this->lss_files[index];
+            const auto* lf = ld->get_file_ptr();
+            int retval = 0;
+
+            if (lf == nullptr) {
+                return retval;
+            }
+            if (ld->is_visible()) {
+                retval += 2;
+            }
+            if ((now - lf->get_stat().st_mtime) <= RECENT_WRITE_PERIOD) {
+                retval += 1;
+            }
+            return retval;
+        };
+
+        std::stable_sort(file_order.begin(),
+                         file_order.end(),
+                         [&prio_for](const auto& left, const auto& right) {
+                             return prio_for(left) > prio_for(right);
+                         });
+    }
 
     bool time_left = true;
     for (const auto file_index : file_order) {
@@ -766,10 +836,13 @@ logfile_sub_source::rebuild_index(
 
         this->lss_index.clear();
         this->lss_filtered_index.clear();
+        this->lss_dedup_seen.clear();
         this->lss_longest_line = 0;
         this->lss_basename_width = 0;
         this->lss_filename_width = 0;
         vis_bm[&textview_curses::BM_USER_EXPR].clear();
+        vis_bm[&BM_WARNINGS].clear();
+        vis_bm[&BM_ERRORS].clear();
     } else if (retval == rebuild_result::rr_partial_rebuild) {
         size_t remaining = 0;
 
@@ -817,11 +890,14 @@ logfile_sub_source::rebuild_index(
             std::distance(this->lss_filtered_index.begin(), filt_row_iter));
         search_start = vis_line_t(this->lss_filtered_index.size());
 
-        auto bm_range = vis_bm[&textview_curses::BM_USER_EXPR].equal_range(
-            search_start, -1_vl);
-        auto bm_new_size = std::distance(
-            vis_bm[&textview_curses::BM_USER_EXPR].begin(), bm_range.first);
-        vis_bm[&textview_curses::BM_USER_EXPR].resize(bm_new_size);
+        for (const auto* bm_type :
+             {&textview_curses::BM_USER_EXPR, &BM_WARNINGS, &BM_ERRORS})
+        {
+            auto bm_range = vis_bm[bm_type].equal_range(search_start, -1_vl);
+            auto bm_new_size
+                = std::distance(vis_bm[bm_type].begin(), bm_range.first);
+            vis_bm[bm_type].resize(bm_new_size);
+        }
 
         if (this->lss_index_delegate) {
             this->lss_index_delegate->index_start(*this);
@@ -840,7 +916,6 @@ logfile_sub_source::rebuild_index(
 
     if (retval != rebuild_result::rr_no_change || force) {
         size_t index_size = 0, start_size = this->lss_index.size();
-        logline_cmp line_cmper(*this);
 
         for (auto& ld : this->lss_files) {
             auto* lf = ld->get_file_ptr();
@@ -857,6 +932,30 @@ logfile_sub_source::rebuild_index(
         }
 
         if (full_sort) {
+            // Sorting the index with logline_cmp means chasing a pointer
+            // into a logfile's index for every comparison.  Pull the sort
+            // keys out into a dense array instead so the sort streams over
+            // contiguous memory.
+            struct sort_entry {
+                uint64_t se_time_millis;
+                file_off_t se_offset;
+                uint16_t se_sub_offset;
+                content_line_t se_line;
+
+                bool operator<(const sort_entry& rhs) const
+                {
+                    if (this->se_time_millis != rhs.se_time_millis) {
+                        return this->se_time_millis < rhs.se_time_millis;
+                    }
+                    if (this->se_offset != rhs.se_offset) {
+                        return this->se_offset < rhs.se_offset;
+                    }
+                    return this->se_sub_offset < rhs.se_sub_offset;
+                }
+            };
+            std::vector<sort_entry> sort_entries;
+
+            sort_entries.reserve(total_lines);
             for (auto& ld : this->lss_files) {
                 auto* lf = ld->get_file_ptr();
 
@@ -867,31 +966,58 @@ logfile_sub_source::rebuild_index(
                 for (size_t line_index = 0; line_index < lf->size();
                      line_index++)
                 {
-                    if ((*lf)[line_index].is_ignored()) {
+                    const auto& ll = (*lf)[line_index];
+
+                    if (ll.is_ignored()) {
                         continue;
                     }
 
                     content_line_t con_line(
                         ld->ld_file_index * MAX_LINES_PER_FILE + line_index);
 
-                    this->lss_index.push_back(con_line);
+                    sort_entries.push_back(sort_entry{
+                        ll.get_time_in_millis(),
+                        ll.get_offset(),
+                        ll.get_sub_offset(),
+                        con_line,
+                    });
                 }
             }
 
             // XXX get rid of this full sort on the initial run, it's not
             // needed unless the file is not in time-order
             if (this->lss_sorting_observer) {
-                this->lss_sorting_observer(*this, 0, this->lss_index.size());
+                this->lss_sorting_observer(*this, 0, sort_entries.size());
+            }
+            std::sort(sort_entries.begin(), sort_entries.end());
+            for (const auto& se : sort_entries) {
+                this->lss_index.push_back(se.se_line);
             }
-            std::sort(
-                this->lss_index.begin(), this->lss_index.end(), line_cmper);
             if (this->lss_sorting_observer) {
                 this->lss_sorting_observer(
                     *this, this->lss_index.size(), this->lss_index.size());
             }
         } else {
+            // Files with no unindexed lines do not need to participate in
+            // the merge, leaving them out keeps the comparison tree shallow
+            // when only a few files are growing.
+            int active_file_count = 0;
+
+            for (iter = this->lss_files.begin(); iter != this->lss_files.end();
+                 iter++)
+            {
+                auto* ld = iter->get();
+                auto* lf = ld->get_file_ptr();
+                if (lf == nullptr) {
+                    continue;
+                }
+                if (lf->size() > ld->ld_lines_indexed) {
+                    active_file_count += 1;
+                }
+            }
+
             kmerge_tree_c<logline, logfile_data, logfile::iterator> merge(
-                file_count);
+                active_file_count);
 
             for (iter = this->lss_files.begin(); iter != this->lss_files.end();
                  iter++)
@@ -902,7 +1028,10 @@ logfile_sub_source::rebuild_index(
                     continue;
                 }
 
-                merge.add(ld, lf->begin() + ld->ld_lines_indexed, lf->end());
+                if (lf->size() > ld->ld_lines_indexed) {
+                    merge.add(
+                        ld, lf->begin() + ld->ld_lines_indexed, lf->end());
+                }
                 index_size += lf->size();
             }
 
@@ -912,41 +1041,43 @@ logfile_sub_source::rebuild_index(
                 this->lss_sorting_observer(*this, index_off, index_size);
             }
             for (;;) {
-                logfile::iterator lf_iter;
+                logfile::iterator lf_iter, lf_iter_end;
                 logfile_data* ld;
 
-                if (!merge.get_top(ld, lf_iter)) {
+                if (!merge.next_run(ld, lf_iter, lf_iter_end)) {
                     break;
                 }
 
-                if (!lf_iter->is_ignored()) {
-                    int file_index = ld->ld_file_index;
-                    int line_index = lf_iter - ld->get_file_ptr()->begin();
+                for (; lf_iter != lf_iter_end; ++lf_iter) {
+                    if (!lf_iter->is_ignored()) {
+                        int file_index = ld->ld_file_index;
+                        int line_index = lf_iter - ld->get_file_ptr()->begin();
 
-                    content_line_t con_line(file_index * MAX_LINES_PER_FILE
-                                            + line_index);
+                        content_line_t con_line(file_index * MAX_LINES_PER_FILE
+                                                + line_index);
 
-                    if (lf_iter->is_marked()) {
-                        auto start_iter = lf_iter;
-                        while (start_iter->is_continued()) {
-                            --start_iter;
+                        if (lf_iter->is_marked()) {
+                            auto start_iter = lf_iter;
+                            while (start_iter->is_continued()) {
+                                --start_iter;
+                            }
+                            int start_index
+                                = start_iter - ld->get_file_ptr()->begin();
+                            content_line_t start_con_line(
+                                file_index * MAX_LINES_PER_FILE + start_index);
+
+                            this->lss_user_marks[&textview_curses::BM_META]
+                                .insert_once(start_con_line);
+                            lf_iter->set_mark(false);
                         }
-                        int start_index
-                            = start_iter - ld->get_file_ptr()->begin();
-                        content_line_t start_con_line(
-                            file_index * MAX_LINES_PER_FILE + start_index);
-
-                        this->lss_user_marks[&textview_curses::BM_META]
-                            .insert_once(start_con_line);
-                        lf_iter->set_mark(false);
+                        this->lss_index.push_back(con_line);
                     }
-                    this->lss_index.push_back(con_line);
-                }
 
-                merge.next();
-                index_off += 1;
-                if (index_off % 10000 == 0 && this->lss_sorting_observer) {
-                    this->lss_sorting_observer(*this, index_off, index_size);
+                    index_off += 1;
+                    if (index_off % 10000 == 0 && this->lss_sorting_observer) {
+                        this->lss_sorting_observer(
+                            *this, index_off, index_size);
+                    }
                 }
             }
             if (this->lss_sorting_observer) {
@@ -963,6 +1094,13 @@ logfile_sub_source::rebuild_index(
                 continue;
             }
 
+            if (lf->is_hibernated() && !full_sort) {
+                // The stub has no lines and the merged index kept this
+                // file's entries, so hold the indexed count where it was
+                // to keep the resumed lines from being merged in twice.
+                continue;
+            }
+
             (*iter)->ld_lines_indexed = lf->size();
         }
 
@@ -988,6 +1126,14 @@ logfile_sub_source::rebuild_index(
             }
 
             auto* lf = (*ld)->get_file_ptr();
+
+            if (line_number >= lf->size()) {
+                // The file shrank behind the merged index, for example a
+                // hibernated file whose index could not be restored.  A
+                // full rebuild is already pending.
+                continue;
+            }
+
             auto line_iter = lf->begin() + line_number;
 
             if (line_iter->is_ignored()) {
@@ -1014,6 +1160,24 @@ logfile_sub_source::rebuild_index(
                         line_iter->set_expr_mark(false);
                     }
                 }
+                if (line_iter->is_message()) {
+                    switch (line_iter->get_msg_level()) {
+                        case LEVEL_WARNING:
+                            vis_bm[&BM_WARNINGS].insert_once(
+                                vis_line_t(this->lss_filtered_index.size()));
+                            break;
+
+                        case LEVEL_FATAL:
+                        case LEVEL_ERROR:
+                        case LEVEL_CRITICAL:
+                            vis_bm[&BM_ERRORS].insert_once(
+                                vis_line_t(this->lss_filtered_index.size()));
+                            break;
+
+                        default:
+                            break;
+                    }
+                }
                 this->lss_filtered_index.push_back(index_index);
                 if (this->lss_index_delegate != nullptr) {
                     this->lss_index_delegate->index_line(
@@ -1051,60 +1215,46 @@ logfile_sub_source::rebuild_index(
 void
 logfile_sub_source::text_update_marks(vis_bookmarks& bm)
 {
-    std::shared_ptr<logfile> last_file;
-    vis_line_t vl;
-
-    bm[&BM_WARNINGS].clear();
-    bm[&BM_ERRORS].clear();
+    /* The warning/error marks are maintained incrementally as the index
+     * is rebuilt, like BM_USER_EXPR, so they do not need to be rebuilt
+     * with a pass over every line here. */
     bm[&BM_FILES].clear();
 
     for (auto& lss_user_mark : this->lss_user_marks) {
         bm[lss_user_mark.first].clear();
     }
 
-    for (; vl < (int) this->lss_filtered_index.size(); ++vl) {
-        const content_line_t orig_cl = this->at(vl);
-        content_line_t cl = orig_cl;
-        auto lf = this->find(cl);
-
-        for (auto& lss_user_mark : this->lss_user_marks) {
-            if (binary_search(lss_user_mark.second.begin(),
-                              lss_user_mark.second.end(),
-                              orig_cl))
-            {
-                bm[lss_user_mark.first].insert_once(vl);
-
-                if (lss_user_mark.first == &textview_curses::BM_USER) {
-                    auto ll = lf->begin() + cl;
+    /* Map each marked content line to its visible line instead of testing
+     * every visible line against every mark set.  The mark sets are tiny
+     * compared to the index, so this keeps the reload cost bounded by the
+     * number of marks while tailing. */
+    for (auto& lss_user_mark : this->lss_user_marks) {
+        for (const auto& cl : lss_user_mark.second) {
+            auto vl_opt = this->find_from_content(cl);
 
-                    ll->set_mark(true);
-                }
+            if (!vl_opt) {
+                continue;
             }
-        }
+            bm[lss_user_mark.first].insert_once(vl_opt.value());
 
-        if (lf != last_file) {
-            bm[&BM_FILES].insert_once(vl);
+            if (lss_user_mark.first == &textview_curses::BM_USER) {
+                this->find_line(cl)->set_mark(true);
+            }
         }
+    }
 
-        auto line_iter = lf->begin() + cl;
-        if (line_iter->is_message()) {
-            switch (line_iter->get_msg_level()) {
-                case LEVEL_WARNING:
-                    bm[&BM_WARNINGS].insert_once(vl);
-                    break;
-
-                case LEVEL_FATAL:
-                case LEVEL_ERROR:
-                case LEVEL_CRITICAL:
-                    bm[&BM_ERRORS].insert_once(vl);
-                    break;
+    /* The owning file can be read straight out of the content line
+     * number, so finding the file boundaries only needs integer math. */
+    auto last_file_index = -1;
+    for (vis_line_t vl = 0_vl; vl < (int) this->lss_filtered_index.size();
+         ++vl)
+    {
+        auto file_index = (int) (this->at(vl) / MAX_LINES_PER_FILE);
 
-                default:
-                    break;
-            }
+        if (file_index != last_file_index) {
+            bm[&BM_FILES].insert_once(vl);
+            last_file_index = file_index;
         }
-
-        last_file = lf;
     }
 }
 
@@ -1131,9 +1281,19 @@ logfile_sub_source::get_line_accel_direction(vis_line_t vl)
     return la.get_direction();
 }
 
+static std::string
+filter_fingerprint(const text_filter& tf)
+{
+    return hasher().update(tf.to_command()).to_string();
+}
+
 void
 logfile_sub_source::text_filters_changed()
 {
+    // Filter results are only worth persisting for files where the re-scan
+    // is noticeable.
+    static const size_t FILTER_CACHE_MIN_LINES = 10000;
+
     this->lss_index_generation += 1;
 
     if (this->lss_line_meta_changed) {
@@ -1144,11 +1304,104 @@ logfile_sub_source::text_filters_changed()
     for (auto& ld : *this) {
         auto* lf = ld->get_file_ptr();
 
-        if (lf != nullptr) {
-            ld->ld_filter_state.clear_deleted_filter_state();
-            lf->reobserve_from(lf->begin()
-                               + ld->ld_filter_state.get_min_count(lf->size()));
+        if (lf == nullptr) {
+            continue;
+        }
+
+        ld->ld_filter_state.restart_edited_filter_state();
+        ld->ld_filter_state.clear_deleted_filter_state();
+
+        auto& lfs = ld->ld_filter_state.lfo_filter_state;
+        auto cacheable = !lf->get_content_id().empty()
+            && lf->size() >= FILTER_CACHE_MIN_LINES;
+        uint32_t stale_filters = 0;
+
+        if (cacheable) {
+            // Before re-reading the file to evaluate new filters, see if
+            // this (file, filter) pair was already evaluated in a previous
+            // session.
+            for (const auto& filter : ld->ld_filter_state.lfo_filter_stack) {
+                if (filter->lf_deleted) {
+                    continue;
+                }
+
+                auto findex = filter->get_index();
+
+                if (lfs.tfs_filter_count[findex] >= lf->size()) {
+                    continue;
+                }
+
+                if (lfs.tfs_filter_count[findex] == 0) {
+                    auto load_res = lnav::index_cache::load_filter(
+                        lf->get_content_id(), filter_fingerprint(*filter));
+
+                    if (load_res.isOk()) {
+                        auto cf = load_res.unwrap();
+
+                        if (cf.cf_line_count >= lf->size()) {
+                            uint32_t mask = 1U << findex;
+                            int hits = 0;
+
+                            lfs.resize(lf->size());
+                            for (size_t lpc = 0; lpc < lf->size(); lpc++) {
+                                if (cf.is_line_set(lpc)) {
+                                    lfs.tfs_mask[lpc] |= mask;
+                                    hits += 1;
+                                } else {
+                                    lfs.tfs_mask[lpc] &= ~mask;
+                                }
+                            }
+                            lfs.tfs_filter_count[findex] = lf->size();
+                            lfs.tfs_filter_hits[findex] = hits;
+                            lfs.tfs_message_matched[findex] = false;
+                            lfs.tfs_lines_for_message[findex] = 0;
+                            lfs.tfs_last_message_matched[findex] = false;
+                            lfs.tfs_last_lines_for_message[findex] = 0;
+                            continue;
+                        }
+                    }
+                }
+
+                stale_filters |= 1U << findex;
+            }
         }
+
+        lf->reobserve_from(lf->begin()
+                           + ld->ld_filter_state.get_min_count(lf->size()));
+
+        if (stale_filters != 0) {
+            // Persist the results of the filters that were just evaluated
+            // over the whole file.
+            for (const auto& filter : ld->ld_filter_state.lfo_filter_stack) {
+                auto findex = filter->get_index();
+
+                if (filter->lf_deleted
+                    || !(stale_filters & (1U << findex))
+                    || lfs.tfs_filter_count[findex] < lf->size())
+                {
+                    continue;
+                }
+
+                std::vector<uint32_t> bitmap((lf->size() + 31) / 32);
+                uint32_t mask = 1U << findex;
+
+                for (size_t lpc = 0; lpc < lf->size(); lpc++) {
+                    if (lfs.tfs_mask[lpc] & mask) {
+                        bitmap[lpc / 32] |= 1U << (lpc % 32);
+                    }
+                }
+                lnav::index_cache::store_filter(lf->get_content_id(),
+                                                filter_fingerprint(*filter),
+                                                lf->size(),
+                                                bitmap);
+            }
+        }
+    }
+
+    for (const auto& filter : this->get_filters()) {
+        // The carried-over results have now been consumed, any further
+        // re-scans need to evaluate the filter normally.
+        filter->lf_edit_delta = text_filter::edit_delta_t::NONE;
     }
 
     auto& vis_bm = this->tss_view->get_bookmarks();
@@ -1160,8 +1413,11 @@ logfile_sub_source::text_filters_changed()
         this->lss_index_delegate->index_start(*this);
     }
     vis_bm[&textview_curses::BM_USER_EXPR].clear();
+    vis_bm[&BM_WARNINGS].clear();
+    vis_bm[&BM_ERRORS].clear();
 
     this->lss_filtered_index.clear();
+    this->lss_dedup_seen.clear();
     for (size_t index_index = 0; index_index < this->lss_index.size();
          index_index++)
     {
@@ -1174,6 +1430,14 @@ logfile_sub_source::text_filters_changed()
         }
 
         auto lf = (*ld)->get_file_ptr();
+
+        if (line_number >= lf->size()) {
+            // The file shrank behind the merged index, for example a
+            // hibernated file whose index could not be restored.  A full
+            // rebuild is already pending.
+            continue;
+        }
+
         auto line_iter = lf->begin() + line_number;
 
         if (!this->tss_apply_filters
@@ -1196,6 +1460,24 @@ logfile_sub_source::text_filters_changed()
                     line_iter->set_expr_mark(false);
                 }
             }
+            if (line_iter->is_message()) {
+                switch (line_iter->get_msg_level()) {
+                    case LEVEL_WARNING:
+                        vis_bm[&BM_WARNINGS].insert_once(
+                            vis_line_t(this->lss_filtered_index.size()));
+                        break;
+
+                    case LEVEL_FATAL:
+                    case LEVEL_ERROR:
+                    case LEVEL_CRITICAL:
+                        vis_bm[&BM_ERRORS].insert_once(
+                            vis_line_t(this->lss_filtered_index.size()));
+                        break;
+
+                    default:
+                        break;
+                }
+            }
             this->lss_filtered_index.push_back(index_index);
             if (this->lss_index_delegate != nullptr) {
                 this->lss_index_delegate->index_line(*this, lf, line_iter);
@@ -1415,17 +1697,71 @@ logfile_sub_source::eval_sql_filter(sqlite3_stmt* stmt,
     shared_buffer_ref raw_sbr;
     logline_value_vector values;
     auto& sbr = values.lvv_sbr;
-    lf->read_full_message(ll, sbr);
-    sbr.erase_ansi();
     auto format = lf->get_format();
     string_attrs_t sa;
     auto line_number = std::distance(lf->cbegin(), ll);
-    format->annotate(line_number, sa, values);
+
+    auto count = sqlite3_bind_parameter_count(stmt);
+
+    // Reading and annotating the message is the expensive part of an
+    // evaluation, so it is skipped when the expression only looks at
+    // line metadata (level, time, file, mark, ...), which is the common
+    // shape for filter expressions.
+    static const char* METADATA_PARAMS[] = {
+        ":log_level",
+        ":log_time",
+        ":log_time_msecs",
+        ":log_mark",
+        ":log_comment",
+        ":log_tags",
+        ":log_format",
+        ":log_format_regex",
+        ":log_path",
+        ":log_unique_path",
+    };
+    const auto* stmt_sql = sqlite3_sql(stmt);
+    auto memo_iter = std::find_if(this->lss_stmt_needs_message.begin(),
+                                  this->lss_stmt_needs_message.end(),
+                                  [stmt](const stmt_needs_message& snm) {
+                                      return snm.snm_stmt == stmt;
+                                  });
+    auto needs_message = false;
+    if (stmt_sql != nullptr
+        && memo_iter != this->lss_stmt_needs_message.end()
+        && memo_iter->snm_sql == stmt_sql)
+    {
+        needs_message = memo_iter->snm_needs_message;
+    } else {
+        for (int lpc = 0; !needs_message && lpc < count; lpc++) {
+            const auto* name = sqlite3_bind_parameter_name(stmt, lpc + 1);
+
+            if (name[0] == '$') {
+                continue;
+            }
+            needs_message = std::none_of(
+                std::begin(METADATA_PARAMS),
+                std::end(METADATA_PARAMS),
+                [name](const char* param) { return strcmp(name, param) == 0; });
+        }
+        if (stmt_sql != nullptr) {
+            if (memo_iter != this->lss_stmt_needs_message.end()) {
+                this->lss_stmt_needs_message.erase(memo_iter);
+            } else if (this->lss_stmt_needs_message.size() >= 4) {
+                this->lss_stmt_needs_message.erase(
+                    this->lss_stmt_needs_message.begin());
+            }
+            this->lss_stmt_needs_message.push_back(
+                stmt_needs_message{stmt, stmt_sql, needs_message});
+        }
+    }
+    if (needs_message) {
+        lf->read_full_message(ll, sbr);
+        sbr.erase_ansi();
+        format->annotate(line_number, sa, values);
+    }
 
     sqlite3_reset(stmt);
     sqlite3_clear_bindings(stmt);
-
-    auto count = sqlite3_bind_parameter_count(stmt);
     for (int lpc = 0; lpc < count; lpc++) {
         const auto* name = sqlite3_bind_parameter_name(stmt, lpc + 1);
 
@@ -1630,6 +1966,45 @@ logfile_sub_source::eval_sql_filter(sqlite3_stmt* stmt,
     return Ok(true);
 }
 
+/**
+ * Digest of a message used for duplicate suppression.  The timestamp
+ * range captured at scan time is skipped wholesale when it is known, and
+ * runs of digits are skipped everywhere so that sequence numbers and
+ * other counters do not make every occurrence of a repeated message
+ * unique.
+ */
+static uint64_t
+dedup_digest(const shared_buffer_ref& sbr,
+             nonstd::optional<line_extent> extent)
+{
+    // The filtered index is rebuilt on the main loop, so a single scratch
+    // buffer can be reused across lines.
+    static std::string stripped;
+
+    const char* data = sbr.get_data();
+    size_t length = sbr.length();
+    size_t ts_start = length, ts_end = length;
+
+    if (extent && extent->le_ts_end <= length) {
+        ts_start = extent->le_ts_start;
+        ts_end = extent->le_ts_end;
+    }
+
+    stripped.clear();
+    stripped.reserve(length);
+    for (size_t lpc = 0; lpc < length; lpc++) {
+        if (lpc == ts_start) {
+            lpc = ts_end - 1;
+            continue;
+        }
+        if (!isdigit((unsigned char) data[lpc])) {
+            stripped.push_back(data[lpc]);
+        }
+    }
+
+    return XXH3_64bits(stripped.data(), stripped.length());
+}
+
 bool
 logfile_sub_source::check_extra_filters(iterator ld, logfile::iterator ll)
 {
@@ -1649,6 +2024,29 @@ logfile_sub_source::check_extra_filters(iterator ld, logfile::iterator ll)
         return false;
     }
 
+    if (this->lss_duplicates_hidden) {
+        if (!ll->is_message()) {
+            if ((*ld)->ld_dedup_in_hidden_msg) {
+                return false;
+            }
+        } else {
+            auto* lf = (*ld)->get_file_ptr();
+            auto read_res = lf->read_line(ll);
+
+            if (read_res.isOk()) {
+                auto digest = dedup_digest(
+                    read_res.unwrap(),
+                    lf->get_line_extent(std::distance(lf->begin(), ll)));
+                auto hidden = !this->lss_dedup_seen.insert(digest).second;
+
+                (*ld)->ld_dedup_in_hidden_msg = hidden;
+                if (hidden) {
+                    return false;
+                }
+            }
+        }
+    }
+
     return true;
 }
 
@@ -2237,16 +2635,8 @@ logfile_sub_source::text_crumbs_for_line(int line,
             [this]() -> std::vector<breadcrumb::possibility> {
                 std::vector<breadcrumb::possibility> retval;
 
-                for (const auto& file_data : this->lss_files) {
-                    if (file_data->get_file_ptr() == nullptr) {
-                        continue;
-                    }
-                    safe::ReadAccess<logfile::safe_opid_map> r_opid_map(
-                        file_data->get_file_ptr()->get_opids());
-
-                    for (const auto& pair : *r_opid_map) {
-                        retval.emplace_back(pair.first.to_string());
-                    }
+                for (const auto& pair : this->get_opid_map()) {
+                    retval.emplace_back(pair.first);
                 }
 
                 return retval;
@@ -2384,6 +2774,130 @@ logfile_sub_source::text_crumbs_for_line(int line,
     }
 }
 
+const std::map<std::string, opid_time_range>&
+logfile_sub_source::get_opid_map()
+{
+    size_t file_count = 0, generation = 0;
+
+    for (const auto& ld : this->lss_files) {
+        const auto* lf = ld->get_file_ptr();
+
+        if (lf == nullptr) {
+            continue;
+        }
+        file_count += 1;
+        generation += lf->get_opid_generation();
+    }
+
+    if (file_count != this->lss_opid_map_file_count
+        || generation != this->lss_opid_map_generation)
+    {
+        this->lss_opid_map.clear();
+        for (const auto& ld : this->lss_files) {
+            auto* lf = ld->get_file_ptr();
+
+            if (lf == nullptr) {
+                continue;
+            }
+
+            safe::ReadAccess<logfile::safe_opid_map> r_opid_map(
+                lf->get_opids());
+
+            for (const auto& pair : *r_opid_map) {
+                auto emp_res
+                    = this->lss_opid_map.emplace(pair.first.to_string(),
+                                                 pair.second);
+
+                if (!emp_res.second) {
+                    auto& otr = emp_res.first->second;
+
+                    if (pair.second.otr_begin < otr.otr_begin) {
+                        otr.otr_begin = pair.second.otr_begin;
+                    }
+                    if (otr.otr_end < pair.second.otr_end) {
+                        otr.otr_end = pair.second.otr_end;
+                    }
+                }
+            }
+        }
+        this->lss_opid_map_file_count = file_count;
+        this->lss_opid_map_generation = generation;
+    }
+
+    return this->lss_opid_map;
+}
+
+const std::vector<logfile_sub_source::opid_graph_edge>&
+logfile_sub_source::get_opid_graph()
+{
+    size_t file_count = 0, generation = 0;
+
+    for (const auto& ld : this->lss_files) {
+        const auto* lf = ld->get_file_ptr();
+
+        if (lf == nullptr) {
+            continue;
+        }
+        file_count += 1;
+        generation += lf->get_opid_generation();
+    }
+
+    if (file_count != this->lss_opid_graph_file_count
+        || generation != this->lss_opid_graph_generation)
+    {
+        struct opid_occurrence {
+            std::string oo_path;
+            struct timeval oo_begin;
+
+            bool operator<(const opid_occurrence& rhs) const
+            {
+                return this->oo_begin < rhs.oo_begin;
+            }
+        };
+        std::map<std::string, std::vector<opid_occurrence>> occurrences;
+
+        for (const auto& ld : this->lss_files) {
+            auto* lf = ld->get_file_ptr();
+
+            if (lf == nullptr) {
+                continue;
+            }
+
+            safe::ReadAccess<logfile::safe_opid_map> r_opid_map(
+                lf->get_opids());
+
+            for (const auto& pair : *r_opid_map) {
+                occurrences[pair.first.to_string()].push_back(opid_occurrence{
+                    lf->get_filename(),
+                    pair.second.otr_begin,
+                });
+            }
+        }
+
+        this->lss_opid_graph.clear();
+        for (auto& pair : occurrences) {
+            if (pair.second.size() < 2) {
+                continue;
+            }
+
+            std::sort(pair.second.begin(), pair.second.end());
+            for (size_t lpc = 0; lpc + 1 < pair.second.size(); lpc++) {
+                this->lss_opid_graph.push_back(opid_graph_edge{
+                    pair.first,
+                    pair.second[lpc].oo_path,
+                    pair.second[lpc + 1].oo_path,
+                    pair.second[lpc].oo_begin,
+                    pair.second[lpc + 1].oo_begin,
+                });
+            }
+        }
+        this->lss_opid_graph_file_count = file_count;
+        this->lss_opid_graph_generation = generation;
+    }
+
+    return this->lss_opid_graph;
+}
+
 void
 logfile_sub_source::quiesce()
 {
@@ -2398,6 +2912,26 @@ logfile_sub_source::quiesce()
     }
 }
 
+void
+logfile_sub_source::text_prefetch_for(vis_line_t start, vis_line_t end)
+{
+    for (auto curr = start; curr < end; ++curr) {
+        if (curr < 0_vl
+            || (size_t) curr >= this->lss_filtered_index.size())
+        {
+            continue;
+        }
+
+        auto line = this->at(curr);
+        auto lf = this->find(line);
+
+        // Pulling the line content here warms the line_buffer cache and,
+        // for compressed files, gives it a chance to kick off a background
+        // load of the next chunk before the user pages onto it.
+        lf->read_line(lf->begin() + line);
+    }
+}
+
 bookmark_metadata&
 logfile_sub_source::get_bookmark_metadata(content_line_t cl)
 {
@@ -2405,6 +2939,10 @@ logfile_sub_source::get_bookmark_metadata(content_line_t cl)
     auto line_number = static_cast<uint32_t>(
         std::distance(line_pair.first->begin(), line_pair.second));
 
+    // This accessor hands out a mutable reference, so assume the caller
+    // is going to change something.
+    this->lss_metadata_generation += 1;
+
     return line_pair.first->get_bookmark_metadata()[line_number];
 }
 
@@ -2435,6 +2973,7 @@ logfile_sub_source::erase_bookmark_metadata(content_line_t cl)
     auto bm_iter = bm.find(line_number);
     if (bm_iter != bm.end()) {
         bm.erase(bm_iter);
+        this->lss_metadata_generation += 1;
     }
 }
 
@@ -2448,4 +2987,5 @@ logfile_sub_source::clear_bookmark_metadata()
 
         ld->get_file_ptr()->get_bookmark_metadata().clear();
     }
+    this->lss_metadata_generation += 1;
 }
@@ -89,6 +89,7 @@ public:
         : text_filter(type, filter_lang_t::REGEX, id, index),
           pf_pcre(std::move(code))
     {
+        this->lf_required_literal = this->pf_pcre->get_required_substring();
     }
 
     ~pcre_filter() override = default;
@@ -399,6 +400,19 @@ public:
 
     bool get_marked_only() { return this->lss_marked_only; }
 
+    void set_duplicates_hidden(bool val)
+    {
+        if (this->lss_duplicates_hidden != val) {
+            this->lss_duplicates_hidden = val;
+            this->text_filters_changed();
+        }
+    }
+
+    bool get_duplicates_hidden() const
+    {
+        return this->lss_duplicates_hidden;
+    }
+
     size_t text_line_count() { return this->lss_filtered_index.size(); }
 
     size_t text_line_width(textview_curses& curses)
@@ -499,6 +513,11 @@ public:
 
     void clear_bookmark_metadata();
 
+    size_t text_metadata_generation() override
+    {
+        return this->lss_metadata_generation;
+    }
+
     int get_filtered_count() const
     {
         return this->lss_index.size() - this->lss_filtered_index.size();
@@ -565,16 +584,17 @@ public:
 
     logline* find_line(content_line_t line) const
     {
-        logline* retval = nullptr;
-        std::shared_ptr<logfile> lf = this->find(line);
-
-        if (lf != nullptr) {
-            auto ll_iter = lf->begin() + line;
+        // This is called from the comparators used to sort and search the
+        // index, so avoid bumping the file's reference count on every
+        // lookup.
+        auto* lf = this->lss_files[line / MAX_LINES_PER_FILE]->get_file_ptr();
 
-            retval = &(*ll_iter);
+        if (lf == nullptr) {
+            return nullptr;
         }
+        auto ll_iter = lf->begin() + (line % MAX_LINES_PER_FILE);
 
-        return retval;
+        return &(*ll_iter);
     }
 
     nonstd::optional<std::pair<std::shared_ptr<logfile>, logfile::iterator>>
@@ -689,13 +709,28 @@ public:
             return this->get_file_ptr() != nullptr && this->ld_visible;
         }
 
-        void set_visibility(bool vis) { this->ld_visible = vis; }
+        void set_visibility(bool vis)
+        {
+            this->ld_visible = vis;
+            if (vis && this->get_file_ptr() != nullptr
+                && this->get_file_ptr()->is_hibernated()
+                && !this->get_file_ptr()->resume())
+            {
+                // The saved index could not be restored, so the filter
+                // state needs to be rebuilt along with the index when the
+                // file is rescanned.
+                this->clear();
+                this->ld_lines_indexed = 0;
+            }
+        }
 
         size_t ld_file_index;
         line_filter_observer ld_filter_state;
         size_t ld_lines_indexed{0};
         size_t ld_lines_watched{0};
         bool ld_visible;
+        /** Continuation lines follow the dedup verdict of their message. */
+        bool ld_dedup_in_hidden_msg{false};
     };
 
     using iterator = std::vector<std::unique_ptr<logfile_data>>::iterator;
@@ -823,6 +858,35 @@ public:
 
     void set_exec_context(exec_context* ec) { this->lss_exec_context = ec; }
 
+    /**
+     * Get the opids from all of the files in this source merged into a
+     * single map.  The merged map is rebuilt lazily, when a file reports
+     * that new opids were found during a scan, so a lookup here is cheap
+     * compared to walking the per-file maps.
+     */
+    const std::map<std::string, opid_time_range>& get_opid_map();
+
+    /**
+     * An edge in the cross-file operation flow graph, recording that an
+     * opid was first seen in the source file and later appeared in the
+     * destination file.
+     */
+    struct opid_graph_edge {
+        std::string oge_opid;
+        std::string oge_src_path;
+        std::string oge_dst_path;
+        struct timeval oge_src_begin;
+        struct timeval oge_dst_begin;
+    };
+
+    /**
+     * Get the flow graph of opids that span multiple files, with an edge
+     * for each consecutive pair of files ordered by when the opid first
+     * appeared in them.  Like get_opid_map(), the graph is rebuilt lazily
+     * when a file reports new opids.
+     */
+    const std::vector<opid_graph_edge>& get_opid_graph();
+
     static const uint64_t MAX_CONTENT_LINES = (1ULL << 40) - 1;
     static const uint64_t MAX_LINES_PER_FILE = 256 * 1024 * 1024;
     static const uint64_t MAX_FILES = (MAX_CONTENT_LINES / MAX_LINES_PER_FILE);
@@ -834,6 +898,8 @@ public:
 
     void quiesce();
 
+    void text_prefetch_for(vis_line_t start, vis_line_t end) override;
+
 private:
     static const size_t LINE_SIZE_CACHE_SIZE = 512;
 
@@ -982,9 +1048,25 @@ private:
     auto_mem<sqlite3_stmt> lss_preview_filter_stmt{sqlite3_finalize};
 
     bookmarks<content_line_t>::type lss_user_marks;
+    /** Bumped on every bookmark metadata change, see
+     * text_metadata_generation(). */
+    size_t lss_metadata_generation{0};
     auto_mem<sqlite3_stmt> lss_marker_stmt{sqlite3_finalize};
     std::string lss_marker_stmt_text;
 
+    /**
+     * Memo of whether a filter/marker statement's bound parameters require
+     * reading and annotating the message, so the classification is not
+     * redone for every line during a rebuild.  The SQL text is kept to
+     * guard against a finalized statement's address being reused.
+     */
+    struct stmt_needs_message {
+        sqlite3_stmt* snm_stmt{nullptr};
+        std::string snm_sql;
+        bool snm_needs_message{false};
+    };
+    std::vector<stmt_needs_message> lss_stmt_needs_message;
+
     line_flags_t lss_token_flags{0};
     iterator lss_token_file_data;
     std::shared_ptr<logfile> lss_token_file;
@@ -996,6 +1078,16 @@ private:
     logline_value_vector lss_token_values;
     int lss_token_shift_start{0};
     int lss_token_shift_size{0};
+    /**
+     * Timestamp rendering memo.  Adjacent lines usually fall in the same
+     * second, so the broken-down UTC time (and the formatted prefix for
+     * the fixed machine-oriented format) are reused across lines and only
+     * the fractional part is formatted per line.
+     */
+    time_t lss_time_memo_sec{-1};
+    struct tm lss_time_memo_tm;
+    char lss_time_memo_buf[32];
+    off_t lss_time_memo_len{0};
     shared_buffer lss_share_manager;
     logfile::iterator lss_token_line;
     std::array<std::pair<int, size_t>, LINE_SIZE_CACHE_SIZE>
@@ -1008,8 +1100,20 @@ private:
         std::numeric_limits<time_t>::max(), 0
     };
     bool lss_marked_only{false};
+    bool lss_duplicates_hidden{false};
+    /**
+     * Digests of the messages seen so far in a filtered-index rebuild,
+     * used to suppress repeated messages when duplicates are hidden.
+     */
+    robin_hood::unordered_set<uint64_t> lss_dedup_seen;
     index_delegate* lss_index_delegate{nullptr};
     size_t lss_longest_line{0};
+    std::map<std::string, opid_time_range> lss_opid_map;
+    size_t lss_opid_map_file_count{0};
+    size_t lss_opid_map_generation{0};
+    std::vector<opid_graph_edge> lss_opid_graph;
+    size_t lss_opid_graph_file_count{0};
+    size_t lss_opid_graph_generation{0};
     meta_grepper lss_meta_grepper;
     log_location_history lss_location_history;
     exec_context* lss_exec_context{nullptr};
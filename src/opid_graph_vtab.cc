@@ -0,0 +1,98 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/injector.bind.hh"
+#include "config.h"
+#include "lnav.hh"
+#include "sql_util.hh"
+#include "vtab_module.hh"
+
+struct lnav_opid_graph : public tvt_iterator_cursor<lnav_opid_graph> {
+    using iterator
+        = std::vector<logfile_sub_source::opid_graph_edge>::const_iterator;
+
+    static constexpr const char* NAME = "lnav_opid_graph";
+    static constexpr const char* CREATE_STMT = R"(
+-- The flow of operations across log files, with an edge for each hop an
+-- opid makes from one file to the next, ordered by first appearance.
+CREATE TABLE lnav_opid_graph (
+    opid       TEXT,  -- The ID of the operation.
+    src_path   TEXT,  -- The path of the file the opid came from.
+    dst_path   TEXT,  -- The path of the file the opid moved to.
+    src_begin  TEXT,  -- When the opid first appeared in the source file.
+    dst_begin  TEXT   -- When the opid first appeared in the destination file.
+);
+)";
+
+    iterator begin()
+    {
+        // Snapshot the edges since a rescan during the query could rebuild
+        // the graph out from under the iterators.
+        this->og_edges = lnav_data.ld_log_source.get_opid_graph();
+        return this->og_edges.begin();
+    }
+
+    iterator end() { return this->og_edges.end(); }
+
+    int get_column(cursor& vc, sqlite3_context* ctx, int col)
+    {
+        const auto& edge = *vc.iter;
+        char time_buf[64];
+
+        switch (col) {
+            case 0:
+                to_sqlite(ctx, edge.oge_opid);
+                break;
+            case 1:
+                to_sqlite(ctx, edge.oge_src_path);
+                break;
+            case 2:
+                to_sqlite(ctx, edge.oge_dst_path);
+                break;
+            case 3:
+                sql_strftime(
+                    time_buf, sizeof(time_buf), edge.oge_src_begin, 'T');
+                sqlite3_result_text(ctx, time_buf, -1, SQLITE_TRANSIENT);
+                break;
+            case 4:
+                sql_strftime(
+                    time_buf, sizeof(time_buf), edge.oge_dst_begin, 'T');
+                sqlite3_result_text(ctx, time_buf, -1, SQLITE_TRANSIENT);
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+    std::vector<logfile_sub_source::opid_graph_edge> og_edges;
+};
+
+static auto opid_graph_binder
+    = injector::bind_multiple<vtab_module_base>()
+          .add<vtab_module<tvt_no_update<lnav_opid_graph>>>();
@@ -35,6 +35,7 @@
 
 #include "pcap_manager.hh"
 
+#include <fcntl.h>
 #include <unistd.h>
 
 #include "base/fs_util.hh"
@@ -48,6 +49,26 @@ convert(const std::string& filename)
 {
     log_info("attempting to convert pcap file -- %s", filename.c_str());
 
+#ifdef POSIX_FADV_WILLNEED
+    {
+        // Dissection is CPU-bound, so ask the kernel to prefetch the
+        // capture while tshark works through it rather than faulting
+        // it in a read at a time.
+        auto_fd pcap_fd(open(filename.c_str(), O_RDONLY));
+
+        if (pcap_fd != -1) {
+            posix_fadvise(pcap_fd, 0, 0, POSIX_FADV_WILLNEED);
+        }
+    }
+#endif
+
+    // The conversion is deliberately a single tshark process.  Splitting
+    // the capture into packet ranges and dissecting them in parallel
+    // looks attractive, but tshark's dissectors carry state across
+    // packets (TCP reassembly, request/response matching), so a packet
+    // that depends on an earlier chunk would dissect differently.  The
+    // output file is tailed as it is written, so packets start showing
+    // up long before the conversion finishes.
     auto outfile = TRY(lnav::filesystem::open_temp_file(
         ghc::filesystem::temp_directory_path() / "lnav.pcap.XXXXXX"));
     ghc::filesystem::remove(outfile.first);
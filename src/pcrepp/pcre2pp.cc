@@ -29,13 +29,214 @@
  * @file pcrepp.cc
  */
 
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
 #include "pcre2pp.hh"
 
+#include <ctype.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "base/auto_fd.hh"
 #include "config.h"
 
 namespace lnav {
 namespace pcre2pp {
 
+static pcre2_match_context* match_context();
+
+namespace compile_cache {
+
+struct cache_entry {
+    std::vector<uint8_t> ce_bytes;
+    bool ce_touched{false};
+};
+
+struct cache_state {
+    std::mutex cs_mutex;
+    std::unordered_map<std::string, cache_entry> cs_entries;
+    bool cs_enabled{false};
+};
+
+static cache_state&
+state()
+{
+    static cache_state retval;
+
+    return retval;
+}
+
+static std::string
+key_for(int options, string_fragment sf)
+{
+    return std::to_string(options) + ":" + sf.to_string();
+}
+
+struct cache_file_header {
+    char cfh_magic[8];
+    uint32_t cfh_version;
+    uint32_t cfh_count;
+};
+
+static constexpr char CACHE_MAGIC[8]
+    = {'l', 'n', 'a', 'v', 'p', 'c', 'r', 'e'};
+static constexpr uint32_t CACHE_VERSION = 1;
+
+/**
+ * Look for a previously-serialized compiled pattern.  Entries are dropped
+ * if pcre2_serialize_decode() rejects them, which covers caches written by
+ * a different pcre2 version.
+ */
+static auto_mem<pcre2_code>
+find(int options, string_fragment sf)
+{
+    auto_mem<pcre2_code> retval(pcre2_code_free);
+    auto& cs = state();
+    std::lock_guard<std::mutex> lg(cs.cs_mutex);
+
+    if (!cs.cs_enabled) {
+        return retval;
+    }
+
+    auto iter = cs.cs_entries.find(key_for(options, sf));
+    if (iter == cs.cs_entries.end()) {
+        return retval;
+    }
+
+    pcre2_code* decoded = nullptr;
+    auto rc = pcre2_serialize_decode(
+        &decoded, 1, iter->second.ce_bytes.data(), nullptr);
+    if (rc != 1) {
+        cs.cs_entries.erase(iter);
+        return retval;
+    }
+
+    iter->second.ce_touched = true;
+    retval = decoded;
+    return retval;
+}
+
+static void
+add(int options, string_fragment sf, pcre2_code* co)
+{
+    auto& cs = state();
+    std::lock_guard<std::mutex> lg(cs.cs_mutex);
+
+    if (!cs.cs_enabled) {
+        return;
+    }
+
+    uint8_t* bytes = nullptr;
+    PCRE2_SIZE byte_count = 0;
+    const pcre2_code* codes[] = {co};
+
+    if (pcre2_serialize_encode(codes, 1, &bytes, &byte_count, nullptr) != 1) {
+        return;
+    }
+
+    auto& entry = cs.cs_entries[key_for(options, sf)];
+    entry.ce_bytes.assign(bytes, bytes + byte_count);
+    entry.ce_touched = true;
+    pcre2_serialize_free(bytes);
+}
+
+void
+load(const std::string& path)
+{
+    auto& cs = state();
+    std::lock_guard<std::mutex> lg(cs.cs_mutex);
+
+    cs.cs_enabled = true;
+
+    auto_fd fd(open(path.c_str(), O_RDONLY));
+    if (fd == -1) {
+        return;
+    }
+
+    cache_file_header cfh;
+    if (read(fd, &cfh, sizeof(cfh)) != sizeof(cfh)
+        || memcmp(cfh.cfh_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0
+        || cfh.cfh_version != CACHE_VERSION)
+    {
+        return;
+    }
+
+    for (uint32_t lpc = 0; lpc < cfh.cfh_count; lpc++) {
+        uint32_t lens[2];
+
+        if (read(fd, lens, sizeof(lens)) != sizeof(lens)) {
+            return;
+        }
+
+        std::string key;
+        key.resize(lens[0]);
+        cache_entry entry;
+        entry.ce_bytes.resize(lens[1]);
+        if (read(fd, &key[0], lens[0]) != (ssize_t) lens[0]
+            || read(fd, entry.ce_bytes.data(), lens[1]) != (ssize_t) lens[1])
+        {
+            return;
+        }
+
+        cs.cs_entries.emplace(std::move(key), std::move(entry));
+    }
+}
+
+void
+save(const std::string& path)
+{
+    auto& cs = state();
+    std::lock_guard<std::mutex> lg(cs.cs_mutex);
+
+    cs.cs_enabled = false;
+
+    auto tmp_path = path + ".tmp";
+    auto_fd fd(open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0600));
+    if (fd == -1) {
+        return;
+    }
+
+    cache_file_header cfh;
+    memcpy(cfh.cfh_magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    cfh.cfh_version = CACHE_VERSION;
+    cfh.cfh_count = 0;
+    for (const auto& pair : cs.cs_entries) {
+        if (pair.second.ce_touched) {
+            cfh.cfh_count += 1;
+        }
+    }
+
+    bool success = write(fd, &cfh, sizeof(cfh)) == sizeof(cfh);
+    for (const auto& pair : cs.cs_entries) {
+        if (!success || !pair.second.ce_touched) {
+            continue;
+        }
+
+        uint32_t lens[2] = {
+            (uint32_t) pair.first.size(),
+            (uint32_t) pair.second.ce_bytes.size(),
+        };
+
+        success = write(fd, lens, sizeof(lens)) == sizeof(lens)
+            && write(fd, pair.first.data(), lens[0]) == (ssize_t) lens[0]
+            && write(fd, pair.second.ce_bytes.data(), lens[1])
+                == (ssize_t) lens[1];
+    }
+
+    if (success) {
+        rename(tmp_path.c_str(), path.c_str());
+    } else {
+        remove(tmp_path.c_str());
+    }
+    cs.cs_entries.clear();
+}
+
+}  // namespace compile_cache
+
 std::string
 quote(const char* unquoted)
 {
@@ -86,17 +287,27 @@ code::from(string_fragment sf, int options)
     auto_mem<pcre2_code> co(pcre2_code_free);
 
     options |= PCRE2_UTF;
-    co = pcre2_compile(
-        sf.udata(), sf.length(), options, &ce.ce_code, &ce.ce_offset, nullptr);
-
+    co = compile_cache::find(options, sf);
     if (co == nullptr) {
-        ce.ce_pattern = sf.to_string();
-        return Err(ce);
+        co = pcre2_compile(sf.udata(),
+                           sf.length(),
+                           options,
+                           &ce.ce_code,
+                           &ce.ce_offset,
+                           nullptr);
+
+        if (co == nullptr) {
+            ce.ce_pattern = sf.to_string();
+            return Err(ce);
+        }
+
+        compile_cache::add(options, sf, co);
     }
 
     auto jit_rc = pcre2_jit_compile(co, PCRE2_JIT_COMPLETE);
     if (jit_rc < 0) {
-        // log_error("failed to JIT compile pattern: %d", jit_rc);
+        // pcre2_match() transparently falls back to the interpreter for
+        // patterns that could not be JIT compiled.
     }
 
     return Ok(code{std::move(co), sf.to_string()});
@@ -130,7 +341,7 @@ code::match_partial(string_fragment in) const
                               0,
                               PCRE2_PARTIAL_HARD,
                               md.md_data.in(),
-                              nullptr);
+                              match_context());
 
         if (rc == PCRE2_ERROR_PARTIAL) {
             return md.md_ovector[1];
@@ -166,6 +377,142 @@ code::get_capture_count() const
     return retval;
 }
 
+std::string
+code::to_literal(const pcre2_code* code, const std::string& pattern)
+{
+    static const char* META_CHARS = "\\^$.[]|()?*+{}";
+
+    uint32_t arg_options = 0;
+
+    pcre2_pattern_info(code, PCRE2_INFO_ARGOPTIONS, &arg_options);
+    if (arg_options & PCRE2_CASELESS) {
+        return "";
+    }
+
+    if (pattern.empty()
+        || pattern.find_first_of(META_CHARS) != std::string::npos)
+    {
+        return "";
+    }
+
+    return pattern;
+}
+
+std::string
+code::get_required_substring() const
+{
+    static const char* RUN_BREAKERS = "^$.]}";
+
+    uint32_t arg_options = 0;
+
+    pcre2_pattern_info(this->p_code.in(), PCRE2_INFO_ARGOPTIONS, &arg_options);
+    if (arg_options & PCRE2_CASELESS) {
+        return "";
+    }
+    if (this->p_pattern.find_first_of("\\|(?") != std::string::npos) {
+        // Escapes, alternation, groups, and optional elements make it hard
+        // to prove a literal is required, so bail on those patterns.
+        return "";
+    }
+
+    std::string best, current;
+    auto flush = [&best, &current]() {
+        if (current.size() > best.size()) {
+            best = current;
+        }
+        current.clear();
+    };
+
+    for (size_t lpc = 0; lpc < this->p_pattern.size(); lpc++) {
+        auto ch = this->p_pattern[lpc];
+
+        if (ch == '[') {
+            while (lpc < this->p_pattern.size()
+                   && this->p_pattern[lpc] != ']')
+            {
+                lpc += 1;
+            }
+            flush();
+        } else if (ch == '*' || ch == '{') {
+            // The quantifier makes the previous character optional or
+            // repeated, so it cannot be part of a required run.
+            if (!current.empty()) {
+                current.pop_back();
+            }
+            flush();
+            if (ch == '{') {
+                while (lpc < this->p_pattern.size()
+                       && this->p_pattern[lpc] != '}')
+                {
+                    lpc += 1;
+                }
+            }
+        } else if (ch == '+' || strchr(RUN_BREAKERS, ch) != nullptr) {
+            flush();
+        } else {
+            current.push_back(ch);
+        }
+    }
+    flush();
+
+    if (best.size() < 3) {
+        return "";
+    }
+    return best;
+}
+
+nonstd::optional<unsigned char>
+code::get_first_code_unit() const
+{
+    uint32_t first_type = 0;
+
+    pcre2_pattern_info(
+        this->p_code.in(), PCRE2_INFO_FIRSTCODETYPE, &first_type);
+    if (first_type != 1) {
+        return nonstd::nullopt;
+    }
+
+    uint32_t first_unit = 0;
+
+    pcre2_pattern_info(
+        this->p_code.in(), PCRE2_INFO_FIRSTCODEUNIT, &first_unit);
+
+    return nonstd::make_optional<unsigned char>(first_unit);
+}
+
+bool
+code::add_first_code_units(std::bitset<256>& units_out) const
+{
+    auto first_unit = this->get_first_code_unit();
+
+    if (first_unit) {
+        units_out.set(first_unit.value());
+        if (isalpha(first_unit.value())) {
+            /* The pattern may be caseless, cover both cases to be safe. */
+            units_out.set(tolower(first_unit.value()));
+            units_out.set(toupper(first_unit.value()));
+        }
+        return true;
+    }
+
+    /*
+     * No single starting unit, but a pattern that begins with a class,
+     * like a timestamp's leading digit, has a starting-byte bitmap.
+     */
+    const uint8_t* bitmap = nullptr;
+
+    pcre2_pattern_info(this->p_code.in(), PCRE2_INFO_FIRSTBITMAP, &bitmap);
+    if (bitmap == nullptr) {
+        return false;
+    }
+    for (size_t lpc = 0; lpc < 256; lpc++) {
+        if (bitmap[lpc / 8] & (1U << (lpc % 8))) {
+            units_out.set(lpc);
+        }
+    }
+    return true;
+}
+
 std::vector<string_fragment>
 code::get_captures() const
 {
@@ -269,7 +616,11 @@ code::replace(string_fragment str, const char* repl) const
     std::string::size_type start = 0;
     string_fragment remaining = str;
 
-    auto md = this->create_match_data();
+    static thread_local match_data md = this->create_match_data();
+
+    if (md.get_capacity() < this->p_match_proto.md_ovector_count) {
+        md = this->create_match_data();
+    }
     while (remaining.is_valid()) {
         auto find_res = this->capture_from(str)
                             .at(remaining)
@@ -390,6 +741,34 @@ code::named_captures::end() const
     };
 }
 
+/**
+ * JIT-compiled patterns run on a separately-allocated machine stack, so
+ * give each thread its own stack sized for the nested patterns in log
+ * formats.  If the stack or context cannot be allocated, matching falls
+ * back to pcre2's builtin stack, and patterns that failed to JIT compile
+ * fall back to the interpreter automatically.
+ */
+static pcre2_match_context*
+match_context()
+{
+    static thread_local auto_mem<pcre2_jit_stack> jit_stack(
+        pcre2_jit_stack_free);
+    static thread_local auto_mem<pcre2_match_context> retval(
+        pcre2_match_context_free);
+
+    if (retval.in() == nullptr) {
+        retval = pcre2_match_context_create(nullptr);
+        if (retval.in() != nullptr) {
+            jit_stack = pcre2_jit_stack_create(32 * 1024, 512 * 1024, nullptr);
+            if (jit_stack.in() != nullptr) {
+                pcre2_jit_stack_assign(retval.in(), nullptr, jit_stack.in());
+            }
+        }
+    }
+
+    return retval.in();
+}
+
 matcher::matches_result
 matcher::matches(uint32_t options)
 {
@@ -399,13 +778,54 @@ matcher::matches(uint32_t options)
         return not_found{};
     }
 
+    auto match_offset = this->mb_input.i_offset;
+
+    if (!this->mb_code.p_literal.empty() && options == 0) {
+        // Purely literal pattern, jump straight to the next candidate with
+        // memchr() instead of letting pcre2 scan byte-by-byte.  The actual
+        // match is still done by pcre2_match() below so that the match data
+        // is filled in consistently.
+        const auto& str = this->mb_input.i_string;
+        const auto& lit = this->mb_code.p_literal;
+        const void* lit_ptr = nullptr;
+
+        if (match_offset + (int) lit.size() <= str.length()) {
+            const char* start = str.data() + match_offset;
+            size_t remaining = str.length() - match_offset;
+
+            while (remaining >= lit.size()) {
+                const auto* cand = (const char*) memchr(
+                    start, lit.front(), remaining - lit.size() + 1);
+
+                if (cand == nullptr) {
+                    break;
+                }
+                if (memcmp(cand, lit.data(), lit.size()) == 0) {
+                    lit_ptr = cand;
+                    break;
+                }
+                remaining -= (cand - start) + 1;
+                start = cand + 1;
+            }
+        }
+        if (lit_ptr == nullptr) {
+            this->mb_match_data.md_input = this->mb_input;
+            this->mb_match_data.md_ovector[0] = this->mb_input.i_offset;
+            this->mb_match_data.md_ovector[1] = this->mb_input.i_offset;
+            this->mb_match_data.md_capture_end = 1;
+            return not_found{};
+        }
+
+        match_offset = (const char*) lit_ptr - str.data();
+    }
+
     auto rc = pcre2_match(this->mb_code.p_code.in(),
                           this->mb_input.i_string.udata(),
                           this->mb_input.i_string.length(),
-                          this->mb_input.i_offset,
+                          match_offset,
                           options,
                           this->mb_match_data.md_data.in(),
-                          nullptr);
+                          match_context());
 
     if (rc > 0) {
         this->mb_match_data.md_input = this->mb_input;
@@ -32,6 +32,7 @@
 
 #define PCRE2_CODE_UNIT_WIDTH 8
 
+#include <bitset>
 #include <memory>
 #include <string>
 #include <vector>
@@ -259,12 +260,30 @@ public:
 
     const std::string& get_pattern() const { return this->p_pattern; }
 
+    /**
+     * Get a substring that must be present in any input for this pattern
+     * to match, or an empty string if one cannot be proven.  Useful for
+     * short-circuiting evaluation with content sketches.
+     */
+    std::string get_required_substring() const;
+
     named_captures get_named_captures() const;
 
     const char* get_name_for_capture(size_t index) const;
 
     size_t get_capture_count() const;
 
+    nonstd::optional<unsigned char> get_first_code_unit() const;
+
+    /**
+     * Add the set of code units a match can start with to the given
+     * bitset, using the compiled pattern's starting-byte information.
+     *
+     * @return False if the starting bytes could not be determined, in
+     * which case the bitset is left untouched.
+     */
+    bool add_first_code_units(std::bitset<256>& units_out) const;
+
     int name_index(const char* name) const;
 
     std::vector<string_fragment> get_captures() const;
@@ -307,7 +326,8 @@ public:
 
     code(auto_mem<pcre2_code> code, std::string pattern)
         : p_code(std::move(code)), p_pattern(std::move(pattern)),
-          p_match_proto(this->create_match_data())
+          p_match_proto(this->create_match_data()),
+          p_literal(to_literal(this->p_code.in(), this->p_pattern))
     {
     }
 
@@ -315,9 +335,18 @@ private:
     friend matcher;
     friend match_data;
 
+    /**
+     * If the pattern is a case-sensitive literal, return it so matching can
+     * be prefiltered with memchr() instead of scanning with pcre2_match().
+     * Returns an empty string for anything with metacharacters.
+     */
+    static std::string to_literal(const pcre2_code* code,
+                                  const std::string& pattern);
+
     auto_mem<pcre2_code> p_code;
     std::string p_pattern;
     match_data p_match_proto;
+    std::string p_literal;
 };
 
 template<typename T, std::size_t N>
@@ -335,8 +364,13 @@ template<uint32_t Options, typename F>
 Result<string_fragment, matcher::error>
 capture_builder::for_each(F func) &&
 {
-    auto md = this->mb_code.create_match_data();
-    auto mat = matcher{this->mb_code, this->mb_input, md};
+    /*
+     * Reused across calls on this thread, into() grows it to fit the
+     * largest pattern seen so far.  Highlighting and searching call this
+     * once per line, so after warmup the allocator drops off that path.
+     */
+    static thread_local auto md = match_data::unitialized();
+    auto mat = std::move(*this).into(md);
 
     bool done = false;
     matcher::error eret;
@@ -361,6 +395,23 @@ capture_builder::for_each(F func) &&
     return Err(eret);
 }
 
+namespace compile_cache {
+
+/**
+ * Load serialized compiled patterns from the given file and start caching
+ * patterns compiled by code::from() until save() is called.  Entries that
+ * were written by an incompatible pcre2 version are dropped on lookup.
+ */
+void load(const std::string& path);
+
+/**
+ * Write out the patterns compiled or reused since load() was called and
+ * stop caching new compilations.
+ */
+void save(const std::string& path);
+
+}  // namespace compile_cache
+
 }  // namespace pcre2pp
 }  // namespace lnav
 
@@ -244,3 +244,23 @@ TEST_CASE("get_captures-namedq")
     assert(re.get_captures()[0].sf_begin == 0);
     assert(re.get_captures()[0].sf_end == 11);
 }
+
+TEST_CASE("literal-prefilter")
+{
+    static const char INPUT[] = "abc def ghi def";
+
+    auto re = lnav::pcre2pp::code::from_const("def");
+    int count = 0;
+
+    re.capture_from(string_fragment::from_const(INPUT))
+        .for_each([&count](lnav::pcre2pp::match_data& md) {
+            assert(md[0]->length() == 3);
+            count += 1;
+        });
+    CHECK(count == 2);
+
+    auto miss = lnav::pcre2pp::code::from_const("zzz");
+    auto find_res
+        = miss.find_in(string_fragment::from_const(INPUT)).ignore_error();
+    CHECK(!find_res.has_value());
+}
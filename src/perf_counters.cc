@@ -0,0 +1,116 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "perf_counters.hh"
+
+#include "config.h"
+
+namespace lnav {
+namespace perf {
+
+counter_array&
+get_counters()
+{
+    static counter_array retval = {{
+        {
+            "line_buffer.reads",
+            "Number of read/pread/decompress calls made to load file data",
+        },
+        {
+            "line_buffer.read_bytes",
+            "Number of bytes loaded from files",
+        },
+        {
+            "logfile.format_scans",
+            "Number of lines run through a log format's scanner",
+        },
+        {
+            "filter.evals",
+            "Number of line/filter evaluations",
+        },
+        {
+            "lss.index_rebuilds",
+            "Number of rebuilds of the merged log message index",
+        },
+        {
+            "render.string_copy_bytes",
+            "Number of bytes copied out of shared line buffers on the "
+            "render path; rising numbers point at a new copy point",
+        },
+        {
+            "view.repaints",
+            "Number of view redraws",
+        },
+        {
+            "view.frames_skipped",
+            "Number of repaints deferred by the frame budget while "
+            "indexing was producing changes",
+        },
+        {
+            "loop.stalls",
+            "Number of main loop iterations that blew the latency budget; "
+            "the lnav_stalls table has the details for recent ones",
+        },
+    }};
+
+    return retval;
+}
+
+std::vector<gauge>&
+get_gauges()
+{
+    static std::vector<gauge> retval;
+
+    return retval;
+}
+
+void
+register_gauge(const char* name,
+               const char* description,
+               std::function<uint64_t()> value)
+{
+    get_gauges().push_back(gauge{name, description, std::move(value)});
+}
+
+void
+write_summary(FILE* out)
+{
+    for (const auto& pc : get_counters()) {
+        fprintf(out,
+                "perf\t%s\t%llu\t%llu\n",
+                pc.c_name,
+                (unsigned long long) pc.c_count.load(
+                    std::memory_order_relaxed),
+                (unsigned long long) pc.c_duration_us.load(
+                    std::memory_order_relaxed));
+    }
+}
+
+}  // namespace perf
+}  // namespace lnav
@@ -0,0 +1,149 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef lnav_perf_counters_hh
+#define lnav_perf_counters_hh
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <vector>
+
+#include <stdint.h>
+#include <stdio.h>
+
+namespace lnav {
+namespace perf {
+
+/**
+ * Counters for the hot paths in a session.  These are kept cheap enough
+ * to leave enabled in release builds -- a relaxed atomic increment on
+ * the counting paths and a steady_clock read on the coarse, timed ones
+ * -- so that a slow session in the field can be diagnosed with a query
+ * against the lnav_perf table instead of a rebuild under a profiler.
+ */
+enum class counter_id : size_t {
+    LINE_BUFFER_READS,
+    LINE_BUFFER_READ_BYTES,
+    FORMAT_SCANS,
+    FILTER_EVALS,
+    INDEX_REBUILDS,
+    RENDER_COPY_BYTES,
+    VIEW_REPAINTS,
+    VIEW_FRAMES_SKIPPED,
+    LOOP_STALLS,
+
+    __MAX
+};
+
+constexpr size_t COUNTER_COUNT = (size_t) counter_id::__MAX;
+
+struct counter {
+    const char* c_name;
+    const char* c_description;
+    std::atomic<uint64_t> c_count{0};
+    std::atomic<uint64_t> c_duration_us{0};
+};
+
+using counter_array = std::array<counter, COUNTER_COUNT>;
+
+counter_array& get_counters();
+
+/**
+ * A named value that is sampled when the lnav_perf table is queried.
+ * Unlike counters, gauges report the current footprint of a resource,
+ * like the bytes held by an arena, rather than a running total.
+ */
+struct gauge {
+    const char* g_name;
+    const char* g_description;
+    std::function<uint64_t()> g_value;
+};
+
+std::vector<gauge>& get_gauges();
+
+/**
+ * Register a gauge to be shown in the lnav_perf table.  Registration
+ * should happen once during startup; the value callback is invoked on
+ * the main thread when the table is queried.
+ */
+void register_gauge(const char* name,
+                    const char* description,
+                    std::function<uint64_t()> value);
+
+/**
+ * Writes the counters to the given file as tab-separated
+ * "perf\t<name>\t<count>\t<duration_us>" lines for automation to consume.
+ */
+void write_summary(FILE* out);
+
+inline void
+count(counter_id id, uint64_t amount = 1)
+{
+    get_counters()[(size_t) id].c_count.fetch_add(amount,
+                                                  std::memory_order_relaxed);
+}
+
+/**
+ * Adds one to the counter and accumulates the elapsed wall-clock time in
+ * c_duration_us.  Only meant for coarse operations, like an index rebuild
+ * or a repaint, not per-line work.
+ */
+class timer {
+public:
+    explicit timer(counter_id id)
+        : t_id(id), t_start(std::chrono::steady_clock::now())
+    {
+    }
+
+    timer(const timer&) = delete;
+    timer& operator=(const timer&) = delete;
+
+    ~timer()
+    {
+        auto elapsed_us
+            = std::chrono::duration_cast<std::chrono::microseconds>(
+                  std::chrono::steady_clock::now() - this->t_start)
+                  .count();
+        auto& c = get_counters()[(size_t) this->t_id];
+
+        c.c_count.fetch_add(1, std::memory_order_relaxed);
+        c.c_duration_us.fetch_add(elapsed_us, std::memory_order_relaxed);
+    }
+
+private:
+    counter_id t_id;
+    std::chrono::steady_clock::time_point t_start;
+};
+
+}  // namespace perf
+}  // namespace lnav
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/injector.bind.hh"
+#include "config.h"
+#include "perf_counters.hh"
+#include "vtab_module.hh"
+
+struct lnav_perf : public tvt_iterator_cursor<lnav_perf> {
+    struct perf_row {
+        const char* pr_name;
+        const char* pr_description;
+        int64_t pr_value;
+        int64_t pr_duration_us;
+    };
+
+    using iterator = std::vector<perf_row>::iterator;
+
+    static constexpr const char* NAME = "lnav_perf";
+    static constexpr const char* CREATE_STMT = R"(
+-- Counters for hot paths in this session, for diagnosing where time goes.
+CREATE TABLE lnav_perf (
+    name        TEXT,     -- The name of the counter.
+    description TEXT,     -- A description of what is being counted.
+    counter     INTEGER,  -- The count or, for gauges, the sampled value.
+    duration_us INTEGER   -- Accumulated time, for timed counters, else NULL.
+);
+)";
+
+    iterator begin()
+    {
+        this->p_rows.clear();
+        for (auto& pc : lnav::perf::get_counters()) {
+            this->p_rows.push_back(perf_row{
+                pc.c_name,
+                pc.c_description,
+                (int64_t) pc.c_count.load(std::memory_order_relaxed),
+                (int64_t) pc.c_duration_us.load(std::memory_order_relaxed),
+            });
+        }
+        for (auto& pg : lnav::perf::get_gauges()) {
+            this->p_rows.push_back(perf_row{
+                pg.g_name,
+                pg.g_description,
+                (int64_t) pg.g_value(),
+                0,
+            });
+        }
+        return this->p_rows.begin();
+    }
+
+    iterator end() { return this->p_rows.end(); }
+
+    int get_column(cursor& vc, sqlite3_context* ctx, int col)
+    {
+        auto& pr = *vc.iter;
+
+        switch (col) {
+            case 0:
+                sqlite3_result_text(ctx, pr.pr_name, -1, SQLITE_STATIC);
+                break;
+            case 1:
+                sqlite3_result_text(ctx, pr.pr_description, -1, SQLITE_STATIC);
+                break;
+            case 2:
+                to_sqlite(ctx, pr.pr_value);
+                break;
+            case 3:
+                if (pr.pr_duration_us == 0) {
+                    sqlite3_result_null(ctx);
+                } else {
+                    to_sqlite(ctx, pr.pr_duration_us);
+                }
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+    std::vector<perf_row> p_rows;
+};
+
+static auto perf_binder = injector::bind_multiple<vtab_module_base>()
+                              .add<vtab_module<tvt_no_update<lnav_perf>>>();
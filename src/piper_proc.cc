@@ -29,6 +29,8 @@
  * @file piper_proc.cc
  */
 
+#include <vector>
+
 #include "piper_proc.hh"
 
 #include <errno.h>
@@ -50,19 +52,34 @@ using namespace std::chrono_literals;
 
 static const char* STDIN_EOF_MSG = "---- END-OF-STDIN ----";
 
-static ssize_t
-write_timestamp(int fd, off_t woff)
+/**
+ * The size at which batched lines are flushed to the backing file.
+ * Writes also happen whenever the input pipe runs dry, so this only
+ * bounds the buffering while a producer is blasting data at us.
+ */
+static const size_t PIPER_BATCH_SIZE = 256 * 1024;
+
+static size_t
+fill_timestamp(char* time_str, size_t size)
 {
-    char time_str[64];
     struct timeval tv;
     char ms_str[10];
 
     gettimeofday(&tv, nullptr);
-    strftime(time_str, sizeof(time_str), "%FT%T", localtime(&tv.tv_sec));
+    strftime(time_str, size, "%FT%T", localtime(&tv.tv_sec));
     snprintf(ms_str, sizeof(ms_str), ".%03d", (int) (tv.tv_usec / 1000));
     strcat(time_str, ms_str);
     strcat(time_str, "  ");
-    return pwrite(fd, time_str, strlen(time_str), woff);
+    return strlen(time_str);
+}
+
+static ssize_t
+write_timestamp(int fd, off_t woff)
+{
+    char time_str[64];
+
+    auto ts_len = fill_timestamp(time_str, sizeof(time_str));
+    return pwrite(fd, time_str, ts_len, woff);
 }
 
 piper_proc::piper_proc(auto_fd pipefd, bool timestamp, auto_fd filefd)
@@ -82,6 +99,8 @@ piper_proc::piper_proc(auto_fd pipefd, bool timestamp, auto_fd filefd)
             line_buffer lb;
             off_t woff = 0, last_woff = 0;
             file_range last_range;
+            std::vector<char> batch;
+            off_t batch_woff = 0;
 
             auto open_res = lnav::filesystem::open_file("/dev/null", O_RDWR);
             if (open_res.isErr()) {
@@ -109,7 +128,81 @@ piper_proc::piper_proc(auto_fd pipefd, bool timestamp, auto_fd filefd)
                 }
             }
             log_perror(fcntl(pipefd.get(), F_SETFL, O_NONBLOCK));
+
+            if (!timestamp) {
+                // Without timestamp decoration the backing file is a
+                // verbatim copy of the pipe, so there's no need to frame
+                // lines here -- the main process re-indexes them anyway.
+                // Ferry raw blocks straight from the pipe to the file.
+                static const auto TIMEOUT
+                    = std::chrono::duration_cast<std::chrono::milliseconds>(1s)
+                          .count();
+                char block[64 * 1024];
+                bool eof = false;
+
+                while (!eof) {
+                    struct pollfd pfd = {pipefd.get(), POLLIN, 0};
+
+                    auto poll_rc = poll(&pfd, 1, TIMEOUT);
+                    if (poll_rc == 0) {
+                        // update the timestamp to keep the file alive from
+                        // any cleanup processes
+                        log_perror(futimes(this->pp_fd.get(), nullptr));
+                        continue;
+                    }
+                    while (true) {
+                        auto rrc = read(pipefd.get(), block, sizeof(block));
+
+                        if (rrc == -1) {
+                            if (errno == EAGAIN || errno == EINTR) {
+                                break;
+                            }
+                            perror("Unable to read from pipe for stdin");
+                            eof = true;
+                            break;
+                        }
+                        if (rrc == 0) {
+                            eof = true;
+                            break;
+                        }
+
+                        /* Need to do pwrite here since the fd is used by
+                         * the main lnav process as well.
+                         */
+                        auto wrc = pwrite(this->pp_fd, block, rrc, woff);
+                        if (wrc == -1) {
+                            perror(
+                                "Unable to write to output file for stdin");
+                            eof = true;
+                            break;
+                        }
+                        woff += rrc;
+                    }
+                }
+                _exit(0);
+            }
+
             lb.set_fd(pipefd);
+            batch.reserve(PIPER_BATCH_SIZE);
+
+            /* Need to do pwrite here since the fd is used by the main
+             * lnav process as well.
+             */
+            auto flush_batch = [this, &batch, &batch_woff]() {
+                if (batch.empty()) {
+                    return true;
+                }
+
+                auto wrc = pwrite(
+                    this->pp_fd, batch.data(), batch.size(), batch_woff);
+                if (wrc == -1) {
+                    perror("Unable to write to output file for stdin");
+                    return false;
+                }
+                batch.clear();
+                return true;
+            };
+
             do {
                 static const auto TIMEOUT
                     = std::chrono::duration_cast<std::chrono::milliseconds>(1s)
@@ -148,37 +241,49 @@ piper_proc::piper_proc(auto_fd pipefd, bool timestamp, auto_fd filefd)
 
                     auto sbr = read_result.unwrap();
 
-                    ssize_t wrc;
-
                     last_woff = woff;
-                    if (timestamp) {
-                        wrc = write_timestamp(this->pp_fd, woff);
-                        if (wrc == -1) {
-                            perror("Unable to write to output file for stdin");
-                            break;
-                        }
-                        woff += wrc;
+                    if (batch.empty()) {
+                        batch_woff = woff;
                     }
+                    if (timestamp) {
+                        char time_str[64];
 
-                    /* Need to do pwrite here since the fd is used by the main
-                     * lnav process as well.
-                     */
-                    wrc = pwrite(
-                        this->pp_fd, sbr.get_data(), sbr.length(), woff);
-                    if (wrc == -1) {
-                        perror("Unable to write to output file for stdin");
-                        break;
+                        auto ts_len
+                            = fill_timestamp(time_str, sizeof(time_str));
+                        batch.insert(
+                            batch.end(), time_str, time_str + ts_len);
+                        woff += ts_len;
                     }
-                    woff += wrc;
+
+                    batch.insert(batch.end(),
+                                 sbr.get_data(),
+                                 sbr.get_data() + sbr.length());
+                    woff += sbr.length();
 
                     last_range = li.li_file_range;
                     if (li.li_partial
                         && sbr.get_data()[sbr.length() - 1] != '\n'
                         && (last_range.next_offset() != lb.get_file_size()))
                     {
+                        // Flush so the partial line is visible right away
+                        // and rewind so the complete line overwrites it on
+                        // the next pass.
+                        if (!flush_batch()) {
+                            break;
+                        }
                         woff = last_woff;
+                    } else if (batch.size() >= PIPER_BATCH_SIZE
+                               && !flush_batch())
+                    {
+                        break;
                     }
                 }
+
+                // The pipe has run dry, write out what we have so the
+                // main process can see it.
+                if (!flush_batch()) {
+                    break;
+                }
             } while (lb.is_pipe() && !lb.is_pipe_closed());
 
             if (timestamp) {
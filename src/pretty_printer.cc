@@ -70,7 +70,7 @@ pretty_printer::append_to(attr_line_t& al)
                     this->start_new_line();
                     this->write_element(el);
                     this->pp_interval_state.back().is_start
-                        = this->pp_stream.tellp();
+                        = (file_off_t) this->pp_stream.size();
                     this->pp_interval_state.back().is_name
                         = tok_res->to_string();
                     this->descend();
@@ -92,7 +92,7 @@ pretty_printer::append_to(attr_line_t& al)
                 this->pp_values.emplace_back(el);
                 this->descend();
                 this->pp_interval_state.back().is_start
-                    = this->pp_stream.tellp();
+                    = (file_off_t) this->pp_stream.size();
                 continue;
             case DT_RCURLY:
             case DT_RSQUARE:
@@ -113,7 +113,7 @@ pretty_printer::append_to(attr_line_t& al)
                     this->write_element(el);
                     this->start_new_line();
                     this->pp_interval_state.back().is_start
-                        = this->pp_stream.tellp();
+                        = (file_off_t) this->pp_stream.size();
                     continue;
                 }
                 break;
@@ -136,7 +136,7 @@ pretty_printer::append_to(attr_line_t& al)
     this->flush_values();
 
     attr_line_t combined;
-    combined.get_string() = this->pp_stream.str();
+    combined.get_string() = std::move(this->pp_stream);
     combined.get_attrs() = this->pp_attrs;
 
     if (!al.empty()) {
@@ -178,7 +178,7 @@ pretty_printer::write_element(const pretty_printer::element& el)
         this->pp_soft_indent = 0;
         if (this->pp_line_length > 0) {
             this->pp_line_length = 0;
-            this->pp_stream << std::endl;
+            this->pp_stream.push_back('\n');
             this->pp_body_lines.top() += 1;
         }
         return;
@@ -186,7 +186,7 @@ pretty_printer::write_element(const pretty_printer::element& el)
     if (this->pp_line_length == 0) {
         this->append_indent();
     }
-    ssize_t start_size = this->pp_stream.tellp();
+    ssize_t start_size = (ssize_t) this->pp_stream.size();
     if (el.e_token == DT_QUOTED_STRING) {
         auto_mem<char> unquoted_str((char*) malloc(el.e_capture.length() + 1));
         const char* start
@@ -203,25 +203,26 @@ pretty_printer::write_element(const pretty_printer::element& el)
             switch (start[0]) {
                 case 'r':
                 case 'u':
-                    this->pp_stream << start[0];
-                    this->pp_stream << start[1] << start[1];
+                    this->pp_stream.push_back(start[0]);
+                    this->pp_stream.append(2, start[1]);
                     break;
                 default:
-                    this->pp_stream << start[0] << start[0];
+                    this->pp_stream.append(2, start[0]);
                     break;
             }
-            this->pp_stream << std::endl << result.get_string();
+            this->pp_stream.push_back('\n');
+            this->pp_stream.append(result.get_string());
             if (result.empty() || result.get_string().back() != '\n') {
-                this->pp_stream << std::endl;
+                this->pp_stream.push_back('\n');
             }
-            this->pp_stream << start[el.e_capture.length() - 1]
-                            << start[el.e_capture.length() - 1];
+            this->pp_stream.append(2, start[el.e_capture.length() - 1]);
         } else {
-            this->pp_stream
-                << this->pp_scanner->to_string_fragment(el.e_capture);
+            auto sf = this->pp_scanner->to_string_fragment(el.e_capture);
+            this->pp_stream.append(sf.data(), sf.length());
         }
     } else {
-        this->pp_stream << this->pp_scanner->to_string_fragment(el.e_capture);
+        auto sf = this->pp_scanner->to_string_fragment(el.e_capture);
+        this->pp_stream.append(sf.data(), sf.length());
         int shift_amount
             = start_size - el.e_capture.c_begin - this->pp_shift_accum;
         shift_string_attrs(this->pp_attrs, el.e_capture.c_begin, shift_amount);
@@ -237,14 +238,14 @@ pretty_printer::write_element(const pretty_printer::element& el)
 void
 pretty_printer::append_indent()
 {
-    this->pp_stream << std::string(
-        this->pp_leading_indent + this->pp_soft_indent, ' ');
+    this->pp_stream.append(this->pp_leading_indent + this->pp_soft_indent,
+                           ' ');
     this->pp_soft_indent = 0;
-    if (this->pp_stream.tellp() == this->pp_leading_indent) {
+    if (this->pp_stream.size() == (size_t) this->pp_leading_indent) {
         return;
     }
     for (int lpc = 0; lpc < this->pp_depth; lpc++) {
-        this->pp_stream << "    ";
+        this->pp_stream.append("    ");
     }
 }
 
@@ -274,7 +275,7 @@ pretty_printer::flush_values(bool start_on_depth)
                                   .to_string();
                         if (!this->pp_interval_state.back().is_name.empty()) {
                             this->pp_interval_state.back().is_start
-                                = static_cast<ssize_t>(this->pp_stream.tellp());
+                                = static_cast<ssize_t>(this->pp_stream.size());
                         }
                         last_key = nonstd::nullopt;
                     }
@@ -286,7 +287,7 @@ pretty_printer::flush_values(bool start_on_depth)
                 && (el.e_token == DT_LSQUARE || el.e_token == DT_LCURLY))
             {
                 if (this->pp_line_length > 0) {
-                    this->pp_stream << std::endl;
+                    this->pp_stream.push_back('\n');
                 }
                 this->pp_line_length = 0;
             }
@@ -303,12 +304,12 @@ pretty_printer::start_new_line()
     bool has_output;
 
     if (this->pp_line_length > 0) {
-        this->pp_stream << std::endl;
+        this->pp_stream.push_back('\n');
         this->pp_line_length = 0;
     }
     has_output = this->flush_values();
     if (has_output && this->pp_line_length > 0) {
-        this->pp_stream << std::endl;
+        this->pp_stream.push_back('\n');
     }
     this->pp_line_length = 0;
     this->pp_body_lines.top() += 1;
@@ -358,7 +359,7 @@ pretty_printer::append_child_node()
         : lnav::document::section_key_t{ivstate.is_name};
     this->pp_intervals.emplace_back(
         ivstate.is_start.value(),
-        static_cast<ssize_t>(this->pp_stream.tellp()),
+        static_cast<ssize_t>(this->pp_stream.size()),
         new_key);
     auto new_node = this->pp_hier_stage != nullptr
         ? std::move(this->pp_hier_stage)
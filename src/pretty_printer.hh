@@ -32,8 +32,8 @@
 
 #include <deque>
 #include <map>
-#include <sstream>
 #include <stack>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -79,6 +79,9 @@ public:
         this->pp_interval_state.resize(1);
         this->pp_hier_nodes.push_back(
             std::make_unique<lnav::document::hier_node>());
+        // The rewritten text is usually a bit larger than the input, so
+        // reserving the input size up front avoids most reallocations.
+        this->pp_stream.reserve(ds->get_input().length());
     }
 
     void append_to(attr_line_t& al);
@@ -124,7 +127,7 @@ private:
     std::stack<int> pp_body_lines{};
     data_scanner* pp_scanner;
     string_attrs_t pp_attrs;
-    std::ostringstream pp_stream;
+    std::string pp_stream;
     std::deque<element> pp_values{};
     int pp_shift_accum{0};
     bool pp_is_xml{false};
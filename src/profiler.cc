@@ -0,0 +1,323 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "profiler.hh"
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+#include <errno.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "base/auto_mem.hh"
+#include "base/lnav_log.hh"
+#include "config.h"
+#include "fmt/format.h"
+
+#ifdef HAVE_EXECINFO_H
+#    include <execinfo.h>
+#    define PROFILER_SUPPORTED 1
+#endif
+#if BACKWARD_HAS_DW == 1
+#    include "backward-cpp/backward.hpp"
+#endif
+
+namespace lnav {
+namespace profiler {
+
+#ifdef PROFILER_SUPPORTED
+
+/** Capture stops once this many samples have been taken. */
+static constexpr size_t MAX_SAMPLES = 20000;
+static constexpr size_t MAX_FRAMES = 48;
+/** Sample every 10ms of CPU time, roughly 100Hz when busy. */
+static constexpr long SAMPLE_INTERVAL_USECS = 10000;
+
+struct stack_sample {
+    int ss_depth;
+    void* ss_frames[MAX_FRAMES];
+};
+
+static std::vector<stack_sample> sample_buffer;
+static std::atomic<size_t> sample_count{0};
+static bool profiler_running = false;
+
+static void
+sigprof_handler(int sig)
+{
+    auto index = sample_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (index >= sample_buffer.size()) {
+        return;
+    }
+
+    auto& ss = sample_buffer[index];
+
+    ss.ss_depth = ::backtrace(ss.ss_frames, MAX_FRAMES);
+}
+
+/**
+ * Make a frame name safe for the collapsed format, where semicolons
+ * separate frames and the last space separates the count.
+ */
+static std::string
+sanitize_frame_name(std::string name)
+{
+    for (auto& ch : name) {
+        if (ch == ';') {
+            ch = ':';
+        } else if (ch == ' ' || ch == '\t' || ch == '\n') {
+            ch = '_';
+        }
+    }
+
+    return name;
+}
+
+#    if BACKWARD_HAS_DW == 1
+static std::string
+resolve_frame(backward::TraceResolver& tr, void* addr, size_t index)
+{
+    auto rt = tr.resolve(
+        backward::ResolvedTrace(backward::Trace(addr, index)));
+
+    if (!rt.source.function.empty()) {
+        return rt.source.function;
+    }
+    if (!rt.object_function.empty()) {
+        return rt.object_function;
+    }
+    return fmt::format(FMT_STRING("{}"), fmt::ptr(addr));
+}
+#    else
+static std::string
+resolve_frame(void* addr)
+{
+    auto_mem<char*> symbols;
+
+    symbols = ::backtrace_symbols(&addr, 1);
+    if (symbols.in() == nullptr) {
+        return fmt::format(FMT_STRING("{}"), fmt::ptr(addr));
+    }
+
+    // The symbol looks like "binary(function+0x...) [0x...]", pull out
+    // just the function when it is there.
+    std::string retval = symbols.in()[0];
+    auto open_paren = retval.find('(');
+    auto plus = retval.find('+', open_paren == std::string::npos
+                                ? 0
+                                : open_paren);
+
+    if (open_paren != std::string::npos && plus != std::string::npos
+        && plus > open_paren + 1)
+    {
+        retval = retval.substr(open_paren + 1, plus - open_paren - 1);
+    }
+
+    return retval;
+}
+#    endif
+
+#endif
+
+bool
+is_supported()
+{
+#ifdef PROFILER_SUPPORTED
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool
+is_running()
+{
+#ifdef PROFILER_SUPPORTED
+    return profiler_running;
+#else
+    return false;
+#endif
+}
+
+Result<void, std::string>
+start()
+{
+#ifndef PROFILER_SUPPORTED
+    return Err(
+        std::string("stack sampling is not supported on this platform"));
+#else
+    if (profiler_running) {
+        return Err(std::string("the profiler is already running"));
+    }
+
+    sample_buffer.resize(MAX_SAMPLES);
+    sample_count.store(0, std::memory_order_relaxed);
+
+    // The first backtrace() call can allocate, so prime it here instead
+    // of in the signal handler.
+    void* primer[4];
+    ::backtrace(primer, 4);
+
+    struct sigaction sa {};
+
+    sa.sa_handler = sigprof_handler;
+    sa.sa_flags = SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, nullptr) == -1) {
+        return Err(fmt::format(FMT_STRING("unable to install SIGPROF "
+                                          "handler -- {}"),
+                               strerror(errno)));
+    }
+
+    struct itimerval timer {};
+
+    timer.it_interval.tv_usec = SAMPLE_INTERVAL_USECS;
+    timer.it_value = timer.it_interval;
+    if (setitimer(ITIMER_PROF, &timer, nullptr) == -1) {
+        signal(SIGPROF, SIG_DFL);
+        return Err(fmt::format(
+            FMT_STRING("unable to start profiling timer -- {}"),
+            strerror(errno)));
+    }
+
+    profiler_running = true;
+    log_info("profiler started with a %zu sample buffer", MAX_SAMPLES);
+
+    return Ok();
+#endif
+}
+
+Result<size_t, std::string>
+stop(const ghc::filesystem::path& out_path)
+{
+#ifndef PROFILER_SUPPORTED
+    return Err(
+        std::string("stack sampling is not supported on this platform"));
+#else
+    if (!profiler_running) {
+        return Err(std::string("the profiler is not running"));
+    }
+
+    struct itimerval timer {};
+
+    setitimer(ITIMER_PROF, &timer, nullptr);
+    signal(SIGPROF, SIG_DFL);
+    profiler_running = false;
+
+    auto captured = std::min(sample_count.load(std::memory_order_relaxed),
+                             sample_buffer.size());
+
+    if (captured == 0) {
+        std::vector<stack_sample>().swap(sample_buffer);
+        return Err(std::string("no samples were captured"));
+    }
+
+    // The innermost frames are the handler and the signal trampoline,
+    // the interrupted code starts below them.
+    static constexpr int SKIP_FRAMES = 2;
+
+    std::map<std::vector<void*>, size_t> stack_counts;
+
+    for (size_t lpc = 0; lpc < captured; lpc++) {
+        const auto& ss = sample_buffer[lpc];
+
+        if (ss.ss_depth <= SKIP_FRAMES) {
+            continue;
+        }
+
+        std::vector<void*> stack(ss.ss_frames + SKIP_FRAMES,
+                                 ss.ss_frames + ss.ss_depth);
+
+        stack_counts[stack] += 1;
+    }
+    std::vector<stack_sample>().swap(sample_buffer);
+
+    auto_mem<FILE> out_file(fclose);
+
+    out_file = fopen(out_path.c_str(), "we");
+    if (out_file.in() == nullptr) {
+        return Err(fmt::format(FMT_STRING("unable to open '{}' -- {}"),
+                               out_path.string(),
+                               strerror(errno)));
+    }
+
+#    if BACKWARD_HAS_DW == 1
+    backward::TraceResolver tr;
+#    endif
+    std::map<void*, std::string> name_cache;
+    auto name_for = [&](void* addr) -> const std::string& {
+        auto iter = name_cache.find(addr);
+
+        if (iter == name_cache.end()) {
+#    if BACKWARD_HAS_DW == 1
+            auto name = resolve_frame(tr, addr, name_cache.size());
+#    else
+            auto name = resolve_frame(addr);
+#    endif
+            iter = name_cache
+                       .emplace(addr, sanitize_frame_name(std::move(name)))
+                       .first;
+        }
+
+        return iter->second;
+    };
+
+    size_t retval = 0;
+    for (const auto& pair : stack_counts) {
+        std::string line;
+
+        // Collapsed stacks are written root first.
+        for (auto frame_iter = pair.first.rbegin();
+             frame_iter != pair.first.rend();
+             ++frame_iter)
+        {
+            if (!line.empty()) {
+                line.push_back(';');
+            }
+            line.append(name_for(*frame_iter));
+        }
+        fmt::print(out_file.in(), FMT_STRING("{} {}\n"), line, pair.second);
+        retval += pair.second;
+    }
+
+    log_info("profiler wrote %zu samples (%zu unique stacks) to %s",
+             retval,
+             stack_counts.size(),
+             out_path.c_str());
+
+    return Ok(retval);
+#endif
+}
+
+}  // namespace profiler
+}  // namespace lnav
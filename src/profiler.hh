@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file profiler.hh
+ */
+
+#ifndef lnav_profiler_hh
+#define lnav_profiler_hh
+
+#include <string>
+
+#include "base/result.h"
+#include "ghc/filesystem.hpp"
+
+namespace lnav {
+namespace profiler {
+
+/** @return True if stack sampling is available on this platform. */
+bool is_supported();
+
+/** @return True if the profiler is currently capturing samples. */
+bool is_running();
+
+/**
+ * Start capturing stack samples of this process at roughly 100Hz of CPU
+ * time using SIGPROF.  Capture stops by itself once the preallocated
+ * sample buffer fills up.
+ *
+ * @return An error message if sampling could not be started.
+ */
+Result<void, std::string> start();
+
+/**
+ * Stop sampling, resolve the captured stacks, and write them out in the
+ * collapsed-stack format consumed by flamegraph tooling (one
+ * "frame;frame;frame count" line per unique stack).
+ *
+ * @param out_path The path to write the collapsed stacks to.
+ * @return The number of samples written or the reason the profile could
+ * not be saved.
+ */
+Result<size_t, std::string> stop(const ghc::filesystem::path& out_path);
+
+}  // namespace profiler
+}  // namespace lnav
+
+#endif
@@ -37,6 +37,7 @@
 // XXX
 #define __STDC_FORMAT_MACROS
 #include <cstdlib>
+#include <vector>
 
 #include <ctype.h>
 #include <inttypes.h>
@@ -1116,4 +1117,43 @@ extern struct ptime_fmt PTIMEC_FORMATS[];
 
 extern const char* PTIMEC_FORMAT_STR[];
 
+/**
+ * A timestamp format compiled down to a list of parsing operations so
+ * that executing it does not need to re-examine the format string for
+ * every line, like ptime_fmt() does.
+ */
+struct ptime_prog {
+    struct op {
+        enum class kind_t {
+            literal,
+            conversion,
+            full_month,
+            upto,
+            upto_end,
+        };
+
+        kind_t o_kind;
+        ptime_func o_func{nullptr};
+        char o_char{'\0'};
+    };
+
+    std::vector<op> pp_ops;
+};
+
+ptime_prog ptime_compile(const char* fmt);
+
+bool ptime_exec(const ptime_prog& prog,
+                struct exttm* dst,
+                const char* str,
+                off_t& off,
+                ssize_t len);
+
+/**
+ * Get the compiled program for the given timestamp format, compiling and
+ * caching it on first use.  The cache is per-thread and keyed on the
+ * format string pointer, which is fine for the format strings owned by
+ * loaded log formats.
+ */
+const ptime_prog& ptime_prog_for(const char* fmt);
+
 #endif
@@ -30,6 +30,7 @@
  */
 
 #include <algorithm>
+#include <unordered_map>
 
 #include "ptimec.hh"
 
@@ -135,6 +136,141 @@ ptime_fmt(const char* fmt,
     return true;
 }
 
+#define COMPILE_FMT_CASE(ch, c) \
+    case ch: \
+        retval.pp_ops.push_back({ \
+            ptime_prog::op::kind_t::conversion, \
+            ptime_##c, \
+        }); \
+        lpc += 1; \
+        break
+
+ptime_prog
+ptime_compile(const char* fmt)
+{
+    ptime_prog retval;
+
+    for (ssize_t lpc = 0; fmt[lpc]; lpc++) {
+        if (fmt[lpc] == '%') {
+            switch (fmt[lpc + 1]) {
+                case 'B':
+                    retval.pp_ops.push_back({
+                        ptime_prog::op::kind_t::full_month,
+                    });
+                    lpc += 1;
+                    break;
+                case 'a':
+                case 'Z':
+                    if (fmt[lpc + 2]) {
+                        retval.pp_ops.push_back({
+                            ptime_prog::op::kind_t::upto,
+                            nullptr,
+                            fmt[lpc + 2],
+                        });
+                    } else {
+                        retval.pp_ops.push_back({
+                            ptime_prog::op::kind_t::upto_end,
+                        });
+                    }
+                    lpc += 1;
+                    break;
+                    COMPILE_FMT_CASE('b', b);
+                    COMPILE_FMT_CASE('S', S);
+                    COMPILE_FMT_CASE('s', s);
+                    COMPILE_FMT_CASE('L', L);
+                    COMPILE_FMT_CASE('M', M);
+                    COMPILE_FMT_CASE('H', H);
+                    COMPILE_FMT_CASE('i', i);
+                    COMPILE_FMT_CASE('6', 6);
+                    COMPILE_FMT_CASE('I', I);
+                    COMPILE_FMT_CASE('d', d);
+                    COMPILE_FMT_CASE('e', e);
+                    COMPILE_FMT_CASE('f', f);
+                    COMPILE_FMT_CASE('k', k);
+                    COMPILE_FMT_CASE('l', l);
+                    COMPILE_FMT_CASE('m', m);
+                    COMPILE_FMT_CASE('N', N);
+                    COMPILE_FMT_CASE('p', p);
+                    COMPILE_FMT_CASE('q', q);
+                    COMPILE_FMT_CASE('Y', Y);
+                    COMPILE_FMT_CASE('y', y);
+                    COMPILE_FMT_CASE('z', z);
+                    COMPILE_FMT_CASE('@', at);
+            }
+        } else {
+            retval.pp_ops.push_back({
+                ptime_prog::op::kind_t::literal,
+                nullptr,
+                fmt[lpc],
+            });
+        }
+    }
+
+    return retval;
+}
+
+bool
+ptime_exec(const ptime_prog& prog,
+           struct exttm* dst,
+           const char* str,
+           off_t& off,
+           ssize_t len)
+{
+    for (const auto& op : prog.pp_ops) {
+        switch (op.o_kind) {
+            case ptime_prog::op::kind_t::literal:
+                if (!ptime_char(op.o_char, str, off, len)) {
+                    return false;
+                }
+                break;
+            case ptime_prog::op::kind_t::conversion:
+                if (!op.o_func(dst, str, off, len)) {
+                    return false;
+                }
+                break;
+            case ptime_prog::op::kind_t::full_month: {
+                size_t b_len = len - off;
+                char full_month[b_len + 1];
+                const char* end_of_date;
+
+                memcpy(full_month, &str[off], b_len);
+                full_month[b_len] = '\0';
+                end_of_date = strptime(full_month, "%B", &dst->et_tm);
+                if (end_of_date == nullptr) {
+                    return false;
+                }
+                off += end_of_date - full_month;
+                break;
+            }
+            case ptime_prog::op::kind_t::upto:
+                if (!ptime_upto(op.o_char, str, off, len)) {
+                    return false;
+                }
+                break;
+            case ptime_prog::op::kind_t::upto_end:
+                if (!ptime_upto_end(str, off, len)) {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    return true;
+}
+
+const ptime_prog&
+ptime_prog_for(const char* fmt)
+{
+    static thread_local std::unordered_map<const char*, ptime_prog> progs;
+
+    auto iter = progs.find(fmt);
+    if (iter == progs.end()) {
+        iter = progs.emplace(fmt, ptime_compile(fmt)).first;
+    }
+
+    return iter->second;
+}
+
 #define FTIME_FMT_CASE(ch, c) \
     case ch: \
         ftime_##c(dst, off_inout, len, tm); \
@@ -0,0 +1,123 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/injector.bind.hh"
+#include "config.h"
+#include "lnav.hh"
+#include "sql_util.hh"
+#include "view_helpers.hist.hh"
+#include "vtab_module.hh"
+
+struct lnav_log_rates : public tvt_iterator_cursor<lnav_log_rates> {
+    struct rate_row {
+        time_t rr_time;
+        int64_t rr_total;
+        int64_t rr_errors;
+        int64_t rr_warnings;
+        int64_t rr_marks;
+    };
+
+    using iterator = std::vector<rate_row>::iterator;
+
+    static constexpr const char* NAME = "lnav_log_rates";
+    static constexpr const char* CREATE_STMT = R"(
+-- Per-minute message counts by level, taken from the summaries built
+-- during indexing, so rate queries do not materialize any log rows.
+CREATE TABLE lnav_log_rates (
+    begin_time TEXT,     -- The start of the minute bucket.
+    slice_sec  INTEGER,  -- The width of the bucket, in seconds.
+    total      INTEGER,  -- The number of messages in the bucket.
+    errors     INTEGER,  -- The number of error messages.
+    warnings   INTEGER,  -- The number of warning messages.
+    marks      INTEGER   -- The number of marked messages.
+);
+)";
+
+    iterator begin()
+    {
+        this->lr_rows.clear();
+
+        auto* hid = dynamic_cast<hist_index_delegate*>(
+            lnav_data.ld_log_source.get_index_delegate());
+        if (hid != nullptr) {
+            for (const auto& shard : hid->get_shards()) {
+                this->lr_rows.push_back(rate_row{
+                    shard.hs_time,
+                    (int64_t) (shard.hs_values[hist_source2::HT_NORMAL]
+                               + shard.hs_values[hist_source2::HT_WARNING]
+                               + shard.hs_values[hist_source2::HT_ERROR]),
+                    (int64_t) shard.hs_values[hist_source2::HT_ERROR],
+                    (int64_t) shard.hs_values[hist_source2::HT_WARNING],
+                    (int64_t) shard.hs_values[hist_source2::HT_MARK],
+                });
+            }
+        }
+        return this->lr_rows.begin();
+    }
+
+    iterator end() { return this->lr_rows.end(); }
+
+    int get_column(cursor& vc, sqlite3_context* ctx, int col)
+    {
+        const auto& rr = *vc.iter;
+
+        switch (col) {
+            case 0: {
+                char time_buf[64];
+                struct timeval tv = {rr.rr_time, 0};
+
+                sql_strftime(time_buf, sizeof(time_buf), tv, 'T');
+                sqlite3_result_text(ctx, time_buf, -1, SQLITE_TRANSIENT);
+                break;
+            }
+            case 1:
+                to_sqlite(ctx, (int64_t) hist_index_delegate::SHARD_SLICE);
+                break;
+            case 2:
+                to_sqlite(ctx, rr.rr_total);
+                break;
+            case 3:
+                to_sqlite(ctx, rr.rr_errors);
+                break;
+            case 4:
+                to_sqlite(ctx, rr.rr_warnings);
+                break;
+            case 5:
+                to_sqlite(ctx, rr.rr_marks);
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+    std::vector<rate_row> lr_rows;
+};
+
+static auto rates_binder = injector::bind_multiple<vtab_module_base>()
+                               .add<vtab_module<tvt_no_update<lnav_log_rates>>>();
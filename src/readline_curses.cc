@@ -64,7 +64,7 @@
 #include "lnav_util.hh"
 #include "readline_curses.hh"
 #include "shlex.hh"
-#include "spookyhash/SpookyV2.h"
+#include "xxHash/xxhash.h"
 
 static int got_line = 0;
 static int got_abort = 0;
@@ -97,6 +97,7 @@ static std::string last_match_str;
 static bool last_match_str_valid;
 static bool arg_needs_shlex;
 static nonstd::optional<std::string> rewrite_line_start;
+static uint64_t possibility_generation;
 
 static void
 sigalrm(int sig)
@@ -281,23 +282,50 @@ readline_context::completion_generator(const char* text_in, int state)
             }
 
             if (matches.empty()) {
+                static std::string last_pattern;
+                static uint64_t last_generation;
+                static const std::set<std::string>* last_possibilities;
+                static std::vector<const std::string*> candidates;
+
                 std::vector<std::pair<int, std::string>> fuzzy_matches;
                 std::vector<std::pair<int, std::string>> fuzzy_long_matches;
 
-                for (const auto& poss : (*arg_possibilities)) {
-                    std::string poss_str = tolower(poss);
+                // A string that does not contain the pattern as a
+                // subsequence cannot match an extended pattern either, so
+                // the survivors of the previous keystroke are the only
+                // candidates worth rescoring when the pattern grows.
+                if (last_possibilities != arg_possibilities
+                    || last_generation != possibility_generation
+                    || text_str.compare(0, last_pattern.size(), last_pattern)
+                        != 0)
+                {
+                    candidates.clear();
+                    for (const auto& poss : (*arg_possibilities)) {
+                        candidates.push_back(&poss);
+                    }
+                }
+                last_pattern = text_str;
+                last_generation = possibility_generation;
+                last_possibilities = arg_possibilities;
+
+                auto prev_candidates = std::move(candidates);
+                candidates.clear();
+                for (const auto* poss_ptr : prev_candidates) {
+                    const auto& poss = *poss_ptr;
                     int score = 0;
 
-                    if (fts::fuzzy_match(
-                            text_str.c_str(), poss_str.c_str(), score)
-                        && score > 0)
+                    if (!fts::fuzzy_match_simple(text_str.c_str(),
+                                                 poss.c_str()))
                     {
-                        if (score <= 0) {
-                            continue;
-                        }
+                        continue;
+                    }
+                    candidates.push_back(poss_ptr);
 
+                    if (fts::fuzzy_match(text_str.c_str(), poss.c_str(), score)
+                        && score > 0)
+                    {
                         auto poss_slash_count
-                            = std::count(poss_str.begin(), poss_str.end(), '/');
+                            = std::count(poss.begin(), poss.end(), '/');
                         if (endswith(poss, "/")) {
                             poss_slash_count -= 1;
                         }
@@ -779,7 +807,7 @@ readline_curses::start()
             }
         } else {
             if (FD_ISSET(STDIN_FILENO, &ready_rfds)) {
-                static uint64_t last_h1, last_h2;
+                static uint64_t last_line_hash;
 
                 struct itimerval itv;
 
@@ -795,8 +823,6 @@ readline_curses::start()
                     this->line_ready("");
                     rl_callback_handler_remove();
                 } else {
-                    uint64_t h1 = 1, h2 = 2;
-
                     if (rl_last_func == readline_context::command_complete) {
                         rl_last_func = rl_menu_complete;
                     }
@@ -832,9 +858,9 @@ readline_curses::start()
                     }
                     rewrite_line_start = nonstd::nullopt;
 
-                    SpookyHash::Hash128(rl_line_buffer, rl_end, &h1, &h2);
+                    auto line_hash = XXH3_64bits(rl_line_buffer, rl_end);
 
-                    if (h1 == last_h1 && h2 == last_h2) {
+                    if (line_hash == last_line_hash) {
                         // do nothing
                     } else if (sendcmd(this->rc_command_pipe[RCF_SLAVE],
                                        complete_done ? 'l' : 'c',
@@ -845,8 +871,7 @@ readline_curses::start()
                         perror("line: write failed");
                         _exit(1);
                     }
-                    last_h1 = h1;
-                    last_h2 = h2;
+                    last_line_hash = line_hash;
                     if (sendcmd(this->rc_command_pipe[RCF_SLAVE], 'w', "", 0)
                         != 0)
                     {
@@ -945,6 +970,36 @@ readline_curses::start()
                         this->rc_contexts[context]
                             ->rc_prefixes[std::string(type)]
                             = std::string(&msg[prompt_start]);
+                    } else if (sscanf(msg,
+                                      "apb:%d:%31[^:]:%n",
+                                      &context,
+                                      type,
+                                      &prompt_start)
+                               == 2)
+                    {
+                        require(this->rc_contexts[context] != nullptr);
+
+                        const char* value = &msg[prompt_start];
+
+                        while (value[0] != '\0') {
+                            const char* sep = strchr(value, '\x1f');
+
+                            if (sep == nullptr) {
+                                this->rc_contexts[context]->add_possibility(
+                                    std::string(type), std::string(value));
+                                break;
+                            }
+                            this->rc_contexts[context]->add_possibility(
+                                std::string(type),
+                                std::string(value, sep - value));
+                            value = sep + 1;
+                        }
+                        possibility_generation += 1;
+                        if (rl_last_func == rl_complete
+                            || rl_last_func == rl_menu_complete)
+                        {
+                            rl_last_func = NULL;
+                        }
                     } else if (sscanf(msg,
                                       "ap:%d:%31[^:]:%n",
                                       &context,
@@ -956,6 +1011,7 @@ readline_curses::start()
 
                         this->rc_contexts[context]->add_possibility(
                             std::string(type), std::string(&msg[prompt_start]));
+                        possibility_generation += 1;
                         if (rl_last_func == rl_complete
                             || rl_last_func == rl_menu_complete)
                         {
@@ -972,10 +1028,12 @@ readline_curses::start()
 
                         this->rc_contexts[context]->rem_possibility(
                             std::string(type), std::string(&msg[prompt_start]));
+                        possibility_generation += 1;
                     } else if (sscanf(msg, "cpre:%d", &context) == 1) {
                         this->rc_contexts[context]->rc_prefixes.clear();
                     } else if (sscanf(msg, "cp:%d:%s", &context, type)) {
                         this->rc_contexts[context]->clear_possibilities(type);
+                        possibility_generation += 1;
                     } else {
                         log_error("unhandled message: %s", msg);
                     }
@@ -1352,6 +1410,55 @@ readline_curses::add_possibility(int context,
     }
 }
 
+void
+readline_curses::add_possibilities(int context,
+                                   const std::string& type,
+                                   const std::vector<std::string>& values)
+{
+    char buffer[1024];
+    int header_len
+        = snprintf(buffer, sizeof(buffer), "apb:%d:%s:", context, type.c_str());
+    size_t used = header_len;
+
+    for (const auto& value : values) {
+        if (value.empty()) {
+            continue;
+        }
+        if (value.length() >= sizeof(buffer) - header_len - 1) {
+            // An oversized value takes the single-item path, which
+            // truncates it to the frame size like it always has.
+            this->add_possibility(context, type, value);
+            continue;
+        }
+        if (used + value.length() + 2 > sizeof(buffer)) {
+            // The child reads into a fixed-size buffer, so flush this
+            // frame and start a new one.
+            buffer[used] = '\0';
+            if (sendstring(
+                    this->rc_command_pipe[RCF_MASTER], buffer, used + 1)
+                == -1)
+            {
+                perror("add_possibilities: write failed");
+                return;
+            }
+            used = header_len;
+        }
+        if (used > (size_t) header_len) {
+            buffer[used++] = '\x1f';
+        }
+        memcpy(&buffer[used], value.c_str(), value.length());
+        used += value.length();
+    }
+    if (used > (size_t) header_len) {
+        buffer[used] = '\0';
+        if (sendstring(this->rc_command_pipe[RCF_MASTER], buffer, used + 1)
+            == -1)
+        {
+            perror("add_possibilities: write failed");
+        }
+    }
+}
+
 void
 readline_curses::rem_possibility(int context,
                                  const std::string& type,
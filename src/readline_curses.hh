@@ -236,6 +236,10 @@ public:
                          const std::string& type,
                          const std::string& value);
 
+    void add_possibilities(int context,
+                           const std::string& type,
+                           const std::vector<std::string>& values);
+
     void add_possibility(int context,
                          const std::string& type,
                          const char* values[])
@@ -260,9 +264,8 @@ public:
                          const std::string& type,
                          const Container<std::string>& values)
     {
-        for (const auto& str : values) {
-            this->add_possibility(context, type, str);
-        }
+        this->add_possibilities(
+            context, type, std::vector<std::string>{values.begin(), values.end()});
     }
 
     void rem_possibility(int context,
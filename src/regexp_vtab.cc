@@ -27,6 +27,9 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <memory>
+#include <unordered_map>
+
 #ifdef __CYGWIN__
 #    include <alloca.h>
 #endif
@@ -43,6 +46,42 @@
 #include "yajlpp/yajlpp.hh"
 #include "yajlpp/yajlpp_def.hh"
 
+/**
+ * Compiled patterns are reused across xFilter() calls since these table
+ * functions are commonly joined against another table, with the same
+ * pattern text passed in for every row of the outer query.  The cache
+ * is thread-local, like the one used by the scalar regexp functions,
+ * so no locking is needed.  Match state stays on the cursor, so two
+ * open cursors can share a compiled pattern safely.
+ */
+static Result<std::shared_ptr<lnav::pcre2pp::code>,
+              lnav::pcre2pp::compile_error>
+compile_pattern(string_fragment pattern)
+{
+    using code_cache_t
+        = std::unordered_map<string_fragment,
+                             std::shared_ptr<lnav::pcre2pp::code>,
+                             frag_hasher>;
+    static thread_local code_cache_t cache;
+
+    auto iter = cache.find(pattern);
+    if (iter == cache.end()) {
+        auto compile_res = lnav::pcre2pp::code::from(pattern);
+
+        if (compile_res.isErr()) {
+            return Err(compile_res.unwrapErr());
+        }
+
+        auto code = compile_res.unwrap().to_shared();
+        auto pair = cache.emplace(
+            string_fragment::from_str(code->get_pattern()), code);
+
+        iter = pair.first;
+    }
+
+    return Ok(iter->second);
+}
+
 enum {
     RC_COL_MATCH_INDEX,
     RC_COL_INDEX,
@@ -236,18 +275,22 @@ rcFilter(sqlite3_vtab_cursor* pVtabCursor,
     pCur->c_content.assign(blob, byte_count);
 
     auto pattern = from_sqlite<string_fragment>()(argc, argv, 1);
-    auto compile_res = lnav::pcre2pp::code::from(pattern);
-    if (compile_res.isErr()) {
-        pVtabCursor->pVtab->zErrMsg
-            = sqlite3_mprintf("Invalid regular expression: %s",
-                              compile_res.unwrapErr().get_message().c_str());
-        return SQLITE_ERROR;
-    }
+    if (pCur->c_pattern == nullptr
+        || !(pattern == pCur->c_pattern->get_pattern()))
+    {
+        auto compile_res = compile_pattern(pattern);
+        if (compile_res.isErr()) {
+            pVtabCursor->pVtab->zErrMsg = sqlite3_mprintf(
+                "Invalid regular expression: %s",
+                compile_res.unwrapErr().get_message().c_str());
+            return SQLITE_ERROR;
+        }
 
-    pCur->c_pattern = compile_res.unwrap().to_shared();
+        pCur->c_pattern = compile_res.unwrap();
+        pCur->c_match_data = pCur->c_pattern->create_match_data();
+    }
 
     pCur->c_index = 0;
-    pCur->c_match_data = pCur->c_pattern->create_match_data();
 
     pCur->c_remaining.clear();
     auto match_res = pCur->c_pattern->capture_from(pCur->c_content)
@@ -483,12 +526,26 @@ rcjFilter(sqlite3_vtab_cursor* pVtabCursor,
     pCur->c_content.assign(blob, byte_count);
 
     auto pattern = from_sqlite<string_fragment>()(argc, argv, 1);
-    auto compile_res = lnav::pcre2pp::code::from(pattern);
-    if (compile_res.isErr()) {
-        pVtabCursor->pVtab->zErrMsg
-            = sqlite3_mprintf("Invalid regular expression: %s",
-                              compile_res.unwrapErr().get_message().c_str());
-        return SQLITE_ERROR;
+    if (pCur->c_pattern == nullptr
+        || !(pattern == pCur->c_pattern->get_pattern()))
+    {
+        auto compile_res = compile_pattern(pattern);
+        if (compile_res.isErr()) {
+            pVtabCursor->pVtab->zErrMsg = sqlite3_mprintf(
+                "Invalid regular expression: %s",
+                compile_res.unwrapErr().get_message().c_str());
+            return SQLITE_ERROR;
+        }
+
+        pCur->c_pattern = compile_res.unwrap();
+        pCur->c_namer
+            = std::make_unique<column_namer>(column_namer::language::JSON);
+        pCur->c_namer->add_column(string_fragment::from_const("__all__"));
+        for (int lpc = 1; lpc <= pCur->c_pattern->get_capture_count(); lpc++) {
+            pCur->c_namer->add_column(string_fragment::from_c_str(
+                pCur->c_pattern->get_name_for_capture(lpc)));
+        }
+        pCur->c_match_data = pCur->c_pattern->create_match_data();
     }
 
     pCur->c_flags_string.clear();
@@ -517,16 +574,6 @@ rcjFilter(sqlite3_vtab_cursor* pVtabCursor,
         }
     }
 
-    pCur->c_pattern = compile_res.unwrap().to_shared();
-    pCur->c_namer
-        = std::make_unique<column_namer>(column_namer::language::JSON);
-    pCur->c_namer->add_column(string_fragment::from_const("__all__"));
-    for (int lpc = 1; lpc <= pCur->c_pattern->get_capture_count(); lpc++) {
-        pCur->c_namer->add_column(string_fragment::from_c_str(
-            pCur->c_pattern->get_name_for_capture(lpc)));
-    }
-
-    pCur->c_match_data = pCur->c_pattern->create_match_data();
     pCur->c_remaining.clear();
     auto match_res = pCur->c_pattern->capture_from(pCur->c_content)
                          .into(pCur->c_match_data)
@@ -30,7 +30,7 @@
 #include "sequence_matcher.hh"
 
 #include "config.h"
-#include "spookyhash/SpookyV2.h"
+#include "xxHash/xxhash.h"
 
 sequence_matcher::sequence_matcher(field_col_t& example)
 {
@@ -63,17 +63,21 @@ sequence_matcher::sequence_matcher(field_col_t& example)
 void
 sequence_matcher::identity(const std::vector<std::string>& values, id_t& id_out)
 {
-    SpookyHash context;
+    XXH3_state_t context;
     int lpc = 0;
 
-    context.Init(0, 0);
+    XXH3_128bits_reset(&context);
     for (std::list<field>::iterator iter = sm_fields.begin();
          iter != sm_fields.end();
          ++iter, lpc++)
     {
         if (iter->sf_type == FT_VARIABLE) {
-            context.Update(values[lpc].c_str(), values[lpc].length() + 1);
+            XXH3_128bits_update(
+                &context, values[lpc].c_str(), values[lpc].length() + 1);
         }
     }
-    context.Final(id_out.out(0), id_out.out(1));
+
+    auto hash = XXH3_128bits_digest(&context);
+    *id_out.out(0) = hash.low64;
+    *id_out.out(1) = hash.high64;
 }
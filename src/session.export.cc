@@ -27,10 +27,15 @@
  * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#include <algorithm>
+
 #include "session.export.hh"
 
+#include <sys/stat.h>
+
 #include "base/injector.hh"
 #include "bound_tags.hh"
+#include "index_cache.hh"
 #include "lnav.hh"
 #include "sqlitepp.client.hh"
 #include "sqlitepp.hh"
@@ -172,8 +177,18 @@ replace_home_dir(std::string path)
     return path;
 }
 
-Result<void, lnav::console::user_message>
-export_to(FILE* file)
+/**
+ * Where a bundle was written and the names of the log files copied into
+ * it, so the restore script can open the copies instead of the original
+ * paths.
+ */
+struct bundle_manifest {
+    std::string bm_dir;
+    std::vector<std::string> bm_names;
+};
+
+static Result<void, lnav::console::user_message>
+export_script(FILE* file, const bundle_manifest* bundle)
 {
     static auto& lnav_db = injector::get<auto_sqlite3&>();
 
@@ -207,6 +222,12 @@ SELECT content_id, format, time_offset FROM lnav_file
     static constexpr const char LOG_DIR_INSERT[] = R"(
 # Set this environment variable to override this value or edit this script.
 ;INSERT OR IGNORE INTO environ (name, value) VALUES ('LOG_DIR_{}', {})
+)";
+
+    static constexpr const char BUNDLE_DIR_INSERT[] = R"(
+# The logs are bundled alongside this script.  Set this environment
+# variable or edit this script if the bundle was unpacked elsewhere.
+;INSERT OR IGNORE INTO environ (name, value) VALUES ('LNAV_BUNDLE_DIR', {})
 )";
 
     static constexpr const char MARK_HEADER[] = R"(
@@ -261,52 +282,62 @@ SELECT content_id, format, time_offset FROM lnav_file
 
     fmt::print(file, FMT_STRING(HEADER), sqlitepp::quote(PACKAGE_VERSION));
 
-    std::map<std::string, std::vector<std::string>> file_containers;
-    std::set<std::string> raw_files;
-    for (const auto& name_pair : lnav_data.ld_active_files.fc_file_names) {
-        const auto& open_opts = name_pair.second;
-
-        if (!open_opts.loo_is_visible || !open_opts.loo_include_in_session
-            || open_opts.loo_temp_file
-            || open_opts.loo_source != logfile_name_source::USER)
-        {
-            continue;
+    if (bundle != nullptr) {
+        fmt::print(file,
+                   FMT_STRING(BUNDLE_DIR_INSERT),
+                   sqlitepp::quote(bundle->bm_dir));
+        for (const auto& name : bundle->bm_names) {
+            fmt::print(file, FMT_STRING(":open $LNAV_BUNDLE_DIR/{}\n"), name);
         }
+        fmt::print(file, FMT_STRING("\n:rebuild\n"));
+    } else {
+        std::map<std::string, std::vector<std::string>> file_containers;
+        std::set<std::string> raw_files;
+        for (const auto& name_pair : lnav_data.ld_active_files.fc_file_names) {
+            const auto& open_opts = name_pair.second;
+
+            if (!open_opts.loo_is_visible || !open_opts.loo_include_in_session
+                || open_opts.loo_temp_file
+                || open_opts.loo_source != logfile_name_source::USER)
+            {
+                continue;
+            }
 
-        auto file_path_str = name_pair.first;
-        auto file_path = ghc::filesystem::path(file_path_str);
-        auto container_path_opt = find_container_dir(file_path);
-        if (container_path_opt) {
-            auto container_parent = container_path_opt.value().parent_path();
-            auto file_container_path
-                = ghc::filesystem::relative(file_path, container_parent)
-                      .string();
-            file_containers[container_parent.string()].push_back(
-                file_container_path);
-        } else {
-            raw_files.insert(file_path_str);
+            auto file_path_str = name_pair.first;
+            auto file_path = ghc::filesystem::path(file_path_str);
+            auto container_path_opt = find_container_dir(file_path);
+            if (container_path_opt) {
+                auto container_parent = container_path_opt.value().parent_path();
+                auto file_container_path
+                    = ghc::filesystem::relative(file_path, container_parent)
+                          .string();
+                file_containers[container_parent.string()].push_back(
+                    file_container_path);
+            } else {
+                raw_files.insert(file_path_str);
+            }
         }
-    }
-    for (const auto& file_path_str : raw_files) {
-        fmt::print(
-            file, FMT_STRING(":open {}\n"), replace_home_dir(file_path_str));
-    }
-    size_t container_index = 0;
-    for (const auto& container_pair : file_containers) {
-        fmt::print(file,
-                   FMT_STRING(LOG_DIR_INSERT),
-                   container_index,
-                   sqlitepp::quote(container_pair.first));
-        for (const auto& file_path_str : container_pair.second) {
+        for (const auto& file_path_str : raw_files) {
+            fmt::print(
+                file, FMT_STRING(":open {}\n"), replace_home_dir(file_path_str));
+        }
+        size_t container_index = 0;
+        for (const auto& container_pair : file_containers) {
             fmt::print(file,
-                       FMT_STRING(":open $LOG_DIR_{}/{}\n"),
+                       FMT_STRING(LOG_DIR_INSERT),
                        container_index,
-                       file_path_str);
+                       sqlitepp::quote(container_pair.first));
+            for (const auto& file_path_str : container_pair.second) {
+                fmt::print(file,
+                           FMT_STRING(":open $LOG_DIR_{}/{}\n"),
+                           container_index,
+                           file_path_str);
+            }
+            container_index += 1;
         }
-        container_index += 1;
-    }
 
-    fmt::print(file, FMT_STRING("\n:rebuild\n"));
+        fmt::print(file, FMT_STRING("\n:rebuild\n"));
+    }
 
     auto mark_count = 0;
     auto each_mark_res
@@ -480,5 +511,93 @@ SELECT content_id, format, time_offset FROM lnav_file
     return Ok();
 }
 
+Result<void, lnav::console::user_message>
+export_to(FILE* file)
+{
+    return export_script(file, nullptr);
+}
+
+Result<void, lnav::console::user_message>
+export_bundle_to(const ghc::filesystem::path& dir)
+{
+    std::error_code ec;
+
+    ghc::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return Err(console::user_message::error(
+                       attr_line_t("unable to create bundle directory: ")
+                           .append(lnav::roles::file(dir.string())))
+                       .with_reason(ec.message()));
+    }
+
+    bundle_manifest manifest;
+    manifest.bm_dir = ghc::filesystem::absolute(dir).string();
+
+    for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+        const auto& loo = lf->get_open_options();
+
+        if (lf->get_format() == nullptr || !loo.loo_is_visible
+            || !loo.loo_include_in_session || loo.loo_temp_file
+            || loo.loo_source != logfile_name_source::USER)
+        {
+            continue;
+        }
+
+        auto src_path = lf->get_path();
+        auto dest_name = src_path.filename().string();
+
+        // Files from different directories can share a name, keep the
+        // copies apart with a counter prefix.
+        if (std::find(manifest.bm_names.begin(),
+                      manifest.bm_names.end(),
+                      dest_name)
+            != manifest.bm_names.end())
+        {
+            dest_name = fmt::format(
+                FMT_STRING("{}.{}"), manifest.bm_names.size(), dest_name);
+        }
+
+        auto dest_path = dir / dest_name;
+        ghc::filesystem::copy_file(
+            src_path,
+            dest_path,
+            ghc::filesystem::copy_options::overwrite_existing,
+            ec);
+        if (ec) {
+            return Err(console::user_message::error(
+                           attr_line_t("unable to copy log file into bundle: ")
+                               .append(lnav::roles::file(src_path.string())))
+                           .with_reason(ec.message()));
+        }
+
+        // Ship the index next to the copy so opening the bundle does not
+        // rescan multi-gigabyte files.  Best effort, a recipient without
+        // the sidecar just pays for the scan.
+        auto sidecar_path = dest_path;
+        sidecar_path += lnav::index_cache::SIDECAR_EXTENSION;
+        lf->write_index_sidecar(sidecar_path);
+
+        manifest.bm_names.emplace_back(std::move(dest_name));
+    }
+
+    if (manifest.bm_names.empty()) {
+        return Err(console::user_message::error(
+            "no loaded log files are eligible for bundling"));
+    }
+
+    auto script_path = dir / "restore-session.lnav";
+    auto_mem<FILE> script(fclose);
+
+    if ((script = fopen(script_path.c_str(), "we")) == nullptr) {
+        return Err(console::user_message::error(
+                       attr_line_t("unable to create bundle script: ")
+                           .append(lnav::roles::file(script_path.string())))
+                       .with_errno_reason());
+    }
+    fchmod(fileno(script.in()), S_IRWXU);
+
+    return export_script(script.in(), &manifest);
+}
+
 }  // namespace session
 }  // namespace lnav
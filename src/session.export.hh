@@ -31,12 +31,23 @@
 #define lnav_session_export_hh
 
 #include "base/lnav.console.hh"
+#include "ghc/filesystem.hpp"
 
 namespace lnav {
 namespace session {
 
 Result<void, lnav::console::user_message> export_to(FILE* file);
 
+/**
+ * Write a self-contained session bundle to the given directory: a copy of
+ * each user-opened log file, a pre-built index sidecar next to each copy,
+ * and a "restore-session.lnav" script that reopens the files and restores
+ * marks, filters, and other view state.  The directory can be compressed
+ * and shared as-is, lnav opens archives directly.
+ */
+Result<void, lnav::console::user_message> export_bundle_to(
+    const ghc::filesystem::path& dir);
+
 }
 }  // namespace lnav
 
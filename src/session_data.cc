@@ -30,6 +30,7 @@
  */
 
 #include <algorithm>
+#include <set>
 #include <utility>
 
 #include "session_data.hh"
@@ -77,6 +78,17 @@ CREATE TABLE IF NOT EXISTS bookmarks (
     PRIMARY KEY (log_time, log_format, log_hash, session_time)
 );
 
+CREATE TABLE IF NOT EXISTS bookmark_runs (
+    log_time datetime,
+    log_format varchar(64),
+    log_hash varchar(128),
+    session_time integer,
+    run_length integer,
+    access_time datetime DEFAULT CURRENT_TIMESTAMP,
+
+    PRIMARY KEY (log_time, log_format, log_hash, session_time)
+);
+
 CREATE TABLE IF NOT EXISTS time_offset (
     log_time datetime,
     log_format varchar(64),
@@ -117,6 +129,11 @@ static const char* BOOKMARK_LRU_STMT
       "  (SELECT access_time FROM bookmarks "
       "   ORDER BY access_time DESC LIMIT 1 OFFSET 50000)";
 
+static const char* BOOKMARK_RUN_LRU_STMT
+    = "DELETE FROM bookmark_runs WHERE access_time <= "
+      "  (SELECT access_time FROM bookmark_runs "
+      "   ORDER BY access_time DESC LIMIT 1 OFFSET 50000)";
+
 static const char* NETLOC_LRU_STMT
     = "DELETE FROM recent_netlocs WHERE access_time <= "
       "  (SELECT access_time FROM bookmarks "
@@ -131,8 +148,28 @@ static const size_t MAX_SESSIONS = 8;
 static const size_t MAX_SESSION_FILE_COUNT = 256;
 
 static std::vector<content_line_t> marked_session_lines;
+/**
+ * Plain user marks are persisted as runs of consecutive lines instead of
+ * one row per line, so auto-marking a pattern across millions of lines
+ * costs one row per run.  Each entry is the first content line of a run
+ * that was written to the bookmark_runs table plus its length.
+ */
+static std::vector<std::pair<content_line_t, uint64_t>> marked_session_runs;
 static std::vector<content_line_t> offset_session_lines;
 
+/**
+ * The files whose bookmarks have already been restored for the session
+ * being loaded.  Restoring a mark means scanning and hashing every line
+ * with a matching timestamp, so it is only done once per file and is
+ * deferred until the file has been indexed instead of being done up
+ * front for every file in the session.
+ */
+static std::set<std::string> bookmark_restored_files;
+static int64_t bookmark_restore_session_time = -1;
+
+/** The fingerprint of the session state written by the last save. */
+static std::string last_session_fingerprint;
+
 static bool
 bind_line(sqlite3* db,
           sqlite3_stmt* stmt,
@@ -378,6 +415,32 @@ load_time_bookmarks()
     logfile_sub_source::iterator file_iter;
     bool reload_needed = false;
     auto_mem<char, sqlite3_free> errmsg;
+    static bool db_prepped = false;
+
+    if (bookmark_restore_session_time != lnav_data.ld_session_load_time) {
+        bookmark_restore_session_time = lnav_data.ld_session_load_time;
+        bookmark_restored_files.clear();
+    }
+
+    bool needs_restore = false;
+    for (file_iter = lnav_data.ld_log_source.begin();
+         file_iter != lnav_data.ld_log_source.end();
+         ++file_iter)
+    {
+        auto lf = (*file_iter)->get_file();
+
+        if (lf == nullptr) {
+            continue;
+        }
+        if (bookmark_restored_files.count(lf->get_filename()) == 0) {
+            needs_restore = true;
+            break;
+        }
+    }
+
+    if (!needs_restore && db_prepped) {
+        return;
+    }
 
     log_info("loading bookmark db: %s", db_path.c_str());
 
@@ -423,6 +486,11 @@ load_time_bookmarks()
                 [](prepared_stmt::end_of_rows) { return true; });
         }
     }
+    db_prepped = true;
+
+    if (!needs_restore) {
+        return;
+    }
 
     if (sqlite3_prepare_v2(
             db.in(),
@@ -452,6 +520,10 @@ load_time_bookmarks()
             continue;
         }
 
+        if (bookmark_restored_files.count(lf->get_filename()) > 0) {
+            continue;
+        }
+
         base_content_line = lss.get_file_base_content_line(file_iter);
 
         auto low_line_iter = lf->begin();
@@ -543,7 +615,6 @@ load_time_bookmarks()
                                   .to_string();
 
                         if (line_hash == log_hash) {
-                            auto& bm_meta = lf->get_bookmark_metadata();
                             auto line_number = static_cast<uint32_t>(
                                 std::distance(lf->begin(), line_iter));
                             content_line_t line_cl = content_line_t(
@@ -553,13 +624,15 @@ load_time_bookmarks()
                             if (part_name != nullptr && part_name[0] != '\0') {
                                 lss.set_user_mark(&textview_curses::BM_META,
                                                   line_cl);
-                                bm_meta[line_number].bm_name = part_name;
+                                lss.get_bookmark_metadata(line_cl).bm_name
+                                    = part_name;
                                 meta = true;
                             }
                             if (comment != nullptr && comment[0] != '\0') {
                                 lss.set_user_mark(&textview_curses::BM_META,
                                                   line_cl);
-                                bm_meta[line_number].bm_comment = comment;
+                                lss.get_bookmark_metadata(line_cl).bm_comment
+                                    = comment;
                                 meta = true;
                             }
                             if (tags != nullptr && tags[0] != '\0') {
@@ -586,7 +659,8 @@ load_time_bookmarks()
                                         }
                                         bookmark_metadata::KNOWN_TAGS.insert(
                                             elem->u.string);
-                                        bm_meta[line_number].add_tag(
+                                        lss.get_bookmark_metadata(line_cl)
+                                            .add_tag(
                                             elem->u.string);
                                     }
                                 }
@@ -619,6 +693,176 @@ load_time_bookmarks()
         sqlite3_reset(stmt.in());
     }
 
+    // The bookmark_runs table is created on save, so it may be missing
+    // from an older metadata DB; that just means there are no runs to
+    // load.
+    if (sqlite3_prepare_v2(
+            db.in(),
+            "SELECT log_time, log_hash, session_time, run_length, "
+            "session_time=? as same_session FROM bookmark_runs WHERE "
+            " log_time between ? and ? and log_format = ? "
+            " ORDER BY same_session DESC, session_time DESC",
+            -1,
+            stmt.out(),
+            nullptr)
+        != SQLITE_OK)
+    {
+        log_info("could not prepare bookmark_runs select statement -- %s",
+                 sqlite3_errmsg(db));
+    } else {
+        for (file_iter = lnav_data.ld_log_source.begin();
+             file_iter != lnav_data.ld_log_source.end();
+             ++file_iter)
+        {
+            auto lf = (*file_iter)->get_file();
+            content_line_t base_content_line;
+
+            if (lf == nullptr) {
+                continue;
+            }
+
+            if (bookmark_restored_files.count(lf->get_filename()) > 0) {
+                continue;
+            }
+
+            base_content_line = lss.get_file_base_content_line(file_iter);
+
+            auto low_line_iter = lf->begin();
+            auto high_line_iter = lf->end();
+
+            --high_line_iter;
+
+            if (bind_values(stmt.in(),
+                            lnav_data.ld_session_load_time,
+                            lf->original_line_time(low_line_iter),
+                            lf->original_line_time(high_line_iter),
+                            lf->get_format()->get_name())
+                != SQLITE_OK)
+            {
+                return;
+            }
+
+            date_time_scanner dts;
+            bool done = false;
+            int64_t last_mark_time = -1;
+
+            while (!done) {
+                int rc = sqlite3_step(stmt.in());
+
+                switch (rc) {
+                    case SQLITE_OK:
+                    case SQLITE_DONE:
+                        done = true;
+                        break;
+
+                    case SQLITE_ROW: {
+                        const char* log_time
+                            = (const char*) sqlite3_column_text(stmt.in(), 0);
+                        const char* log_hash
+                            = (const char*) sqlite3_column_text(stmt.in(), 1);
+                        int64_t mark_time
+                            = sqlite3_column_int64(stmt.in(), 2);
+                        int64_t run_length
+                            = sqlite3_column_int64(stmt.in(), 3);
+                        struct timeval log_tv;
+                        struct exttm log_tm;
+
+                        if (last_mark_time == -1) {
+                            last_mark_time = mark_time;
+                        } else if (last_mark_time != mark_time) {
+                            done = true;
+                            continue;
+                        }
+
+                        if (run_length <= 0) {
+                            continue;
+                        }
+
+                        if (!dts.scan(log_time,
+                                      strlen(log_time),
+                                      nullptr,
+                                      &log_tm,
+                                      log_tv))
+                        {
+                            continue;
+                        }
+
+                        auto line_iter
+                            = lower_bound(lf->begin(), lf->end(), log_tv);
+                        while (line_iter != lf->end()) {
+                            struct timeval line_tv = line_iter->get_timeval();
+
+                            if ((line_tv.tv_sec != log_tv.tv_sec)
+                                || (line_tv.tv_usec != log_tv.tv_usec))
+                            {
+                                break;
+                            }
+
+                            auto cl = content_line_t(
+                                std::distance(lf->begin(), line_iter));
+                            auto read_result = lf->read_line(line_iter);
+
+                            if (read_result.isErr()) {
+                                break;
+                            }
+
+                            auto sbr = read_result.unwrap();
+
+                            auto line_hash
+                                = hasher()
+                                      .update(sbr.get_data(), sbr.length())
+                                      .update(cl)
+                                      .to_string();
+
+                            // Only the first line of the run is verified;
+                            // the following lines are marked on faith,
+                            // which keeps restore proportional to the
+                            // number of runs.
+                            if (line_hash == log_hash) {
+                                auto line_number = static_cast<uint32_t>(
+                                    std::distance(lf->begin(), line_iter));
+                                auto lines_left = static_cast<int64_t>(
+                                    lf->size() - line_number);
+                                auto actual_length
+                                    = std::min(run_length, lines_left);
+
+                                for (int64_t lpc = 0; lpc < actual_length;
+                                     lpc++)
+                                {
+                                    lss.set_user_mark(
+                                        &textview_curses::BM_USER,
+                                        content_line_t(base_content_line
+                                                       + line_number + lpc));
+                                }
+                                marked_session_runs.emplace_back(
+                                    content_line_t(base_content_line
+                                                   + line_number),
+                                    (uint64_t) actual_length);
+                                reload_needed = true;
+                                break;
+                            }
+
+                            ++line_iter;
+                        }
+                        break;
+                    }
+
+                    default: {
+                        const char* errmsg;
+
+                        errmsg = sqlite3_errmsg(lnav_data.ld_db);
+                        log_error("bookmark_runs select error: code %d -- %s",
+                                  rc,
+                                  errmsg);
+                        done = true;
+                    } break;
+                }
+            }
+
+            sqlite3_reset(stmt.in());
+        }
+    }
+
     if (sqlite3_prepare_v2(
             db.in(),
             "SELECT *,session_time=? as same_session FROM time_offset WHERE "
@@ -645,6 +889,10 @@ load_time_bookmarks()
             continue;
         }
 
+        if (bookmark_restored_files.count(lf->get_filename()) > 0) {
+            continue;
+        }
+
         lss.find(lf->get_filename().c_str(), base_content_line);
 
         auto low_line_iter = lf->begin();
@@ -748,6 +996,8 @@ load_time_bookmarks()
         }
 
         sqlite3_reset(stmt.in());
+
+        bookmark_restored_files.insert(lf->get_filename());
     }
 
     if (reload_needed) {
@@ -904,7 +1154,11 @@ static const struct json_path_container view_info_handlers = {
 void
 load_session()
 {
-    load_time_bookmarks();
+    // The bookmark replay is deferred to load_time_bookmarks() calls made
+    // as files finish indexing so the view states restored below are
+    // usable right away.
+    bookmark_restored_files.clear();
+    bookmark_restore_session_time = -1;
     scan_sessions() | [](const auto pair) {
         yajl_handle handle;
         auto_fd fd;
@@ -918,8 +1172,6 @@ load_session()
         ypc.with_obj(session_data);
         handle = yajl_alloc(&ypc.ypc_callbacks, nullptr, &ypc);
 
-        load_time_bookmarks();
-
         if ((fd = lnav::filesystem::openp(view_info_path, O_RDONLY)) < 0) {
             perror("cannot open session file");
         } else {
@@ -981,7 +1233,8 @@ yajl_writer(void* context, const char* str, size_t len)
 static void
 save_user_bookmarks(sqlite3* db,
                     sqlite3_stmt* stmt,
-                    bookmark_vector<content_line_t>& user_marks)
+                    bookmark_vector<content_line_t>& user_marks,
+                    bool skip_plain)
 {
     logfile_sub_source& lss = lnav_data.ld_log_source;
     bookmark_vector<content_line_t>::iterator iter;
@@ -989,6 +1242,11 @@ save_user_bookmarks(sqlite3* db,
     for (iter = user_marks.begin(); iter != user_marks.end(); ++iter) {
         content_line_t cl = *iter;
         auto line_meta_opt = lss.find_bookmark_metadata(cl);
+
+        if (skip_plain && !line_meta_opt) {
+            // Persisted as part of a run in the bookmark_runs table.
+            continue;
+        }
         if (!bind_line(db, stmt, cl, lnav_data.ld_session_time)) {
             continue;
         }
@@ -1067,6 +1325,111 @@ save_user_bookmarks(sqlite3* db,
     }
 }
 
+/**
+ * Persist plain user marks as runs of consecutive lines.  Only the first
+ * line of a run is read and hashed; the row just records how many lines
+ * follow it, so a dense mark set costs one row per run instead of one
+ * row per line.
+ */
+static void
+save_user_bookmark_runs(sqlite3* db,
+                        bookmark_vector<content_line_t>& user_marks)
+{
+    logfile_sub_source& lss = lnav_data.ld_log_source;
+    auto_mem<sqlite3_stmt> stmt(sqlite3_finalize);
+
+    if (sqlite3_prepare_v2(db,
+                           "DELETE FROM bookmark_runs WHERE "
+                           " log_time = ? and log_format = ? and log_hash = ? "
+                           " and session_time = ?",
+                           -1,
+                           stmt.out(),
+                           nullptr)
+        != SQLITE_OK)
+    {
+        log_error("could not prepare bookmark_runs delete statement -- %s",
+                  sqlite3_errmsg(db));
+        return;
+    }
+
+    for (const auto& run : marked_session_runs) {
+        if (!bind_line(db, stmt.in(), run.first, lnav_data.ld_session_time)) {
+            continue;
+        }
+
+        if (sqlite3_step(stmt.in()) != SQLITE_DONE) {
+            log_error("could not execute bookmark_runs delete statement -- %s",
+                      sqlite3_errmsg(db));
+            return;
+        }
+
+        sqlite3_reset(stmt.in());
+    }
+
+    marked_session_runs.clear();
+
+    if (sqlite3_prepare_v2(db,
+                           "REPLACE INTO bookmark_runs"
+                           " (log_time, log_format, log_hash, session_time, "
+                           "run_length)"
+                           " VALUES (?, ?, ?, ?, ?)",
+                           -1,
+                           stmt.out(),
+                           nullptr)
+        != SQLITE_OK)
+    {
+        log_error("could not prepare bookmark_runs replace statement -- %s",
+                  sqlite3_errmsg(db));
+        return;
+    }
+
+    auto iter = user_marks.begin();
+    while (iter != user_marks.end()) {
+        auto start_cl = *iter;
+        uint64_t run_length = 0;
+
+        // A run covers consecutive plain-marked lines within a single
+        // file; lines with metadata are persisted individually so their
+        // part names/comments/tags stay attached to the right line.
+        while (iter != user_marks.end()
+               && *iter == content_line_t(start_cl + run_length)
+               && (*iter / logfile_sub_source::MAX_LINES_PER_FILE
+                   == start_cl / logfile_sub_source::MAX_LINES_PER_FILE)
+               && !lss.find_bookmark_metadata(*iter))
+        {
+            run_length += 1;
+            ++iter;
+        }
+
+        if (run_length == 0) {
+            ++iter;
+            continue;
+        }
+
+        if (!bind_line(db, stmt.in(), start_cl, lnav_data.ld_session_time)) {
+            continue;
+        }
+
+        if (sqlite3_bind_int64(stmt.in(), 5, (int64_t) run_length)
+            != SQLITE_OK)
+        {
+            log_error("could not bind run length -- %s", sqlite3_errmsg(db));
+            return;
+        }
+
+        if (sqlite3_step(stmt.in()) != SQLITE_DONE) {
+            log_error(
+                "could not execute bookmark_runs replace statement -- %s",
+                sqlite3_errmsg(db));
+            return;
+        }
+
+        sqlite3_reset(stmt.in());
+
+        marked_session_runs.emplace_back(start_cl, run_length);
+    }
+}
+
 static void
 save_time_bookmarks()
 {
@@ -1221,8 +1584,10 @@ save_time_bookmarks()
         }
     }
 
-    save_user_bookmarks(db.in(), stmt.in(), bm[&textview_curses::BM_USER]);
-    save_user_bookmarks(db.in(), stmt.in(), bm[&textview_curses::BM_META]);
+    save_user_bookmarks(db.in(), stmt.in(), bm[&textview_curses::BM_USER], true);
+    save_user_bookmarks(
+        db.in(), stmt.in(), bm[&textview_curses::BM_META], false);
+    save_user_bookmark_runs(db.in(), bm[&textview_curses::BM_USER]);
 
     if (sqlite3_prepare_v2(db.in(),
                            "DELETE FROM time_offset WHERE "
@@ -1371,6 +1736,14 @@ save_time_bookmarks()
         return;
     }
 
+    if (sqlite3_exec(
+            db.in(), BOOKMARK_RUN_LRU_STMT, nullptr, nullptr, errmsg.out())
+        != SQLITE_OK)
+    {
+        log_error("unable to delete old bookmark runs -- %s", errmsg.in());
+        return;
+    }
+
     if (sqlite3_exec(db.in(), NETLOC_LRU_STMT, nullptr, nullptr, errmsg.out())
         != SQLITE_OK)
     {
@@ -1572,6 +1945,81 @@ save_session_with_id(const std::string& session_id)
     }
 }
 
+/**
+ * Compute a fingerprint of the state that save_session() writes out.  The
+ * fingerprint covers the marks, bookmark metadata, view states, and
+ * filters, but not the content of the lines behind the marks, so it is
+ * cheap enough to evaluate on the periodic checkpoints done by the main
+ * loop.
+ */
+static std::string
+compute_session_fingerprint()
+{
+    logfile_sub_source& lss = lnav_data.ld_log_source;
+    auto& bm = lss.get_user_bookmarks();
+    struct timeval tv;
+    hasher h;
+
+    h.update((int64_t) lnav_data.ld_session_time);
+    h.update((int64_t) lss.is_time_offset_enabled());
+    if (lss.get_min_log_time(tv)) {
+        h.update((int64_t) tv.tv_sec).update((int64_t) tv.tv_usec);
+    }
+    if (lss.get_max_log_time(tv)) {
+        h.update((int64_t) tv.tv_sec).update((int64_t) tv.tv_usec);
+    }
+    h.update(lss.get_sql_marker_text());
+    for (int lpc = 0; lpc < LNV__MAX; lpc++) {
+        textview_curses& tc = lnav_data.ld_views[lpc];
+
+        h.update((int64_t) tc.get_top());
+        h.update(tc.get_current_search());
+        h.update((int64_t) tc.get_word_wrap());
+
+        for (const auto& hl : tc.get_highlights()) {
+            if (hl.first.first != highlight_source_t::INTERACTIVE) {
+                continue;
+            }
+            h.update(hl.first.second);
+        }
+
+        auto* tss = tc.get_sub_source();
+        if (tss == nullptr) {
+            continue;
+        }
+        h.update((int64_t) tss->tss_apply_filters);
+        for (const auto& filter : tss->get_filters()) {
+            h.update(filter->to_command());
+            h.update((int64_t) filter->is_enabled());
+        }
+    }
+    for (auto cl : bm[&textview_curses::BM_USER]) {
+        h.update((int64_t) cl);
+    }
+    for (auto cl : bm[&textview_curses::BM_META]) {
+        h.update((int64_t) cl);
+
+        auto line_meta_opt = lss.find_bookmark_metadata(cl);
+        if (!line_meta_opt) {
+            continue;
+        }
+        const auto& line_meta = *(line_meta_opt.value());
+        h.update(line_meta.bm_name);
+        h.update(line_meta.bm_comment);
+        for (const auto& tag : line_meta.bm_tags) {
+            h.update(tag);
+        }
+    }
+    for (const auto& lf : lnav_data.ld_active_files.fc_files) {
+        auto ld_opt = lss.find_data(lf);
+
+        h.update(lf->get_filename());
+        h.update((int64_t) (!ld_opt || ld_opt.value()->ld_visible));
+    }
+
+    return h.to_string();
+}
+
 void
 save_session()
 {
@@ -1580,6 +2028,12 @@ save_session()
         return;
     }
 
+    auto fingerprint = compute_session_fingerprint();
+    if (fingerprint == last_session_fingerprint) {
+        log_debug("session state unchanged, skipping save");
+        return;
+    }
+
     log_debug("BEGIN save_session");
     save_time_bookmarks();
 
@@ -1591,6 +2045,7 @@ save_session()
         }
         save_session_with_id(pair.first);
     }
+    last_session_fingerprint = fingerprint;
     log_debug("END save_session");
 }
 
@@ -1622,6 +2077,7 @@ reset_session()
     }
 
     lnav_data.ld_log_source.set_marked_only(false);
+    lnav_data.ld_log_source.set_duplicates_hidden(false);
     lnav_data.ld_log_source.clear_min_max_log_times();
     lnav_data.ld_log_source.set_min_log_level(LEVEL_UNKNOWN);
     lnav_data.ld_log_source.set_sql_filter("", nullptr);
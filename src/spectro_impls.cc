@@ -450,6 +450,26 @@ db_spectro_value_source::update_stats()
     this->dsvs_stats.lvs_count = dls.dls_rows.size();
 }
 
+nonstd::optional<double>
+db_spectro_value_source::cell_value(const db_label_source& dls,
+                                    vis_line_t row) const
+{
+    const auto& cols = dls.dls_rows[row];
+    auto col = this->dsvs_column_index.value();
+    auto retval = cols.number_at(col);
+
+    if (!retval) {
+        // Graphable text columns do not have a typed value, fall back to
+        // parsing the display string.
+        auto scan_res = scn::scan_value<double>(scn::string_view{cols[col]});
+
+        if (scan_res) {
+            retval = scan_res.value();
+        }
+    }
+    return retval;
+}
+
 void
 db_spectro_value_source::spectro_bounds(spectrogram_bounds& sb_out)
 {
@@ -478,11 +498,10 @@ db_spectro_value_source::spectro_row(spectrogram_request& sr,
         = dls.row_for_time({sr.sr_end_time, 0}).value_or(dls.dls_rows.size());
 
     for (auto lpc = begin_row; lpc < end_row; ++lpc) {
-        auto scan_res = scn::scan_value<double>(scn::string_view{
-            dls.dls_rows[lpc][this->dsvs_column_index.value()]});
+        auto cell_num = this->cell_value(dls, lpc);
 
-        if (scan_res) {
-            row_out.add_value(sr, scan_res.value(), false);
+        if (cell_num) {
+            row_out.add_value(sr, cell_num.value(), false);
         }
     }
 
@@ -500,12 +519,11 @@ db_spectro_value_source::spectro_row(spectrogram_request& sr,
                            .value_or(dls.dls_rows.size());
 
         for (auto lpc = begin_row; lpc < end_row; ++lpc) {
-            auto scan_res = scn::scan_value<double>(scn::string_view{
-                dls.dls_rows[lpc][this->dsvs_column_index.value()]});
-            if (!scan_res) {
+            auto cell_num = this->cell_value(dls, lpc);
+            if (!cell_num) {
                 continue;
             }
-            auto value = scan_res.value();
+            auto value = cell_num.value();
             if ((range_min == value)
                 || (range_min < value && value < range_max))
             {
@@ -33,6 +33,8 @@
 #include "log_format.hh"
 #include "spectro_source.hh"
 
+class db_label_source;
+
 class log_spectro_value_source : public spectrogram_value_source {
 public:
     log_spectro_value_source(intern_string_t colname);
@@ -76,6 +78,9 @@ public:
     {
     }
 
+    nonstd::optional<double> cell_value(const db_label_source& dls,
+                                        vis_line_t row) const;
+
     std::string dsvs_colname;
     logline_value_stats dsvs_stats;
     time_t dsvs_begin_time{0};
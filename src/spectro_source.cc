@@ -491,10 +491,43 @@ spectrogram_source::cache_bounds()
 
     this->ss_value_source->spectro_bounds(sb);
 
+    if (this->ss_granularity != this->ss_cached_granularity) {
+        // The cached rows were computed for a different time slice, so
+        // their keys and contents no longer line up with the rows that
+        // will be requested.
+        this->ss_row_cache.clear();
+        this->ss_cached_granularity = this->ss_granularity;
+    }
+
     if (sb.sb_count == this->ss_cached_bounds.sb_count) {
         return;
     }
 
+    const auto& old_sb = this->ss_cached_bounds;
+    if (old_sb.sb_count > 0 && sb.sb_count > old_sb.sb_count
+        && sb.sb_begin_time == old_sb.sb_begin_time
+        && sb.sb_min_value_out == old_sb.sb_min_value_out
+        && sb.sb_max_value_out == old_sb.sb_max_value_out)
+    {
+        // Data was appended without disturbing the value range, so only
+        // the rows at or past the old end of the data can have changed.
+        // Everything before that is composed from the cache as-is.
+        auto stale_begin
+            = rounddown(old_sb.sb_end_time, this->ss_granularity);
+
+        for (auto iter = this->ss_row_cache.begin();
+             iter != this->ss_row_cache.end();)
+        {
+            if (iter->first >= stale_begin) {
+                iter = this->ss_row_cache.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    } else {
+        this->ss_row_cache.clear();
+    }
+
     this->ss_cached_bounds = sb;
 
     if (sb.sb_count == 0) {
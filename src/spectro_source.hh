@@ -178,6 +178,7 @@ public:
     exec_context* ss_exec_context;
     std::unique_ptr<text_sub_source> ss_details_source;
     int ss_granularity{60};
+    int ss_cached_granularity{-1};
     spectrogram_value_source* ss_value_source{nullptr};
     spectrogram_bounds ss_cached_bounds;
     spectrogram_thresholds ss_cached_thresholds;
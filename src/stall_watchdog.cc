@@ -0,0 +1,203 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "stall_watchdog.hh"
+
+#include <chrono>
+
+#include "base/lnav_log.hh"
+#include "config.h"
+#include "fmt/format.h"
+#include "perf_counters.hh"
+
+namespace lnav {
+namespace stalls {
+
+const char* const STAGE_INPUT = "input";
+const char* const STAGE_IO = "io";
+const char* const STAGE_INDEXING = "indexing";
+const char* const STAGE_SQL = "sql";
+const char* const STAGE_RENDER = "render";
+const char* const STAGE_POLL = "poll";
+const char* const STAGE_OTHER = "other";
+
+/** An iteration is a stall once it has been busy for this long. */
+static constexpr uint64_t STALL_THRESHOLD_US = 250 * 1000;
+/** Only the most recent stalls are kept for the lnav_stalls table. */
+static constexpr size_t MAX_RECORDS = 32;
+
+struct stage_slot {
+    const char* ss_name;
+    uint64_t ss_duration_us;
+};
+
+static bool iteration_active = false;
+static std::chrono::steady_clock::time_point iteration_start;
+static const char* current_stage = nullptr;
+static std::chrono::steady_clock::time_point current_stage_start;
+static std::vector<stage_slot> stage_accum;
+static std::vector<stall_record> stall_records;
+
+/**
+ * Charge the time since the last stage switch to the current stage.  The
+ * handful of stage names are string literals, so slots are matched by
+ * pointer.
+ */
+static void
+attribute_to_current(std::chrono::steady_clock::time_point now)
+{
+    if (current_stage == nullptr || !iteration_active) {
+        return;
+    }
+
+    auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                          now - current_stage_start)
+                          .count();
+
+    for (auto& slot : stage_accum) {
+        if (slot.ss_name == current_stage) {
+            slot.ss_duration_us += elapsed_us;
+            return;
+        }
+    }
+    stage_accum.push_back(stage_slot{current_stage, (uint64_t) elapsed_us});
+}
+
+stage_guard::stage_guard(const char* name)
+{
+    auto now = std::chrono::steady_clock::now();
+
+    attribute_to_current(now);
+    this->sg_prev_stage = current_stage;
+    current_stage = name;
+    current_stage_start = now;
+}
+
+stage_guard::~stage_guard()
+{
+    auto now = std::chrono::steady_clock::now();
+
+    attribute_to_current(now);
+    current_stage = this->sg_prev_stage;
+    current_stage_start = now;
+}
+
+void
+begin_iteration()
+{
+    iteration_active = true;
+    iteration_start = std::chrono::steady_clock::now();
+    current_stage = nullptr;
+    stage_accum.clear();
+}
+
+void
+end_iteration()
+{
+    if (!iteration_active) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+
+    attribute_to_current(now);
+    iteration_active = false;
+
+    uint64_t total_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                            now - iteration_start)
+                            .count();
+    uint64_t staged_us = 0;
+    uint64_t idle_us = 0;
+
+    for (const auto& slot : stage_accum) {
+        if (slot.ss_name == STAGE_POLL) {
+            idle_us += slot.ss_duration_us;
+        } else {
+            staged_us += slot.ss_duration_us;
+        }
+    }
+
+    auto busy_us = total_us > idle_us ? total_us - idle_us : 0;
+    if (busy_us < STALL_THRESHOLD_US) {
+        return;
+    }
+
+    // Anything not under a stage_guard shows up as "other" so a stall in
+    // unmarked code is still visible instead of vanishing.
+    if (busy_us > staged_us) {
+        stage_accum.push_back(stage_slot{STAGE_OTHER, busy_us - staged_us});
+    }
+
+    const stage_slot* worst = nullptr;
+    std::string breakdown;
+
+    for (const auto& slot : stage_accum) {
+        if (slot.ss_name == STAGE_POLL) {
+            continue;
+        }
+        if (worst == nullptr || slot.ss_duration_us > worst->ss_duration_us) {
+            worst = &slot;
+        }
+        if (!breakdown.empty()) {
+            breakdown.append("; ");
+        }
+        breakdown.append(fmt::format(FMT_STRING("{}={}.{:03}s"),
+                                     slot.ss_name,
+                                     slot.ss_duration_us / 1000000,
+                                     (slot.ss_duration_us % 1000000) / 1000));
+    }
+
+    log_warning("main loop stalled for %llu.%03llus in '%s' stage (%s)",
+                (unsigned long long) (busy_us / 1000000),
+                (unsigned long long) ((busy_us % 1000000) / 1000),
+                worst->ss_name,
+                breakdown.c_str());
+    lnav::perf::count(lnav::perf::counter_id::LOOP_STALLS);
+
+    stall_record rec;
+
+    gettimeofday(&rec.st_time, nullptr);
+    rec.st_duration_us = busy_us;
+    rec.st_stage = worst->ss_name;
+    rec.st_stage_duration_us = worst->ss_duration_us;
+    rec.st_breakdown = std::move(breakdown);
+    stall_records.emplace_back(std::move(rec));
+    if (stall_records.size() > MAX_RECORDS) {
+        stall_records.erase(stall_records.begin());
+    }
+}
+
+const std::vector<stall_record>&
+get_records()
+{
+    return stall_records;
+}
+
+}  // namespace stalls
+}  // namespace lnav
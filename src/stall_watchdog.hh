@@ -0,0 +1,122 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file stall_watchdog.hh
+ */
+
+#ifndef lnav_stall_watchdog_hh
+#define lnav_stall_watchdog_hh
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+#include <sys/time.h>
+
+namespace lnav {
+namespace stalls {
+
+/**
+ * A latency watchdog for the main event loop.  Each iteration of the loop
+ * is timed and the time is attributed to named stages (indexing, sql,
+ * render, ...) by stage_guard objects placed around the phases of an
+ * iteration.  When an iteration spends more than STALL_THRESHOLD busy, a
+ * record of which stage ran long is written to the lnav_log ring buffer
+ * and kept for the lnav_stalls table, so a stall in the field can be
+ * diagnosed after the fact.
+ *
+ * All of this state belongs to the main thread; worker threads should not
+ * create stage_guards.
+ */
+
+/** Stage names for the phases of a main loop iteration. */
+extern const char* const STAGE_INPUT;
+extern const char* const STAGE_IO;
+extern const char* const STAGE_INDEXING;
+extern const char* const STAGE_SQL;
+extern const char* const STAGE_RENDER;
+/**
+ * Time spent waiting in poll() is idle, not work, so it is attributed
+ * to this stage and excluded from the stall check.
+ */
+extern const char* const STAGE_POLL;
+/** Iteration time not covered by any stage_guard. */
+extern const char* const STAGE_OTHER;
+
+/** A main loop iteration that blew through the latency budget. */
+struct stall_record {
+    /** The wall-clock time the stall was detected. */
+    struct timeval st_time;
+    /** The busy time of the iteration, excluding poll(), in microseconds. */
+    uint64_t st_duration_us;
+    /** The stage that consumed the most time. */
+    const char* st_stage;
+    /** The time spent in that stage, in microseconds. */
+    uint64_t st_stage_duration_us;
+    /** Per-stage timings for the whole iteration, for display. */
+    std::string st_breakdown;
+};
+
+/**
+ * Attributes the elapsed time of a scope to the given stage.  Guards can
+ * nest; time spent in an inner guard is charged to the inner stage only.
+ */
+class stage_guard {
+public:
+    explicit stage_guard(const char* name);
+
+    stage_guard(const stage_guard&) = delete;
+    stage_guard& operator=(const stage_guard&) = delete;
+
+    ~stage_guard();
+
+private:
+    const char* sg_prev_stage;
+};
+
+/** Called at the top of a main loop iteration to reset the stage clocks. */
+void begin_iteration();
+
+/**
+ * Called at the bottom of a main loop iteration.  If the busy time of the
+ * iteration exceeded the latency budget, the slowest stage is logged and
+ * a stall_record is appended for the lnav_stalls table.
+ */
+void end_iteration();
+
+/**
+ * @return The most recent stall records, oldest first.  Only a bounded
+ * number are kept; the loop.stalls counter in lnav_perf has the full
+ * count.  Main thread only.
+ */
+const std::vector<stall_record>& get_records();
+
+}  // namespace stalls
+}  // namespace lnav
+
+#endif
@@ -0,0 +1,108 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "base/injector.bind.hh"
+#include "config.h"
+#include "sql_util.hh"
+#include "stall_watchdog.hh"
+#include "vtab_module.hh"
+
+struct lnav_stalls : public tvt_iterator_cursor<lnav_stalls> {
+    struct stall_row {
+        std::string sr_time;
+        int64_t sr_duration_us;
+        const char* sr_stage;
+        int64_t sr_stage_duration_us;
+        std::string sr_breakdown;
+    };
+
+    using iterator = std::vector<stall_row>::iterator;
+
+    static constexpr const char* NAME = "lnav_stalls";
+    static constexpr const char* CREATE_STMT = R"(
+-- Main loop iterations that ran long, for diagnosing UI stalls.
+CREATE TABLE lnav_stalls (
+    begin_time        TEXT,     -- When the stall was detected.
+    duration_us       INTEGER,  -- The busy time of the iteration.
+    stage             TEXT,     -- The stage that consumed the most time.
+    stage_duration_us INTEGER,  -- The time spent in that stage.
+    breakdown         TEXT      -- Per-stage timings for the iteration.
+);
+)";
+
+    iterator begin()
+    {
+        this->s_rows.clear();
+        for (const auto& rec : lnav::stalls::get_records()) {
+            char time_buf[64];
+
+            sql_strftime(time_buf, sizeof(time_buf), rec.st_time, 'T');
+            this->s_rows.push_back(stall_row{
+                time_buf,
+                (int64_t) rec.st_duration_us,
+                rec.st_stage,
+                (int64_t) rec.st_stage_duration_us,
+                rec.st_breakdown,
+            });
+        }
+        return this->s_rows.begin();
+    }
+
+    iterator end() { return this->s_rows.end(); }
+
+    int get_column(cursor& vc, sqlite3_context* ctx, int col)
+    {
+        auto& sr = *vc.iter;
+
+        switch (col) {
+            case 0:
+                to_sqlite(ctx, sr.sr_time);
+                break;
+            case 1:
+                to_sqlite(ctx, sr.sr_duration_us);
+                break;
+            case 2:
+                sqlite3_result_text(ctx, sr.sr_stage, -1, SQLITE_STATIC);
+                break;
+            case 3:
+                to_sqlite(ctx, sr.sr_stage_duration_us);
+                break;
+            case 4:
+                to_sqlite(ctx, sr.sr_breakdown);
+                break;
+        }
+
+        return SQLITE_OK;
+    }
+
+    std::vector<stall_row> s_rows;
+};
+
+static auto stalls_binder = injector::bind_multiple<vtab_module_base>()
+                                .add<vtab_module<tvt_no_update<lnav_stalls>>>();
@@ -33,6 +33,7 @@
 
 #include <stdint.h>
 
+#include "base/date_time_scanner.hh"
 #include "base/opt_util.hh"
 #include "config.h"
 #include "lnav.hh"
@@ -72,6 +73,44 @@ sql_log_top_datetime()
     return buffer;
 }
 
+static int64_t
+sql_log_msg_count(nonstd::optional<std::string> begin_time,
+                  nonstd::optional<std::string> end_time)
+{
+    auto& lss = lnav_data.ld_log_source;
+    auto end_row = vis_line_t(lss.text_line_count());
+    auto begin_row = 0_vl;
+    date_time_scanner dts;
+    struct timeval tv;
+
+    // The message index is sorted by time, so the count for a range is
+    // just the difference of two binary searches and no rows need to be
+    // materialized through the vtab.
+    if (begin_time) {
+        if (!dts.convert_to_timeval(
+                begin_time->c_str(), begin_time->size(), nullptr, tv))
+        {
+            throw sqlite_func_error("begin time is not a valid datetime: {}",
+                                    begin_time.value());
+        }
+        begin_row = lss.row_for_time(tv).value_or(end_row);
+    }
+    if (end_time) {
+        if (!dts.convert_to_timeval(
+                end_time->c_str(), end_time->size(), nullptr, tv))
+        {
+            throw sqlite_func_error("end time is not a valid datetime: {}",
+                                    end_time.value());
+        }
+        end_row = lss.row_for_time(tv).value_or(end_row);
+    }
+
+    if (end_row < begin_row) {
+        return 0;
+    }
+    return (int64_t) (end_row - begin_row);
+}
+
 static nonstd::optional<std::string>
 sql_lnav_top_file()
 {
@@ -140,6 +179,22 @@ state_extension_functions(struct FuncDef** basic_funcs,
                               "the log view.")
                         .sql_function()),
 
+        sqlite_func_adapter<decltype(&sql_log_msg_count), sql_log_msg_count>::
+            builder(
+                help_text("log_msg_count",
+                          "Return the number of filtered log messages in the "
+                          "given time range using the message index instead "
+                          "of scanning rows.")
+                    .sql_function()
+                    .with_parameter(help_text("begin_time",
+                                              "The inclusive start of the "
+                                              "time range")
+                                        .optional())
+                    .with_parameter(help_text("end_time",
+                                              "The exclusive end of the time "
+                                              "range")
+                                        .optional())),
+
         sqlite_func_adapter<decltype(&sql_lnav_top_file), sql_lnav_top_file>::
             builder(help_text("lnav_top_file",
                               "Return the name of the file that the top line "
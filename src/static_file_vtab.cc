@@ -28,12 +28,19 @@
  */
 
 #include <map>
+#include <memory>
+#include <vector>
 
 #include "static_file_vtab.hh"
 
+#include <errno.h>
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
+#include "base/auto_fd.hh"
 #include "base/auto_mem.hh"
 #include "base/fs_util.hh"
 #include "base/lnav_log.hh"
@@ -61,10 +68,92 @@ struct static_file_info {
     ghc::filesystem::path sfi_path;
 };
 
+/**
+ * A static file's content held in a shared, read-only mapping.  The
+ * mapping lives in a session-wide cache so a lookup file that is joined
+ * against repeatedly is mapped once and handed to sqlite without
+ * copying, instead of being read into a fresh buffer for every row.
+ */
+struct mapped_static_file {
+    mapped_static_file(void* base, const struct stat& st)
+        : msf_base(base), msf_stat(st)
+    {
+    }
+
+    mapped_static_file(const mapped_static_file&) = delete;
+    mapped_static_file& operator=(const mapped_static_file&) = delete;
+
+    ~mapped_static_file()
+    {
+        if (this->msf_base != nullptr) {
+            munmap(this->msf_base, this->msf_stat.st_size);
+        }
+    }
+
+    void* msf_base;
+    struct stat msf_stat;
+};
+
+static std::map<std::string, std::shared_ptr<mapped_static_file>>
+    sf_content_cache;
+
+/**
+ * Get the cached mapping for the given file, validated against the
+ * file's identity/mtime/size so an updated file is re-mapped on the
+ * next query.
+ */
+static Result<std::shared_ptr<mapped_static_file>, std::string>
+map_static_file(const ghc::filesystem::path& path)
+{
+    auto fd = TRY(lnav::filesystem::open_file(path, O_RDONLY | O_CLOEXEC));
+    struct stat st;
+
+    if (fstat(fd.get(), &st) == -1) {
+        return Err(fmt::format(FMT_STRING("unable to stat: {} -- {}"),
+                               path.string(),
+                               strerror(errno)));
+    }
+
+    auto cache_iter = sf_content_cache.find(path.string());
+    if (cache_iter != sf_content_cache.end()) {
+        const auto& cached_st = cache_iter->second->msf_stat;
+
+        if (cached_st.st_dev == st.st_dev && cached_st.st_ino == st.st_ino
+            && cached_st.st_mtime == st.st_mtime
+            && cached_st.st_size == st.st_size)
+        {
+            return Ok(cache_iter->second);
+        }
+        sf_content_cache.erase(cache_iter);
+    }
+
+    void* base = nullptr;
+    if (st.st_size > 0) {
+        base = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd.get(), 0);
+        if (base == MAP_FAILED) {
+            return Err(fmt::format(FMT_STRING("unable to mmap: {} -- {}"),
+                                   path.string(),
+                                   strerror(errno)));
+        }
+    }
+
+    auto retval = std::make_shared<mapped_static_file>(base, st);
+
+    sf_content_cache[path.string()] = retval;
+
+    return Ok(std::move(retval));
+}
+
 struct sf_vtab_cursor {
     sqlite3_vtab_cursor base;
     std::map<std::string, static_file_info>::iterator vc_files_iter;
     std::map<std::string, static_file_info> vc_files;
+    /**
+     * The mappings handed out as blobs stay pinned here until the cursor
+     * closes so a cache refresh cannot unmap content the statement is
+     * still looking at.
+     */
+    std::vector<std::shared_ptr<mapped_static_file>> vc_content_refs;
 };
 
 static int sfvt_destructor(sqlite3_vtab* p_svt);
@@ -236,19 +325,25 @@ sfvt_column(sqlite3_vtab_cursor* cur, sqlite3_context* ctx, int col)
             break;
         }
         case 2: {
-            auto read_res = lnav::filesystem::read_file(
-                vc->vc_files_iter->second.sfi_path);
-            if (read_res.isErr()) {
+            auto map_res = map_static_file(vc->vc_files_iter->second.sfi_path);
+            if (map_res.isErr()) {
                 auto um = lnav::console::user_message::error(
                               "unable to read static file")
-                              .with_reason(read_res.unwrapErr());
+                              .with_reason(map_res.unwrapErr());
 
                 to_sqlite(ctx, um);
             } else {
-                auto str = read_res.unwrap();
-
-                sqlite3_result_blob(
-                    ctx, str.c_str(), str.size(), SQLITE_TRANSIENT);
+                auto msf = map_res.unwrap();
+
+                if (msf->msf_stat.st_size == 0) {
+                    sqlite3_result_zeroblob(ctx, 0);
+                } else {
+                    vc->vc_content_refs.push_back(msf);
+                    sqlite3_result_blob(ctx,
+                                        msf->msf_base,
+                                        msf->msf_stat.st_size,
+                                        SQLITE_STATIC);
+                }
             }
             break;
         }
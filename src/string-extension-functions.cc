@@ -50,6 +50,12 @@ using namespace mapbox;
 
 struct cache_entry {
     std::shared_ptr<lnav::pcre2pp::code> re2;
+    /**
+     * Reused across calls so extracting captures from millions of rows
+     * does not allocate a match-data block per row.  The cache is
+     * thread-local, so reuse is safe.
+     */
+    std::shared_ptr<lnav::pcre2pp::match_data> re2_match_data;
     std::shared_ptr<column_namer> cn{
         std::make_shared<column_namer>(column_namer::language::JSON)};
 };
@@ -73,6 +79,8 @@ find_re(string_fragment re)
         cache_entry c;
 
         c.re2 = compile_res.unwrap().to_shared();
+        c.re2_match_data = std::make_shared<lnav::pcre2pp::match_data>(
+            c.re2->create_match_data());
         auto pair = cache.insert(
             std::make_pair(string_fragment::from_str(c.re2->get_pattern()), c));
 
@@ -106,7 +114,7 @@ regexp_match(string_fragment re, string_fragment str)
             "regular expression does not have any captures");
     }
 
-    auto md = extractor.create_match_data();
+    auto& md = *reobj->re2_match_data;
     auto match_res = extractor.capture_from(str).into(md).matches();
     if (match_res.is<lnav::pcre2pp::matcher::not_found>()) {
         return static_cast<const char*>(nullptr);
@@ -582,19 +590,29 @@ sql_decode(string_fragment str, encode_algo algo)
             return blob_auto_buffer{std::move(buf)};
         }
         case encode_algo::hex: {
+            static const auto nibble = [](unsigned char ch) -> int {
+                if (ch >= '0' && ch <= '9') {
+                    return ch - '0';
+                }
+                if (ch >= 'a' && ch <= 'f') {
+                    return ch - 'a' + 10;
+                }
+                if (ch >= 'A' && ch <= 'F') {
+                    return ch - 'A' + 10;
+                }
+                return -1;
+            };
+
             auto buf = auto_buffer::alloc(str.length() / 2);
-            auto sv = str.to_string_view();
-
-            while (!sv.empty()) {
-                int32_t value;
-                auto scan_res = scn::scan(sv, "{:2x}", value);
-                if (!scan_res) {
-                    throw sqlite_func_error(
-                        "invalid hex input at: {}",
-                        std::distance(str.begin(), sv.begin()));
+
+            for (int lpc = 0; lpc < str.length(); lpc += 2) {
+                auto hi = lpc + 1 < str.length() ? nibble(str[lpc]) : -1;
+                auto lo = hi < 0 ? -1 : nibble(str[lpc + 1]);
+
+                if (lo < 0) {
+                    throw sqlite_func_error("invalid hex input at: {}", lpc);
                 }
-                buf.push_back((char) (value & 0xff));
-                sv = scan_res.range_as_string_view();
+                buf.push_back((char) ((hi << 4) | lo));
             }
 
             return blob_auto_buffer{std::move(buf)};
@@ -98,6 +98,114 @@ read_err_pipe(const std::string& netloc,
     }
 }
 
+/**
+ * Try to reconstruct an offered block from the other files mirrored in the
+ * same directory.  When a remote file is rotated by a rename or a copy,
+ * the successor's content lives at the same offsets as the file that was
+ * already fetched under the old name, so the block can be copied locally
+ * and acked without transferring it again.
+ *
+ * @return True if the block was written to the local path.
+ */
+static bool
+reconstruct_block_from_sibling(const ghc::filesystem::path& local_path,
+                               const tailer::packet_offer_block& pob)
+{
+    constexpr int64_t BUFFER_SIZE = 4 * 1024 * 1024;
+    std::error_code dir_ec;
+
+    for (const auto& entry : ghc::filesystem::directory_iterator(
+             local_path.parent_path(), dir_ec))
+    {
+        if (entry.path() == local_path) {
+            continue;
+        }
+
+        auto open_res = lnav::filesystem::open_file(entry.path(), O_RDONLY);
+        if (open_res.isErr()) {
+            continue;
+        }
+
+        auto fd = open_res.unwrap();
+        struct stat st;
+
+        if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode)
+            || st.st_size < pob.pob_offset + pob.pob_length)
+        {
+            continue;
+        }
+
+        auto_mem<unsigned char> buffer;
+
+        buffer = (unsigned char*) malloc(BUFFER_SIZE);
+
+        auto remaining = pob.pob_length;
+        auto remaining_offset = pob.pob_offset;
+        tailer::hash_frag thf;
+        SHA256_CTX shactx;
+        bool read_failed = false;
+
+        sha256_init(&shactx);
+        while (remaining > 0) {
+            auto nbytes = std::min(remaining, BUFFER_SIZE);
+            auto bytes_read = pread(fd, buffer, nbytes, remaining_offset);
+
+            if (bytes_read <= 0) {
+                read_failed = true;
+                break;
+            }
+            sha256_update(&shactx, buffer.in(), bytes_read);
+            remaining -= bytes_read;
+            remaining_offset += bytes_read;
+        }
+        if (read_failed) {
+            continue;
+        }
+
+        sha256_final(&shactx, thf.thf_hash);
+        if (!(thf == pob.pob_hash)) {
+            continue;
+        }
+
+        log_debug("found offered block %s[%lld..+%lld] in %s",
+                  local_path.c_str(),
+                  pob.pob_offset,
+                  pob.pob_length,
+                  entry.path().c_str());
+
+        auto create_res = lnav::filesystem::create_file(
+            local_path, O_WRONLY | O_CREAT, 0600);
+        if (create_res.isErr()) {
+            log_error("open: %s", create_res.unwrapErr().c_str());
+            return false;
+        }
+
+        auto out_fd = create_res.unwrap();
+
+        ftruncate(out_fd, pob.pob_offset);
+        remaining = pob.pob_length;
+        remaining_offset = pob.pob_offset;
+        while (remaining > 0) {
+            auto nbytes = std::min(remaining, BUFFER_SIZE);
+            auto bytes_read = pread(fd, buffer, nbytes, remaining_offset);
+
+            if (bytes_read <= 0
+                || pwrite(out_fd, buffer, bytes_read, remaining_offset)
+                    != bytes_read)
+            {
+                ftruncate(out_fd, pob.pob_offset);
+                return false;
+            }
+            remaining -= bytes_read;
+            remaining_offset += bytes_read;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
 static void
 update_tailer_progress(const std::string& netloc, const std::string& msg)
 {
@@ -150,8 +258,22 @@ tailer::looper::loop_body()
             continue;
         }
         if (this->l_remotes.count(netloc) == 0) {
-            auto create_res = host_tailer::for_host(netloc);
+            auto conn_iter = this->l_connecting_remotes.find(netloc);
 
+            if (conn_iter == this->l_connecting_remotes.end()) {
+                this->l_connecting_remotes[netloc] = std::async(
+                    std::launch::async, &host_tailer::for_host, netloc);
+                continue;
+            }
+            if (conn_iter->second.wait_for(std::chrono::seconds(0))
+                != std::future_status::ready)
+            {
+                continue;
+            }
+
+            auto create_res = conn_iter->second.get();
+
+            this->l_connecting_remotes.erase(conn_iter);
             if (create_res.isErr()) {
                 report_error(netloc, create_res.unwrapErr());
                 if (std::any_of(
@@ -752,6 +874,22 @@ tailer::looper::host_tailer::loop_body()
                 }
 
                 if (open_res.isErr()) {
+                    if (reconstruct_block_from_sibling(local_path, pob)) {
+                        log_debug(
+                            "block copied from rotated sibling, sending ack");
+                        send_packet(conn.ht_to_child.get(),
+                                    TPT_ACK_BLOCK,
+                                    TPPT_STRING,
+                                    pob.pob_path.c_str(),
+                                    TPPT_INT64,
+                                    pob.pob_offset,
+                                    TPPT_INT64,
+                                    pob.pob_length,
+                                    TPPT_INT64,
+                                    (int64_t) (pob.pob_offset + pob.pob_length),
+                                    TPPT_DONE);
+                        return std::move(this->ht_state);
+                    }
                     log_debug("file not found (%s), sending need block",
                               open_res.unwrapErr().c_str());
                     send_packet(conn.ht_to_child.get(),
@@ -839,6 +977,21 @@ tailer::looper::host_tailer::loop_body()
                     }
                     log_debug("local file is different, sending need block");
                 }
+                if (reconstruct_block_from_sibling(local_path, pob)) {
+                    log_debug("block copied from rotated sibling, sending ack");
+                    send_packet(conn.ht_to_child.get(),
+                                TPT_ACK_BLOCK,
+                                TPPT_STRING,
+                                pob.pob_path.c_str(),
+                                TPPT_INT64,
+                                pob.pob_offset,
+                                TPPT_INT64,
+                                pob.pob_length,
+                                TPPT_INT64,
+                                (int64_t) (pob.pob_offset + pob.pob_length),
+                                TPPT_DONE);
+                    return std::move(this->ht_state);
+                }
                 send_packet(conn.ht_to_child.get(),
                             TPT_NEED_BLOCK,
                             TPPT_STRING,
@@ -44,6 +44,7 @@ struct config {
     std::map<std::string, std::string> c_ssh_options{};
     std::map<std::string, std::string> c_ssh_config{
         {"BatchMode", "yes"},
+        {"Compression", "yes"},
         {"ConnectTimeout", "10"},
     };
 };
@@ -30,6 +30,7 @@
 #ifndef lnav_tailer_looper_hh
 #define lnav_tailer_looper_hh
 
+#include <future>
 #include <set>
 
 #include <logfile_fwd.hh>
@@ -149,6 +150,15 @@ private:
 
     std::map<std::string, remote_path_queue> l_netlocs_to_paths;
     std::map<std::string, std::shared_ptr<host_tailer>> l_remotes;
+    /**
+     * Connection attempts that are still in flight.  Setting up a host
+     * means two ssh handshakes plus the tailer binary transfer, so the
+     * attempts run on their own threads and loop_body() collects the
+     * results instead of connecting to each host in turn.
+     */
+    std::map<std::string,
+             std::future<Result<std::shared_ptr<host_tailer>, std::string>>>
+        l_connecting_remotes;
 };
 
 void cleanup_cache();
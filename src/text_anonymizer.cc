@@ -131,6 +131,7 @@ text_anonymizer::next(string_fragment line)
     data_scanner ds(line);
     std::string retval;
 
+    retval.reserve(line.length());
     while (true) {
         auto tok_res = ds.tokenize2();
         if (!tok_res) {
@@ -452,11 +453,13 @@ text_anonymizer::next(string_fragment line)
                     ds.to_string_fragment(tok_res->tr_inner_capture)
                         .to_string());
 
-                retval += line.sub_range(tok_res->tr_capture.c_begin,
-                                         tok_res->tr_inner_capture.c_begin)
-                              .to_string()
-                    + anon_inner
-                    + ds.to_string_fragment(tok_res->tr_capture).back();
+                auto leading
+                    = line.sub_range(tok_res->tr_capture.c_begin,
+                                     tok_res->tr_inner_capture.c_begin);
+
+                retval.append(leading.data(), leading.length());
+                retval += anon_inner;
+                retval += ds.to_string_fragment(tok_res->tr_capture).back();
                 break;
             }
             case DT_XML_OPEN_TAG: {
@@ -503,12 +506,19 @@ text_anonymizer::next(string_fragment line)
                 break;
             }
             case DT_UUID: {
-                retval
-                    += hasher().update(tok_res->to_string()).to_uuid_string();
+                auto sf = ds.to_string_fragment(tok_res->tr_capture);
+
+                retval += hasher()
+                              .update(sf.data(), sf.length())
+                              .to_uuid_string();
                 break;
             }
             default: {
-                retval += tok_res->to_string();
+                // Tokens that pass through unchanged are appended directly
+                // instead of being copied into a temporary string first.
+                auto sf = ds.to_string_fragment(tok_res->tr_capture);
+
+                retval.append(sf.data(), sf.length());
                 break;
             }
         }
@@ -37,6 +37,7 @@
 #include "config.h"
 #include "lnav.events.hh"
 #include "md2attr_line.hh"
+#include "perf_counters.hh"
 #include "sqlitepp.hh"
 
 using namespace lnav::roles::literals;
@@ -78,7 +79,12 @@ textfile_sub_source::text_value_for_line(textview_curses& tc,
                 auto read_result = lf->read_line(
                     lf->begin() + lfo->lfo_filter_state.tfs_index[line]);
                 if (read_result.isOk()) {
-                    value_out = to_string(read_result.unwrap());
+                    auto sbr = read_result.unwrap();
+
+                    value_out.assign(sbr.get_data(), sbr.length());
+                    lnav::perf::count(
+                        lnav::perf::counter_id::RENDER_COPY_BYTES,
+                        sbr.length());
                 }
             }
         } else {
@@ -228,6 +234,7 @@ textfile_sub_source::text_filters_changed()
     auto* lfo = (line_filter_observer*) lf->get_logline_observer();
     uint32_t filter_in_mask, filter_out_mask;
 
+    lfo->restart_edited_filter_state();
     lfo->clear_deleted_filter_state();
     lf->reobserve_from(lf->begin() + lfo->get_min_count(lf->size()));
 
@@ -242,6 +249,10 @@ textfile_sub_source::text_filters_changed()
         lfo->lfo_filter_state.tfs_index.push_back(lpc);
     }
 
+    for (const auto& filter : this->get_filters()) {
+        filter->lf_edit_delta = text_filter::edit_delta_t::NONE;
+    }
+
     this->tss_view->redo_search();
 }
 
@@ -636,13 +647,28 @@ textfile_sub_source::rescan_files(
                 }
 
                 if (ms_iter == this->tss_doc_metadata.end()) {
+                    /* Discovering the section structure requires a full
+                     * parse of the content, which can stall the UI for a
+                     * very large file, so only the head of such a file is
+                     * discovered. */
+                    static const file_ssize_t MAX_STRUCTURE_SIZE
+                        = 16 * 1024 * 1024;
+
                     auto read_res = lf->read_file();
 
                     if (read_res.isOk()) {
                         auto content = attr_line_t(read_res.unwrap());
+                        auto discover_range = line_range{0, -1};
 
                         log_info("generating metdata for: %s",
                                  lf->get_filename().c_str());
+                        if (st.st_size > MAX_STRUCTURE_SIZE) {
+                            log_info(
+                                "  file is too large, limiting structure "
+                                "discovery to the first %lld bytes",
+                                (long long) MAX_STRUCTURE_SIZE);
+                            discover_range.lr_end = MAX_STRUCTURE_SIZE;
+                        }
                         scrub_ansi_string(content.get_string(),
                                           &content.get_attrs());
                         this->tss_doc_metadata[lf->get_filename()]
@@ -650,7 +676,7 @@ textfile_sub_source::rescan_files(
                                 st.st_mtime,
                                 static_cast<file_ssize_t>(st.st_size),
                                 lnav::document::discover_structure(
-                                    content, line_range{0, -1}),
+                                    content, discover_range),
                             };
                     }
                 }
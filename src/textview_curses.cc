@@ -28,6 +28,7 @@
  */
 
 #include <algorithm>
+#include <chrono>
 #include <vector>
 
 #include "textview_curses.hh"
@@ -43,6 +44,7 @@
 #include "logfile.hh"
 #include "shlex.hh"
 #include "view_curses.hh"
+#include "xxHash/xxhash.h"
 
 const auto REVERSE_SEARCH_OFFSET = 2000_vl;
 
@@ -81,7 +83,55 @@ text_filter::add_line(logfile_filter_state& lfs,
                       logfile::const_iterator ll,
                       shared_buffer_ref& line)
 {
-    bool match_state = this->matches(*lfs.tfs_logfile, ll, line);
+    bool match_state;
+    size_t line_number = lfs.tfs_filter_count[this->lf_index]
+        + lfs.tfs_lines_for_message[this->lf_index];
+    uint32_t mask = ((uint32_t) 1U) << this->lf_index;
+
+    if (!ll->is_message() && lfs.tfs_message_matched[this->lf_index]) {
+        // A prior line of this message already matched, so the
+        // message-level result cannot change and the evaluation can be
+        // skipped.
+        match_state = true;
+    } else if (this->lf_edit_delta == edit_delta_t::NARROWED
+        && line_number < lfs.tfs_carried_count[this->lf_index]
+        && !(lfs.tfs_mask[line_number] & mask))
+    {
+        // The previous version of this filter did not match here and the
+        // new pattern only narrows it, so there is no need to run the
+        // regex.
+        match_state = false;
+    } else if (this->lf_edit_delta == edit_delta_t::WIDENED
+               && line_number < lfs.tfs_carried_count[this->lf_index]
+               && (lfs.tfs_mask[line_number] & mask))
+    {
+        // The previous version matched this message and the new pattern
+        // only widens it, so it must still match.
+        match_state = true;
+    } else if (!this->lf_required_literal.empty()
+               && !lfs.sketch_may_contain(line_number,
+                                          this->lf_required_literal))
+    {
+        // The chunk sketch says the literal this filter requires does not
+        // appear anywhere nearby, so the regex cannot match.
+        match_state = false;
+    } else {
+        this->lf_eval_count += 1;
+        if ((this->lf_eval_count & 0x1f) == 0) {
+            // Timing every evaluation would cost more than many of the
+            // filters themselves, so sample one in every 32.
+            auto eval_start = std::chrono::steady_clock::now();
+
+            match_state = this->matches(*lfs.tfs_logfile, ll, line);
+            this->lf_eval_time_us
+                += std::chrono::duration_cast<std::chrono::microseconds>(
+                       std::chrono::steady_clock::now() - eval_start)
+                       .count();
+            this->lf_eval_time_samples += 1;
+        } else {
+            match_state = this->matches(*lfs.tfs_logfile, ll, line);
+        }
+    }
 
     if (ll->is_message()) {
         this->end_of_message(lfs);
@@ -239,6 +289,7 @@ textview_curses::reload_config(error_reporter& reporter)
 void
 textview_curses::reload_data()
 {
+    this->invalidate_render_cache();
     if (this->tc_sub_source != nullptr) {
         this->tc_sub_source->text_update_marks(this->tc_bookmarks);
     }
@@ -310,6 +361,15 @@ void
 textview_curses::grep_end(grep_proc<vis_line_t>& gp)
 {
     this->tc_searching -= 1;
+    if (this->tc_search_child != nullptr
+        && &gp == this->tc_search_child->get_grep_proc()
+        && !this->tc_current_search.empty())
+    {
+        auto& memo = this->tc_search_memos[this->tc_current_search];
+
+        memo.sm_hits = this->tc_bookmarks[&BM_SEARCH];
+        memo.sm_covered = this->get_inner_height();
+    }
     this->grep_end_batch(gp);
 
     ensure(this->tc_searching >= 0);
@@ -331,13 +391,111 @@ textview_curses::grep_match(grep_proc<vis_line_t>& gp,
     }
 }
 
+const std::vector<std::pair<const highlighter*, bool>>&
+textview_curses::get_active_highlights(text_format_t tf)
+{
+    auto key = this->highlight_fingerprint() * 31
+        + static_cast<size_t>(lnav::enums::to_underlying(tf)) + 1;
+
+    if (key != this->tc_active_highlights_key) {
+        this->tc_active_highlights.clear();
+        for (const auto& hl_pair : this->tc_highlights) {
+            const auto& hl = hl_pair.second;
+
+            if (!hl.h_text_formats.empty()
+                && hl.h_text_formats.count(tf) == 0)
+            {
+                continue;
+            }
+            if (this->tc_disabled_highlights.count(hl_pair.first.first)) {
+                continue;
+            }
+
+            bool internal_hl
+                = hl_pair.first.first == highlight_source_t::INTERNAL
+                || hl_pair.first.first == highlight_source_t::THEME;
+
+            this->tc_active_highlights.emplace_back(&hl, internal_hl);
+        }
+        this->tc_active_highlights_key = key;
+    }
+
+    return this->tc_active_highlights;
+}
+
+size_t
+textview_curses::highlight_fingerprint() const
+{
+    size_t retval = this->tc_highlights.size()
+        + (this->tc_disabled_highlights.size() << 8);
+
+    for (const auto& hl_pair : this->tc_highlights) {
+        retval = retval * 31
+            + reinterpret_cast<size_t>(hl_pair.second.h_regex.get());
+    }
+
+    return retval;
+}
+
 void
 textview_curses::listview_value_for_rows(const listview_curses& lv,
                                          vis_line_t row,
                                          std::vector<attr_line_t>& rows_out)
 {
+    auto fingerprint = this->highlight_fingerprint();
+
+    if (this->tc_sub_source != nullptr) {
+        fingerprint = fingerprint * 31
+            + this->tc_sub_source->text_metadata_generation();
+    }
+
+    if (fingerprint != this->tc_render_cache_key) {
+        this->tc_render_cache.clear();
+        this->tc_highlight_memo.clear();
+        this->tc_render_cache_key = fingerprint;
+    } else if (this->tc_render_cache.size() > RENDER_CACHE_SIZE) {
+        // Drop renderings that are far from the viewport instead of
+        // clearing wholesale so the visible lines stay warm while paging
+        // through a large file.
+        auto near_start = (int) row - (int) (RENDER_CACHE_SIZE / 2);
+        auto near_end = (int) row + (int) (RENDER_CACHE_SIZE / 2);
+
+        for (auto iter = this->tc_render_cache.begin();
+             iter != this->tc_render_cache.end();)
+        {
+            if (iter->first < near_start || iter->first > near_end) {
+                iter = this->tc_render_cache.erase(iter);
+            } else {
+                ++iter;
+            }
+        }
+    }
+
     for (auto& al : rows_out) {
-        this->textview_value_for_row(row, al);
+        auto cache_iter = this->tc_render_cache.find((int) row);
+
+        if (cache_iter != this->tc_render_cache.end()) {
+            al = cache_iter->second;
+        } else {
+            this->textview_value_for_row(row, al);
+            this->tc_render_cache[(int) row] = al;
+        }
+
+        // The cursor moves without the line content changing, so the
+        // cursor role is applied on top of the cached rendering here
+        // instead of in textview_value_for_row().
+        if (this->is_selectable() && row == this->get_selection()
+            && this->tc_cursor_role)
+        {
+            auto& sa = al.get_attrs();
+            auto orig_line = find_string_attr_range(sa, &SA_ORIGINAL_LINE);
+
+            if (!orig_line.is_valid()) {
+                orig_line.lr_start = 0;
+            }
+            sa.emplace_back(line_range{orig_line.lr_start, -1},
+                            VC_ROLE.value(this->tc_cursor_role.value()));
+        }
         ++row;
     }
 }
@@ -429,6 +587,10 @@ textview_curses::handle_mouse(mouse_event& me)
 void
 textview_curses::textview_value_for_row(vis_line_t row, attr_line_t& value_out)
 {
+    /* The line may be recycled from a previous frame, so clear the
+     * contents while keeping the storage. */
+    value_out.clear();
+
     auto& sa = value_out.get_attrs();
     auto& str = value_out.get_string();
     auto source_format = this->tc_sub_source->get_text_format();
@@ -458,41 +620,79 @@ textview_curses::textview_value_for_row(vis_line_t row, attr_line_t& value_out)
         format_name = format_attr_opt.value().get();
     }
 
-    if (this->is_selectable() && row == this->get_selection()
-        && this->tc_cursor_role)
-    {
-        sa.emplace_back(line_range{orig_line.lr_start, -1},
-                        VC_ROLE.value(this->tc_cursor_role.value()));
-    }
-
-    for (auto& tc_highlight : this->tc_highlights) {
-        bool internal_hl
-            = tc_highlight.first.first == highlight_source_t::INTERNAL
-            || tc_highlight.first.first == highlight_source_t::THEME;
-
-        if (!tc_highlight.second.h_text_formats.empty()
-            && tc_highlight.second.h_text_formats.count(source_format) == 0)
-        {
-            continue;
+    const auto& active_hls = this->get_active_highlights(source_format);
+    uint64_t memo_key = 0;
+    auto applied_from_memo = false;
+
+    if (!active_hls.empty()) {
+        // A highlight's output depends on the line content plus the style
+        // attrs consulted by the non-nestable check, so both go into the
+        // key.  Identical lines then share one run of the regexes.
+        std::vector<int64_t> footer;
+
+        footer.reserve(sa.size() * 3 + 4);
+        footer.push_back(lnav::enums::to_underlying(source_format));
+        footer.push_back((int64_t) (intptr_t) format_name.get());
+        footer.push_back(body.lr_start);
+        footer.push_back(orig_line.lr_start);
+        for (const auto& attr : sa) {
+            if (attr.sa_type == &VC_STYLE || attr.sa_type == &VC_ROLE
+                || attr.sa_type == &VC_FOREGROUND
+                || attr.sa_type == &VC_BACKGROUND)
+            {
+                footer.push_back((int64_t) (intptr_t) attr.sa_type);
+                footer.push_back(attr.sa_range.lr_start);
+                footer.push_back(attr.sa_range.lr_end);
+            }
         }
+        memo_key = XXH3_64bits(str.data(), str.size())
+            ^ (XXH3_64bits(footer.data(), footer.size() * sizeof(int64_t))
+               + 0x9e3779b97f4a7c15ULL);
 
-        if (!tc_highlight.second.h_format_name.empty()
-            && tc_highlight.second.h_format_name != format_name)
+        auto memo_iter = this->tc_highlight_memo.find(memo_key);
+        if (memo_iter != this->tc_highlight_memo.end()
+            && memo_iter->second.hm_str_len == str.size())
         {
-            continue;
+            sa.insert(sa.end(),
+                      memo_iter->second.hm_attrs.begin(),
+                      memo_iter->second.hm_attrs.end());
+            applied_from_memo = true;
         }
+    }
 
-        if (this->tc_disabled_highlights.count(tc_highlight.first.first)) {
-            continue;
+    if (!applied_from_memo) {
+        auto pre_highlight_count = sa.size();
+
+        for (const auto& hl_pair : active_hls) {
+            const auto& tc_highlight = *hl_pair.first;
+            bool internal_hl = hl_pair.second;
+
+            if (!tc_highlight.h_format_name.empty()
+                && tc_highlight.h_format_name != format_name)
+            {
+                continue;
+            }
+
+            // Internal highlights should only apply to the log message body
+            // so that we don't start highlighting other fields.
+            // User-provided highlights should apply only to the line itself
+            // and not any of the surrounding decorations that are added (for
+            // example, the file lines that are inserted at the beginning of
+            // the log view).
+            int start_pos = internal_hl ? body.lr_start : orig_line.lr_start;
+            tc_highlight.annotate(value_out, start_pos);
         }
 
-        // Internal highlights should only apply to the log message body so
-        // that we don't start highlighting other fields.  User-provided
-        // highlights should apply only to the line itself and not any of the
-        // surrounding decorations that are added (for example, the file lines
-        // that are inserted at the beginning of the log view).
-        int start_pos = internal_hl ? body.lr_start : orig_line.lr_start;
-        tc_highlight.second.annotate(value_out, start_pos);
+        if (!active_hls.empty()) {
+            if (this->tc_highlight_memo.size() > HIGHLIGHT_MEMO_SIZE) {
+                this->tc_highlight_memo.clear();
+            }
+
+            auto& memo = this->tc_highlight_memo[memo_key];
+
+            memo.hm_str_len = str.size();
+            memo.hm_attrs.assign(sa.begin() + pre_highlight_count, sa.end());
+        }
     }
 
     if (this->tc_hide_fields) {
@@ -613,15 +813,45 @@ textview_curses::execute_search(const std::string& regex_orig)
                 code, *this);
 
             gp->set_sink(this);
-            auto top = this->get_top();
-            if (top < REVERSE_SEARCH_OFFSET) {
-                top = 0_vl;
+            auto memo_iter = this->tc_search_memos.find(regex);
+            if (memo_iter != this->tc_search_memos.end()) {
+                /* This pattern was searched before, restore the hits that
+                 * were found and only scan the lines added since then. */
+                auto& search_bv = this->tc_bookmarks[&BM_SEARCH];
+                auto height = this->get_inner_height();
+
+                for (const auto& hit : memo_iter->second.sm_hits) {
+                    if (hit >= height) {
+                        break;
+                    }
+                    search_bv.insert_once(hit);
+                    if (this->tc_sub_source != nullptr) {
+                        this->tc_sub_source->text_mark(&BM_SEARCH, hit, true);
+                    }
+                }
+                this->set_needs_update();
+                gp->queue_request(
+                    std::min(memo_iter->second.sm_covered, height));
             } else {
-                top -= REVERSE_SEARCH_OFFSET;
-            }
-            gp->queue_request(top);
-            if (top > 0) {
-                gp->queue_request(0_vl, top);
+                auto top = this->get_top();
+                auto bottom = this->get_bottom() + 1_vl;
+                auto near_top = top < REVERSE_SEARCH_OFFSET
+                    ? 0_vl
+                    : top - REVERSE_SEARCH_OFFSET;
+
+                /* Scan outward from the viewport so that a hit near the
+                 * visible lines is delivered first: the visible range
+                 * plus a band above it, then the rest of the lines below,
+                 * then the remainder above. */
+                if (near_top < bottom) {
+                    gp->queue_request(near_top, bottom);
+                    gp->queue_request(bottom);
+                } else {
+                    gp->queue_request(near_top);
+                }
+                if (near_top > 0) {
+                    gp->queue_request(0_vl, near_top);
+                }
             }
             gp->start();
 
@@ -708,6 +938,7 @@ textview_curses::set_user_mark(const bookmark_type_t* bm,
         this->search_range(vl, vl + 1_vl);
         this->search_new_data();
     }
+    this->invalidate_render_cache();
     this->set_needs_update();
 }
 
@@ -748,11 +979,15 @@ textview_curses::toggle_user_mark(const bookmark_type_t* bm,
     }
     this->search_range(start_line, end_line + 1_vl);
     this->search_new_data();
+    this->invalidate_render_cache();
 }
 
 void
 textview_curses::redo_search()
 {
+    /* The content or line numbering has changed, so the memoized hits
+     * for previous patterns are no longer valid. */
+    this->tc_search_memos.clear();
     if (this->tc_search_child) {
         auto* gp = this->tc_search_child->get_grep_proc();
 
@@ -1055,6 +1290,7 @@ logfile_filter_state::logfile_filter_state(std::shared_ptr<logfile> lf)
     memset(this->tfs_last_lines_for_message,
            0,
            sizeof(this->tfs_last_lines_for_message));
+    memset(this->tfs_carried_count, 0, sizeof(this->tfs_carried_count));
     this->tfs_mask.reserve(64 * 1024);
 }
 
@@ -1072,8 +1308,62 @@ logfile_filter_state::clear()
     memset(this->tfs_last_lines_for_message,
            0,
            sizeof(this->tfs_last_lines_for_message));
+    memset(this->tfs_carried_count, 0, sizeof(this->tfs_carried_count));
     this->tfs_mask.clear();
     this->tfs_index.clear();
+    this->tfs_sketches.clear();
+    this->tfs_sketched_lines = 0;
+}
+
+static uint32_t
+sketch_trigram_hash(const unsigned char* data)
+{
+    return (((data[0] * 131U) + data[1]) * 131U) + data[2];
+}
+
+void
+logfile_filter_state::sketch_line(size_t line_number,
+                                  const char* data,
+                                  size_t len)
+{
+    auto chunk = line_number / SKETCH_CHUNK_LINES;
+
+    if (chunk >= this->tfs_sketches.size()) {
+        this->tfs_sketches.resize(chunk + 1);
+    }
+
+    auto& sketch = this->tfs_sketches[chunk];
+    const auto* udata = (const unsigned char*) data;
+
+    for (size_t lpc = 0; lpc + 3 <= len; lpc++) {
+        sketch.insert(sketch_trigram_hash(&udata[lpc]));
+    }
+    this->tfs_sketched_lines = line_number + 1;
+}
+
+bool
+logfile_filter_state::sketch_may_contain(size_t line_number,
+                                         const std::string& literal) const
+{
+    if (literal.size() < 3 || line_number >= this->tfs_sketched_lines) {
+        return true;
+    }
+
+    auto chunk = line_number / SKETCH_CHUNK_LINES;
+
+    if (chunk >= this->tfs_sketches.size()) {
+        return true;
+    }
+
+    const auto& sketch = this->tfs_sketches[chunk];
+    const auto* udata = (const unsigned char*) literal.data();
+
+    for (size_t lpc = 0; lpc + 3 <= literal.size(); lpc++) {
+        if (!sketch.contains(sketch_trigram_hash(&udata[lpc]))) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void
@@ -1085,6 +1375,19 @@ logfile_filter_state::clear_filter_state(size_t index)
     this->tfs_lines_for_message[index] = 0;
     this->tfs_last_message_matched[index] = false;
     this->tfs_last_lines_for_message[index] = 0;
+    this->tfs_carried_count[index] = 0;
+}
+
+void
+logfile_filter_state::restart_filter_state(size_t index)
+{
+    this->tfs_carried_count[index] = this->tfs_filter_count[index];
+    this->tfs_filter_count[index] = 0;
+    this->tfs_filter_hits[index] = 0;
+    this->tfs_message_matched[index] = false;
+    this->tfs_lines_for_message[index] = 0;
+    this->tfs_last_message_matched[index] = false;
+    this->tfs_last_lines_for_message[index] = 0;
 }
 
 void
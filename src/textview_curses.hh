@@ -32,6 +32,7 @@
 #ifndef textview_curses_hh
 #define textview_curses_hh
 
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -60,6 +61,13 @@ public:
 
     void clear_filter_state(size_t index);
 
+    /**
+     * Restart evaluation for the filter at the given index while keeping
+     * its mask bits.  The carried-over bits serve as the candidate set for
+     * a filter that was edited into a provably narrower/wider pattern.
+     */
+    void restart_filter_state(size_t index);
+
     void clear_deleted_filter_state(uint32_t used_mask);
 
     void resize(size_t newsize);
@@ -68,6 +76,44 @@ public:
 
     const static int MAX_FILTERS = 32;
 
+    /** The number of lines summarized by each content sketch. */
+    const static size_t SKETCH_CHUNK_LINES = 1024;
+
+    /**
+     * A small bloom filter over the trigrams in a chunk of lines.
+     * Literal-bearing filters consult these to skip regex evaluation over
+     * chunks that cannot contain their literal.  Stale bits left behind
+     * by rolled-back lines only cost time, never correctness.
+     */
+    struct chunk_sketch {
+        std::array<uint64_t, 64> cs_bits{};
+
+        void insert(uint32_t hash)
+        {
+            auto bit = hash & 0xfff;
+
+            this->cs_bits[bit >> 6] |= 1ULL << (bit & 0x3f);
+        }
+
+        bool contains(uint32_t hash) const
+        {
+            auto bit = hash & 0xfff;
+
+            return (this->cs_bits[bit >> 6] & (1ULL << (bit & 0x3f))) != 0;
+        }
+    };
+
+    /** Record the given line's trigrams in its chunk's sketch. */
+    void sketch_line(size_t line_number, const char* data, size_t len);
+
+    /**
+     * Check if the chunk holding the given line might contain the given
+     * literal.  Returns true when in doubt, including for lines that have
+     * not been sketched yet.
+     */
+    bool sketch_may_contain(size_t line_number,
+                            const std::string& literal) const;
+
     std::shared_ptr<logfile> tfs_logfile;
     size_t tfs_filter_count[MAX_FILTERS];
     int tfs_filter_hits[MAX_FILTERS];
@@ -75,8 +121,12 @@ public:
     size_t tfs_lines_for_message[MAX_FILTERS];
     bool tfs_last_message_matched[MAX_FILTERS];
     size_t tfs_last_lines_for_message[MAX_FILTERS];
+    size_t tfs_carried_count[MAX_FILTERS];
     std::vector<uint32_t> tfs_mask;
     std::vector<uint32_t> tfs_index;
+    std::vector<chunk_sketch> tfs_sketches;
+    /** The number of leading lines covered by the sketches. */
+    size_t tfs_sketched_lines{0};
 };
 
 enum class filter_lang_t : int {
@@ -97,6 +147,18 @@ public:
         LFT__MASK = (MAYBE | INCLUDE | EXCLUDE)
     } type_t;
 
+    /**
+     * How this filter's match set relates to that of the filter it
+     * replaced, when an edit can be proven to only narrow or widen the
+     * pattern.  The carried-over result bits are then used to skip regex
+     * evaluations during the re-scan.
+     */
+    enum class edit_delta_t {
+        NONE,
+        NARROWED,
+        WIDENED,
+    };
+
     text_filter(type_t type, filter_lang_t lang, std::string id, size_t index)
         : lf_type(type), lf_lang(lang), lf_id(std::move(id)), lf_index(index)
     {
@@ -133,6 +195,18 @@ public:
     bool operator==(const std::string& rhs) const { return this->lf_id == rhs; }
 
     bool lf_deleted{false};
+    edit_delta_t lf_edit_delta{edit_delta_t::NONE};
+    /**
+     * A substring that must appear in a line for this filter to match, or
+     * empty if one could not be derived from the pattern.  Checked against
+     * the chunk content sketches before running the regex.
+     */
+    std::string lf_required_literal;
+    /** Number of lines this filter has been evaluated against. */
+    uint64_t lf_eval_count{0};
+    /** Sampled evaluation time, one in every 32 evaluations is timed. */
+    uint64_t lf_eval_time_us{0};
+    uint64_t lf_eval_time_samples{0};
 
 protected:
     bool lf_enabled{true};
@@ -417,6 +491,21 @@ public:
 
     virtual void quiesce() {}
 
+    /**
+     * Warm the caches needed to display the given range of lines.  Called
+     * with the pages adjacent to the viewport while the UI is otherwise
+     * idle so that paging through a cold file does not fault in content
+     * synchronously.
+     */
+    virtual void text_prefetch_for(vis_line_t start, vis_line_t end) {}
+
+    /**
+     * @return A counter that is bumped whenever line metadata (partition
+     * names, comments, tags) changes, so the rendered-line cache can be
+     * invalidated precisely instead of the view being fully reloaded.
+     */
+    virtual size_t text_metadata_generation() { return 0; }
+
     bool tss_supports_filtering{false};
     bool tss_apply_filters{true};
 
@@ -560,6 +649,18 @@ public:
 
     void textview_value_for_row(vis_line_t line, attr_line_t& value_out);
 
+    /**
+     * Drop any fully-styled lines that have been cached for repaints.
+     * This needs to be called whenever something that feeds into the
+     * rendering changes, like the marks or the hidden-field setting.
+     * Changes to the highlight map are detected automatically.
+     */
+    void invalidate_render_cache()
+    {
+        this->tc_render_cache.clear();
+        this->tc_highlight_memo.clear();
+    }
+
     bool listview_is_row_selectable(const listview_curses& lv, vis_line_t row);
 
     void listview_selection_changed(const listview_curses& lv);
@@ -647,6 +748,7 @@ public:
         bool retval = this->tc_hide_fields;
 
         this->tc_hide_fields = !this->tc_hide_fields;
+        this->invalidate_render_cache();
 
         return retval;
     }
@@ -755,10 +857,55 @@ protected:
     bool tc_hide_fields{true};
     bool tc_paused{false};
 
+    /**
+     * The hits found for a search pattern along with the number of lines
+     * that were scanned to find them.  Recalling a pattern that was
+     * searched before in this session restores the hits from here so that
+     * highlighting and hit navigation are available immediately and only
+     * the lines added since the last scan need to be searched.
+     */
+    struct search_memo {
+        bookmark_vector<vis_line_t> sm_hits;
+        vis_line_t sm_covered{0_vl};
+    };
+
     std::string tc_current_search;
     std::string tc_previous_search;
+    std::unordered_map<std::string, search_memo> tc_search_memos;
     std::shared_ptr<grep_highlighter> tc_search_child;
     std::shared_ptr<grep_proc<vis_line_t>> tc_source_search_child;
+
+    static const size_t RENDER_CACHE_SIZE = 1024;
+    static const size_t HIGHLIGHT_MEMO_SIZE = 4096;
+
+    size_t highlight_fingerprint() const;
+
+    std::unordered_map<int, attr_line_t> tc_render_cache;
+    size_t tc_render_cache_key{0};
+
+    /**
+     * Memoized result of running the active highlighters over a line,
+     * keyed by a hash of the line's content and the style attrs that feed
+     * into the non-nestable check.  Repetitive files have thousands of
+     * identical lines, so the regexes only need to run on the first one.
+     */
+    struct highlight_memo {
+        size_t hm_str_len;
+        std::vector<string_attr> hm_attrs;
+    };
+    std::unordered_map<uint64_t, highlight_memo> tc_highlight_memo;
+
+    /**
+     * Look up the highlighters that can apply to lines of the given text
+     * format, recomputing the list only when the highlighter set changes.
+     * The bool in each pair is true for internal/theme highlights, which
+     * are restricted to the message body.
+     */
+    const std::vector<std::pair<const highlighter*, bool>>&
+    get_active_highlights(text_format_t tf);
+
+    std::vector<std::pair<const highlighter*, bool>> tc_active_highlights;
+    size_t tc_active_highlights_key{0};
 };
 
 #endif
@@ -1,7 +1,21 @@
+#ifndef HAVE_AVX2
 #define HAVE_AVX2   0
+#endif
+#ifndef HAVE_NEON32
 #define HAVE_NEON32 0
+#endif
+#ifndef HAVE_NEON64
 #define HAVE_NEON64 0
+#endif
+#ifndef HAVE_SSSE3
 #define HAVE_SSSE3  0
+#endif
+#ifndef HAVE_SSE41
 #define HAVE_SSE41  0
+#endif
+#ifndef HAVE_SSE42
 #define HAVE_SSE42  0
+#endif
+#ifndef HAVE_AVX
 #define HAVE_AVX    0
+#endif
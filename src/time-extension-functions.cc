@@ -49,6 +49,9 @@ timeslice(sqlite3_value* time_in, nonstd::optional<const char*> slice_in_opt)
     thread_local struct {
         std::string c_slice_str;
         relative_time c_rel_time;
+        int64_t c_win_start_us{-1};
+        int64_t c_win_end_us{-1};
+        std::string c_win_text;
     } cache;
     const auto slice_in
         = string_fragment::from_c_str(slice_in_opt.value_or("15m"));
@@ -73,6 +76,39 @@ timeslice(sqlite3_value* time_in, nonstd::optional<const char*> slice_in_opt)
         }
 
         cache.c_slice_str = slice_in.to_string();
+        cache.c_win_start_us = cache.c_win_end_us = -1;
+    }
+
+    if (sqlite3_value_type(time_in) == SQLITE_INTEGER
+        && cache.c_rel_time.is_relative())
+    {
+        // The common grouping query passes log_time_msecs with a fixed
+        // duration, so the bucket can be computed directly from the
+        // integer and the boundaries of the last bucket remembered.
+        // Runs of rows in the same slice then reuse the formatted text
+        // without a gmtime()/strftime() round trip per row.
+        auto slice_us = cache.c_rel_time.to_microseconds();
+        auto us = sqlite3_value_int64(time_in) * 1000LL;
+
+        if (slice_us > 0 && us >= 0) {
+            if (us < cache.c_win_start_us || us >= cache.c_win_end_us) {
+                auto start_us = us - (us % slice_us);
+                struct timeval win_tv = {
+                    (time_t) (start_us / 1000000LL),
+                    (suseconds_t) (start_us % 1000000LL),
+                };
+                char win_text[64];
+                auto win_len
+                    = sql_strftime(win_text, sizeof(win_text), win_tv);
+
+                cache.c_win_start_us = start_us;
+                cache.c_win_end_us = start_us + slice_us;
+                cache.c_win_text.assign(win_text, win_len);
+            }
+
+            return text_auto_buffer{auto_buffer::from(
+                cache.c_win_text.data(), cache.c_win_text.size())};
+        }
     }
 
     struct timeval tv;
@@ -145,24 +181,53 @@ timeslice(sqlite3_value* time_in, nonstd::optional<const char*> slice_in_opt)
     return text_auto_buffer{std::move(ts)};
 }
 
+/**
+ * Parse a relative-time expression, remembering recent results.  The
+ * arguments to timediff() are usually constant across a query, so the
+ * grammar should not be rerun for every row; timestamps that fail to
+ * parse are remembered, too, since they fail on every row as well.
+ */
+static nonstd::optional<relative_time>
+parse_relative_time_cached(string_fragment sf)
+{
+    static thread_local cache::lru_cache<std::string,
+                                         nonstd::optional<relative_time>>
+        REL_TIME_CACHE{16};
+
+    auto key = sf.to_string();
+    auto cached = REL_TIME_CACHE.get(key);
+    if (cached) {
+        return cached.value();
+    }
+
+    nonstd::optional<relative_time> retval;
+    auto parse_res = relative_time::from_str(sf);
+    if (parse_res.isOk()) {
+        retval = parse_res.unwrap();
+    }
+    REL_TIME_CACHE.put(key, retval);
+
+    return retval;
+}
+
 static nonstd::optional<double>
 sql_timediff(string_fragment time1, string_fragment time2)
 {
     struct timeval tv1, tv2, retval;
     date_time_scanner dts1, dts2;
-    auto parse_res1 = relative_time::from_str(time1);
+    auto parse_res1 = parse_relative_time_cached(time1);
 
-    if (parse_res1.isOk()) {
-        tv1 = parse_res1.unwrap().adjust_now().to_timeval();
+    if (parse_res1) {
+        tv1 = parse_res1.value().adjust_now().to_timeval();
     } else if (!dts1.convert_to_timeval(
                    time1.data(), time1.length(), nullptr, tv1))
     {
         return nonstd::nullopt;
     }
 
-    auto parse_res2 = relative_time::from_str(time2);
-    if (parse_res2.isOk()) {
-        tv2 = parse_res2.unwrap().adjust_now().to_timeval();
+    auto parse_res2 = parse_relative_time_cached(time2);
+    if (parse_res2) {
+        tv2 = parse_res2.value().adjust_now().to_timeval();
     } else if (!dts2.convert_to_timeval(
                    time2.data(), time2.length(), nullptr, tv2))
     {
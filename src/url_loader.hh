@@ -57,7 +57,17 @@ public:
         curl_easy_setopt(this->cr_handle, CURLOPT_WRITEFUNCTION, write_cb);
         curl_easy_setopt(this->cr_handle, CURLOPT_WRITEDATA, this);
         curl_easy_setopt(this->cr_handle, CURLOPT_FILETIME, 1);
-        curl_easy_setopt(this->cr_handle, CURLOPT_BUFFERSIZE, 128L * 1024L);
+        // The spool fd is handed to the file collection as soon as this
+        // request is queued, so indexing tails the file while the
+        // transfer is still running.  Tune the transfer for throughput
+        // since that is what bounds how quickly the view fills in.
+        curl_easy_setopt(
+            this->cr_handle, CURLOPT_BUFFERSIZE, CURL_MAX_READ_SIZE);
+        curl_easy_setopt(this->cr_handle, CURLOPT_TCP_KEEPALIVE, 1L);
+#    ifdef CURL_HTTP_VERSION_2TLS
+        curl_easy_setopt(
+            this->cr_handle, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+#    endif
     }
 
     int get_fd() const { return this->ul_fd.get(); }
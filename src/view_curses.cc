@@ -150,63 +150,89 @@ view_curses::mvwattrline(WINDOW* window,
     line_range lr_bytes;
     int char_index = 0;
 
-    for (size_t lpc = 0; lpc < line.size(); lpc++) {
-        int exp_start_index = expanded_line.size();
-        auto ch = static_cast<unsigned char>(line[lpc]);
-
-        if (char_index == lr_chars.lr_start) {
-            lr_bytes.lr_start = exp_start_index;
-        } else if (char_index == lr_chars.lr_end) {
-            lr_bytes.lr_end = exp_start_index;
+    if (std::all_of(line.begin(), line.end(), [](char ch) {
+            auto uch = static_cast<unsigned char>(ch);
+
+            return uch >= ' ' && uch < 0x7f;
+        }))
+    {
+        // Pure-ASCII lines are the overwhelmingly common case and map
+        // characters to bytes one-to-one, so the per-character expansion
+        // walk can be skipped entirely.
+        expanded_line = line;
+        char_index = expanded_line.size();
+        if (lr_chars.lr_start <= char_index) {
+            lr_bytes.lr_start = lr_chars.lr_start;
+        }
+        if (lr_chars.lr_end <= char_index) {
+            lr_bytes.lr_end = lr_chars.lr_end;
         }
+    } else {
+        for (size_t lpc = 0; lpc < line.size(); lpc++) {
+            int exp_start_index = expanded_line.size();
+            auto ch = static_cast<unsigned char>(line[lpc]);
+
+            if (char_index == lr_chars.lr_start) {
+                lr_bytes.lr_start = exp_start_index;
+            } else if (char_index == lr_chars.lr_end) {
+                lr_bytes.lr_end = exp_start_index;
+            }
+
+            switch (ch) {
+                case '\t': {
+                    do {
+                        expanded_line.push_back(' ');
+                        char_index += 1;
+                    } while (expanded_line.size() % 8);
+                    utf_adjustments.emplace_back(
+                        lpc, expanded_line.size() - exp_start_index - 1);
+                    break;
+                }
 
-        switch (ch) {
-            case '\t': {
-                do {
+                case '\r':
+                case '\n':
                     expanded_line.push_back(' ');
                     char_index += 1;
-                } while (expanded_line.size() % 8);
-                utf_adjustments.emplace_back(
-                    lpc, expanded_line.size() - exp_start_index - 1);
-                break;
-            }
-
-            case '\r':
-            case '\n':
-                expanded_line.push_back(' ');
-                char_index += 1;
-                break;
+                    break;
+
+                default: {
+                    if (ch < 0x80) {
+                        // ASCII is one byte and one column, skip the decoder.
+                        expanded_line.push_back(ch);
+                        char_index += 1;
+                        break;
+                    }
 
-            default: {
-                auto size_result = ww898::utf::utf8::char_size([&line, lpc]() {
-                    return std::make_pair(line[lpc], line.length() - lpc - 1);
-                });
+                    auto size_result = ww898::utf::utf8::char_size([&line, lpc]() {
+                        return std::make_pair(line[lpc], line.length() - lpc - 1);
+                    });
 
-                if (size_result.isErr()) {
-                    expanded_line.push_back('?');
-                } else {
-                    auto offset = 1 - (int) size_result.unwrap();
+                    if (size_result.isErr()) {
+                        expanded_line.push_back('?');
+                    } else {
+                        auto offset = 1 - (int) size_result.unwrap();
 
-                    expanded_line.push_back(ch);
-                    if (offset) {
+                        expanded_line.push_back(ch);
+                        if (offset) {
 #if 0
-                        if (char_index < lr_chars.lr_start) {
-                            lr_bytes.lr_start += abs(offset);
-                        }
-                        if (char_index < lr_chars.lr_end) {
-                            lr_bytes.lr_end += abs(offset);
-                        }
+                            if (char_index < lr_chars.lr_start) {
+                                lr_bytes.lr_start += abs(offset);
+                            }
+                            if (char_index < lr_chars.lr_end) {
+                                lr_bytes.lr_end += abs(offset);
+                            }
 #endif
-                        utf_adjustments.emplace_back(lpc, offset);
-                        for (; offset && (lpc + 1) < line.size();
-                             lpc++, offset++)
-                        {
-                            expanded_line.push_back(line[lpc + 1]);
+                            utf_adjustments.emplace_back(lpc, offset);
+                            for (; offset && (lpc + 1) < line.size();
+                                 lpc++, offset++)
+                            {
+                                expanded_line.push_back(line[lpc + 1]);
+                            }
                         }
                     }
+                    char_index += 1;
+                    break;
                 }
-                char_index += 1;
-                break;
             }
         }
     }
@@ -224,10 +250,7 @@ view_curses::mvwattrline(WINDOW* window,
     auto text_role_attrs = vc.attrs_for_role(role_t::VCR_TEXT);
     auto attrs = vc.attrs_for_role(base_role);
     wmove(window, y, x);
-    wattr_set(window,
-              attrs.ta_attrs,
-              vc.ensure_color_pair(attrs.ta_fg_color, attrs.ta_bg_color),
-              nullptr);
+    wattr_set(window, attrs.ta_attrs, vc.color_pair_for_role(base_role), nullptr);
     if (lr_bytes.lr_start < (int) full_line.size()) {
         waddnstr(
             window, &full_line.c_str()[lr_bytes.lr_start], lr_bytes.length());
@@ -409,6 +432,10 @@ view_curses::mvwattrline(WINDOW* window,
 
         int ch_width = lr_chars.length();
         cchar_t row_ch[ch_width + 1];
+        int content_pair = -1;
+        short content_fg = -1, content_bg = -1;
+        short memo_fg = -2, memo_bg = -2;
+        int memo_pair = 0;
 
         mvwin_wchnstr(window, y, x, row_ch, ch_width);
         for (int lpc = 0; lpc < ch_width; lpc++) {
@@ -416,26 +443,35 @@ view_curses::mvwattrline(WINDOW* window,
                 continue;
             }
 #ifdef NCURSES_EXT_COLORS
-            auto cur_pair = row_ch[lpc].ext_color;
+            int cur_pair = row_ch[lpc].ext_color;
 #else
-            auto cur_pair = PAIR_NUMBER(row_ch[lpc].attr);
+            int cur_pair = PAIR_NUMBER(row_ch[lpc].attr);
 #endif
-            short cur_fg, cur_bg;
-            pair_content(cur_pair, &cur_fg, &cur_bg);
+            // Wide views color cells in long runs, so memoize the
+            // pair_content()/ensure_color_pair() bookkeeping instead of
+            // paying for it on every cell.
+            if (cur_pair != content_pair) {
+                content_pair = cur_pair;
+                pair_content(cur_pair, &content_fg, &content_bg);
+            }
             if (fg_color[lpc] == -1) {
-                fg_color[lpc] = cur_fg;
+                fg_color[lpc] = content_fg;
             }
             if (bg_color[lpc] == -1) {
-                bg_color[lpc] = cur_bg;
+                bg_color[lpc] = content_bg;
             }
 
-            int color_pair = vc.ensure_color_pair(fg_color[lpc], bg_color[lpc]);
+            if (fg_color[lpc] != memo_fg || bg_color[lpc] != memo_bg) {
+                memo_fg = fg_color[lpc];
+                memo_bg = bg_color[lpc];
+                memo_pair = vc.ensure_color_pair(memo_fg, memo_bg);
+            }
 
             row_ch[lpc].attr = row_ch[lpc].attr & ~A_COLOR;
 #ifdef NCURSES_EXT_COLORS
-            row_ch[lpc].ext_color = color_pair;
+            row_ch[lpc].ext_color = memo_pair;
 #else
-            row_ch[lpc].attr |= COLOR_PAIR(color_pair);
+            row_ch[lpc].attr |= COLOR_PAIR(memo_pair);
 #endif
         }
         mvwadd_wchnstr(window, y, x, row_ch, ch_width);
@@ -977,10 +1013,38 @@ view_colors::init_roles(const lnav_theme& lt,
         }
     }
 
-    if (initialized && this->vc_color_pair_end == 0) {
+    this->vc_dyn_pairs.clear();
+    if (initialized) {
+        /* Allocate a stable color pair for every role up front so that
+         * the render path can use a direct lookup instead of going
+         * through the LRU cache of dynamic pairs for every line. */
+        std::map<std::pair<short, short>, int> allocated_pairs;
+
         this->vc_color_pair_end = 1;
+        for (int32_t role_index = 0;
+             role_index < lnav::enums::to_underlying(role_t::VCR__MAX);
+             role_index++)
+        {
+            const auto& ra = this->vc_role_attrs[role_index];
+            auto fg = ra.ra_normal.ta_fg_color.value_or(-1);
+            auto bg = ra.ra_normal.ta_bg_color.value_or(-1);
+            auto pair_iter = allocated_pairs.find(std::make_pair(fg, bg));
+
+            if (pair_iter == allocated_pairs.end()) {
+                auto pair_attrs = attr_for_colors(fg, bg);
+                int pair_num = this->vc_color_pair_end++;
+
+                init_pair(pair_num,
+                          pair_attrs.ta_fg_color.value_or(-1),
+                          pair_attrs.ta_bg_color.value_or(-1));
+                pair_iter = allocated_pairs
+                                .emplace(std::make_pair(fg, bg), pair_num)
+                                .first;
+            }
+            this->vc_role_pairs[role_index] = pair_iter->second;
+        }
+        this->vc_dyn_pairs.set_max_size(256 - this->vc_color_pair_end);
     }
-    this->vc_dyn_pairs.clear();
 
     for (int32_t role_index = 0;
          role_index < lnav::enums::to_underlying(role_t::VCR__MAX);
@@ -233,6 +233,23 @@ public:
             : this->vc_role_attrs[lnav::enums::to_underlying(role)].ra_normal;
     }
 
+    /**
+     * @param role The role to retrieve the color pair for.
+     * @return The color pair that was allocated for the role's normal
+     * attributes when the theme was compiled by init_roles().
+     */
+    int color_pair_for_role(role_t role) const
+    {
+        if (role == role_t::VCR_NONE) {
+            return 0;
+        }
+
+        require(role > role_t::VCR_NONE);
+        require(role < role_t::VCR__MAX);
+
+        return this->vc_role_pairs[lnav::enums::to_underlying(role)];
+    }
+
     nonstd::optional<short> color_for_ident(const char* str, size_t len) const;
 
     nonstd::optional<short> color_for_ident(const string_fragment& sf) const
@@ -303,6 +320,8 @@ private:
 
     /** Map of role IDs to attribute values. */
     role_attrs vc_role_attrs[lnav::enums::to_underlying(role_t::VCR__MAX)];
+    /** Map of role IDs to color pairs allocated by init_roles(). */
+    int vc_role_pairs[lnav::enums::to_underlying(role_t::VCR__MAX)]{};
     short vc_ansi_to_theme[8];
     short vc_highlight_colors[HI_COLOR_COUNT];
     int vc_color_pair_end{0};
@@ -339,6 +358,8 @@ struct mouse_event {
     struct timeval me_time {};
     int me_x;
     int me_y;
+    /** The number of identical wheel events coalesced into this one. */
+    int me_count{1};
 };
 
 /**
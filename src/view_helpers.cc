@@ -31,6 +31,7 @@
 
 #include "base/humanize.hh"
 #include "base/itertools.hh"
+#include "base/math_util.hh"
 #include "config.h"
 #include "document.sections.hh"
 #include "environ_vtab.hh"
@@ -102,6 +103,8 @@ view_from_string(const char* name)
 static void
 open_schema_view()
 {
+    static std::string last_schema;
+
     textview_curses* schema_tc = &lnav_data.ld_views[LNV_SCHEMA];
     std::string schema;
 
@@ -115,6 +118,13 @@ open_schema_view()
         schema += "\n" + vtab_iter.second->get_table_statement();
     }
 
+    if (schema == last_schema && schema_tc->get_sub_source() != nullptr) {
+        // Nothing changed, keep the warm view state (top line, search)
+        // instead of rebuilding the source.
+        return;
+    }
+    last_schema = schema;
+
     delete schema_tc->get_sub_source();
 
     auto* pts = new plain_text_source(schema);
@@ -1110,6 +1120,29 @@ void
 hist_index_delegate::index_start(logfile_sub_source& lss)
 {
     this->hid_source.clear();
+    this->hid_shards.clear();
+    this->hid_hour_shards.clear();
+}
+
+void
+hist_index_delegate::update_shards(std::vector<hist_shard>& shards,
+                                   int64_t slice,
+                                   time_t row,
+                                   hist_source2::hist_type_t ht,
+                                   bool marked)
+{
+    auto shard_time = rounddown(row, slice);
+
+    if (shards.empty() || shards.back().hs_time < shard_time) {
+        shards.emplace_back();
+        shards.back().hs_time = shard_time;
+    }
+
+    auto& shard = shards.back();
+    shard.hs_values[ht] += 1;
+    if (marked) {
+        shard.hs_values[hist_source2::HT_MARK] += 1;
+    }
 }
 
 void
@@ -1138,9 +1171,14 @@ hist_index_delegate::index_line(logfile_sub_source& lss,
     }
 
     this->hid_source.add_value(ll->get_time(), ht);
-    if (ll->is_marked() || ll->is_expr_marked()) {
+    auto marked = ll->is_marked() || ll->is_expr_marked();
+    if (marked) {
         this->hid_source.add_value(ll->get_time(), hist_source2::HT_MARK);
     }
+
+    update_shards(this->hid_shards, SHARD_SLICE, ll->get_time(), ht, marked);
+    update_shards(
+        this->hid_hour_shards, HOUR_SHARD_SLICE, ll->get_time(), ht, marked);
 }
 
 void
@@ -1150,6 +1188,36 @@ hist_index_delegate::index_complete(logfile_sub_source& lss)
     lnav_data.ld_views[LNV_SPECTRO].reload_data();
 }
 
+bool
+hist_index_delegate::repopulate_from_shards(int64_t slice)
+{
+    if (slice < SHARD_SLICE || (slice % SHARD_SLICE) != 0) {
+        return false;
+    }
+
+    const auto& shards = (slice % HOUR_SHARD_SLICE) == 0
+        ? this->hid_hour_shards
+        : this->hid_shards;
+
+    this->hid_source.set_time_slice(slice);
+    this->hid_source.clear();
+    for (const auto& shard : shards) {
+        for (int ht = 0; ht < hist_source2::HT__MAX; ht++) {
+            if (shard.hs_values[ht] == 0) {
+                continue;
+            }
+            this->hid_source.add_value(
+                shard.hs_time,
+                static_cast<hist_source2::hist_type_t>(ht),
+                shard.hs_values[ht]);
+        }
+    }
+    this->hid_view.reload_data();
+    lnav_data.ld_views[LNV_SPECTRO].reload_data();
+
+    return true;
+}
+
 static std::vector<breadcrumb::possibility>
 view_title_poss()
 {
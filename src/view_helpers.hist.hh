@@ -30,6 +30,8 @@
 #ifndef lnav_view_helpers_hist_hh
 #define lnav_view_helpers_hist_hh
 
+#include <vector>
+
 #include "hist_source.hh"
 #include "logfile_sub_source.hh"
 
@@ -45,9 +47,51 @@ public:
 
     void index_complete(logfile_sub_source& lss) override;
 
+    /**
+     * Rebuild the histogram for the given time slice from the shard
+     * summaries recorded during the last index pass instead of re-walking
+     * the full index.  The coarsest summary level whose granularity evenly
+     * divides the slice is used, so hour-and-up zoom levels only touch the
+     * hourly rollups.  Only slices that are a multiple of the base shard
+     * size can be served this way.
+     *
+     * @param slice The new time slice, in seconds.
+     * @return True if the histogram was repopulated from the summaries.
+     */
+    bool repopulate_from_shards(int64_t slice);
+
+    /** The granularity of the base shard summaries, in seconds. */
+    static const int64_t SHARD_SLICE = 60;
+
+    /** The granularity of the rolled-up shard summaries, in seconds. */
+    static const int64_t HOUR_SHARD_SLICE = 60 * 60;
+
+    /** Per-shard value totals recorded as lines are indexed. */
+    struct hist_shard {
+        time_t hs_time{0};
+        double hs_values[hist_source2::HT__MAX] = {};
+    };
+
+    /**
+     * Get the per-minute shard summaries, for rate queries that want the
+     * level counts without materializing log rows.
+     */
+    const std::vector<hist_shard>& get_shards() const
+    {
+        return this->hid_shards;
+    }
+
 private:
+    static void update_shards(std::vector<hist_shard>& shards,
+                              int64_t slice,
+                              time_t row,
+                              hist_source2::hist_type_t ht,
+                              bool marked);
+
     hist_source2& hid_source;
     textview_curses& hid_view;
+    std::vector<hist_shard> hid_shards;
+    std::vector<hist_shard> hid_hour_shards;
 };
 
 #endif
@@ -31,6 +31,7 @@
 #include <unordered_map>
 
 #include "base/lnav_log.hh"
+#include "base/lrucache.hpp"
 #include "config.h"
 #include "pugixml/pugixml.hpp"
 #include "sql_help.hh"
@@ -51,6 +52,14 @@ enum {
 static thread_local std::unordered_map<std::string, pugi::xpath_query>
     QUERY_CACHE;
 
+// SOAP-style analyses run many xpath() calls over the same payloads, so
+// hold onto the most recently parsed documents.  The handles are shared
+// and treated as immutable, which lets several cursors evaluate against
+// one parse.
+static thread_local cache::lru_cache<std::string,
+                                     std::shared_ptr<pugi::xml_document>>
+    DOC_CACHE{16};
+
 static pugi::xpath_query
 checkout_query(const std::string& query)
 {
@@ -106,7 +115,7 @@ CREATE TABLE xpath (
         std::string c_value;
         bool c_value_as_blob{false};
         pugi::xpath_query c_query;
-        pugi::xml_document c_doc;
+        std::shared_ptr<pugi::xml_document> c_doc;
         pugi::xpath_node_set c_results;
 
         cursor(sqlite3_vtab* vt) : base({vt}) {}
@@ -312,13 +321,21 @@ rcFilter(sqlite3_vtab_cursor* pVtabCursor,
 
     auto blob = (const char*) sqlite3_value_blob(argv[1]);
     pCur->c_value.assign(blob, byte_count);
-    auto parse_res = pCur->c_doc.load_string(pCur->c_value.c_str());
-    if (!parse_res) {
-        pVtabCursor->pVtab->zErrMsg
-            = sqlite3_mprintf("Invalid XML document at offset %d: %s",
-                              parse_res.offset,
-                              parse_res.description());
-        return SQLITE_ERROR;
+    auto cached_doc = DOC_CACHE.get(pCur->c_value);
+    if (cached_doc) {
+        pCur->c_doc = cached_doc.value();
+    } else {
+        auto new_doc = std::make_shared<pugi::xml_document>();
+        auto parse_res = new_doc->load_string(pCur->c_value.c_str());
+        if (!parse_res) {
+            pVtabCursor->pVtab->zErrMsg
+                = sqlite3_mprintf("Invalid XML document at offset %d: %s",
+                                  parse_res.offset,
+                                  parse_res.description());
+            return SQLITE_ERROR;
+        }
+        DOC_CACHE.put(pCur->c_value, new_doc);
+        pCur->c_doc = std::move(new_doc);
     }
 
     pCur->c_xpath = (const char*) sqlite3_value_text(argv[0]);
@@ -333,7 +350,7 @@ rcFilter(sqlite3_vtab_cursor* pVtabCursor,
     }
 
     pCur->c_rowid = 0;
-    pCur->c_results = pCur->c_doc.select_nodes(pCur->c_query);
+    pCur->c_results = pCur->c_doc->select_nodes(pCur->c_query);
 
     return SQLITE_OK;
 }
@@ -38,22 +38,28 @@ const char* xterm_mouse::XT_TERMCAP = "\033[?1000%?%p1%{1}%=%th%el%;";
 const char* xterm_mouse::XT_TERMCAP_TRACKING = "\033[?1002%?%p1%{1}%=%th%el%;";
 const char* xterm_mouse::XT_TERMCAP_SGR = "\033[?1006%?%p1%{1}%=%th%el%;";
 
-void
-xterm_mouse::handle_mouse()
+/**
+ * Read the body of a single SGR mouse sequence.  The leading "\x1b[<"
+ * (or the KEY_MOUSE keycode it was translated to) has already been
+ * consumed by the caller.
+ */
+static bool
+read_sgr_body(int& bstate, int& x, int& y, bool& release)
 {
-    bool release = false;
-    int ch;
     size_t index = 0;
-    int bstate, x, y;
     char buffer[64];
     bool done = false;
 
+    release = false;
     while (!done) {
         if (index >= sizeof(buffer) - 1) {
             break;
         }
-        ch = getch();
+        auto ch = getch();
         switch (ch) {
+            case ERR:
+                done = true;
+                break;
             case 'm':
                 release = true;
                 done = true;
@@ -69,12 +75,92 @@ xterm_mouse::handle_mouse()
     buffer[index] = '\0';
 
     if (sscanf(buffer, "%d;%d;%d", &bstate, &x, &y) == 3) {
-        if (this->xm_behavior) {
-            this->xm_behavior->mouse_event(bstate, release, x, y);
+        return true;
+    }
+
+    log_error("bad mouse escape sequence: %s", buffer);
+    return false;
+}
+
+static bool
+is_wheel_button(int bstate)
+{
+    auto masked = bstate & xterm_mouse::XT_BUTTON__MASK;
+
+    return masked == xterm_mouse::XT_SCROLL_UP
+        || masked == xterm_mouse::XT_SCROLL_DOWN;
+}
+
+void
+xterm_mouse::handle_mouse()
+{
+    bool release;
+    int bstate, x, y;
+
+    if (!read_sgr_body(bstate, x, y, release)) {
+        return;
+    }
+
+    if (this->xm_behavior == nullptr) {
+        return;
+    }
+
+    int count = 1;
+
+    if (!release && is_wheel_button(bstate)) {
+        // Trackpads and high-resolution wheels deliver bursts of wheel
+        // sequences faster than the views can relayout.  Merge the run
+        // of identical clicks already sitting in the input queue into a
+        // single event so the scroll is applied once for the batch.
+        int ch;
+
+        while ((ch = getch()) != ERR) {
+            if (ch == '\x1b') {
+                auto ch2 = getch();
+                if (ch2 != '[') {
+                    if (ch2 != ERR) {
+                        ungetch(ch2);
+                    }
+                    ungetch(ch);
+                    break;
+                }
+                auto ch3 = getch();
+                if (ch3 != '<') {
+                    if (ch3 != ERR) {
+                        ungetch(ch3);
+                    }
+                    ungetch(ch2);
+                    ungetch(ch);
+                    break;
+                }
+            } else if (ch != KEY_MOUSE) {
+                ungetch(ch);
+                break;
+            }
+
+            bool next_release;
+            int next_bstate, next_x, next_y;
+
+            if (!read_sgr_body(next_bstate, next_x, next_y, next_release)) {
+                break;
+            }
+            if (!next_release && next_bstate == bstate) {
+                count += 1;
+                x = next_x;
+                y = next_y;
+                continue;
+            }
+
+            // The run ended with a different kind of event, deliver the
+            // batch built so far followed by the odd one out.
+            this->xm_behavior->mouse_event(bstate, release, count, x, y);
+            this->xm_behavior->mouse_event(
+                next_bstate, next_release, 1, next_x, next_y);
+            return;
         }
-    } else {
-        log_error("bad mouse escape sequence: %s", buffer);
     }
+
+    this->xm_behavior->mouse_event(bstate, release, count, x, y);
 }
 
 void
@@ -61,10 +61,13 @@ public:
      * @param button The button that was pressed or released.  This will
      *   be one of the XT_BUTTON or XT_SCROLL constants in the xterm_mouse
      *   class.
+     * @param count  The number of identical wheel events that were
+     *   coalesced into this one, one for any other kind of event.
      * @param x      The X coordinate where the event occurred.
      * @param y      The Y coordinate where the event occurred.
      */
-    virtual void mouse_event(int button, bool release, int x, int y) = 0;
+    virtual void mouse_event(int button, bool release, int count, int x, int y)
+        = 0;
 };
 
 /**
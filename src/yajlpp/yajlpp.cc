@@ -149,7 +149,8 @@ json_path_handler_base::json_path_handler_base(const std::string& property)
                                           PCRE2_ANCHORED)
                     .unwrap()
                     .to_shared()),
-      jph_is_array(property.back() == '#')
+      jph_is_array(property.back() == '#'),
+      jph_is_literal(property.back() != '#')
 {
     memset(&this->jph_callbacks, 0, sizeof(this->jph_callbacks));
 }
@@ -713,13 +714,33 @@ yajlpp_parse_context::update_callbacks(const json_path_container* orig_handlers,
     for (const auto& jph : handlers->jpc_children) {
         static thread_local auto md = lnav::pcre2pp::match_data::unitialized();
 
-        if (jph.jph_regex->capture_from(path_frag)
-                .into(md)
-                .matches()
-                .ignore_error())
-        {
-            auto cap = md[0].value();
+        bool matched;
+        int cap_end = -1;
+
+        if (jph.jph_is_literal) {
+            // A plain property name only ever matches itself, so compare
+            // the bytes directly instead of evaluating the quoted and
+            // anchored regex for every key event.  The regex is still
+            // around for documentation and generation.
+            const auto& prop = jph.jph_property;
+
+            matched = (size_t) path_frag.length() >= prop.size()
+                && memcmp(path_frag.data(), prop.c_str(), prop.size()) == 0;
+            if (matched) {
+                cap_end = 1 + child_start + (int) prop.size();
+            }
+        } else {
+            matched = jph.jph_regex->capture_from(path_frag)
+                          .into(md)
+                          .matches()
+                          .ignore_error()
+                          .has_value();
+            if (matched) {
+                cap_end = md[0].value().sf_end;
+            }
+        }
 
+        if (matched) {
             if (jph.jph_is_array) {
                 this->ypc_array_handler_count += 1;
             }
@@ -728,7 +749,7 @@ yajlpp_parse_context::update_callbacks(const json_path_container* orig_handlers,
                     ? static_cast<size_t>(-1)
                     : this->ypc_array_index[this->ypc_array_handler_count - 1];
 
-                if ((cap.sf_end != (int) this->ypc_path.size() - 1)
+                if ((cap_end != (int) this->ypc_path.size() - 1)
                     && (!jph.is_array()
                         || index != yajlpp_provider_context::nindex))
                 {
@@ -740,12 +761,12 @@ yajlpp_parse_context::update_callbacks(const json_path_container* orig_handlers,
             if (jph.jph_children) {
                 this->ypc_handler_stack.emplace_back(&jph);
 
-                if (cap.sf_end != (int) this->ypc_path.size() - 1) {
-                    this->update_callbacks(jph.jph_children, cap.sf_end);
+                if (cap_end != (int) this->ypc_path.size() - 1) {
+                    this->update_callbacks(jph.jph_children, cap_end);
                     return;
                 }
             } else {
-                if (cap.sf_end != (int) this->ypc_path.size() - 1) {
+                if (cap_end != (int) this->ypc_path.size() - 1) {
                     continue;
                 }
 
@@ -277,6 +277,12 @@ struct json_path_handler_base {
     bool jph_optional_wrapper{false};
     bool jph_is_array;
     bool jph_is_pattern_property{false};
+    /**
+     * Set for handlers whose property is a plain name, in which case
+     * path matching is done with a string comparison instead of
+     * evaluating jph_regex for every key event.
+     */
+    bool jph_is_literal{false};
     std::vector<std::string> jph_examples;
 
     std::function<int(yajlpp_parse_context*)> jph_null_cb;
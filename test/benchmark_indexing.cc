@@ -0,0 +1,276 @@
+/**
+ * Copyright (c) 2022, Timothy Stack
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * * Redistributions of source code must retain the above copyright notice, this
+ * list of conditions and the following disclaimer.
+ * * Redistributions in binary form must reproduce the above copyright notice,
+ * this list of conditions and the following disclaimer in the documentation
+ * and/or other materials provided with the distribution.
+ * * Neither the name of Timothy Stack nor the names of its contributors
+ * may be used to endorse or promote products derived from this software
+ * without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE REGENTS AND CONTRIBUTORS ''AS IS'' AND ANY
+ * EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE REGENTS OR CONTRIBUTORS BE LIABLE FOR ANY
+ * DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * @file benchmark_indexing.cc
+ *
+ * Microbenchmarks for the indexing hot path: line_buffer::load_next_line(),
+ * date_time_scanner::scan(), and log_format::scan() (by way of
+ * logfile::rebuild_index()).  Each stage is run repeatedly over the given
+ * corpus files and the lines/sec and bytes/sec rates are printed so that
+ * throughput regressions can be bisected between releases.
+ */
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "base/auto_fd.hh"
+#include "base/date_time_scanner.hh"
+#include "base/injector.hh"
+#include "config.h"
+#include "line_buffer.hh"
+#include "log_format.hh"
+#include "logfile.hh"
+
+using namespace std;
+
+struct stage_totals {
+    uint64_t st_lines{0};
+    uint64_t st_bytes{0};
+    std::chrono::microseconds st_elapsed{0};
+};
+
+static void
+report(const char* stage, const char* path, const stage_totals& totals)
+{
+    auto elapsed_us = std::max((int64_t) 1, (int64_t) totals.st_elapsed.count());
+
+    printf("BENCH %-16s %-28s lines=%10llu bytes=%11llu elapsed_us=%9lld "
+           "lines_per_sec=%11.0f bytes_per_sec=%13.0f\n",
+           stage,
+           path,
+           (unsigned long long) totals.st_lines,
+           (unsigned long long) totals.st_bytes,
+           (long long) elapsed_us,
+           totals.st_lines * 1000000.0 / elapsed_us,
+           totals.st_bytes * 1000000.0 / elapsed_us);
+}
+
+static int
+bench_line_buffer(const char* path, int passes, stage_totals& totals)
+{
+    for (int pass = 0; pass < passes; pass++) {
+        auto_fd fd;
+
+        if ((fd = open(path, O_RDONLY)) == -1) {
+            perror("open");
+            return EXIT_FAILURE;
+        }
+
+        line_buffer lb;
+        file_range last_range;
+
+        lb.set_fd(fd);
+
+        auto start = std::chrono::steady_clock::now();
+        while (true) {
+            auto load_result = lb.load_next_line(last_range);
+
+            if (load_result.isErr()) {
+                fprintf(stderr,
+                        "unable to load line: %s\n",
+                        load_result.unwrapErr().c_str());
+                return EXIT_FAILURE;
+            }
+
+            auto li = load_result.unwrap();
+
+            if (li.li_file_range.empty()) {
+                break;
+            }
+
+            totals.st_lines += 1;
+            totals.st_bytes += li.li_file_range.fr_size;
+            last_range = li.li_file_range;
+        }
+        totals.st_elapsed
+            += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+static int
+bench_date_time_scanner(const char* path, int passes, stage_totals& totals)
+{
+    std::vector<std::string> lines;
+
+    {
+        auto_fd fd;
+
+        if ((fd = open(path, O_RDONLY)) == -1) {
+            perror("open");
+            return EXIT_FAILURE;
+        }
+
+        line_buffer lb;
+        file_range last_range;
+
+        lb.set_fd(fd);
+        while (true) {
+            auto load_result = lb.load_next_line(last_range);
+
+            if (load_result.isErr()) {
+                fprintf(stderr,
+                        "unable to load line: %s\n",
+                        load_result.unwrapErr().c_str());
+                return EXIT_FAILURE;
+            }
+
+            auto li = load_result.unwrap();
+
+            if (li.li_file_range.empty()) {
+                break;
+            }
+
+            auto read_result = lb.read_range(li.li_file_range);
+
+            if (read_result.isOk()) {
+                auto sbr = read_result.unwrap();
+
+                lines.emplace_back(sbr.get_data(), sbr.length());
+            }
+            last_range = li.li_file_range;
+        }
+    }
+
+    date_time_scanner dts;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < passes; pass++) {
+        for (const auto& line : lines) {
+            struct exttm tm;
+            struct timeval tv;
+
+            dts.scan(line.c_str(), line.size(), nullptr, &tm, tv);
+            totals.st_lines += 1;
+            totals.st_bytes += line.size();
+        }
+    }
+    totals.st_elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    return EXIT_SUCCESS;
+}
+
+static int
+bench_format_scan(const char* path, int passes, stage_totals& totals)
+{
+    for (int pass = 0; pass < passes; pass++) {
+        logfile_open_options default_loo;
+        auto open_res = logfile::open(path, default_loo);
+
+        if (open_res.isErr()) {
+            fprintf(stderr,
+                    "unable to open logfile: %s\n",
+                    open_res.unwrapErr().c_str());
+            return EXIT_FAILURE;
+        }
+
+        auto lf = open_res.unwrap();
+
+        auto start = std::chrono::steady_clock::now();
+        lf->rebuild_index();
+        totals.st_elapsed
+            += std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - start);
+        totals.st_lines += lf->size();
+        totals.st_bytes += lf->get_index_size();
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char* argv[])
+{
+    int c, passes = 100, retval = EXIT_SUCCESS;
+
+    {
+        static auto builtin_formats
+            = injector::get<std::vector<std::shared_ptr<log_format>>>();
+        auto& root_formats = log_format::get_root_formats();
+
+        log_format::get_root_formats().insert(root_formats.begin(),
+                                              builtin_formats.begin(),
+                                              builtin_formats.end());
+        builtin_formats.clear();
+    }
+
+    while ((c = getopt(argc, argv, "n:")) != -1) {
+        switch (c) {
+            case 'n':
+                passes = atoi(optarg);
+                break;
+            default:
+                retval = EXIT_FAILURE;
+                break;
+        }
+    }
+
+    argc -= optind;
+    argv += optind;
+
+    if (retval == EXIT_FAILURE || passes <= 0) {
+        fprintf(stderr, "usage: benchmark_indexing [-n passes] file...\n");
+        return EXIT_FAILURE;
+    }
+    if (argc == 0) {
+        fprintf(stderr, "error: expecting log file name\n");
+        return EXIT_FAILURE;
+    }
+
+    for (int lpc = 0; lpc < argc; lpc++) {
+        stage_totals lb_totals, dts_totals, scan_totals;
+
+        if (bench_line_buffer(argv[lpc], passes, lb_totals) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        report("line_buffer", argv[lpc], lb_totals);
+
+        if (bench_date_time_scanner(argv[lpc], passes, dts_totals)
+            != EXIT_SUCCESS)
+        {
+            return EXIT_FAILURE;
+        }
+        report("date_time_scanner", argv[lpc], dts_totals);
+
+        if (bench_format_scan(argv[lpc], passes, scan_totals) != EXIT_SUCCESS) {
+            return EXIT_FAILURE;
+        }
+        report("format_scan", argv[lpc], scan_totals);
+    }
+
+    return retval;
+}
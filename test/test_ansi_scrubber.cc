@@ -35,6 +35,7 @@
  */
 
 #include <assert.h>
+#include <string.h>
 
 #include "base/ansi_scrubber.hh"
 #include "config.h"
@@ -55,6 +56,15 @@ main(int argc, char* argv[])
         assert(new_len == 13);
     }
 
+    {
+        char input[] = "no escapes here";
+
+        auto new_len = erase_ansi_escapes(string_fragment::from_const(input));
+
+        assert(new_len == sizeof(input) - 1);
+        assert(strcmp(input, "no escapes here") == 0);
+    }
+
     {
         std::string boldish
             = "\u2022\b\u2022\u2023\b\u2023 h\bhe\bel\blo\bo _\ba_\bb_\bc a\b_ "
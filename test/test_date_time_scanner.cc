@@ -164,6 +164,31 @@ main(int argc, char* argv[])
         assert(strcmp(ts, buf) == 0);
     }
 
+    {
+        const char* iso_time = "2014-02-11 16:12:34";
+        const char* syslog_time = "May 10 12:00:01";
+        struct timeval tv;
+        struct exttm tm;
+        date_time_scanner dts;
+
+        for (int lpc = 0; lpc < date_time_scanner::SHAPE_MATCH_COUNT; lpc++) {
+            assert(dts.scan(iso_time, strlen(iso_time), nullptr, &tm, tv)
+                   != nullptr);
+        }
+        assert(dts.shape_matches(iso_time, strlen(iso_time)));
+        assert(!dts.shape_matches(syslog_time, strlen(syslog_time)));
+
+        // The shape check should reject without unlocking until enough
+        // consecutive misses have piled up, after which discovery is
+        // re-run and the new format takes over.
+        for (int lpc = 0; lpc < date_time_scanner::MAX_SCAN_MISSES - 1; lpc++) {
+            assert(dts.scan(syslog_time, strlen(syslog_time), nullptr, &tm, tv)
+                   == nullptr);
+        }
+        assert(dts.scan(syslog_time, strlen(syslog_time), nullptr, &tm, tv)
+               != nullptr);
+    }
+
     {
         const char* epoch_str = "ts 1428721664 ]";
         struct exttm tm;